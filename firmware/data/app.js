@@ -1,6 +1,18 @@
 const RECONNECT_DELAY = 2000;
 let socket;
 let reconnectTimer;
+// Last state sequence seen, so a reconnect only asks for what was missed.
+let stateSeq = null;
+let stateEpoch = null;
+
+// Clock sync: a burst of pings on connect and then periodically; the sample
+// with the shortest round trip gives the offset to device time.
+const CLOCK_SYNC_SAMPLES = 8;
+const CLOCK_SYNC_SPACING = 150;
+const CLOCK_SYNC_INTERVAL = 30000;
+let clockTimer;
+let clockBurst = [];
+let clockOffset = null;
 
 const cueCards = new Map();
 
@@ -51,6 +63,62 @@ function renameCue(index, text) {
   sendMessage({ type: "rename", cue: index, text });
 }
 
+// Applied by the controller in one pass, so every LED changes together.
+function sendBatch(ops) {
+  sendMessage({ type: "batch", ops });
+}
+
+function releaseAllCues() {
+  sendBatch([{ op: "release", cue: "all" }]);
+}
+
+// Fires on the controller's clock, so units and browsers with a synced offset
+// act together regardless of when the message gets there.
+function scheduleCue(index, delayMs, op = "trigger") {
+  if (clockOffset === null) {
+    console.warn("Horloge non synchronisée");
+    return false;
+  }
+  const at = performance.now() + delayMs + clockOffset;
+  sendMessage({ type: "schedule", cue: index, op, at });
+  return true;
+}
+
+function sendClockPing(remaining) {
+  if (!socket || socket.readyState !== WebSocket.OPEN) {
+    return;
+  }
+  socket.send(JSON.stringify({ type: "ping", t0: performance.now() }));
+  if (remaining > 1) {
+    clockTimer = setTimeout(() => sendClockPing(remaining - 1), CLOCK_SYNC_SPACING);
+  } else {
+    startClockSync(CLOCK_SYNC_INTERVAL);
+  }
+}
+
+function startClockSync(delay = 0) {
+  clearTimeout(clockTimer);
+  clockTimer = setTimeout(() => {
+    clockBurst = [];
+    sendClockPing(CLOCK_SYNC_SAMPLES);
+  }, delay);
+}
+
+function handlePongMessage({ t0, t1, t2 }) {
+  const t3 = performance.now();
+  const rtt = t3 - t0 - (t2 - t1);
+  const offset = (t1 - t0 + (t2 - t3)) / 2;
+  clockBurst.push({ rtt, offset });
+  if (clockBurst.length < CLOCK_SYNC_SAMPLES) {
+    return;
+  }
+
+  const best = clockBurst.reduce((a, b) => (b.rtt < a.rtt ? b : a));
+  clockBurst = [];
+  clockOffset = best.offset;
+  sendMessage({ type: "clock", offset: best.offset, rtt: best.rtt });
+}
+
 function handlePointerStart(event) {
   const index = Number(event.currentTarget.dataset.cue);
   event.preventDefault();
@@ -69,62 +137,107 @@ function handlePointerEnd(event) {
   }
 }
 
-function bindCueControls() {
-  document.querySelectorAll(".cue").forEach((card) => {
-    const index = Number(card.dataset.cue);
-    const triggerButton = card.querySelector(".cue-trigger");
-    const releaseButton = card.querySelector(".cue-release");
-    const input = card.querySelector("input");
-
-    if (triggerButton) {
-      triggerButton.addEventListener("pointerdown", handlePointerStart);
-      triggerButton.addEventListener("pointerup", handlePointerEnd);
-      triggerButton.addEventListener("pointercancel", handlePointerEnd);
-      triggerButton.addEventListener("pointerleave", handlePointerEnd);
-
-      triggerButton.addEventListener("keydown", (evt) => {
-        if (evt.code === "Space" || evt.code === "Enter") {
-          evt.preventDefault();
-          triggerCue(index);
-        }
-      });
+function bindCueCard(card) {
+  const index = Number(card.dataset.cue);
+  const triggerButton = card.querySelector(".cue-trigger");
+  const releaseButton = card.querySelector(".cue-release");
+  const input = card.querySelector("input");
 
-      triggerButton.addEventListener("keyup", (evt) => {
-        if (evt.code === "Space" || evt.code === "Enter") {
-          evt.preventDefault();
-          releaseCue(index);
-        }
-      });
-    }
+  if (triggerButton) {
+    triggerButton.addEventListener("pointerdown", handlePointerStart);
+    triggerButton.addEventListener("pointerup", handlePointerEnd);
+    triggerButton.addEventListener("pointercancel", handlePointerEnd);
+    triggerButton.addEventListener("pointerleave", handlePointerEnd);
+
+    triggerButton.addEventListener("keydown", (evt) => {
+      if (evt.code === "Space" || evt.code === "Enter") {
+        evt.preventDefault();
+        triggerCue(index);
+      }
+    });
 
-    if (releaseButton) {
-      releaseButton.addEventListener("click", () => releaseCue(index));
-      releaseButton.addEventListener("touchend", (evt) => {
+    triggerButton.addEventListener("keyup", (evt) => {
+      if (evt.code === "Space" || evt.code === "Enter") {
         evt.preventDefault();
         releaseCue(index);
-      });
-    }
+      }
+    });
+  }
 
-    if (input) {
-      input.dataset.lastValue = input.value.trim();
-      const commitRename = () => {
-        const value = input.value.trim();
-        if (input.dataset.lastValue !== value) {
-          renameCue(index, value);
-          input.dataset.lastValue = value;
-        }
-      };
+  if (releaseButton) {
+    releaseButton.addEventListener("click", () => releaseCue(index));
+    releaseButton.addEventListener("touchend", (evt) => {
+      evt.preventDefault();
+      releaseCue(index);
+    });
+  }
 
-      input.addEventListener("change", commitRename);
-      input.addEventListener("blur", commitRename);
-    }
+  if (input) {
+    input.dataset.lastValue = input.value.trim();
+    const commitRename = () => {
+      const value = input.value.trim();
+      if (input.dataset.lastValue !== value) {
+        renameCue(index, value);
+        input.dataset.lastValue = value;
+      }
+    };
+
+    input.addEventListener("change", commitRename);
+    input.addEventListener("blur", commitRename);
+  }
+
+  cueCards.set(index, card);
+}
 
-    cueCards.set(index, card);
+function bindCueControls() {
+  document.querySelectorAll(".cue").forEach(bindCueCard);
+
+  const releaseAll = $("#releaseAll");
+  if (releaseAll) {
+    releaseAll.addEventListener("click", releaseAllCues);
+  }
+}
+
+// The page ships with three cards; builds configured with more channels get
+// extra cards cloned from the first one.
+function ensureCueCard(index) {
+  if (cueCards.has(index)) {
+    return cueCards.get(index);
+  }
+
+  const template = cueCards.get(0);
+  const container = $("#cues");
+  if (!template || !container) {
+    return undefined;
+  }
+
+  const card = template.cloneNode(true);
+  card.dataset.cue = String(index);
+  card.classList.remove("active");
+  card.querySelectorAll("[data-cue]").forEach((el) => {
+    el.dataset.cue = String(index);
   });
+
+  const input = card.querySelector("input");
+  if (input) {
+    input.id = `text${index}`;
+    input.value = "";
+    input.dataset.cueInput = String(index);
+  }
+
+  const label = card.querySelector("label");
+  if (label) {
+    label.htmlFor = `text${index}`;
+    label.textContent = `Texte Cue ${index + 1}`;
+  }
+
+  container.appendChild(card);
+  bindCueCard(card);
+  return card;
 }
 
 function applyCueState({ index, text, active }) {
-  const card = cueCards.get(index);
+  const card = ensureCueCard(index);
   if (!card) {
     return;
   }
@@ -138,7 +251,20 @@ function applyCueState({ index, text, active }) {
   card.classList.toggle("active", Boolean(active));
 }
 
+// Sequences are 16-bit on the device and wrap around.
+function trackSequence(seq) {
+  if (typeof seq !== "number") {
+    return;
+  }
+  if (stateSeq === null || ((seq - stateSeq) & 0xffff) < 0x8000) {
+    stateSeq = seq;
+  }
+}
+
 function handleInitMessage(payload) {
+  stateEpoch = payload.epoch;
+  stateSeq = null;
+  trackSequence(payload.seq);
   if (Array.isArray(payload.cues)) {
     payload.cues.forEach(applyCueState);
   }
@@ -166,15 +292,27 @@ function handleSocketMessage(event) {
         break;
       case "cue":
         applyCueState(payload);
+        trackSequence(payload.seq);
+        break;
+      case "delta":
+        if (Array.isArray(payload.cues)) {
+          payload.cues.forEach(applyCueState);
+        }
+        trackSequence(payload.seq);
+        updateStatus("🟢 Connecté au contrôleur");
         break;
       case "snapshot":
         if (Array.isArray(payload.cues)) {
           payload.cues.forEach(applyCueState);
         }
+        trackSequence(payload.seq);
         break;
       case "ack":
         handleAckMessage(payload);
         break;
+      case "pong":
+        handlePongMessage(payload);
+        break;
       default:
         console.debug("Message inconnu", payload);
         break;
@@ -188,13 +326,20 @@ function openSocket() {
   clearTimeout(reconnectTimer);
 
   const protocol = location.protocol === "https:" ? "wss" : "ws";
-  socket = new WebSocket(`${protocol}://${location.host}/ws`);
+  const resume =
+    stateSeq !== null && stateEpoch !== null
+      ? `?since=${stateSeq}&epoch=${stateEpoch}`
+      : "";
+  socket = new WebSocket(`${protocol}://${location.host}/ws${resume}`);
 
   socket.addEventListener("open", () => {
     updateStatus("🟢 Connecté au contrôleur");
+    startClockSync();
   });
 
   socket.addEventListener("close", () => {
+    clearTimeout(clockTimer);
+    clockBurst = [];
     updateStatus("🔴 Déconnecté. Reconnexion en cours...");
     reconnectTimer = setTimeout(openSocket, RECONNECT_DELAY);
   });
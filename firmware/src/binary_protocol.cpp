@@ -0,0 +1,38 @@
+#include "binary_protocol.h"
+
+namespace stagecue {
+
+void encodeBinaryFrame(const BinaryFrame &frame, uint8_t *out) {
+  out[0] = static_cast<uint8_t>(frame.opcode);
+  out[1] = frame.cue;
+  out[2] = static_cast<uint8_t>(frame.sequence);
+  out[3] = static_cast<uint8_t>(frame.sequence >> 8);
+  out[4] = static_cast<uint8_t>(frame.timestamp);
+  out[5] = static_cast<uint8_t>(frame.timestamp >> 8);
+  out[6] = static_cast<uint8_t>(frame.timestamp >> 16);
+  out[7] = static_cast<uint8_t>(frame.timestamp >> 24);
+}
+
+bool decodeBinaryFrame(const uint8_t *data, size_t len, BinaryFrame &frame) {
+  if (data == nullptr || len != kBinaryFrameSize) {
+    return false;
+  }
+
+  switch (static_cast<BinaryOpcode>(data[0])) {
+    case BinaryOpcode::kTrigger:
+    case BinaryOpcode::kRelease:
+      break;
+    default:
+      return false;  // clients may only send requests
+  }
+
+  frame.opcode = static_cast<BinaryOpcode>(data[0]);
+  frame.cue = data[1];
+  frame.sequence = static_cast<uint16_t>(data[2] | (data[3] << 8));
+  frame.timestamp = static_cast<uint32_t>(data[4]) | (static_cast<uint32_t>(data[5]) << 8) |
+                    (static_cast<uint32_t>(data[6]) << 16) |
+                    (static_cast<uint32_t>(data[7]) << 24);
+  return true;
+}
+
+}  // namespace stagecue
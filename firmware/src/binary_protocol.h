@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace stagecue {
+
+// Compact WebSocket framing for latency-sensitive clients. A client opts in
+// with {"type":"hello","binary":true}; init, snapshot and rename messages stay
+// JSON, while trigger/release/ack/state travel as fixed 8-byte frames:
+//
+//   byte 0     opcode
+//   byte 1     cue index
+//   bytes 2-3  sequence number (little endian)
+//   bytes 4-7  timestamp in milliseconds (little endian)
+//
+// Requests carry a client-chosen sequence that the ack/nack echoes; state
+// frames carry the device state sequence and the device time of the change.
+enum class BinaryOpcode : uint8_t {
+  kTrigger = 0x01,
+  kRelease = 0x02,
+  kAck = 0x10,
+  kNack = 0x11,
+  kStateIdle = 0x20,
+  kStateActive = 0x21,
+};
+
+inline constexpr size_t kBinaryFrameSize = 8U;
+
+struct BinaryFrame {
+  BinaryOpcode opcode = BinaryOpcode::kAck;
+  uint8_t cue = 0;
+  uint16_t sequence = 0;
+  uint32_t timestamp = 0;
+};
+
+void encodeBinaryFrame(const BinaryFrame &frame, uint8_t *out);
+bool decodeBinaryFrame(const uint8_t *data, size_t len, BinaryFrame &frame);
+
+}  // namespace stagecue
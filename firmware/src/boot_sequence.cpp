@@ -0,0 +1,58 @@
+#include "boot_sequence.h"
+
+#include "boot_timeline.h"
+#include "config.h"
+#include "cues.h"
+#include "display_manager.h"
+#include "web_server.h"
+#include "wifi_supervisor.h"
+
+namespace stagecue {
+
+namespace {
+
+void bringUpDisplay() {
+  if (!initDisplay()) {
+    Serial.println(F("[Setup] Display initialisation failed"));
+  }
+  markBootPhase(BootPhase::kDisplayReady);
+  while (!requestCueDisplayRefresh()) {
+    vTaskDelay(1);
+  }
+}
+
+// The station link comes up in the background; the peer fabric joins once
+// it has an address.
+void bringUpNetwork() {
+  startWifiSupervisor();
+  startWebServer();
+  if (!loadShowFile()) {
+    Serial.println(F("[Setup] No show file, cues run standalone"));
+  }
+  printBootTimeline();
+}
+
+template <void (*BringUp)()>
+void bootTask(void *) {
+  BringUp();
+  vTaskDelete(nullptr);
+}
+
+template <void (*BringUp)()>
+void startBootTask(const char *name, uint32_t stackSize) {
+  if (xTaskCreatePinnedToCore(bootTask<BringUp>, name, stackSize, nullptr, kBootTaskPriority,
+                              nullptr, kBootTaskCore) != pdPASS) {
+    // Bring it up inline instead; slower, but the device still works.
+    Serial.printf("[Setup] Unable to start %s task\n", name);
+    BringUp();
+  }
+}
+
+}  // namespace
+
+void startBackgroundBringUp() {
+  startBootTask<bringUpDisplay>("boot_display", kBootDisplayTaskStackSize);
+  startBootTask<bringUpNetwork>("boot_network", kBootNetworkTaskStackSize);
+}
+
+}  // namespace stagecue
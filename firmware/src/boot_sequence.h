@@ -0,0 +1,9 @@
+#pragma once
+
+namespace stagecue {
+
+// Starts display, Wi-Fi and web server bring-up on background tasks so the
+// caller returns straight away; call after initCues().
+void startBackgroundBringUp();
+
+}  // namespace stagecue
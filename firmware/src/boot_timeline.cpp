@@ -0,0 +1,56 @@
+#include "boot_timeline.h"
+
+#include <array>
+#include <atomic>
+
+namespace stagecue {
+
+namespace {
+
+std::array<std::atomic<uint32_t>, kBootPhaseCount> gPhaseMicros{};
+
+constexpr const char *kPhaseNames[kBootPhaseCount] = {
+    "cues_live",
+    "display_ready",
+    "wifi_connected",
+    "access_point_up",
+    "web_server_ready",
+    "first_trigger",
+};
+
+}  // namespace
+
+void markBootPhase(BootPhase phase) {
+  const size_t slot = static_cast<size_t>(phase);
+  if (slot >= kBootPhaseCount) {
+    return;
+  }
+
+  uint32_t unset = 0;
+  const uint32_t now = micros();
+  gPhaseMicros[slot].compare_exchange_strong(unset, now == 0U ? 1U : now,
+                                             std::memory_order_relaxed);
+}
+
+uint32_t getBootPhaseMicros(BootPhase phase) {
+  const size_t slot = static_cast<size_t>(phase);
+  return slot < kBootPhaseCount ? gPhaseMicros[slot].load(std::memory_order_relaxed) : 0U;
+}
+
+const char *bootPhaseName(BootPhase phase) {
+  const size_t slot = static_cast<size_t>(phase);
+  return slot < kBootPhaseCount ? kPhaseNames[slot] : "unknown";
+}
+
+void printBootTimeline() {
+  Serial.println(F("[Boot] Timeline (ms since reset):"));
+  for (size_t i = 0; i < kBootPhaseCount; ++i) {
+    const uint32_t atUs = gPhaseMicros[i].load(std::memory_order_relaxed);
+    if (atUs == 0U) {
+      continue;
+    }
+    Serial.printf("[Boot]   %-17s %7.1f\n", kPhaseNames[i], atUs / 1000.0f);
+  }
+}
+
+}  // namespace stagecue
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace stagecue {
+
+enum class BootPhase : uint8_t {
+  kCuesLive = 0,
+  kDisplayReady,
+  kWifiConnected,
+  kAccessPointUp,
+  kWebServerReady,
+  kFirstTrigger,
+  kCount,
+};
+
+inline constexpr size_t kBootPhaseCount = static_cast<size_t>(BootPhase::kCount);
+
+// Records the first time a phase is reached, in microseconds since reset.
+// Safe to call from any task; later calls for the same phase are ignored.
+void markBootPhase(BootPhase phase);
+// 0 when the phase has not been reached (yet).
+uint32_t getBootPhaseMicros(BootPhase phase);
+const char *bootPhaseName(BootPhase phase);
+void printBootTimeline();
+
+}  // namespace stagecue
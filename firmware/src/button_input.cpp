@@ -0,0 +1,82 @@
+#include "button_input.h"
+
+#include <array>
+#include <atomic>
+#include <utility>
+
+#include "config.h"
+
+namespace stagecue {
+
+namespace {
+
+static_assert((kButtonEdgeQueueSize & (kButtonEdgeQueueSize - 1U)) == 0U,
+              "Edge queue size must be a power of two");
+
+// Single producer (the GPIO ISR dispatcher runs handlers one at a time on one
+// core) and single consumer (the cue loop), so two indices are enough.
+std::array<ButtonEdge, kButtonEdgeQueueSize> gEdges{};
+std::atomic<uint32_t> gEdgeHead{0};
+std::atomic<uint32_t> gEdgeTail{0};
+std::atomic<bool> gEdgeOverflow{false};
+TaskHandle_t gWakeTask = nullptr;
+
+template <uint8_t Channel>
+void IRAM_ATTR onButtonEdge() {
+  const uint32_t head = gEdgeHead.load(std::memory_order_relaxed);
+  if (head - gEdgeTail.load(std::memory_order_acquire) < kButtonEdgeQueueSize) {
+    gEdges[head & (kButtonEdgeQueueSize - 1U)] = ButtonEdge{Channel, micros()};
+    gEdgeHead.store(head + 1U, std::memory_order_release);
+  } else {
+    gEdgeOverflow.store(true, std::memory_order_relaxed);
+  }
+
+  if (gWakeTask != nullptr) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(gWakeTask, &woken);
+    if (woken == pdTRUE) {
+      portYIELD_FROM_ISR();
+    }
+  }
+}
+
+template <size_t... Channels>
+void attachButtonInterrupts(std::index_sequence<Channels...>) {
+  (attachInterrupt(digitalPinToInterrupt(kCueButtons[Channels]),
+                   onButtonEdge<static_cast<uint8_t>(Channels)>, CHANGE),
+   ...);
+}
+
+}  // namespace
+
+void initButtonInput(TaskHandle_t wakeTask) {
+  gWakeTask = wakeTask;
+  attachButtonInterrupts(std::make_index_sequence<kCueCount>{});
+}
+
+bool popButtonEdge(ButtonEdge &edge) {
+  const uint32_t tail = gEdgeTail.load(std::memory_order_relaxed);
+  if (tail == gEdgeHead.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  edge = gEdges[tail & (kButtonEdgeQueueSize - 1U)];
+  gEdgeTail.store(tail + 1U, std::memory_order_release);
+  return true;
+}
+
+bool hasButtonEdges() {
+  return gEdgeTail.load(std::memory_order_relaxed) != gEdgeHead.load(std::memory_order_acquire);
+}
+
+bool takeButtonOverflow() {
+  return gEdgeOverflow.exchange(false, std::memory_order_relaxed);
+}
+
+uint64_t readButtonLevels() {
+  const uint32_t low = REG_READ(GPIO_IN_REG);
+  const uint32_t high = REG_READ(GPIO_IN1_REG) & 0xFFU;  // GPIO32..39
+  return static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << 32);
+}
+
+}  // namespace stagecue
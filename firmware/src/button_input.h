@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace stagecue {
+
+struct ButtonEdge {
+  uint8_t channel = 0;
+  uint32_t atUs = 0;
+};
+
+// Attaches a CHANGE interrupt to every cue button. Each edge is time-stamped
+// into a ring buffer and `wakeTask` (may be null) is notified.
+void initButtonInput(TaskHandle_t wakeTask);
+
+// Consumer side of the edge ring; call from a single task only.
+bool popButtonEdge(ButtonEdge &edge);
+bool hasButtonEdges();
+
+// True (once) if edges were dropped because the ring was full.
+bool takeButtonOverflow();
+
+// Level of every GPIO (bit n = GPIO n) from one read of the input registers.
+uint64_t readButtonLevels();
+
+inline bool buttonLevel(uint64_t levels, uint8_t pin) {
+  return ((levels >> pin) & 1U) != 0U;
+}
+
+}  // namespace stagecue
@@ -2,6 +2,8 @@
 
 namespace stagecue {
 
-const char *const kDefaultCueTexts[kCueCount] = {"Cue 1", "Cue 2", "Cue 3"};
+void formatDefaultCueText(uint8_t index, char *buffer, size_t size) {
+  snprintf(buffer, size, "Cue %u", static_cast<unsigned>(index) + 1U);
+}
 
 }  // namespace stagecue
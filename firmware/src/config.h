@@ -2,6 +2,40 @@
 
 #include <Arduino.h>
 #include <stddef.h>
+#include <array>
+
+// Number of cue channels (LED + button + OLED). Override from the build flags,
+// e.g. -DSTAGECUE_CUE_COUNT=8, together with the pin lists below if needed.
+#ifndef STAGECUE_CUE_COUNT
+#define STAGECUE_CUE_COUNT 3
+#endif
+
+// Timers shared by auto-release and scheduled cue actions.
+#ifndef STAGECUE_TIMER_POOL_SIZE
+#define STAGECUE_TIMER_POOL_SIZE 64
+#endif
+
+#ifndef STAGECUE_CUE_LED_PINS
+#define STAGECUE_CUE_LED_PINS 25, 26, 27, 14, 13, 23, 19, 18
+#endif
+
+// Buttons are active low. The first five pins have internal pull-ups (GPIO5
+// and GPIO15 are strapping pins whose boot level is high, which an idle
+// button keeps). GPIO34-39 are input-only without pull-ups and need an
+// external 10k resistor to 3.3V. GPIO16/17 carry PSRAM on WROVER modules.
+#ifndef STAGECUE_CUE_BUTTON_PINS
+#ifdef BOARD_HAS_PSRAM
+#define STAGECUE_CUE_BUTTON_PINS 32, 33, 4, 5, 15, 34, 35, 36
+#else
+#define STAGECUE_CUE_BUTTON_PINS 32, 33, 4, 5, 15, 16, 17, 34
+#endif
+#endif
+
+// SSD1306 panels answer at 0x3C or 0x3D only, so more than two sit behind a
+// TCA9548A multiplexer, one panel per channel at the base address.
+#ifndef STAGECUE_OLED_MUX
+#define STAGECUE_OLED_MUX (STAGECUE_CUE_COUNT > 2)
+#endif
 
 namespace stagecue {
 
@@ -10,6 +44,63 @@ namespace stagecue {
 // ──────────────────────────────────────────────────────────────────────────────
 inline constexpr char kFallbackApSsid[] = "CueLight_AP";
 inline constexpr char kFallbackApPass[] = "12345678";
+// Saved networks, tried in priority order (most recently saved first).
+inline constexpr size_t kWifiMaxSavedNetworks = 4U;
+// Joining the cached BSSID/channel skips the scan; past this, fall back to
+// a normal connect.
+inline constexpr uint32_t kWifiFastConnectTimeoutMillis = 3000U;
+inline constexpr uint32_t kWifiConnectTimeoutMillis = 8000U;
+// Pause after every saved network failed, doubling per round up to the max.
+inline constexpr uint32_t kWifiBackoffBaseMillis = 500U;
+inline constexpr uint32_t kWifiBackoffMaxMillis = 30000U;
+// Without a station link for this long, the fallback AP comes up next to the
+// retries; once the link has held for kWifiApLingerMillis and no one is on
+// the portal, it goes away again.
+inline constexpr uint32_t kWifiApFallbackMillis = 15000U;
+inline constexpr uint32_t kWifiApLingerMillis = 60000U;
+// Below this RSSI a scan looks for a stronger access point of the same SSID,
+// which must beat the current one by the hysteresis to be worth the hop.
+inline constexpr int8_t kWifiRoamRssiThreshold = -72;
+inline constexpr uint8_t kWifiRoamHysteresisDb = 8U;
+inline constexpr uint32_t kWifiRoamCheckMillis = 2000U;
+inline constexpr uint32_t kWifiRoamScanIntervalMillis = 30000U;
+inline constexpr size_t kWifiScanCacheSize = 24U;
+// /scan serves cached results and only starts a new scan past this age.
+inline constexpr uint32_t kWifiScanMaxAgeMillis = 30000U;
+inline constexpr uint32_t kWifiScanPollMillis = 100U;
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Web server configuration
+// ──────────────────────────────────────────────────────────────────────────────
+inline constexpr size_t kMaxWebSocketClients = 8U;
+// A client that cannot accept frames for this long is disconnected; until
+// then only the newest state of each cue is kept for it.
+inline constexpr uint32_t kWsSlowClientTimeoutMillis = 5000U;
+// Recent state changes kept so a reconnecting client can catch up with a
+// delta; larger gaps fall back to a full snapshot.
+inline constexpr size_t kStateDeltaRingSize = 32U;
+// Upper bound on assets reported by /api/assets.
+inline constexpr size_t kMaxPackedAssets = 8U;
+// Scratch space for one element of a streamed JSON response; fits a fully
+// escaped cue label or SSID.
+inline constexpr size_t kJsonStreamRecordSize = 384U;
+// Message buffers come from fixed slab pools rather than the heap. An inbound
+// message that finds its pool empty is refused, not queued; an outbound frame
+// falls back to the heap. AsyncTCP handles one request at a time, so inbound
+// slots only cover overlap with the run loop.
+inline constexpr size_t kMaxIncomingMessageSize = 1024U;
+inline constexpr size_t kInboundBufferSlots = 2U;
+inline constexpr size_t kJsonDocumentSlots = 2U;
+inline constexpr size_t kOutboundFrameSlots = 3U;
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Peer fabric configuration
+// ──────────────────────────────────────────────────────────────────────────────
+inline constexpr uint8_t kFabricMulticastGroup[] = {239, 255, 67, 1};
+inline constexpr uint16_t kFabricPort = 4210U;
+// Also the worst-case time for a unit to recover a lost state datagram.
+inline constexpr uint32_t kFabricDigestIntervalMillis = 1000U;
+inline constexpr size_t kFabricMaxPeers = 8U;
 
 // ──────────────────────────────────────────────────────────────────────────────
 // Display configuration
@@ -17,17 +108,148 @@ inline constexpr char kFallbackApPass[] = "12345678";
 inline constexpr uint8_t kScreenWidth = 128;
 inline constexpr uint8_t kScreenHeight = 64;
 inline constexpr uint8_t kOledBaseAddress = 0x3C;
+inline constexpr size_t kOledMaxDirectPanels = 2U;
+inline constexpr bool kOledUseMux = STAGECUE_OLED_MUX;
+inline constexpr uint8_t kOledMuxAddress = 0x70;
+inline constexpr size_t kOledMuxChannels = 8U;
+inline constexpr uint32_t kDisplayI2cClockHz = 400000U;
+inline constexpr size_t kDisplayI2cChunkBytes = 32U;
+inline constexpr uint32_t kDisplayTaskStackSize = 4096U;
+inline constexpr UBaseType_t kDisplayTaskPriority = 1U;
+inline constexpr BaseType_t kDisplayTaskCore = 0;
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Boot configuration
+// ──────────────────────────────────────────────────────────────────────────────
+// Display and network bring-up run on these one-shot tasks so cue I/O is
+// live straight out of setup().
+inline constexpr uint32_t kBootDisplayTaskStackSize = 4096U;
+inline constexpr uint32_t kBootNetworkTaskStackSize = 8192U;
+inline constexpr UBaseType_t kBootTaskPriority = 1U;
+inline constexpr BaseType_t kBootTaskCore = 0;
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Run loop configuration
+// ──────────────────────────────────────────────────────────────────────────────
+// Cooperative tasks sharing the Arduino loop task, which the core pins to
+// CONFIG_ARDUINO_RUNNING_CORE (1); Wi-Fi, AsyncTCP and the display flush
+// task stay on core 0.
+inline constexpr size_t kCoopMaxTasks = 8U;
+inline constexpr uint32_t kRunLoopMaxSleepMillis = 50U;
+// Idle share and per-task stats are published for readers at this period.
+inline constexpr uint32_t kRunLoopStatsPeriodMillis = 1000U;
 
 // ──────────────────────────────────────────────────────────────────────────────
 // Cue configuration
 // ──────────────────────────────────────────────────────────────────────────────
-inline constexpr size_t kCueCount = 3U;
-inline constexpr uint8_t kCueLEDs[kCueCount] = {25, 26, 27};
-inline constexpr uint8_t kCueButtons[kCueCount] = {32, 33, 34};
+inline constexpr size_t kCueCount = STAGECUE_CUE_COUNT;
+// Eight channels use 16 GPIOs plus I2C, which is about what an ESP32 has
+// free, and fill one TCA9548A.
+static_assert(kCueCount > 0U && kCueCount <= 8U, "Cue count must be between 1 and 8");
+
+namespace detail {
+
+inline constexpr uint8_t kLedPinTable[] = {STAGECUE_CUE_LED_PINS};
+inline constexpr uint8_t kButtonPinTable[] = {STAGECUE_CUE_BUTTON_PINS};
+
+template <size_t Count, size_t TableSize>
+constexpr std::array<uint8_t, Count> selectCuePins(const uint8_t (&table)[TableSize]) {
+  static_assert(Count <= TableSize, "Pin list is shorter than kCueCount");
+  std::array<uint8_t, Count> pins{};
+  for (size_t i = 0; i < Count; ++i) {
+    pins[i] = table[i];
+  }
+  return pins;
+}
+
+}  // namespace detail
+
+inline constexpr std::array<uint8_t, kCueCount> kCueLEDs =
+    detail::selectCuePins<kCueCount>(detail::kLedPinTable);
+inline constexpr std::array<uint8_t, kCueCount> kCueButtons =
+    detail::selectCuePins<kCueCount>(detail::kButtonPinTable);
+
+// GPIO34-39 ignore INPUT_PULLUP; buttons there rely on external resistors.
+constexpr bool hasInternalPullUp(uint8_t pin) {
+  return pin < 34U;
+}
+
+constexpr bool isUsableButtonPin(uint8_t pin) {
+  const bool flash = pin >= 6U && pin <= 11U;
+  const bool uart = pin == 1U || pin == 3U;
+#ifdef BOARD_HAS_PSRAM
+  const bool psram = pin == 16U || pin == 17U;
+#else
+  const bool psram = false;
+#endif
+  return pin <= 39U && !flash && !uart && !psram;
+}
+
+namespace detail {
+
+constexpr bool allUsableButtonPins() {
+  for (uint8_t pin : kCueButtons) {
+    if (!isUsableButtonPin(pin)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace detail
+
+static_assert(detail::allUsableButtonPins(),
+              "A button pin is on flash, UART0 or (with BOARD_HAS_PSRAM) PSRAM");
+static_assert(kOledUseMux || kCueCount <= kOledMaxDirectPanels,
+              "More than two panels need STAGECUE_OLED_MUX");
+static_assert(!kOledUseMux || kCueCount <= kOledMuxChannels,
+              "A TCA9548A has eight channels");
 inline constexpr uint32_t kCueAutoReleaseMillis = 1500U;
 inline constexpr uint32_t kButtonDebounceMillis = 50U;
+inline constexpr size_t kButtonEdgeQueueSize = 32U;
+inline constexpr size_t kCueCommandQueueSize = 16U;
+// Enough operations to rename and trigger every cue in one batch; batches
+// wait in their own slots since they do not fit a queue entry.
+inline constexpr size_t kCueBatchMaxOps = 2U * kCueCount;
+inline constexpr size_t kCueBatchSlots = 2U;
+inline constexpr size_t kCueTextMaxLength = 48U;
+// Renames are written to flash once a label has been quiet this long, and
+// never later than kCueStoreMaxDelayMillis after the first pending change.
+inline constexpr uint32_t kCueStoreDebounceMillis = 2000U;
+inline constexpr uint32_t kCueStoreMaxDelayMillis = 10000U;
+// Triggers and releases armed for a device time, e.g. a console GO at T+250 ms.
+inline constexpr size_t kCueScheduleSlots = 8U;
+// Bounded by micros() wrapping every ~71 min.
+inline constexpr uint32_t kCueScheduleMaxAheadMillis = 1800000U;
+// A scheduled time further in the past than this is a clock error, not lag.
+inline constexpr uint32_t kCueScheduleMaxLateMillis = 1000U;
+inline constexpr size_t kTimerPoolSize = STAGECUE_TIMER_POOL_SIZE;
+static_assert(kTimerPoolSize >= kCueCount + kCueScheduleSlots,
+              "Every cue needs an auto-release timer, every schedule slot one more");
+
+// ──────────────────────────────────────────────────────────────────────────────
+// Show file configuration
+// ──────────────────────────────────────────────────────────────────────────────
+inline constexpr char kShowFilePath[] = "/show.txt";
+inline constexpr uint16_t kShowMaxCues = 4096U;
+inline constexpr size_t kShowLineMaxLength = 160U;
+inline constexpr size_t kShowReadChunkBytes = 256U;
+// /api/show/reload compiles on a one-shot task so the AsyncTCP task never
+// blocks on flash reads.
+inline constexpr uint32_t kShowReloadTaskStackSize = 8192U;
+
+// Writes the factory label ("Cue 1", "Cue 2", ...) for a channel.
+void formatDefaultCueText(uint8_t index, char *buffer, size_t size);
 
-extern const char *const kDefaultCueTexts[kCueCount];
+// ──────────────────────────────────────────────────────────────────────────────
+// Diagnostics
+// ──────────────────────────────────────────────────────────────────────────────
+inline constexpr size_t kLatencyWindowSize = 128U;
+// Most recent spans kept for /api/trace; a power of two so the ring index
+// survives the head counter wrapping.
+inline constexpr size_t kTraceRingSize = 256U;
+static_assert((kTraceRingSize & (kTraceRingSize - 1U)) == 0U, "Trace ring size must be a power of two");
+inline constexpr size_t kMetricsLineMaxLength = 160U;
 
 }  // namespace stagecue
 
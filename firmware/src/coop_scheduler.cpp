@@ -0,0 +1,139 @@
+#include "coop_scheduler.h"
+
+#include <algorithm>
+
+namespace stagecue {
+
+static_assert(kCoopMaxTasks <= 32U, "Wake mask holds 32 tasks");
+
+size_t CoopScheduler::add(const CoopTaskSpec &spec, uint32_t nowMs) {
+  if (count_ >= tasks_.size() || spec.run == nullptr) {
+    return kCoopMaxTasks;
+  }
+
+  Task &task = tasks_[count_];
+  task.spec = spec;
+  task.nextRunMs = nowMs + spec.periodMs;
+  task.stats = CoopTaskStats{};
+  task.stats.name = spec.name;
+  task.stats.priority = spec.priority;
+  return count_++;
+}
+
+void CoopScheduler::wake(size_t id) {
+  if (id >= count_) {
+    return;
+  }
+
+  // Keep the first wake's time; later ones before the task runs add nothing.
+  const uint32_t bit = 1UL << id;
+  if ((wokenMask_.load(std::memory_order_relaxed) & bit) == 0U) {
+    tasks_[id].wokenAtUs.store(clockUs_(), std::memory_order_relaxed);
+  }
+  wokenMask_.fetch_or(bit, std::memory_order_release);
+}
+
+bool CoopScheduler::isReady(Task &task, uint32_t nowMs, uint32_t nowUs,
+                            uint32_t &readySinceUs) {
+  bool ready = false;
+  uint32_t oldestAgeUs = 0;
+  const auto consider = [&](uint32_t sinceUs) {
+    const uint32_t ageUs = nowUs - sinceUs;
+    if (!ready || ageUs > oldestAgeUs) {
+      oldestAgeUs = ageUs;
+      readySinceUs = sinceUs;
+    }
+    ready = true;
+  };
+
+  const size_t id = static_cast<size_t>(&task - tasks_.data());
+  if ((wokenMask_.load(std::memory_order_acquire) & (1UL << id)) != 0U) {
+    consider(task.wokenAtUs.load(std::memory_order_relaxed));
+  }
+  if (task.spec.periodMs != 0U) {
+    const int32_t overdueMs = static_cast<int32_t>(nowMs - task.nextRunMs);
+    if (overdueMs >= 0) {
+      consider(nowUs - static_cast<uint32_t>(overdueMs) * 1000U);
+    }
+  }
+  if (task.spec.millisUntilDue != nullptr && task.spec.millisUntilDue(nowMs, 1U) == 0U) {
+    consider(task.dueKnown ? task.dueAtUs : nowUs);
+  }
+  return ready;
+}
+
+bool CoopScheduler::runNext(uint32_t nowMs) {
+  const uint32_t nowUs = clockUs_();
+  Task *next = nullptr;
+  uint32_t readySinceUs = nowUs;
+  for (size_t i = 0; i < count_; ++i) {
+    Task &task = tasks_[i];
+    if (next != nullptr && task.spec.priority >= next->spec.priority) {
+      continue;
+    }
+    uint32_t sinceUs = nowUs;
+    if (isReady(task, nowMs, nowUs, sinceUs)) {
+      next = &task;
+      readySinceUs = sinceUs;
+    }
+  }
+  if (next == nullptr) {
+    return false;
+  }
+
+  const size_t id = static_cast<size_t>(next - tasks_.data());
+  wokenMask_.fetch_and(~(1UL << id), std::memory_order_acq_rel);
+  next->dueKnown = false;
+  if (next->spec.periodMs != 0U) {
+    next->nextRunMs += next->spec.periodMs;
+    if (static_cast<int32_t>(nowMs - next->nextRunMs) >= 0) {
+      next->nextRunMs = nowMs + next->spec.periodMs;  // fell behind; skip the missed runs
+    }
+  }
+
+  const uint32_t startUs = clockUs_();
+  next->spec.run(nowMs);
+  const uint32_t runUs = clockUs_() - startUs;
+
+  CoopTaskStats &stats = next->stats;
+  ++stats.runs;
+  stats.runUs += runUs;
+  stats.maxRunUs = std::max(stats.maxRunUs, runUs);
+  stats.maxDispatchUs = std::max(stats.maxDispatchUs, startUs - readySinceUs);
+  return true;
+}
+
+uint32_t CoopScheduler::millisUntilNext(uint32_t nowMs, uint32_t limitMs) {
+  if (wokenMask_.load(std::memory_order_acquire) != 0U) {
+    return 0U;
+  }
+
+  const uint32_t nowUs = clockUs_();
+  uint32_t timeoutMs = limitMs;
+  for (size_t i = 0; i < count_; ++i) {
+    Task &task = tasks_[i];
+    uint32_t remainingMs = limitMs;
+    if (task.spec.periodMs != 0U) {
+      const int32_t untilRun = static_cast<int32_t>(task.nextRunMs - nowMs);
+      remainingMs = untilRun <= 0 ? 0U : std::min(remainingMs, static_cast<uint32_t>(untilRun));
+    }
+    if (task.spec.millisUntilDue != nullptr) {
+      const uint32_t untilDue = task.spec.millisUntilDue(nowMs, limitMs);
+      // Remember when a deadline was due so a late dispatch shows up in the
+      // stats; a deadline already reached keeps the time first predicted.
+      if (untilDue < limitMs && (untilDue != 0U || !task.dueKnown)) {
+        task.dueAtUs = nowUs + untilDue * 1000U;
+        task.dueKnown = true;
+      }
+      remainingMs = std::min(remainingMs, untilDue);
+    }
+    timeoutMs = std::min(timeoutMs, remainingMs);
+  }
+  return timeoutMs;
+}
+
+CoopTaskStats CoopScheduler::stats(size_t id) const {
+  return id < count_ ? tasks_[id].stats : CoopTaskStats{};
+}
+
+}  // namespace stagecue
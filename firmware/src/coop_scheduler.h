@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include <atomic>
+
+#include "config.h"
+
+namespace stagecue {
+
+struct CoopTaskSpec {
+  const char *name = "";
+  uint8_t priority = 0;  // lower runs first when several tasks are ready
+  // Runs the task every periodMs; 0 leaves it to `millisUntilDue` and wake().
+  uint32_t periodMs = 0;
+  void (*run)(uint32_t nowMs) = nullptr;
+  // Time until the task has work, capped at `limitMs`; 0 means ready now.
+  uint32_t (*millisUntilDue)(uint32_t nowMs, uint32_t limitMs) = nullptr;
+};
+
+struct CoopTaskStats {
+  const char *name = "";
+  uint8_t priority = 0;
+  uint32_t runs = 0;
+  uint64_t runUs = 0;
+  uint32_t maxRunUs = 0;
+  // Longest wait between a task becoming ready (woken, period elapsed or
+  // deadline reached) and it starting to run.
+  uint32_t maxDispatchUs = 0;
+};
+
+// Run-to-completion scheduler for the tasks that share the cue engine's
+// thread. Each pass runs the highest-priority ready task; between passes the
+// owner sleeps for millisUntilNext(). Only wake() is thread-safe.
+class CoopScheduler {
+ public:
+  using Clock = uint32_t (*)();  // microseconds, for run and dispatch times
+
+  explicit CoopScheduler(Clock clockUs) : clockUs_(clockUs) {}
+
+  CoopScheduler(const CoopScheduler &) = delete;
+  CoopScheduler &operator=(const CoopScheduler &) = delete;
+
+  // Returns the task id, or kCoopMaxTasks when the table is full.
+  size_t add(const CoopTaskSpec &spec, uint32_t nowMs);
+  // Marks a task ready from any task or core.
+  void wake(size_t id);
+  // Runs the highest-priority ready task; false when none was ready.
+  bool runNext(uint32_t nowMs);
+  // Time until some task is ready, capped at `limitMs`.
+  uint32_t millisUntilNext(uint32_t nowMs, uint32_t limitMs);
+
+  size_t size() const { return count_; }
+  CoopTaskStats stats(size_t id) const;
+
+ private:
+  struct Task {
+    CoopTaskSpec spec;
+    uint32_t nextRunMs = 0;   // periodic tasks
+    uint32_t dueAtUs = 0;     // when the pending deadline was expected
+    bool dueKnown = false;
+    std::atomic<uint32_t> wokenAtUs{0};
+    CoopTaskStats stats;
+  };
+
+  bool isReady(Task &task, uint32_t nowMs, uint32_t nowUs, uint32_t &readySinceUs);
+
+  Clock clockUs_;
+  std::array<Task, kCoopMaxTasks> tasks_{};
+  size_t count_ = 0;
+  std::atomic<uint32_t> wokenMask_{0};
+};
+
+}  // namespace stagecue
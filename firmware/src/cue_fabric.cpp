@@ -0,0 +1,353 @@
+#include "cue_fabric.h"
+
+#include <AsyncUDP.h>
+#include <WiFi.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#include "config.h"
+#include "cues.h"
+
+namespace stagecue {
+
+namespace {
+
+struct Replica {
+  bool active = false;
+  CueVersion version;
+};
+
+struct FabricCounters {
+  std::atomic<uint32_t> statesSent{0};
+  std::atomic<uint32_t> repairsSent{0};
+  std::atomic<uint32_t> digestsSent{0};
+  std::atomic<uint32_t> sendFailures{0};
+  std::atomic<uint32_t> received{0};
+  std::atomic<uint32_t> malformed{0};
+  std::atomic<uint32_t> applied{0};
+  std::atomic<uint32_t> stale{0};
+  std::atomic<uint32_t> rejected{0};
+};
+
+struct PeerSlot {
+  CueFabricPeer peer;
+  uint32_t lastSequence = 0;
+};
+
+AsyncUDP gUdp;
+std::atomic<bool> gRunning{false};
+uint32_t gNodeId = 0;
+// Lamport clock: bumped by local changes, pulled forward by every stamp seen.
+std::atomic<uint32_t> gClock{0};
+FabricCounters gCounters;
+
+// Written by the cue engine, read by the UDP task when it compares digests.
+std::array<Replica, kCueCount> gReplicas{};
+portMUX_TYPE gReplicaLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Cue engine only.
+uint32_t gAnnounceMask = 0;
+uint32_t gRepairMask = 0;
+uint32_t gNextDigestMs = 0;
+uint32_t gSendSequence = 0;
+
+// UDP task writes, /api/fabric reads.
+std::array<PeerSlot, kFabricMaxPeers> gPeers{};
+portMUX_TYPE gPeerLock = portMUX_INITIALIZER_UNLOCKED;
+
+static_assert(kCueCount <= kFabricMaxDigestEntries, "Digest holds at most 32 cues");
+
+void observeStamp(uint32_t stamp) {
+  uint32_t current = gClock.load(std::memory_order_relaxed);
+  while (stamp > current &&
+         !gClock.compare_exchange_weak(current, stamp, std::memory_order_relaxed)) {
+  }
+}
+
+Replica readReplica(uint8_t index) {
+  portENTER_CRITICAL(&gReplicaLock);
+  const Replica replica = gReplicas[index];
+  portEXIT_CRITICAL(&gReplicaLock);
+  return replica;
+}
+
+void writeReplica(uint8_t index, bool active, const CueVersion &version) {
+  portENTER_CRITICAL(&gReplicaLock);
+  gReplicas[index].active = active;
+  gReplicas[index].version = version;
+  portEXIT_CRITICAL(&gReplicaLock);
+}
+
+FabricHeader nextHeader(FabricMessage type) {
+  FabricHeader header;
+  header.type = type;
+  header.node = gNodeId;
+  header.sequence = ++gSendSequence;
+  return header;
+}
+
+bool sendDatagram(const uint8_t *data, size_t length) {
+  const IPAddress group(kFabricMulticastGroup[0], kFabricMulticastGroup[1],
+                        kFabricMulticastGroup[2], kFabricMulticastGroup[3]);
+  if (gUdp.writeTo(data, length, group, kFabricPort) != length) {
+    gCounters.sendFailures.fetch_add(1U, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void sendState(uint8_t index) {
+  const Replica replica = readReplica(index);
+  FabricCueState state;
+  state.cue = index;
+  state.active = replica.active;
+  state.version = replica.version;
+
+  uint8_t datagram[kFabricStateSize];
+  encodeFabricState(nextHeader(FabricMessage::kState), state, datagram);
+  sendDatagram(datagram, sizeof(datagram));
+}
+
+void sendDigest() {
+  std::array<FabricCueState, kCueCount> states;
+  for (size_t i = 0; i < kCueCount; ++i) {
+    const Replica replica = readReplica(static_cast<uint8_t>(i));
+    states[i].cue = static_cast<uint8_t>(i);
+    states[i].active = replica.active;
+    states[i].version = replica.version;
+  }
+
+  uint8_t datagram[kFabricMaxDatagramSize];
+  const size_t length =
+      encodeFabricDigest(nextHeader(FabricMessage::kDigest), states.data(), kCueCount, datagram);
+  if (sendDatagram(datagram, length)) {
+    gCounters.digestsSent.fetch_add(1U, std::memory_order_relaxed);
+  }
+}
+
+void trackPeer(const FabricHeader &header) {
+  const uint32_t now = millis();
+  portENTER_CRITICAL(&gPeerLock);
+  PeerSlot *slot = nullptr;
+  PeerSlot *oldest = &gPeers[0];
+  for (auto &candidate : gPeers) {
+    if (candidate.peer.node == header.node) {
+      slot = &candidate;
+      break;
+    }
+    if (candidate.peer.lastSeenMs < oldest->peer.lastSeenMs) {
+      oldest = &candidate;
+    }
+  }
+
+  if (slot == nullptr) {
+    // Unknown peer: take an empty slot, or evict the longest silent one.
+    slot = oldest;
+    *slot = PeerSlot{};
+    slot->peer.node = header.node;
+  } else {
+    const int32_t gap = static_cast<int32_t>(header.sequence - slot->lastSequence - 1U);
+    if (gap > 0) {
+      slot->peer.lost += static_cast<uint32_t>(gap);
+    }
+  }
+  slot->lastSequence = header.sequence;
+  slot->peer.lastSeenMs = now;
+  ++slot->peer.datagrams;
+  portEXIT_CRITICAL(&gPeerLock);
+}
+
+void submitPeerCommand(CueCommandType type, const FabricCueState &state) {
+  CueCommand command;
+  command.type = type;
+  command.index = state.cue;
+  command.active = state.active;
+  command.version = state.version;
+  command.requestedAtUs = micros();
+  if (!submitCueCommand(command)) {
+    gCounters.rejected.fetch_add(1U, std::memory_order_relaxed);
+  }
+}
+
+// Runs on the AsyncUDP task: decode, then hand anything that changes cue
+// state to the cue engine as a command.
+void handleDatagram(AsyncUDPPacket &packet) {
+  const uint8_t *data = packet.data();
+  const size_t length = packet.length();
+  FabricHeader header;
+  if (!decodeFabricHeader(data, length, header)) {
+    gCounters.malformed.fetch_add(1U, std::memory_order_relaxed);
+    return;
+  }
+  if (header.node == gNodeId) {
+    return;  // our own datagram, looped back by the group
+  }
+
+  gCounters.received.fetch_add(1U, std::memory_order_relaxed);
+  trackPeer(header);
+
+  if (header.type == FabricMessage::kState) {
+    FabricCueState state;
+    if (!decodeFabricState(data, length, state)) {
+      gCounters.malformed.fetch_add(1U, std::memory_order_relaxed);
+      return;
+    }
+    observeStamp(state.version.stamp);
+    if (state.cue < kCueCount) {
+      submitPeerCommand(CueCommandType::kPeerState, state);
+    }
+    return;
+  }
+
+  std::array<FabricCueState, kCueCount> states;
+  size_t count = 0;
+  if (!decodeFabricDigest(data, length, states.data(), states.size(), count)) {
+    gCounters.malformed.fetch_add(1U, std::memory_order_relaxed);
+    return;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    observeStamp(states[i].version.stamp);
+    const Replica local = readReplica(static_cast<uint8_t>(i));
+    if (isNewerVersion(states[i].version, local.version)) {
+      submitPeerCommand(CueCommandType::kPeerState, states[i]);
+    } else if (isNewerVersion(local.version, states[i].version)) {
+      submitPeerCommand(CueCommandType::kPeerAnnounce, states[i]);
+    }
+  }
+}
+
+}  // namespace
+
+bool startCueFabric() {
+  if (gRunning.load()) {
+    return true;
+  }
+  if (WiFi.status() != WL_CONNECTED) {
+    Serial.println(F("[Fabric] No station link, replication disabled"));
+    return false;
+  }
+
+  gNodeId = static_cast<uint32_t>(ESP.getEfuseMac() >> 16);
+  const IPAddress group(kFabricMulticastGroup[0], kFabricMulticastGroup[1],
+                        kFabricMulticastGroup[2], kFabricMulticastGroup[3]);
+  if (!gUdp.listenMulticast(group, kFabricPort)) {
+    Serial.println(F("[Fabric] Unable to join the multicast group"));
+    return false;
+  }
+  gUdp.onPacket(handleDatagram);
+  gRunning.store(true);
+  Serial.printf("[Fabric] Node %08lx on %s:%u\n", static_cast<unsigned long>(gNodeId),
+                group.toString().c_str(), static_cast<unsigned>(kFabricPort));
+  return true;
+}
+
+void noteLocalCueChange(uint8_t index, bool active) {
+  if (index >= kCueCount) {
+    return;
+  }
+
+  CueVersion version;
+  version.stamp = gClock.fetch_add(1U, std::memory_order_relaxed) + 1U;
+  version.node = gNodeId;
+  writeReplica(index, active, version);
+  gAnnounceMask |= 1UL << index;
+}
+
+bool acceptPeerCueState(uint8_t index, bool active, const CueVersion &version) {
+  bool newer = false;
+  if (index < kCueCount) {
+    // Compare and write under one lock so no other version lands in between.
+    portENTER_CRITICAL(&gReplicaLock);
+    newer = isNewerVersion(version, gReplicas[index].version);
+    if (newer) {
+      gReplicas[index].active = active;
+      gReplicas[index].version = version;
+    }
+    portEXIT_CRITICAL(&gReplicaLock);
+  }
+  if (!newer) {
+    gCounters.stale.fetch_add(1U, std::memory_order_relaxed);
+    return false;
+  }
+
+  gCounters.applied.fetch_add(1U, std::memory_order_relaxed);
+  return true;
+}
+
+void announceCueState(uint8_t index) {
+  if (index < kCueCount) {
+    gRepairMask |= 1UL << index;
+  }
+}
+
+void serviceCueFabric(uint32_t nowMs) {
+  if (!gRunning.load(std::memory_order_relaxed)) {
+    gAnnounceMask = 0;
+    gRepairMask = 0;
+    return;
+  }
+
+  const uint32_t repairs = gRepairMask & ~gAnnounceMask;
+  const uint32_t pending = gAnnounceMask | gRepairMask;
+  gAnnounceMask = 0;
+  gRepairMask = 0;
+  for (size_t i = 0; i < kCueCount; ++i) {
+    if ((pending & (1UL << i)) != 0U) {
+      sendState(static_cast<uint8_t>(i));
+      gCounters.statesSent.fetch_add(1U, std::memory_order_relaxed);
+    }
+  }
+  if (repairs != 0U) {
+    gCounters.repairsSent.fetch_add(static_cast<uint32_t>(__builtin_popcount(repairs)),
+                                    std::memory_order_relaxed);
+  }
+
+  if (static_cast<int32_t>(nowMs - gNextDigestMs) >= 0) {
+    sendDigest();
+    gNextDigestMs = nowMs + kFabricDigestIntervalMillis;
+  }
+}
+
+uint32_t millisUntilCueFabricService(uint32_t nowMs, uint32_t limitMs) {
+  if (!gRunning.load(std::memory_order_relaxed)) {
+    return limitMs;
+  }
+  if ((gAnnounceMask | gRepairMask) != 0U) {
+    return 0U;
+  }
+  const int32_t remaining = static_cast<int32_t>(gNextDigestMs - nowMs);
+  return remaining <= 0 ? 0U : std::min(limitMs, static_cast<uint32_t>(remaining));
+}
+
+CueFabricStats getCueFabricStats() {
+  CueFabricStats stats;
+  stats.running = gRunning.load(std::memory_order_relaxed);
+  stats.node = gNodeId;
+  stats.clock = gClock.load(std::memory_order_relaxed);
+  stats.statesSent = gCounters.statesSent.load(std::memory_order_relaxed);
+  stats.repairsSent = gCounters.repairsSent.load(std::memory_order_relaxed);
+  stats.digestsSent = gCounters.digestsSent.load(std::memory_order_relaxed);
+  stats.sendFailures = gCounters.sendFailures.load(std::memory_order_relaxed);
+  stats.received = gCounters.received.load(std::memory_order_relaxed);
+  stats.malformed = gCounters.malformed.load(std::memory_order_relaxed);
+  stats.applied = gCounters.applied.load(std::memory_order_relaxed);
+  stats.stale = gCounters.stale.load(std::memory_order_relaxed);
+  stats.rejected = gCounters.rejected.load(std::memory_order_relaxed);
+  return stats;
+}
+
+size_t copyCueFabricPeers(CueFabricPeer *peers, size_t capacity) {
+  size_t count = 0;
+  portENTER_CRITICAL(&gPeerLock);
+  for (const auto &slot : gPeers) {
+    if (slot.peer.node != 0U && count < capacity) {
+      peers[count++] = slot.peer;
+    }
+  }
+  portEXIT_CRITICAL(&gPeerLock);
+  return count;
+}
+
+}  // namespace stagecue
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "fabric_protocol.h"
+
+namespace stagecue {
+
+struct CueFabricPeer {
+  uint32_t node = 0;
+  uint32_t lastSeenMs = 0;
+  uint32_t datagrams = 0;
+  uint32_t lost = 0;  // gaps in the peer's datagram sequence
+};
+
+struct CueFabricStats {
+  bool running = false;
+  uint32_t node = 0;
+  uint32_t clock = 0;
+  uint32_t statesSent = 0;
+  uint32_t repairsSent = 0;  // states re-sent because a peer's digest was behind
+  uint32_t digestsSent = 0;
+  uint32_t sendFailures = 0;
+  uint32_t received = 0;
+  uint32_t malformed = 0;
+  uint32_t applied = 0;   // peer states newer than ours
+  uint32_t stale = 0;     // peer states we already had or superseded
+  uint32_t rejected = 0;  // peer updates dropped on a full command queue
+};
+
+// Replicates cue state between units on the same network. Every local
+// change goes out as one multicast datagram in the cue engine tick that
+// made it; a periodic digest lets units pull what they missed and push what
+// their peers missed. Conflicts resolve last-writer-wins on CueVersion.
+//
+// Joins the multicast group once the station link is up; false in access
+// point mode, where there are no peers to reach.
+bool startCueFabric();
+
+// Cue engine side; only call these from the cue engine task.
+void noteLocalCueChange(uint8_t index, bool active);
+// True when `version` is newer than what this unit has; the caller then
+// applies the state without replicating it again.
+bool acceptPeerCueState(uint8_t index, bool active, const CueVersion &version);
+void announceCueState(uint8_t index);
+void serviceCueFabric(uint32_t nowMs);
+// 0 while a change waits to be announced, else the time to the next digest.
+uint32_t millisUntilCueFabricService(uint32_t nowMs, uint32_t limitMs);
+
+CueFabricStats getCueFabricStats();
+size_t copyCueFabricPeers(CueFabricPeer *peers, size_t capacity);
+
+}  // namespace stagecue
@@ -0,0 +1,58 @@
+#include "cue_label.h"
+
+#include <string.h>
+
+namespace stagecue {
+
+namespace {
+
+inline bool isContinuationByte(char value) {
+  return (static_cast<uint8_t>(value) & 0xC0U) == 0x80U;
+}
+
+}  // namespace
+
+bool CueLabel::assign(const char *text) {
+  if (text == nullptr) {
+    clear();
+    return true;
+  }
+  return assign(text, strnlen(text, kCapacity + 1U));
+}
+
+bool CueLabel::assign(const char *text, size_t length) {
+  if (text == nullptr) {
+    clear();
+    return true;
+  }
+
+  const void *terminator = memchr(text, '\0', length);
+  if (terminator != nullptr) {
+    length = static_cast<size_t>(static_cast<const char *>(terminator) - text);
+  }
+
+  const bool truncated = length > kCapacity;
+  if (truncated) {
+    length = kCapacity;
+    // Back off to the lead byte of the sequence that straddles the limit.
+    while (length > 0U && isContinuationByte(text[length])) {
+      --length;
+    }
+  }
+
+  memcpy(data_, text, length);
+  data_[length] = '\0';
+  length_ = static_cast<uint8_t>(length);
+  return !truncated;
+}
+
+void CueLabel::clear() {
+  length_ = 0;
+  data_[0] = '\0';
+}
+
+bool CueLabel::operator==(const CueLabel &other) const {
+  return length_ == other.length_ && memcmp(data_, other.data_, length_) == 0;
+}
+
+}  // namespace stagecue
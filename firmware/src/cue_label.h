@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+namespace stagecue {
+
+// Inline, fixed-capacity UTF-8 cue label. Text longer than kCueTextMaxLength
+// bytes is cut on a code point boundary so a label never ends mid-sequence.
+class CueLabel {
+ public:
+  static constexpr size_t kCapacity = kCueTextMaxLength;
+
+  CueLabel() = default;
+  explicit CueLabel(const char *text) { assign(text); }
+
+  // Returns false when the text had to be truncated.
+  bool assign(const char *text);
+  bool assign(const char *text, size_t length);
+  void clear();
+
+  const char *c_str() const { return data_; }
+  size_t length() const { return length_; }
+  bool empty() const { return length_ == 0U; }
+
+  bool operator==(const CueLabel &other) const;
+  bool operator!=(const CueLabel &other) const { return !(*this == other); }
+
+ private:
+  uint8_t length_ = 0;
+  char data_[kCapacity + 1] = {};
+};
+
+static_assert(CueLabel::kCapacity <= UINT8_MAX, "CueLabel length must fit in a byte");
+
+}  // namespace stagecue
@@ -0,0 +1,221 @@
+#include "cue_store.h"
+
+#include <algorithm>
+#include <array>
+#include <esp_system.h>
+#include <nvs.h>
+
+#include "config.h"
+
+namespace stagecue {
+
+namespace {
+
+constexpr char kCueStoreNamespace[] = "cue_texts";
+
+struct StoredCue {
+  CueLabel staged;
+  CueLabel persisted;  // what flash holds, to skip no-op writes
+  bool dirty = false;
+};
+
+std::array<StoredCue, kCueCount> gStore{};
+nvs_handle_t gHandle = 0;
+bool gStoreReady = false;
+bool gFlushPending = false;
+uint32_t gFirstChangeMs = 0;
+uint32_t gLastChangeMs = 0;
+CueStoreStats gStats;
+portMUX_TYPE gStoreLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Keys are built into caller-owned buffers; the stores may be used from
+// the engine and from a shutdown handler at the same time.
+void formatKey(uint8_t index, char (&key)[8]) {
+  snprintf(key, sizeof(key), "cue%u", static_cast<unsigned>(index));
+}
+
+uint32_t flushDeadline() {
+  const uint32_t debounced = gLastChangeMs + kCueStoreDebounceMillis;
+  const uint32_t capped = gFirstChangeMs + kCueStoreMaxDelayMillis;
+  return static_cast<int32_t>(debounced - capped) < 0 ? debounced : capped;
+}
+
+// A label that did not reach flash is staged again and a new flush armed a
+// debounce window out, so a failing flash is not retried in a tight loop.
+// Call with gStoreLock held.
+void requeueCueText(uint8_t index, uint32_t now) {
+  gStore[index].persisted.clear();  // unknown now
+  gStore[index].dirty = true;
+  if (!gFlushPending) {
+    gFirstChangeMs = now;
+    gFlushPending = true;
+  }
+  gLastChangeMs = now;
+}
+
+void flushOnShutdown() {
+  flushCueStore();
+}
+
+}  // namespace
+
+bool initCueStore() {
+  if (gStoreReady) {
+    return true;
+  }
+
+  if (nvs_open(kCueStoreNamespace, NVS_READWRITE, &gHandle) != ESP_OK) {
+    Serial.println(F("[Store] Unable to open cue storage"));
+    return false;
+  }
+
+  gStoreReady = true;
+  esp_register_shutdown_handler(flushOnShutdown);
+  return true;
+}
+
+bool loadStoredCueText(uint8_t index, CueLabel &text) {
+  if (!gStoreReady || index >= kCueCount) {
+    return false;
+  }
+
+  char key[8];
+  formatKey(index, key);
+  char stored[CueLabel::kCapacity + 1];
+  size_t length = sizeof(stored);
+  if (nvs_get_str(gHandle, key, stored, &length) != ESP_OK) {
+    return false;
+  }
+
+  text.assign(stored);
+  portENTER_CRITICAL(&gStoreLock);
+  gStore[index].persisted = text;
+  gStore[index].staged = text;
+  portEXIT_CRITICAL(&gStoreLock);
+  return !text.empty();
+}
+
+void stageCueText(uint8_t index, const CueLabel &text) {
+  if (index >= kCueCount) {
+    return;
+  }
+
+  const uint32_t now = millis();
+  portENTER_CRITICAL(&gStoreLock);
+  auto &entry = gStore[index];
+  ++gStats.staged;
+  if (entry.dirty) {
+    ++gStats.coalesced;
+  }
+  entry.staged = text;
+  entry.dirty = true;
+  if (!gFlushPending) {
+    gFirstChangeMs = now;
+    gFlushPending = true;
+  }
+  gLastChangeMs = now;
+  portEXIT_CRITICAL(&gStoreLock);
+}
+
+void serviceCueStore(uint32_t nowMs) {
+  portENTER_CRITICAL(&gStoreLock);
+  const bool due = gFlushPending && static_cast<int32_t>(flushDeadline() - nowMs) <= 0;
+  portEXIT_CRITICAL(&gStoreLock);
+
+  if (due) {
+    flushCueStore();
+  }
+}
+
+uint32_t millisUntilCueStoreFlush(uint32_t nowMs, uint32_t limitMs) {
+  portENTER_CRITICAL(&gStoreLock);
+  const bool pending = gFlushPending;
+  const uint32_t deadline = flushDeadline();
+  portEXIT_CRITICAL(&gStoreLock);
+
+  if (!pending) {
+    return limitMs;
+  }
+  const int32_t remaining = static_cast<int32_t>(deadline - nowMs);
+  return remaining <= 0 ? 0U : std::min(limitMs, static_cast<uint32_t>(remaining));
+}
+
+void flushCueStore() {
+  if (!gStoreReady) {
+    return;
+  }
+
+  std::array<CueLabel, kCueCount> pending;
+  uint32_t pendingMask = 0;
+  uint32_t unchanged = 0;
+  portENTER_CRITICAL(&gStoreLock);
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    auto &entry = gStore[i];
+    if (!entry.dirty) {
+      continue;
+    }
+    entry.dirty = false;
+    if (entry.staged == entry.persisted) {
+      ++unchanged;
+      continue;
+    }
+    pending[i] = entry.staged;
+    entry.persisted = entry.staged;
+    pendingMask |= 1UL << i;
+  }
+  gFlushPending = false;
+  gStats.unchanged += unchanged;
+  portEXIT_CRITICAL(&gStoreLock);
+
+  if (pendingMask == 0U) {
+    return;
+  }
+
+  const uint32_t startUs = micros();
+  uint32_t written = 0;
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    if ((pendingMask & (1UL << i)) == 0U) {
+      continue;
+    }
+    char key[8];
+    formatKey(i, key);
+    if (nvs_set_str(gHandle, key, pending[i].c_str()) == ESP_OK) {
+      ++written;
+      continue;
+    }
+
+    Serial.printf("[Store] Unable to write %s\n", key);
+    pendingMask &= ~(1UL << i);
+    portENTER_CRITICAL(&gStoreLock);
+    requeueCueText(i, millis());
+    portEXIT_CRITICAL(&gStoreLock);
+  }
+  const bool committed = nvs_commit(gHandle) == ESP_OK;
+  if (!committed) {
+    Serial.println(F("[Store] Commit failed"));
+  }
+
+  const uint32_t now = millis();
+  portENTER_CRITICAL(&gStoreLock);
+  gStats.keysWritten += written;
+  if (committed) {
+    ++gStats.commits;
+  } else {
+    for (uint8_t i = 0; i < kCueCount; ++i) {
+      if ((pendingMask & (1UL << i)) != 0U) {
+        requeueCueText(i, now);
+      }
+    }
+  }
+  gStats.lastFlushUs = micros() - startUs;
+  portEXIT_CRITICAL(&gStoreLock);
+}
+
+CueStoreStats getCueStoreStats() {
+  portENTER_CRITICAL(&gStoreLock);
+  const CueStoreStats stats = gStats;
+  portEXIT_CRITICAL(&gStoreLock);
+  return stats;
+}
+
+}  // namespace stagecue
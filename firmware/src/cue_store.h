@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "cue_label.h"
+
+namespace stagecue {
+
+struct CueStoreStats {
+  uint32_t staged = 0;     // stageCueText() calls
+  uint32_t coalesced = 0;  // staged over a value that was still waiting
+  uint32_t unchanged = 0;  // flushed values identical to flash, not written
+  uint32_t keysWritten = 0;
+  uint32_t commits = 0;
+  uint32_t lastFlushUs = 0;
+};
+
+// Write-behind storage for cue labels. The cue engine stages the latest
+// label per cue; changes are written once the label has been quiet for
+// kCueStoreDebounceMillis (or at most kCueStoreMaxDelayMillis after the
+// first change) in a single NVS commit. A restart flushes what is left.
+bool initCueStore();
+bool loadStoredCueText(uint8_t index, CueLabel &text);
+void stageCueText(uint8_t index, const CueLabel &text);
+// Engine tick; flushes when the debounce window has passed.
+void serviceCueStore(uint32_t nowMs);
+// Milliseconds until serviceCueStore() has work, capped at `limitMs`.
+uint32_t millisUntilCueStoreFlush(uint32_t nowMs, uint32_t limitMs);
+void flushCueStore();
+CueStoreStats getCueStoreStats();
+
+}  // namespace stagecue
@@ -1,113 +1,573 @@
 #include "cues.h"
 
-#include <Preferences.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <utility>
 
+#include "boot_timeline.h"
+#include "button_input.h"
+#include "cue_fabric.h"
+#include "cue_store.h"
 #include "display_manager.h"
+#include "latency_stats.h"
+#include "mpsc_queue.h"
+#include "run_loop.h"
+#include "timer_wheel.h"
+#include "trace.h"
 #include "web_server.h"
 
 namespace stagecue {
 
 namespace {
 
-constexpr char kCuePreferencesNamespace[] = "cue_texts";
-
+// Owned by the cue engine (loop task). Other tasks read them through
+// getCueSnapshot(); writes and snapshots are serialized by gCueLock.
 std::array<CueState, kCueCount> gCueStates{};
+std::array<CueLabel, kCueCount> gCueTexts{};
+portMUX_TYPE gCueLock = portMUX_INITIALIZER_UNLOCKED;
+
+MpscQueue<CueCommand, kCueCommandQueueSize> gCommandQueue;
+std::atomic<uint32_t> gCommandsSubmitted{0};
+std::atomic<uint32_t> gCommandsRejected{0};
+std::atomic<uint32_t> gCommandQueueHighWater{0};
+std::atomic<uint32_t> gCommandsApplied{0};
+
+// Triggers applied this tick whose broadcast has not gone out yet.
+uint32_t gBroadcastPendingMask = 0;
+std::array<uint32_t, kCueCount> gBroadcastRequestedAtUs{};
+
 std::array<bool, kCueCount> gLastButtonState{};
 std::array<uint32_t, kCueCount> gLastButtonChangeMs{};
-Preferences gCuePreferences;
-bool gPreferencesReady = false;
+// Channels with an edge that has not been accepted or discarded yet, and the
+// ISR timestamp of the first edge of that burst.
+uint32_t gPendingButtonMask = 0;
+std::array<uint32_t, kCueCount> gPendingEdgeUs{};
+
+// Deadlines for auto-release (and other timed cue actions) live in the wheel,
+// so the loop only pays for timers that actually fire.
+TimerWheel gTimers;
+std::array<TimerId, kCueCount> gAutoReleaseTimers{};
+TimerWheelStats gTimerStats;
+portMUX_TYPE gTimerStatsLock = portMUX_INITIALIZER_UNLOCKED;
+
+// The show is engine-owned; other tasks hand a new one over through
+// gIncomingShow and read the published gShowStatus.
+std::unique_ptr<CompiledShow> gShow;
+uint16_t gShowCursor = 0;
+std::atomic<CompiledShow *> gIncomingShow{nullptr};
+ShowStatus gShowStatus;
+portMUX_TYPE gShowLock = portMUX_INITIALIZER_UNLOCKED;
+
+struct ScheduledCue {
+  bool used = false;
+  bool active = false;
+  bool hasText = false;
+  uint8_t index = 0;
+  uint32_t fireAtUs = 0;
+  CueLabel text;
+};
+std::array<ScheduledCue, kCueScheduleSlots> gScheduled{};
+std::atomic<uint32_t> gSchedulesArmed{0};
+std::atomic<uint32_t> gSchedulesFired{0};
+std::atomic<uint32_t> gSchedulesRejected{0};
+
+// Batches are too large for a queue entry, so they wait in these slots and
+// the kBatch command only carries the slot number.
+std::array<CueBatch, kCueBatchSlots> gBatchSlots{};
+std::array<std::atomic<bool>, kCueBatchSlots> gBatchSlotBusy{};
+
+// LED edges collected while a batch applies, then written with one store
+// per GPIO bank and direction so every LED changes in the same cycle.
+struct LedBatch {
+  bool open = false;
+  uint32_t setLow = 0;
+  uint32_t clearLow = 0;
+  uint32_t setHigh = 0;
+  uint32_t clearHigh = 0;
+  uint32_t requestedAtUs = 0;
+  uint8_t triggered = 0;
+};
+LedBatch gLedBatch;
+
+
+static_assert(kCueCount <= 32U, "Pending button mask holds 32 channels");
+
+void writeCueLed(uint8_t index, bool on) {
+  if (!gLedBatch.open) {
+    digitalWrite(kCueLEDs[index], on ? HIGH : LOW);
+    return;
+  }
 
-inline const char *cuePreferenceKey(uint8_t index) {
-  static char key[8];
-  snprintf(key, sizeof(key), "cue%u", static_cast<unsigned>(index));
-  return key;
+  // The last write to a pin wins, as it would outside a batch: W1TS goes after
+  // W1TC, so a bit left in both masks would keep the LED lit.
+  const uint8_t pin = kCueLEDs[index];
+  uint32_t &setMask = pin < 32U ? gLedBatch.setLow : gLedBatch.setHigh;
+  uint32_t &clearMask = pin < 32U ? gLedBatch.clearLow : gLedBatch.clearHigh;
+  const uint32_t bit = 1UL << (pin < 32U ? pin : pin - 32U);
+  (on ? clearMask : setMask) &= ~bit;
+  (on ? setMask : clearMask) |= bit;
 }
 
-void persistCueText(uint8_t index, const String &text) {
-  if (!gPreferencesReady) {
-    return;
+void commitLedBatch() {
+  REG_WRITE(GPIO_OUT_W1TC_REG, gLedBatch.clearLow);
+  REG_WRITE(GPIO_OUT1_W1TC_REG, gLedBatch.clearHigh);
+  REG_WRITE(GPIO_OUT_W1TS_REG, gLedBatch.setLow);
+  REG_WRITE(GPIO_OUT1_W1TS_REG, gLedBatch.setHigh);
+
+  const uint32_t elapsedUs = micros() - gLedBatch.requestedAtUs;
+  for (uint8_t i = 0; i < gLedBatch.triggered; ++i) {
+    recordLatency(LatencyProbe::kTriggerToLed, elapsedUs);
   }
-  gCuePreferences.putString(cuePreferenceKey(index), text);
+  gLedBatch = LedBatch{};
 }
 
-void applyCueState(uint8_t index, bool active) {
+// `replicate` is false for states that came from a peer or from boot defaults,
+// which must not be announced as new changes. `textChanged` folds a new label
+// into the same notification.
+void applyCueState(uint8_t index, bool active, uint32_t requestedAtUs, bool replicate = true,
+                   bool textChanged = false) {
   if (index >= kCueCount) {
     return;
   }
 
   if (gCueStates[index].active == active && gCueStates[index].lastChangeMs != 0U) {
+    if (textChanged) {
+      notifyCueState(index, true);
+    }
     return;
   }
 
+  STAGECUE_TRACE_SCOPE(kApplyCueState, index);
+  portENTER_CRITICAL(&gCueLock);
   gCueStates[index].active = active;
   gCueStates[index].lastChangeMs = millis();
-  digitalWrite(kCueLEDs[index], active ? HIGH : LOW);
-  notifyCueState(index, gCueTexts[index], active);
+  portEXIT_CRITICAL(&gCueLock);
+  if (!active) {
+    gTimers.cancel(gAutoReleaseTimers[index]);
+    gAutoReleaseTimers[index] = kInvalidTimer;
+  }
+  writeCueLed(index, active);
+  if (active && gLedBatch.open) {
+    ++gLedBatch.triggered;  // recorded once the batch reaches the pins
+  } else if (active) {
+    recordLatency(LatencyProbe::kTriggerToLed, micros() - requestedAtUs);
+  }
+  if (replicate) {
+    noteLocalCueChange(index, active);
+  }
+
+  notifyCueState(index, textChanged);
+  if (active) {
+    gBroadcastPendingMask |= 1UL << index;
+    gBroadcastRequestedAtUs[index] = requestedAtUs;
+  }
+}
+
+void flushBroadcasts() {
+  flushCueBroadcasts();
+  if (gBroadcastPendingMask == 0U) {
+    return;
+  }
+
+  const uint32_t nowUs = micros();
+  for (size_t i = 0; i < kCueCount; ++i) {
+    if ((gBroadcastPendingMask & (1UL << i)) != 0U) {
+      recordLatency(LatencyProbe::kTriggerToBroadcast, nowUs - gBroadcastRequestedAtUs[i]);
+    }
+  }
+  gBroadcastPendingMask = 0;
 }
 
-void ensureButtonDefaults(uint8_t index) {
-  gLastButtonState[index] = digitalRead(kCueButtons[index]) == HIGH;
+void autoReleaseExpired(uint32_t index) {
+  gAutoReleaseTimers[index] = kInvalidTimer;
+  applyCueState(static_cast<uint8_t>(index), false, micros());
+}
+
+void activateCue(uint8_t index, uint32_t requestedAtUs, bool fromButton,
+                 uint32_t autoReleaseMs = kCueAutoReleaseMillis, bool textChanged = false) {
+  markBootPhase(BootPhase::kFirstTrigger);
+  updateDisplay(index, gCueTexts[index]);
+  if (fromButton) {
+    recordLatency(LatencyProbe::kButtonToDisplay, micros() - requestedAtUs);
+  }
+  applyCueState(index, true, requestedAtUs, true, textChanged);
+
+  // Re-triggering restarts the countdown.
+  gTimers.cancel(gAutoReleaseTimers[index]);
+  gAutoReleaseTimers[index] =
+      autoReleaseMs > 0U ? gTimers.schedule(millis() + autoReleaseMs, autoReleaseExpired, index)
+                         : kInvalidTimer;
+}
+
+// The unit that made the change owns its auto-release and replicates the
+// release, so a peer state never arms a local timer.
+void applyPeerCueState(const CueCommand &command) {
+  if (!acceptPeerCueState(command.index, command.active, command.version)) {
+    return;
+  }
+
+  gTimers.cancel(gAutoReleaseTimers[command.index]);
+  gAutoReleaseTimers[command.index] = kInvalidTimer;
+  if (command.active) {
+    updateDisplay(command.index, gCueTexts[command.index]);
+  }
+  applyCueState(command.index, command.active, command.requestedAtUs, false);
+}
+
+void fireScheduledCue(uint32_t slot) {
+  ScheduledCue &entry = gScheduled[slot];
+  entry.used = false;
+  const uint32_t nowUs = micros();
+  const int32_t latenessUs = static_cast<int32_t>(nowUs - entry.fireAtUs);
+  recordLatency(LatencyProbe::kScheduleLateness,
+                static_cast<uint32_t>(std::max<int32_t>(latenessUs, 0)));
+  gSchedulesFired.fetch_add(1U, std::memory_order_relaxed);
+
+  if (!entry.active) {
+    applyCueState(entry.index, false, nowUs);
+    return;
+  }
+  if (entry.hasText) {
+    setCueText(entry.index, entry.text.c_str());
+  }
+  activateCue(entry.index, nowUs, false, kCueAutoReleaseMillis, entry.hasText);
+}
+
+// The wheel ticks in milliseconds, so a schedule fires within a millisecond
+// (plus loop wake-up) after its deadline; the lateness probe records by how much.
+void armScheduledCue(const CueCommand &command) {
+  for (size_t slot = 0; slot < gScheduled.size(); ++slot) {
+    ScheduledCue &entry = gScheduled[slot];
+    if (entry.used) {
+      continue;
+    }
+
+    const int32_t remainingUs = static_cast<int32_t>(command.fireAtUs - micros());
+    // Round up: firing a little late beats firing early.
+    const uint32_t deadlineMs =
+        millis() + (remainingUs > 0 ? (static_cast<uint32_t>(remainingUs) + 999U) / 1000U : 0U);
+    if (gTimers.schedule(deadlineMs, fireScheduledCue, static_cast<uint32_t>(slot)) ==
+        kInvalidTimer) {
+      break;
+    }
+
+    entry.used = true;
+    entry.active = command.active;
+    entry.hasText = command.hasText;
+    entry.index = command.index;
+    entry.fireAtUs = command.fireAtUs;
+    entry.text = command.text;
+    gSchedulesArmed.fetch_add(1U, std::memory_order_relaxed);
+    return;
+  }
+  gSchedulesRejected.fetch_add(1U, std::memory_order_relaxed);
+}
+
+void storeCueText(uint8_t index, const char *text) {
+  portENTER_CRITICAL(&gCueLock);
+  gCueTexts[index].assign(text);
+  portEXIT_CRITICAL(&gCueLock);
+}
+
+void assignDefaultCueText(uint8_t index) {
+  char text[CueLabel::kCapacity + 1];
+  formatDefaultCueText(index, text, sizeof(text));
+  storeCueText(index, text);
+}
+
+void publishShowStatus() {
+  ShowStatus status;
+  if (gShow) {
+    status.loaded = true;
+    status.count = gShow->count;
+    status.position = gShowCursor;
+    status.textBytes = gShow->textBytes;
+    status.loadUs = gShow->loadUs;
+    status.skippedLines = gShow->skippedLines;
+  }
+  portENTER_CRITICAL(&gShowLock);
+  gShowStatus = status;
+  portEXIT_CRITICAL(&gShowLock);
+}
+
+void adoptIncomingShow() {
+  CompiledShow *incoming = gIncomingShow.exchange(nullptr);
+  if (incoming == nullptr) {
+    return;
+  }
+  gShow.reset(incoming);
+  gShowCursor = 0;
+  publishShowStatus();
+  Serial.printf("[Show] Loaded %u cues (%lu text bytes) in %lu us\n", gShow->count,
+                static_cast<unsigned long>(gShow->textBytes),
+                static_cast<unsigned long>(gShow->loadUs));
+}
+
+void fireShowCue(uint16_t position, uint32_t requestedAtUs) {
+  const ShowCueRecord &record = gShow->records[position];
+  setCueText(record.channel, gShow->text(record), false);
+  activateCue(record.channel, requestedAtUs, false, record.autoReleaseMs, true);
+  gShowCursor = static_cast<uint16_t>(position + 1U);
+  recordLatency(LatencyProbe::kShowGo, micros() - requestedAtUs);
+}
+
+// GO, BACK and JUMP only move a cursor over the compiled records.
+void applyShowCommand(const CueCommand &command) {
+  if (!gShow) {
+    return;
+  }
+
+  switch (command.type) {
+    case CueCommandType::kShowGo:
+      if (gShowCursor < gShow->count) {
+        fireShowCue(gShowCursor, command.requestedAtUs);
+      }
+      break;
+
+    case CueCommandType::kShowBack:
+      if (gShowCursor >= 2U) {
+        fireShowCue(static_cast<uint16_t>(gShowCursor - 2U), command.requestedAtUs);
+      } else {
+        gShowCursor = 0;
+      }
+      break;
+
+    case CueCommandType::kShowJump:
+      gShowCursor = std::min(command.showPosition, gShow->count);
+      break;
+
+    default:
+      return;
+  }
+  publishShowStatus();
+}
+
+void applyCueBatch(const CueCommand &command);
+
+void applyCueOperation(const CueCommand &command) {
+  switch (command.type) {
+    case CueCommandType::kTrigger:
+      if (command.hasText) {
+        setCueText(command.index, command.text.c_str());
+      }
+      activateCue(command.index, command.requestedAtUs, command.fromButton,
+                  kCueAutoReleaseMillis, command.hasText);
+      break;
+
+    case CueCommandType::kRelease:
+      applyCueState(command.index, false, command.requestedAtUs);
+      break;
+
+    case CueCommandType::kRename:
+      setCueText(command.index, command.text.c_str());
+      notifyCueState(command.index, true);
+      break;
+
+    case CueCommandType::kRefreshDisplays:
+      for (uint8_t i = 0; i < kCueCount; ++i) {
+        updateDisplay(i, gCueTexts[i]);
+      }
+      break;
+
+    case CueCommandType::kShowGo:
+    case CueCommandType::kShowBack:
+    case CueCommandType::kShowJump:
+      applyShowCommand(command);
+      break;
+
+    case CueCommandType::kPeerState:
+      applyPeerCueState(command);
+      break;
+
+    case CueCommandType::kPeerAnnounce:
+      announceCueState(command.index);
+      break;
+
+    case CueCommandType::kBatch:
+      applyCueBatch(command);
+      break;
+
+    case CueCommandType::kSchedule:
+      armScheduledCue(command);
+      break;
+  }
+}
+
+void applyCueCommand(const CueCommand &command) {
+  if (command.index >= kCueCount) {
+    return;
+  }
+
+  applyCueOperation(command);
+  gCommandsApplied.fetch_add(1U, std::memory_order_relaxed);
+}
+
+void applyCueBatch(const CueCommand &command) {
+  if (command.batchSlot >= kCueBatchSlots) {
+    return;
+  }
+
+  const uint32_t startUs = micros();
+  const CueBatch &batch = gBatchSlots[command.batchSlot];
+  gLedBatch.open = true;
+  gLedBatch.requestedAtUs = command.requestedAtUs;
+  for (size_t i = 0; i < batch.count; ++i) {
+    const CueBatchOp &op = batch.ops[i];
+    if (op.index >= kCueCount ||
+        (op.type != CueCommandType::kTrigger && op.type != CueCommandType::kRelease &&
+         op.type != CueCommandType::kRename)) {
+      continue;
+    }
+    CueCommand single;
+    single.type = op.type;
+    single.index = op.index;
+    single.hasText = op.hasText;
+    single.text = op.text;
+    single.requestedAtUs = command.requestedAtUs;
+    applyCueOperation(single);
+  }
+  commitLedBatch();
+  gBatchSlotBusy[command.batchSlot].store(false, std::memory_order_release);
+  recordLatency(LatencyProbe::kBatchApply, micros() - startUs);
+}
+
+// Input sources running on the engine task fall back to applying directly
+// when the queue is full, so a physical button is never dropped.
+void submitLocalCueCommand(const CueCommand &command) {
+  if (!gCommandQueue.push(command)) {
+    applyCueCommand(command);
+  }
+}
+
+void ensureButtonDefaults(uint8_t index, uint64_t levels) {
+  gLastButtonState[index] = buttonLevel(levels, kCueButtons[index]);
   gLastButtonChangeMs[index] = millis();
 }
 
+void drainButtonEdges() {
+  ButtonEdge edge;
+  while (popButtonEdge(edge)) {
+    STAGECUE_TRACE_SINCE(kButtonEdge, edge.atUs, edge.channel);
+    const uint32_t bit = 1UL << edge.channel;
+    if ((gPendingButtonMask & bit) == 0U) {
+      gPendingEdgeUs[edge.channel] = edge.atUs;
+      gPendingButtonMask |= bit;
+    }
+  }
+
+  if (takeButtonOverflow()) {
+    // Edges were lost: re-examine every channel against the live levels.
+    const uint32_t nowUs = micros();
+    for (size_t i = 0; i < kCueCount; ++i) {
+      if ((gPendingButtonMask & (1UL << i)) == 0U) {
+        gPendingEdgeUs[i] = nowUs;
+      }
+    }
+    gPendingButtonMask = kCueCount >= 32U ? UINT32_MAX : (1UL << kCueCount) - 1U;
+  }
+}
+
+// One instantiation per channel: pins and table offsets are constants, so the
+// scan below unrolls into straight-line code for any kCueCount. Edges are
+// accepted on the leading edge once the channel has been stable for the
+// debounce window; an edge inside the window is re-checked when it closes.
+template <uint8_t Index>
+void serviceCueChannel(uint32_t now, uint64_t levels) {
+  constexpr uint32_t kChannelBit = 1UL << Index;
+
+  if ((gPendingButtonMask & kChannelBit) != 0U) {
+    const bool currentLevel = buttonLevel(levels, kCueButtons[Index]);
+    if (currentLevel == gLastButtonState[Index]) {
+      gPendingButtonMask &= ~kChannelBit;
+    } else if (now - gLastButtonChangeMs[Index] >= kButtonDebounceMillis) {
+      gPendingButtonMask &= ~kChannelBit;
+      gLastButtonState[Index] = currentLevel;
+      gLastButtonChangeMs[Index] = now;
+
+      CueCommand command;
+      command.index = Index;
+      command.fromButton = true;
+      command.requestedAtUs = micros();
+      if (!currentLevel) {  // button pressed (active low)
+        recordLatency(LatencyProbe::kPressToTrigger,
+                      command.requestedAtUs - gPendingEdgeUs[Index]);
+        command.type = CueCommandType::kTrigger;
+        submitLocalCueCommand(command);
+      } else if (gCueStates[Index].active) {  // button released
+        command.type = CueCommandType::kRelease;
+        submitLocalCueCommand(command);
+      }
+    }
+  }
+}
+
+template <size_t... Indices>
+void serviceCueChannels(uint32_t now, uint64_t levels, std::index_sequence<Indices...>) {
+  (serviceCueChannel<static_cast<uint8_t>(Indices)>(now, levels), ...);
+}
+
 }  // namespace
 
-std::array<String, kCueCount> gCueTexts{};
+uint32_t millisUntilCueDeadline(uint32_t now, uint32_t limitMs) {
+  if (hasButtonEdges()) {
+    return 0U;
+  }
+
+  uint32_t timeoutMs = limitMs;
+  const auto clampTo = [&timeoutMs, now](uint32_t deadline) {
+    const int32_t remaining = static_cast<int32_t>(deadline - now);
+    timeoutMs = remaining <= 0 ? 0U : std::min(timeoutMs, static_cast<uint32_t>(remaining));
+  };
+
+  for (size_t i = 0; i < kCueCount; ++i) {
+    if ((gPendingButtonMask & (1UL << i)) != 0U) {
+      clampTo(gLastButtonChangeMs[i] + kButtonDebounceMillis);
+    }
+  }
+  return gTimers.millisUntilNext(now, timeoutMs);
+}
 
 void initCues() {
   for (size_t i = 0; i < kCueCount; ++i) {
     pinMode(kCueLEDs[i], OUTPUT);
     digitalWrite(kCueLEDs[i], LOW);
-    pinMode(kCueButtons[i], INPUT_PULLUP);
+    pinMode(kCueButtons[i], hasInternalPullUp(kCueButtons[i]) ? INPUT_PULLUP : INPUT);
   }
+  const uint64_t levels = readButtonLevels();
 
-  if (gCuePreferences.begin(kCuePreferencesNamespace, false)) {
-    gPreferencesReady = true;
-  } else {
-    Serial.println(F("[Cues] Unable to open preferences storage"));
-  }
+  initCueStore();
 
   for (size_t i = 0; i < kCueCount; ++i) {
-    if (gPreferencesReady && gCuePreferences.isKey(cuePreferenceKey(i))) {
-      gCueTexts[i] = gCuePreferences.getString(cuePreferenceKey(i));
-    } else {
-      gCueTexts[i] = kDefaultCueTexts[i];
+    if (!loadStoredCueText(static_cast<uint8_t>(i), gCueTexts[i])) {
+      assignDefaultCueText(static_cast<uint8_t>(i));
     }
 
-    ensureButtonDefaults(i);
+    ensureButtonDefaults(static_cast<uint8_t>(i), levels);
     updateDisplay(static_cast<uint8_t>(i), gCueTexts[i]);
-    applyCueState(static_cast<uint8_t>(i), false);
+    applyCueState(static_cast<uint8_t>(i), false, micros(), false);
   }
+
+  initButtonInput(getRunLoopTaskHandle());
+  markBootPhase(BootPhase::kCuesLive);
 }
 
 void updateCues() {
-  const uint32_t now = millis();
-
-  for (uint8_t i = 0; i < kCueCount; ++i) {
-    const bool currentLevel = digitalRead(kCueButtons[i]) == HIGH;
-
-    if (currentLevel != gLastButtonState[i]) {
-      if (now - gLastButtonChangeMs[i] >= kButtonDebounceMillis) {
-        gLastButtonState[i] = currentLevel;
-        gLastButtonChangeMs[i] = now;
-
-        if (!currentLevel) {  // button pressed (active low)
-          triggerCue(i);
-        } else {  // button released
-          if (gCueStates[i].active) {
-            releaseCue(i);
-          }
-        }
-      }
-    }
-
-    if (gCueStates[i].active &&
-        kCueAutoReleaseMillis > 0U &&
-        now - gCueStates[i].lastChangeMs >= kCueAutoReleaseMillis) {
-      releaseCue(i);
-    }
+  adoptIncomingShow();
+  drainButtonEdges();
+  const uint64_t levels = gPendingButtonMask != 0U ? readButtonLevels() : 0U;
+  serviceCueChannels(millis(), levels, std::make_index_sequence<kCueCount>{});
+
+  CueCommand command;
+  while (gCommandQueue.pop(command)) {
+    applyCueCommand(command);
   }
+  gTimers.advance(millis());
+  portENTER_CRITICAL(&gTimerStatsLock);
+  gTimerStats = gTimers.stats();
+  portEXIT_CRITICAL(&gTimerStatsLock);
+
+  flushBroadcasts();
 }
 
 void triggerCue(uint8_t index) {
@@ -115,8 +575,7 @@ void triggerCue(uint8_t index) {
     return;
   }
 
-  updateDisplay(index, gCueTexts[index]);
-  applyCueState(index, true);
+  activateCue(index, micros(), false);
 }
 
 void releaseCue(uint8_t index) {
@@ -124,33 +583,195 @@ void releaseCue(uint8_t index) {
     return;
   }
 
-  applyCueState(index, false);
+  applyCueState(index, false, micros());
 }
 
-void setCueText(uint8_t index, const String &text, bool persist) {
+void setCueText(uint8_t index, const char *text, bool persist) {
   if (index >= kCueCount) {
     return;
   }
 
-  if (text.length() > 0) {
-    gCueTexts[index] = text;
+  if (text != nullptr && text[0] != '\0') {
+    storeCueText(index, text);
   } else {
-    gCueTexts[index] = kDefaultCueTexts[index];
+    assignDefaultCueText(index);
   }
 
+  invalidateDisplayCache(index);
   updateDisplay(index, gCueTexts[index]);
 
   if (persist) {
-    persistCueText(index, gCueTexts[index]);
+    stageCueText(index, gCueTexts[index]);
+  }
+}
+
+bool submitCueCommand(const CueCommand &command) {
+  if (command.index >= kCueCount) {
+    return false;
+  }
+
+  if (!gCommandQueue.push(command)) {
+    gCommandsRejected.fetch_add(1U, std::memory_order_relaxed);
+    return false;
+  }
+  gCommandsSubmitted.fetch_add(1U, std::memory_order_relaxed);
+
+  const uint32_t depth = static_cast<uint32_t>(gCommandQueue.sizeApprox());
+  uint32_t highWater = gCommandQueueHighWater.load(std::memory_order_relaxed);
+  while (depth > highWater &&
+         !gCommandQueueHighWater.compare_exchange_weak(highWater, depth,
+                                                       std::memory_order_relaxed)) {
   }
+
+  wakeRunLoopTask(RunLoopTask::kCueIo);
+  return true;
+}
+
+bool requestCueTrigger(uint8_t index, const char *text) {
+  CueCommand command;
+  command.type = CueCommandType::kTrigger;
+  command.index = index;
+  command.requestedAtUs = micros();
+  if (text != nullptr) {
+    command.hasText = true;
+    command.text.assign(text);
+  }
+  return submitCueCommand(command);
+}
+
+bool requestCueRelease(uint8_t index) {
+  CueCommand command;
+  command.type = CueCommandType::kRelease;
+  command.index = index;
+  command.requestedAtUs = micros();
+  return submitCueCommand(command);
+}
+
+bool requestCueRename(uint8_t index, const char *text) {
+  CueCommand command;
+  command.type = CueCommandType::kRename;
+  command.index = index;
+  command.hasText = true;
+  command.requestedAtUs = micros();
+  command.text.assign(text);
+  return submitCueCommand(command);
 }
 
-const CueState &getCueState(uint8_t index) {
-  static CueState invalidState{};
+bool requestCueDisplayRefresh() {
+  CueCommand command;
+  command.type = CueCommandType::kRefreshDisplays;
+  command.requestedAtUs = micros();
+  return submitCueCommand(command);
+}
+
+bool submitCueBatch(const CueBatch &batch) {
+  for (size_t slot = 0; slot < kCueBatchSlots; ++slot) {
+    bool expected = false;
+    if (!gBatchSlotBusy[slot].compare_exchange_strong(expected, true,
+                                                      std::memory_order_acquire)) {
+      continue;
+    }
+
+    gBatchSlots[slot] = batch;
+    CueCommand command;
+    command.type = CueCommandType::kBatch;
+    command.batchSlot = static_cast<uint8_t>(slot);
+    command.requestedAtUs = micros();
+    if (submitCueCommand(command)) {
+      return true;
+    }
+    gBatchSlotBusy[slot].store(false, std::memory_order_release);
+    return false;
+  }
+
+  gCommandsRejected.fetch_add(1U, std::memory_order_relaxed);
+  return false;
+}
+
+bool requestCueSchedule(uint8_t index, bool active, uint32_t fireAtUs, const char *text) {
+  CueCommand command;
+  command.type = CueCommandType::kSchedule;
+  command.index = index;
+  command.active = active;
+  command.fireAtUs = fireAtUs;
+  command.requestedAtUs = micros();
+  if (text != nullptr && text[0] != '\0') {
+    command.hasText = true;
+    command.text.assign(text);
+  }
+  return submitCueCommand(command);
+}
+
+bool requestShowGo() {
+  CueCommand command;
+  command.type = CueCommandType::kShowGo;
+  command.requestedAtUs = micros();
+  return submitCueCommand(command);
+}
+
+bool requestShowBack() {
+  CueCommand command;
+  command.type = CueCommandType::kShowBack;
+  command.requestedAtUs = micros();
+  return submitCueCommand(command);
+}
+
+bool requestShowJump(uint16_t position) {
+  CueCommand command;
+  command.type = CueCommandType::kShowJump;
+  command.showPosition = position;
+  command.requestedAtUs = micros();
+  return submitCueCommand(command);
+}
+
+void installShow(std::unique_ptr<CompiledShow> show) {
+  // A show that was installed but never adopted is simply replaced.
+  delete gIncomingShow.exchange(show.release());
+  wakeRunLoopTask(RunLoopTask::kCueIo);
+}
+
+ShowStatus getShowStatus() {
+  portENTER_CRITICAL(&gShowLock);
+  const ShowStatus status = gShowStatus;
+  portEXIT_CRITICAL(&gShowLock);
+  return status;
+}
+
+CueSnapshot getCueSnapshot(uint8_t index) {
+  CueSnapshot snapshot;
   if (index >= kCueCount) {
-    return invalidState;
+    return snapshot;
   }
-  return gCueStates[index];
+
+  portENTER_CRITICAL(&gCueLock);
+  snapshot.state = gCueStates[index];
+  snapshot.text = gCueTexts[index];
+  portEXIT_CRITICAL(&gCueLock);
+  return snapshot;
+}
+
+TimerWheelStats getCueTimerStats() {
+  portENTER_CRITICAL(&gTimerStatsLock);
+  const TimerWheelStats stats = gTimerStats;
+  portEXIT_CRITICAL(&gTimerStatsLock);
+  return stats;
+}
+
+CueCommandStats getCueCommandStats() {
+  CueCommandStats stats;
+  stats.submitted = gCommandsSubmitted.load(std::memory_order_relaxed);
+  stats.rejected = gCommandsRejected.load(std::memory_order_relaxed);
+  stats.applied = gCommandsApplied.load(std::memory_order_relaxed);
+  stats.highWater = gCommandQueueHighWater.load(std::memory_order_relaxed);
+  return stats;
+}
+
+CueScheduleStats getCueScheduleStats() {
+  CueScheduleStats stats;
+  stats.armed = gSchedulesArmed.load(std::memory_order_relaxed);
+  stats.fired = gSchedulesFired.load(std::memory_order_relaxed);
+  stats.rejected = gSchedulesRejected.load(std::memory_order_relaxed);
+  return stats;
 }
 
 }  // namespace stagecue
@@ -2,8 +2,13 @@
 
 #include <Arduino.h>
 #include <array>
+#include <memory>
 
 #include "config.h"
+#include "cue_label.h"
+#include "fabric_protocol.h"
+#include "show.h"
+#include "timer_wheel.h"
 
 namespace stagecue {
 
@@ -12,14 +17,114 @@ struct CueState {
   uint32_t lastChangeMs = 0;
 };
 
-extern std::array<String, kCueCount> gCueTexts;
+// Consistent copy of one cue, safe to take from any task.
+struct CueSnapshot {
+  CueState state;
+  CueLabel text;
+};
+
+enum class CueCommandType : uint8_t {
+  kTrigger,
+  kRelease,
+  kRename,
+  kRefreshDisplays,  // index unused; redraws every label
+  kShowGo,           // fire the standby show cue and advance
+  kShowBack,         // step back one cue and re-fire it
+  kShowJump,         // put `showPosition` in standby without firing
+  kPeerState,        // another unit changed the cue to `active` at `version`
+  kPeerAnnounce,     // another unit is behind on this cue; re-send ours
+  kBatch,            // apply batch slot `batchSlot` in one tick
+  kSchedule,         // trigger (`active`) or release at device time `fireAtUs`
+};
+
+struct CueCommand {
+  CueCommandType type = CueCommandType::kTrigger;
+  uint8_t index = 0;
+  bool hasText = false;
+  bool fromButton = false;
+  bool active = false;
+  uint8_t batchSlot = 0;
+  uint16_t showPosition = 0;
+  uint32_t requestedAtUs = 0;
+  uint32_t fireAtUs = 0;  // micros() domain
+  CueVersion version;
+  CueLabel text;
+};
+
+// One trigger, release or rename inside a CueBatch.
+struct CueBatchOp {
+  CueCommandType type = CueCommandType::kTrigger;
+  uint8_t index = 0;
+  bool hasText = false;
+  CueLabel text;
+};
+
+// Operations the cue engine applies together in one tick: LED edges are
+// written at once and clients get a single coalesced update.
+struct CueBatch {
+  size_t count = 0;
+  std::array<CueBatchOp, kCueBatchMaxOps> ops;
+};
+
+struct ShowStatus {
+  bool loaded = false;
+  uint16_t count = 0;
+  uint16_t position = 0;  // index of the cue the next GO fires
+  uint32_t textBytes = 0;
+  uint32_t loadUs = 0;
+  uint32_t skippedLines = 0;
+};
+
+struct CueScheduleStats {
+  uint32_t armed = 0;
+  uint32_t fired = 0;
+  uint32_t rejected = 0;  // no free schedule slot or timer
+};
+
+struct CueCommandStats {
+  uint32_t submitted = 0;
+  uint32_t rejected = 0;
+  uint32_t applied = 0;
+  uint32_t highWater = 0;
+};
 
 void initCues();
+// One cue engine tick; runs as the run loop's cue I/O task.
 void updateCues();
+// Time until updateCues() has work: a button edge, a debounce window closing
+// or a timer expiring. Queued commands wake the task directly.
+uint32_t millisUntilCueDeadline(uint32_t nowMs, uint32_t limitMs);
+
+// Thread-safe entry points. Commands are applied in order by the cue engine
+// (the loop task); false means the queue was full and nothing was queued.
+bool submitCueCommand(const CueCommand &command);
+bool requestCueTrigger(uint8_t index, const char *text = nullptr);
+bool requestCueRelease(uint8_t index);
+bool requestCueRename(uint8_t index, const char *text);
+// Called once the displays come up after the cue engine is already live.
+bool requestCueDisplayRefresh();
+// False when every batch slot is still in use or the queue is full.
+bool submitCueBatch(const CueBatch &batch);
+// Fires a trigger or release when micros() reaches `fireAtUs`. A full set of
+// schedule slots is only detected by the engine and shows in the stats.
+bool requestCueSchedule(uint8_t index, bool active, uint32_t fireAtUs,
+                        const char *text = nullptr);
+bool requestShowGo();
+bool requestShowBack();
+bool requestShowJump(uint16_t position);
+// Hands a compiled show to the cue engine, which adopts it on its next tick
+// and puts the first cue in standby.
+void installShow(std::unique_ptr<CompiledShow> show);
+ShowStatus getShowStatus();
+CueSnapshot getCueSnapshot(uint8_t index);
+CueCommandStats getCueCommandStats();
+CueScheduleStats getCueScheduleStats();
+// As of the last cue engine tick.
+TimerWheelStats getCueTimerStats();
+
+// Direct mutations; only call these from the cue engine task.
 void triggerCue(uint8_t index);
 void releaseCue(uint8_t index);
-void setCueText(uint8_t index, const String &text, bool persist = true);
-const CueState &getCueState(uint8_t index);
+void setCueText(uint8_t index, const char *text, bool persist = true);
 
 }  // namespace stagecue
-
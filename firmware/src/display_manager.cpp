@@ -4,22 +4,210 @@
 #include <Adafruit_SSD1306.h>
 #include <Wire.h>
 #include <array>
+#include <atomic>
+#include <utility>
 
 #include "config.h"
+#include "latency_stats.h"
+#include "trace.h"
 
 namespace stagecue {
 
 namespace {
 
-static_assert(kCueCount == 3, "Display array initialisers must match cue count");
+constexpr size_t kPageCount = kScreenHeight / 8U;
+constexpr size_t kFrameBytes = static_cast<size_t>(kScreenWidth) * kPageCount;
+constexpr uint8_t kCommandControlByte = 0x00;
+constexpr uint8_t kDataControlByte = 0x40;
+constexpr uint8_t kLabelTextSize = 1;
+constexpr uint16_t kLabelTextColor = SSD1306_WHITE;
 
-std::array<Adafruit_SSD1306, kCueCount> gDisplays = {
-    Adafruit_SSD1306(kScreenWidth, kScreenHeight, &Wire, -1),
-    Adafruit_SSD1306(kScreenWidth, kScreenHeight, &Wire, -1),
-    Adafruit_SSD1306(kScreenWidth, kScreenHeight, &Wire, -1),
-};
+using Frame = std::array<uint8_t, kFrameBytes>;
+
+template <size_t... Indices>
+std::array<Adafruit_SSD1306, sizeof...(Indices)> makeDisplays(std::index_sequence<Indices...>) {
+  return {((void)Indices, Adafruit_SSD1306(kScreenWidth, kScreenHeight, &Wire, -1))...};
+}
+
+std::array<Adafruit_SSD1306, kCueCount> gDisplays =
+    makeDisplays(std::make_index_sequence<kCueCount>{});
 
 std::array<bool, kCueCount> gDisplayReady{};
+// initDisplay() may run on a boot task while the cue engine is already live;
+// the engine only touches the panels once this is published.
+std::atomic<bool> gDisplaysOnline{false};
+
+// Frames handed over by updateDisplay() wait in gPendingFrames until the
+// flush task diffs them against gSentFrames, i.e. what the panel holds.
+std::array<Frame, kCueCount> gPendingFrames{};
+std::array<Frame, kCueCount> gSentFrames{};
+std::array<bool, kCueCount> gPendingDirty{};
+std::array<bool, kCueCount> gPanelUnknown{};
+std::array<DisplayFlushStats, kCueCount> gFlushStats{};
+
+// Rasterized label per cue, keyed by text and style so that re-triggering an
+// unchanged label skips Adafruit_GFX layout entirely. The key only narrows
+// the lookup; a hit also compares the label itself.
+struct LabelCache {
+  bool valid = false;
+  uint32_t key = 0;
+  CueLabel label;
+  Frame frame{};
+};
+
+// Owned by the cue engine task. The switch may be flipped from the web
+// server, so it only raises gLabelCacheReset and the engine drops the
+// entries on its next render.
+std::array<LabelCache, kCueCount> gLabelCache{};
+std::atomic<bool> gLabelCacheEnabled{true};
+std::atomic<bool> gLabelCacheReset{false};
+portMUX_TYPE gFrameLock = portMUX_INITIALIZER_UNLOCKED;
+TaskHandle_t gFlushTask = nullptr;
+
+// Bus owned by the boot display task during init, then by the flush task.
+constexpr uint8_t kNoMuxChannel = 0xFF;
+uint8_t gMuxChannel = kNoMuxChannel;
+
+// Routes the bus to panel `index` and returns the address it answers at.
+uint8_t selectPanel(uint8_t index) {
+  if (!kOledUseMux) {
+    return static_cast<uint8_t>(kOledBaseAddress + index);
+  }
+  if (gMuxChannel != index) {
+    Wire.beginTransmission(kOledMuxAddress);
+    Wire.write(static_cast<uint8_t>(1U << index));
+    Wire.endTransmission();
+    gMuxChannel = index;
+  }
+  return kOledBaseAddress;
+}
+
+uint32_t sendCommands(uint8_t address, const uint8_t *commands, size_t count) {
+  Wire.beginTransmission(address);
+  Wire.write(kCommandControlByte);
+  Wire.write(commands, count);
+  Wire.endTransmission();
+  return static_cast<uint32_t>(count + 2U);  // address + control + commands
+}
+
+uint32_t sendData(uint8_t address, const uint8_t *data, size_t count) {
+  uint32_t bytes = 0;
+  while (count > 0U) {
+    const size_t chunk = count < kDisplayI2cChunkBytes ? count : kDisplayI2cChunkBytes;
+    Wire.beginTransmission(address);
+    Wire.write(kDataControlByte);
+    Wire.write(data, chunk);
+    Wire.endTransmission();
+    bytes += static_cast<uint32_t>(chunk + 2U);
+    data += chunk;
+    count -= chunk;
+  }
+  return bytes;
+}
+
+// Pushes only the column span that changed on each SSD1306 page.
+uint32_t flushFrame(uint8_t index, const Frame &frame) {
+  const uint8_t address = selectPanel(index);
+  Frame &sent = gSentFrames[index];
+  const bool fullPush = gPanelUnknown[index];
+  uint32_t bytes = 0;
+
+  for (size_t page = 0; page < kPageCount; ++page) {
+    const size_t offset = page * kScreenWidth;
+    size_t first = 0;
+    size_t last = kScreenWidth;
+
+    if (!fullPush) {
+      while (first < kScreenWidth && frame[offset + first] == sent[offset + first]) {
+        ++first;
+      }
+      if (first == kScreenWidth) {
+        continue;
+      }
+      while (last > first && frame[offset + last - 1U] == sent[offset + last - 1U]) {
+        --last;
+      }
+    }
+
+    const uint8_t window[] = {
+        SSD1306_PAGEADDR, static_cast<uint8_t>(page), static_cast<uint8_t>(page),
+        SSD1306_COLUMNADDR, static_cast<uint8_t>(first), static_cast<uint8_t>(last - 1U),
+    };
+    bytes += sendCommands(address, window, sizeof(window));
+    bytes += sendData(address, &frame[offset + first], last - first);
+  }
+
+  sent = frame;
+  gPanelUnknown[index] = false;
+  return bytes;
+}
+
+void flushTask(void *) {
+  Wire.setClock(kDisplayI2cClockHz);
+  Frame working;
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    for (uint8_t i = 0; i < kCueCount; ++i) {
+      portENTER_CRITICAL(&gFrameLock);
+      const bool dirty = gPendingDirty[i];
+      if (dirty) {
+        working = gPendingFrames[i];
+        gPendingDirty[i] = false;
+      }
+      portEXIT_CRITICAL(&gFrameLock);
+
+      if (!dirty) {
+        continue;
+      }
+
+      const uint32_t flushStartUs = micros();
+      const uint32_t bytes = flushFrame(i, working);
+      STAGECUE_TRACE_SINCE(kDisplayFlush, flushStartUs, bytes);
+      portENTER_CRITICAL(&gFrameLock);
+      auto &stats = gFlushStats[i];
+      ++stats.updates;
+      stats.bytesPushed += bytes;
+      stats.lastUpdateBytes = bytes;
+      portEXIT_CRITICAL(&gFrameLock);
+    }
+  }
+}
+
+uint32_t labelKey(const CueLabel &text) {
+  uint32_t hash = 2166136261U;  // FNV-1a
+  const auto mix = [&hash](uint8_t byte) {
+    hash ^= byte;
+    hash *= 16777619U;
+  };
+  const char *chars = text.c_str();
+  for (size_t i = 0; i < text.length(); ++i) {
+    mix(static_cast<uint8_t>(chars[i]));
+  }
+  mix(kLabelTextSize);
+  mix(static_cast<uint8_t>(kLabelTextColor));
+  return hash;
+}
+
+void rasterizeLabel(Adafruit_SSD1306 &display, const CueLabel &text) {
+  display.clearDisplay();
+  display.setTextSize(kLabelTextSize);
+  display.setTextColor(kLabelTextColor);
+  display.setCursor(0, 0);
+  display.println(text.c_str());
+}
+
+void submitFrame(uint8_t index, const uint8_t *buffer) {
+  portENTER_CRITICAL(&gFrameLock);
+  memcpy(gPendingFrames[index].data(), buffer, kFrameBytes);
+  gPendingDirty[index] = true;
+  portEXIT_CRITICAL(&gFrameLock);
+
+  if (gFlushTask != nullptr) {
+    xTaskNotifyGive(gFlushTask);
+  }
+}
 
 }  // namespace
 
@@ -27,46 +215,116 @@ bool initDisplay() {
   Wire.begin();
 
   bool allReady = true;
+  std::array<bool, kCueCount> ready{};
   for (uint8_t i = 0; i < kCueCount; ++i) {
-    const uint8_t address = static_cast<uint8_t>(kOledBaseAddress + i);
+    const uint8_t address = selectPanel(i);
     if (!gDisplays[i].begin(SSD1306_SWITCHCAPVCC, address)) {
       Serial.print(F("[Display] Failed to init OLED at 0x"));
       Serial.println(address, HEX);
-      gDisplayReady[i] = false;
       allReady = false;
       continue;
     }
 
-    gDisplayReady[i] = true;
-    clearDisplay(i);
+    ready[i] = true;
+    gPanelUnknown[i] = true;
+  }
+
+  if (gFlushTask == nullptr &&
+      xTaskCreatePinnedToCore(flushTask, "oled_flush", kDisplayTaskStackSize, nullptr,
+                              kDisplayTaskPriority, &gFlushTask,
+                              kDisplayTaskCore) != pdPASS) {
+    Serial.println(F("[Display] Unable to start flush task"));
+    gFlushTask = nullptr;
+    return false;
   }
 
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    if (ready[i]) {
+      gDisplays[i].clearDisplay();
+      submitFrame(i, gDisplays[i].getBuffer());
+    }
+  }
+
+  gDisplayReady = ready;
+  gDisplaysOnline.store(true, std::memory_order_release);
   return allReady;
 }
 
-void updateDisplay(uint8_t index, const String &text) {
-  if (index >= gDisplays.size() || !gDisplayReady[index]) {
+void updateDisplay(uint8_t index, const CueLabel &text) {
+  if (!isDisplayReady(index)) {
     return;
   }
 
+  const uint32_t startUs = micros();
   auto &display = gDisplays[index];
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
-  display.setCursor(0, 0);
-  display.println(text);
-  display.display();
+  if (gLabelCacheReset.exchange(false, std::memory_order_acq_rel)) {
+    for (auto &cache : gLabelCache) {
+      cache.valid = false;
+    }
+  }
+  if (!gLabelCacheEnabled.load(std::memory_order_relaxed)) {
+    rasterizeLabel(display, text);
+    submitFrame(index, display.getBuffer());
+    recordLatency(LatencyProbe::kDisplayRender, micros() - startUs);
+    STAGECUE_TRACE_SINCE(kDisplayRender, startUs, index);
+    return;
+  }
+
+  auto &cache = gLabelCache[index];
+  const uint32_t key = labelKey(text);
+  if (!cache.valid || cache.key != key || cache.label != text) {
+    rasterizeLabel(display, text);
+    memcpy(cache.frame.data(), display.getBuffer(), kFrameBytes);
+    cache.key = key;
+    cache.label = text;
+    cache.valid = true;
+  }
+
+  submitFrame(index, cache.frame.data());
+  recordLatency(LatencyProbe::kDisplayRender, micros() - startUs);
+  STAGECUE_TRACE_SINCE(kDisplayRender, startUs, index);
 }
 
 void clearDisplay(uint8_t index) {
-  if (index >= gDisplays.size() || !gDisplayReady[index]) {
+  if (!isDisplayReady(index)) {
     return;
   }
 
-  auto &display = gDisplays[index];
-  display.clearDisplay();
-  display.display();
+  gDisplays[index].clearDisplay();
+  submitFrame(index, gDisplays[index].getBuffer());
 }
 
-}  // namespace stagecue
+void invalidateDisplayCache(uint8_t index) {
+  if (index >= gLabelCache.size()) {
+    return;
+  }
+  gLabelCache[index].valid = false;
+}
+
+void setDisplayCacheEnabled(bool enabled) {
+  gLabelCacheEnabled.store(enabled, std::memory_order_relaxed);
+  gLabelCacheReset.store(true, std::memory_order_release);
+}
 
+bool isDisplayCacheEnabled() {
+  return gLabelCacheEnabled.load(std::memory_order_relaxed);
+}
+
+DisplayFlushStats getDisplayFlushStats(uint8_t index) {
+  DisplayFlushStats stats;
+  if (index >= gDisplays.size()) {
+    return stats;
+  }
+
+  portENTER_CRITICAL(&gFrameLock);
+  stats = gFlushStats[index];
+  portEXIT_CRITICAL(&gFrameLock);
+  return stats;
+}
+
+bool isDisplayReady(uint8_t index) {
+  return index < gDisplays.size() && gDisplaysOnline.load(std::memory_order_acquire) &&
+         gDisplayReady[index];
+}
+
+}  // namespace stagecue
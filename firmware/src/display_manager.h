@@ -2,11 +2,25 @@
 
 #include <Arduino.h>
 
+#include "cue_label.h"
+
 namespace stagecue {
 
+struct DisplayFlushStats {
+  uint32_t updates = 0;
+  uint32_t bytesPushed = 0;
+  uint32_t lastUpdateBytes = 0;
+};
+
 bool initDisplay();
-void updateDisplay(uint8_t index, const String &text);
+void updateDisplay(uint8_t index, const CueLabel &text);
 void clearDisplay(uint8_t index);
+void invalidateDisplayCache(uint8_t index);
+// Thread-safe; cached labels are dropped on the cue engine's next render.
+void setDisplayCacheEnabled(bool enabled);
+bool isDisplayCacheEnabled();
+DisplayFlushStats getDisplayFlushStats(uint8_t index);
+bool isDisplayReady(uint8_t index);
 
 }  // namespace stagecue
 
@@ -0,0 +1,115 @@
+#include "fabric_protocol.h"
+
+namespace stagecue {
+
+namespace {
+
+void putU32(uint8_t *out, uint32_t value) {
+  out[0] = static_cast<uint8_t>(value);
+  out[1] = static_cast<uint8_t>(value >> 8);
+  out[2] = static_cast<uint8_t>(value >> 16);
+  out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+uint32_t getU32(const uint8_t *data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+void putHeader(const FabricHeader &header, uint8_t *out) {
+  out[0] = 'S';
+  out[1] = 'F';
+  out[2] = kFabricProtocolVersion;
+  out[3] = static_cast<uint8_t>(header.type);
+  putU32(out + 4, header.node);
+  putU32(out + 8, header.sequence);
+}
+
+}  // namespace
+
+size_t encodeFabricState(const FabricHeader &header, const FabricCueState &state, uint8_t *out) {
+  putHeader(header, out);
+  uint8_t *body = out + kFabricHeaderSize;
+  body[0] = state.cue;
+  body[1] = state.active ? 1U : 0U;
+  putU32(body + 2, state.version.stamp);
+  putU32(body + 6, state.version.node);
+  return kFabricStateSize;
+}
+
+size_t encodeFabricDigest(const FabricHeader &header, const FabricCueState *states, size_t count,
+                          uint8_t *out) {
+  if (count > kFabricMaxDigestEntries) {
+    count = kFabricMaxDigestEntries;
+  }
+
+  putHeader(header, out);
+  uint8_t *body = out + kFabricHeaderSize;
+  *body++ = static_cast<uint8_t>(count);
+  for (size_t i = 0; i < count; ++i) {
+    body[0] = states[i].active ? 1U : 0U;
+    putU32(body + 1, states[i].version.stamp);
+    putU32(body + 5, states[i].version.node);
+    body += kFabricDigestEntrySize;
+  }
+  return static_cast<size_t>(body - out);
+}
+
+bool decodeFabricHeader(const uint8_t *data, size_t len, FabricHeader &header) {
+  if (data == nullptr || len < kFabricHeaderSize || data[0] != 'S' || data[1] != 'F' ||
+      data[2] != kFabricProtocolVersion) {
+    return false;
+  }
+
+  switch (static_cast<FabricMessage>(data[3])) {
+    case FabricMessage::kState:
+    case FabricMessage::kDigest:
+      break;
+    default:
+      return false;
+  }
+
+  header.type = static_cast<FabricMessage>(data[3]);
+  header.node = getU32(data + 4);
+  header.sequence = getU32(data + 8);
+  return true;
+}
+
+bool decodeFabricState(const uint8_t *data, size_t len, FabricCueState &state) {
+  if (len != kFabricStateSize) {
+    return false;
+  }
+
+  const uint8_t *body = data + kFabricHeaderSize;
+  state.cue = body[0];
+  state.active = body[1] != 0U;
+  state.version.stamp = getU32(body + 2);
+  state.version.node = getU32(body + 6);
+  return true;
+}
+
+bool decodeFabricDigest(const uint8_t *data, size_t len, FabricCueState *states, size_t capacity,
+                        size_t &count) {
+  if (len < kFabricHeaderSize + 1U) {
+    return false;
+  }
+
+  const uint8_t *body = data + kFabricHeaderSize;
+  const size_t entries = body[0];
+  if (len != kFabricHeaderSize + 1U + entries * kFabricDigestEntrySize) {
+    return false;
+  }
+
+  ++body;
+  count = entries < capacity ? entries : capacity;
+  for (size_t i = 0; i < count; ++i) {
+    states[i].cue = static_cast<uint8_t>(i);
+    states[i].active = body[0] != 0U;
+    states[i].version.stamp = getU32(body + 1);
+    states[i].version.node = getU32(body + 5);
+    body += kFabricDigestEntrySize;
+  }
+  return true;
+}
+
+}  // namespace stagecue
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace stagecue {
+
+// Datagrams exchanged between StageCue units over UDP multicast. Every
+// datagram starts with a 12-byte header (little endian):
+//
+//   bytes 0-1   magic 'S' 'F'
+//   byte 2      protocol version
+//   byte 3      message type
+//   bytes 4-7   sender node id
+//   bytes 8-11  sender datagram sequence (gaps count as lost datagrams)
+//
+// A state message carries one cue; a digest carries the version of every cue
+// the sender has, so receivers can pull what they missed and push what the
+// sender missed:
+//
+//   state   cue, active, stamp (4), origin node (4)
+//   digest  count, then count x {active, stamp (4), origin node (4)}
+enum class FabricMessage : uint8_t {
+  kState = 0x01,
+  kDigest = 0x02,
+};
+
+inline constexpr uint8_t kFabricProtocolVersion = 1U;
+inline constexpr size_t kFabricHeaderSize = 12U;
+inline constexpr size_t kFabricStateSize = kFabricHeaderSize + 10U;
+inline constexpr size_t kFabricDigestEntrySize = 9U;
+inline constexpr size_t kFabricMaxDigestEntries = 32U;
+inline constexpr size_t kFabricMaxDatagramSize =
+    kFabricHeaderSize + 1U + kFabricMaxDigestEntries * kFabricDigestEntrySize;
+
+// Lamport stamp of the change plus the node that made it; the higher stamp
+// wins and the node id breaks ties, so every unit settles on the same state.
+struct CueVersion {
+  uint32_t stamp = 0;
+  uint32_t node = 0;
+};
+
+inline bool isNewerVersion(const CueVersion &candidate, const CueVersion &current) {
+  return candidate.stamp != current.stamp ? candidate.stamp > current.stamp
+                                          : candidate.node > current.node;
+}
+
+struct FabricHeader {
+  FabricMessage type = FabricMessage::kState;
+  uint32_t node = 0;
+  uint32_t sequence = 0;
+};
+
+struct FabricCueState {
+  uint8_t cue = 0;
+  bool active = false;
+  CueVersion version;
+};
+
+size_t encodeFabricState(const FabricHeader &header, const FabricCueState &state, uint8_t *out);
+// Entry i describes cue i; `count` is capped at kFabricMaxDigestEntries.
+size_t encodeFabricDigest(const FabricHeader &header, const FabricCueState *states, size_t count,
+                          uint8_t *out);
+
+bool decodeFabricHeader(const uint8_t *data, size_t len, FabricHeader &header);
+bool decodeFabricState(const uint8_t *data, size_t len, FabricCueState &state);
+// Returns false for a malformed digest; otherwise fills up to `capacity`
+// entries and reports how many through `count`.
+bool decodeFabricDigest(const uint8_t *data, size_t len, FabricCueState *states, size_t capacity,
+                        size_t &count);
+
+}  // namespace stagecue
@@ -0,0 +1,170 @@
+#include "json_stream.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace stagecue {
+
+void JsonRecordWriter::reset() {
+  length_ = 0;
+  overflowed_ = false;
+  needComma_ = false;
+}
+
+void JsonRecordWriter::put(char c) {
+  if (length_ >= sizeof(buffer_)) {
+    overflowed_ = true;
+    return;
+  }
+  buffer_[length_++] = c;
+}
+
+void JsonRecordWriter::separate() {
+  if (needComma_) {
+    put(',');
+  }
+  needComma_ = true;
+}
+
+void JsonRecordWriter::beginObject() {
+  separate();
+  put('{');
+  needComma_ = false;
+}
+
+void JsonRecordWriter::endObject() {
+  put('}');
+  needComma_ = true;
+}
+
+void JsonRecordWriter::key(const char *name) {
+  string(name);
+  put(':');
+  needComma_ = false;
+}
+
+void JsonRecordWriter::string(const char *value) {
+  separate();
+  put('"');
+  for (const char *p = value; *p != '\0'; ++p) {
+    const uint8_t c = static_cast<uint8_t>(*p);
+    if (c == '"' || c == '\\') {
+      put('\\');
+      put(static_cast<char>(c));
+    } else if (c < 0x20U) {
+      char escaped[7];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      for (const char *e = escaped; *e != '\0'; ++e) {
+        put(*e);
+      }
+    } else {
+      put(static_cast<char>(c));
+    }
+  }
+  put('"');
+}
+
+void JsonRecordWriter::number(int32_t value) {
+  char digits[12];
+  snprintf(digits, sizeof(digits), "%ld", static_cast<long>(value));
+  raw(digits);
+}
+
+void JsonRecordWriter::number(uint32_t value) {
+  char digits[11];
+  snprintf(digits, sizeof(digits), "%lu", static_cast<unsigned long>(value));
+  raw(digits);
+}
+
+void JsonRecordWriter::boolean(bool value) {
+  raw(value ? "true" : "false");
+}
+
+void JsonRecordWriter::raw(const char *text) {
+  separate();
+  for (const char *p = text; *p != '\0'; ++p) {
+    put(*p);
+  }
+}
+
+JsonArrayStream::JsonArrayStream(const char *prefix, const char *suffix, ElementFn element,
+                                 DoneFn done)
+    : element_(element), done_(done) {
+  snprintf(prefix_, sizeof(prefix_), "%s[", prefix);
+  snprintf(suffix_, sizeof(suffix_), "]%s", suffix);
+  pendingLength_ = strlen(prefix_);
+}
+
+const char *JsonArrayStream::source() const {
+  switch (stage_) {
+    case Stage::kPrefix:
+      return prefix_;
+    case Stage::kElements:
+      return record_.data();
+    default:
+      return suffix_;
+  }
+}
+
+bool JsonArrayStream::loadNext() {
+  while (true) {
+    record_.reset();
+    if (!element_(nextIndex_++, record_)) {
+      return false;
+    }
+    if (record_.overflowed() || record_.length() == 0U) {
+      Serial.println(F("[Web] Skipping oversized JSON element"));
+      continue;
+    }
+    commaPending_ = !first_;
+    first_ = false;
+    pendingOffset_ = 0;
+    pendingLength_ = record_.length();
+    return true;
+  }
+}
+
+size_t JsonArrayStream::fill(uint8_t *buffer, size_t maxLen) {
+  size_t written = 0;
+  while (written < maxLen && stage_ != Stage::kDone) {
+    if (commaPending_) {
+      buffer[written++] = ',';
+      commaPending_ = false;
+      continue;
+    }
+
+    if (pendingLength_ == 0U) {
+      switch (stage_) {
+        case Stage::kPrefix:
+          stage_ = Stage::kElements;
+          break;
+        case Stage::kElements:
+          if (!loadNext()) {
+            stage_ = Stage::kSuffix;
+            pendingOffset_ = 0;
+            pendingLength_ = strlen(suffix_);
+          }
+          break;
+        case Stage::kSuffix:
+          stage_ = Stage::kDone;
+          if (done_ != nullptr) {
+            done_();
+          }
+          break;
+        case Stage::kDone:
+          break;
+      }
+      continue;
+    }
+
+    const size_t room = maxLen - written;
+    const size_t chunk = pendingLength_ < room ? pendingLength_ : room;
+    memcpy(buffer + written, source() + pendingOffset_, chunk);
+    pendingOffset_ += chunk;
+    pendingLength_ -= chunk;
+    written += chunk;
+  }
+  return written;
+}
+
+}  // namespace stagecue
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+namespace stagecue {
+
+// Formats one JSON value into a fixed buffer. Strings are escaped as they
+// are copied; overflowing the buffer marks the record as failed instead of
+// emitting a truncated value.
+class JsonRecordWriter {
+ public:
+  void reset();
+  void beginObject();
+  void endObject();
+  void key(const char *name);
+  void string(const char *value);
+  void number(int32_t value);
+  void number(uint32_t value);
+  void boolean(bool value);
+  void raw(const char *text);
+
+  const char *data() const { return buffer_; }
+  size_t length() const { return length_; }
+  bool overflowed() const { return overflowed_; }
+
+ private:
+  void put(char c);
+  void separate();
+
+  char buffer_[kJsonStreamRecordSize];
+  size_t length_ = 0;
+  bool overflowed_ = false;
+  bool needComma_ = false;
+};
+
+// Emits `<prefix>[element,element,...]<suffix>` through a chunked response
+// filler, formatting one element at a time so memory use does not grow with
+// the number of elements.
+class JsonArrayStream {
+ public:
+  // Writes element `index` into `record`; returns false once past the end.
+  using ElementFn = bool (*)(size_t index, JsonRecordWriter &record);
+  using DoneFn = void (*)();
+
+  JsonArrayStream(const char *prefix, const char *suffix, ElementFn element,
+                  DoneFn done = nullptr);
+
+  // ESPAsyncWebServer filler contract: returns 0 once everything was sent.
+  size_t fill(uint8_t *buffer, size_t maxLen);
+
+ private:
+  enum class Stage : uint8_t { kPrefix, kElements, kSuffix, kDone };
+
+  bool loadNext();
+  const char *source() const;
+
+  static constexpr size_t kAffixCapacity = 48U;
+
+  char prefix_[kAffixCapacity];
+  char suffix_[kAffixCapacity];
+  ElementFn element_;
+  DoneFn done_;
+  Stage stage_ = Stage::kPrefix;
+  size_t nextIndex_ = 0;
+  bool first_ = true;
+  bool commaPending_ = false;
+  JsonRecordWriter record_;
+  // Offsets rather than pointers: the stream is copied into the response.
+  size_t pendingOffset_ = 0;
+  size_t pendingLength_ = 0;
+};
+
+}  // namespace stagecue
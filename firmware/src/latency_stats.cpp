@@ -0,0 +1,97 @@
+#include "latency_stats.h"
+
+#include <algorithm>
+#include <array>
+
+#include "config.h"
+
+namespace stagecue {
+
+namespace {
+
+struct ProbeWindow {
+  std::array<uint32_t, kLatencyWindowSize> samples{};
+  uint32_t total = 0;
+  uint32_t maxUs = 0;
+};
+
+std::array<ProbeWindow, kLatencyProbeCount> gProbes{};
+portMUX_TYPE gProbeLock = portMUX_INITIALIZER_UNLOCKED;
+
+constexpr const char *kProbeNames[kLatencyProbeCount] = {
+    "trigger_to_led",
+    "trigger_to_broadcast",
+    "button_to_display",
+    "display_render",
+    "press_to_trigger",
+    "ws_decode_json",
+    "ws_decode_binary",
+    "ws_encode_json",
+    "ws_encode_binary",
+    "ws_connect_sync",
+    "show_go",
+    "batch_apply",
+    "schedule_lateness",
+};
+
+// Nearest-rank percentile over the (already partially ordered) window.
+uint32_t percentile(std::array<uint32_t, kLatencyWindowSize> &window, size_t count,
+                    uint8_t rank) {
+  const size_t position = (count * rank + 99U) / 100U - 1U;
+  std::nth_element(window.begin(), window.begin() + position, window.begin() + count);
+  return window[position];
+}
+
+}  // namespace
+
+void recordLatency(LatencyProbe probe, uint32_t elapsedUs) {
+  const size_t slot = static_cast<size_t>(probe);
+  if (slot >= kLatencyProbeCount) {
+    return;
+  }
+
+  portENTER_CRITICAL(&gProbeLock);
+  auto &window = gProbes[slot];
+  window.samples[window.total % kLatencyWindowSize] = elapsedUs;
+  ++window.total;
+  window.maxUs = std::max(window.maxUs, elapsedUs);
+  portEXIT_CRITICAL(&gProbeLock);
+}
+
+LatencySummary summarizeLatency(LatencyProbe probe) {
+  LatencySummary summary;
+  const size_t slot = static_cast<size_t>(probe);
+  if (slot >= kLatencyProbeCount) {
+    return summary;
+  }
+
+  std::array<uint32_t, kLatencyWindowSize> scratch;
+  portENTER_CRITICAL(&gProbeLock);
+  const auto &window = gProbes[slot];
+  scratch = window.samples;
+  summary.samples = window.total;
+  summary.maxUs = window.maxUs;
+  portEXIT_CRITICAL(&gProbeLock);
+
+  const size_t count = std::min<size_t>(summary.samples, kLatencyWindowSize);
+  if (count == 0U) {
+    return summary;
+  }
+
+  summary.p50Us = percentile(scratch, count, 50U);
+  summary.p99Us = percentile(scratch, count, 99U);
+  return summary;
+}
+
+const char *latencyProbeName(LatencyProbe probe) {
+  const size_t slot = static_cast<size_t>(probe);
+  return slot < kLatencyProbeCount ? kProbeNames[slot] : "unknown";
+}
+
+void resetLatencyStats() {
+  portENTER_CRITICAL(&gProbeLock);
+  gProbes = {};
+  portEXIT_CRITICAL(&gProbeLock);
+}
+
+}  // namespace stagecue
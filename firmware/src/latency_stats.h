@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace stagecue {
+
+enum class LatencyProbe : uint8_t {
+  kTriggerToLed = 0,
+  kTriggerToBroadcast,
+  kButtonToDisplay,
+  kDisplayRender,
+  kPressToTrigger,
+  kWsDecodeJson,
+  kWsDecodeBinary,
+  kWsEncodeJson,
+  kWsEncodeBinary,
+  kWsConnectSync,
+  kShowGo,
+  kBatchApply,
+  kScheduleLateness,
+  kCount,
+};
+
+inline constexpr size_t kLatencyProbeCount = static_cast<size_t>(LatencyProbe::kCount);
+
+struct LatencySummary {
+  uint32_t samples = 0;
+  uint32_t p50Us = 0;
+  uint32_t p99Us = 0;
+  uint32_t maxUs = 0;
+};
+
+void recordLatency(LatencyProbe probe, uint32_t elapsedUs);
+LatencySummary summarizeLatency(LatencyProbe probe);
+const char *latencyProbeName(LatencyProbe probe);
+void resetLatencyStats();
+
+}  // namespace stagecue
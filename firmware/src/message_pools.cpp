@@ -0,0 +1,90 @@
+#include "message_pools.h"
+
+namespace stagecue {
+
+namespace {
+
+SlabPool<kMaxIncomingMessageSize + 1U, kInboundBufferSlots> gInboundPool;
+SlabPool<kInboundJsonCapacity, kJsonDocumentSlots> gJsonDocumentPool;
+SlabPool<kOutboundFrameSize, kOutboundFrameSlots> gOutboundPool;
+
+void *acquireBlock(MessagePool pool, size_t size) {
+  switch (pool) {
+    case MessagePool::kInbound:
+      return gInboundPool.acquire(size);
+    case MessagePool::kJsonDocument:
+      return gJsonDocumentPool.acquire(size);
+    case MessagePool::kOutbound:
+      return gOutboundPool.acquire(size);
+    default:
+      return nullptr;
+  }
+}
+
+void releaseBlock(MessagePool pool, void *block) {
+  switch (pool) {
+    case MessagePool::kInbound:
+      gInboundPool.release(block);
+      break;
+    case MessagePool::kJsonDocument:
+      gJsonDocumentPool.release(block);
+      break;
+    case MessagePool::kOutbound:
+      gOutboundPool.release(block);
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace
+
+MessageBuffer::MessageBuffer(MessagePool pool, size_t size)
+    : pool_(pool), data_(static_cast<char *>(acquireBlock(pool, size))) {}
+
+MessageBuffer::~MessageBuffer() {
+  if (data_ != nullptr) {
+    releaseBlock(pool_, data_);
+  }
+}
+
+void *PooledJsonAllocator::allocate(size_t size) {
+  return gJsonDocumentPool.acquire(size);
+}
+
+void PooledJsonAllocator::deallocate(void *pointer) {
+  gJsonDocumentPool.release(pointer);
+}
+
+// Only ever asked to shrink (shrinkToFit) or to stay within the slot.
+void *PooledJsonAllocator::reallocate(void *pointer, size_t size) {
+  return size <= decltype(gJsonDocumentPool)::kSlotSize ? pointer : nullptr;
+}
+
+SlabPoolStats getMessagePoolStats(MessagePool pool) {
+  switch (pool) {
+    case MessagePool::kInbound:
+      return gInboundPool.stats();
+    case MessagePool::kJsonDocument:
+      return gJsonDocumentPool.stats();
+    case MessagePool::kOutbound:
+      return gOutboundPool.stats();
+    default:
+      return SlabPoolStats{};
+  }
+}
+
+const char *messagePoolName(MessagePool pool) {
+  switch (pool) {
+    case MessagePool::kInbound:
+      return "inbound";
+    case MessagePool::kJsonDocument:
+      return "json_document";
+    case MessagePool::kOutbound:
+      return "outbound";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace stagecue
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "config.h"
+#include "slab_pool.h"
+
+namespace stagecue {
+
+enum class MessagePool : uint8_t {
+  kInbound = 0,   // raw text of a client message, parsed in place
+  kJsonDocument,  // node space for the parsed message
+  kOutbound,      // serialized text frames
+  kCount,
+};
+
+inline constexpr size_t kMessagePoolCount = static_cast<size_t>(MessagePool::kCount);
+
+// Inbound strings stay in the message buffer, so only the nodes count.
+inline constexpr size_t kInboundJsonCapacity =
+    JSON_OBJECT_SIZE(5) + JSON_ARRAY_SIZE(kCueBatchMaxOps) + kCueBatchMaxOps * JSON_OBJECT_SIZE(3);
+// An init snapshot with every label at full length and some escaping.
+inline constexpr size_t kOutboundFrameSize = 160U + kCueCount * (72U + 2U * kCueTextMaxLength);
+
+// One pooled block, returned on destruction. Empty when the pool is
+// exhausted or `size` does not fit a slot.
+class MessageBuffer {
+ public:
+  MessageBuffer(MessagePool pool, size_t size);
+  ~MessageBuffer();
+
+  MessageBuffer(const MessageBuffer &) = delete;
+  MessageBuffer &operator=(const MessageBuffer &) = delete;
+
+  char *data() const { return data_; }
+  explicit operator bool() const { return data_ != nullptr; }
+
+ private:
+  MessagePool pool_;
+  char *data_;
+};
+
+// Backs BasicJsonDocument with the kJsonDocument pool. A document that
+// could not get a slot has capacity() 0 and fails to parse with NoMemory.
+struct PooledJsonAllocator {
+  void *allocate(size_t size);
+  void deallocate(void *pointer);
+  void *reallocate(void *pointer, size_t size);
+};
+
+using PooledJsonDocument = BasicJsonDocument<PooledJsonAllocator>;
+
+SlabPoolStats getMessagePoolStats(MessagePool pool);
+const char *messagePoolName(MessagePool pool);
+
+}  // namespace stagecue
@@ -0,0 +1,330 @@
+#include "metrics.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cue_store.h"
+#include "cues.h"
+#include "latency_stats.h"
+#include "message_pools.h"
+#include "run_loop.h"
+
+namespace stagecue {
+
+namespace {
+
+enum class Family : uint8_t {
+  kSpanTotal = 0,
+  kSpanMax,
+  kSpanDuration,
+  kLatency,
+  kLatencySamples,
+  kCueCommands,
+  kCommandQueueHighWater,
+  kLoopIdle,
+  kTaskRuns,
+  kTaskRunTime,
+  kTaskRunMax,
+  kTaskDispatchMax,
+  kTimersPending,
+  kTimersFired,
+  kCueStoreCommits,
+  kPoolHighWater,
+  kPoolExhausted,
+  kPoolOversize,
+  kHeapFree,
+  kHeapMinFree,
+  kUptime,
+  kTraceSpans,
+  kTraceEnabled,
+  kCount,
+};
+
+struct FamilyInfo {
+  const char *name;
+  const char *type;
+  const char *help;
+};
+
+constexpr size_t kFamilyCount = static_cast<size_t>(Family::kCount);
+
+constexpr FamilyInfo kFamilies[kFamilyCount] = {
+    {"stagecue_span_total", "counter", "Traced spans by event and core."},
+    {"stagecue_span_max_microseconds", "gauge", "Longest traced span by event and core."},
+    {"stagecue_span_duration_microseconds", "histogram", "Traced span durations."},
+    {"stagecue_latency_microseconds", "gauge", "Latency probe percentiles over the recent window."},
+    {"stagecue_latency_samples_total", "counter", "Samples recorded by each latency probe."},
+    {"stagecue_cue_commands_total", "counter", "Cue commands by outcome."},
+    {"stagecue_cue_command_queue_high_water", "gauge", "Deepest the cue command queue has been."},
+    {"stagecue_loop_idle_percent", "gauge", "Share of the last second the run loop slept."},
+    {"stagecue_task_runs_total", "counter", "Run loop task dispatches."},
+    {"stagecue_task_run_microseconds_total", "counter", "Time spent in each run loop task."},
+    {"stagecue_task_run_max_microseconds", "gauge", "Longest single run of each task."},
+    {"stagecue_task_dispatch_max_microseconds", "gauge",
+     "Longest wait from a task becoming ready to it running."},
+    {"stagecue_timers_pending", "gauge", "Armed cue timers."},
+    {"stagecue_timers_fired_total", "counter", "Cue timers that expired."},
+    {"stagecue_cue_store_commits_total", "counter", "NVS commits made for cue labels."},
+    {"stagecue_message_pool_high_water", "gauge", "Most message pool slots in use at once."},
+    {"stagecue_message_pool_exhausted_total", "counter",
+     "Messages refused because their pool was empty."},
+    {"stagecue_message_pool_oversize_total", "counter",
+     "Requests larger than a message pool slot."},
+    {"stagecue_heap_free_bytes", "gauge", "Free heap."},
+    {"stagecue_heap_min_free_bytes", "gauge", "Lowest free heap since boot."},
+    {"stagecue_uptime_seconds", "gauge", "Seconds since boot."},
+    {"stagecue_trace_spans_total", "counter", "Spans written to the trace ring."},
+    {"stagecue_trace_enabled", "gauge", "1 when span recording is active."},
+};
+
+constexpr size_t kSpanItemsPerEvent = kTraceHistogramBuckets + 2U;  // buckets, _sum, _count
+constexpr size_t kLatencyItemsPerProbe = 2U;                        // p50, p99
+
+}  // namespace
+
+bool MetricsStream::formatLine(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  const int length = vsnprintf(line_, sizeof(line_), format, args);
+  va_end(args);
+  pendingOffset_ = 0;
+  if (length < 0 || static_cast<size_t>(length) >= sizeof(line_)) {
+    Serial.println(F("[Web] Skipping oversized metrics line"));
+    pendingLength_ = 0;
+  } else {
+    pendingLength_ = static_cast<size_t>(length);
+  }
+  return true;
+}
+
+void MetricsStream::loadHistogram(TraceEvent event) {
+  uint32_t buckets[kTraceHistogramBuckets];
+  getTraceHistogram(event, buckets);
+  uint32_t running = 0;
+  for (size_t i = 0; i < kTraceHistogramBuckets; ++i) {
+    running += buckets[i];
+    cumulative_[i] = running;
+  }
+
+  histogramSumUs_ = 0;
+  for (uint8_t core = 0; core < portNUM_PROCESSORS; ++core) {
+    histogramSumUs_ += getTraceCounters(event, core).totalUs;
+  }
+}
+
+// Formats sample `item` of `family`; false once the family has no more.
+bool MetricsStream::formatSample(size_t family, size_t item) {
+  const char *name = kFamilies[family].name;
+
+  switch (static_cast<Family>(family)) {
+    case Family::kSpanTotal:
+    case Family::kSpanMax: {
+      if (item >= kTraceEventCount * portNUM_PROCESSORS) {
+        return false;
+      }
+      const auto event = static_cast<TraceEvent>(item / portNUM_PROCESSORS);
+      const auto core = static_cast<uint8_t>(item % portNUM_PROCESSORS);
+      const TraceCounters counters = getTraceCounters(event, core);
+      const uint32_t value =
+          static_cast<Family>(family) == Family::kSpanTotal ? counters.count : counters.maxUs;
+      return formatLine("%s{event=\"%s\",core=\"%u\"} %lu\n", name, traceEventName(event),
+                        static_cast<unsigned>(core), static_cast<unsigned long>(value));
+    }
+
+    case Family::kSpanDuration: {
+      if (item >= kTraceEventCount * kSpanItemsPerEvent) {
+        return false;
+      }
+      const auto event = static_cast<TraceEvent>(item / kSpanItemsPerEvent);
+      const size_t part = item % kSpanItemsPerEvent;
+      if (part == 0U) {
+        loadHistogram(event);
+      }
+      const char *eventName = traceEventName(event);
+      if (part < kTraceHistogramBuckets) {
+        const uint32_t bound = traceHistogramBound(part);
+        char le[12];
+        if (bound == 0U) {
+          strcpy(le, "+Inf");
+        } else {
+          snprintf(le, sizeof(le), "%lu", static_cast<unsigned long>(bound));
+        }
+        return formatLine("%s_bucket{event=\"%s\",le=\"%s\"} %lu\n", name, eventName, le,
+                          static_cast<unsigned long>(cumulative_[part]));
+      }
+      if (part == kTraceHistogramBuckets) {
+        return formatLine("%s_sum{event=\"%s\"} %llu\n", name, eventName,
+                          static_cast<unsigned long long>(histogramSumUs_));
+      }
+      return formatLine("%s_count{event=\"%s\"} %lu\n", name, eventName,
+                        static_cast<unsigned long>(cumulative_[kTraceHistogramBuckets - 1U]));
+    }
+
+    case Family::kLatency: {
+      if (item >= kLatencyProbeCount * kLatencyItemsPerProbe) {
+        return false;
+      }
+      const auto probe = static_cast<LatencyProbe>(item / kLatencyItemsPerProbe);
+      const bool p99 = item % kLatencyItemsPerProbe != 0U;
+      const LatencySummary summary = summarizeLatency(probe);
+      return formatLine("%s{probe=\"%s\",quantile=\"%s\"} %lu\n", name, latencyProbeName(probe),
+                        p99 ? "0.99" : "0.5",
+                        static_cast<unsigned long>(p99 ? summary.p99Us : summary.p50Us));
+    }
+
+    case Family::kLatencySamples: {
+      if (item >= kLatencyProbeCount) {
+        return false;
+      }
+      const auto probe = static_cast<LatencyProbe>(item);
+      return formatLine("%s{probe=\"%s\"} %lu\n", name, latencyProbeName(probe),
+                        static_cast<unsigned long>(summarizeLatency(probe).samples));
+    }
+
+    case Family::kTaskRuns:
+    case Family::kTaskRunTime:
+    case Family::kTaskRunMax:
+    case Family::kTaskDispatchMax: {
+      if (item >= kRunLoopTaskCount) {
+        return false;
+      }
+      const CoopTaskStats stats = getRunLoopTaskStats(static_cast<RunLoopTask>(item));
+      uint64_t value = stats.runs;
+      if (static_cast<Family>(family) == Family::kTaskRunTime) {
+        value = stats.runUs;
+      } else if (static_cast<Family>(family) == Family::kTaskRunMax) {
+        value = stats.maxRunUs;
+      } else if (static_cast<Family>(family) == Family::kTaskDispatchMax) {
+        value = stats.maxDispatchUs;
+      }
+      return formatLine("%s{task=\"%s\"} %llu\n", name, stats.name,
+                        static_cast<unsigned long long>(value));
+    }
+
+    case Family::kPoolHighWater:
+    case Family::kPoolExhausted:
+    case Family::kPoolOversize: {
+      if (item >= kMessagePoolCount) {
+        return false;
+      }
+      const auto pool = static_cast<MessagePool>(item);
+      const SlabPoolStats stats = getMessagePoolStats(pool);
+      uint32_t value = static_cast<uint32_t>(stats.highWater);
+      if (static_cast<Family>(family) == Family::kPoolExhausted) {
+        value = stats.exhausted;
+      } else if (static_cast<Family>(family) == Family::kPoolOversize) {
+        value = stats.oversize;
+      }
+      return formatLine("%s{pool=\"%s\"} %lu\n", name, messagePoolName(pool),
+                        static_cast<unsigned long>(value));
+    }
+
+    case Family::kCueCommands: {
+      const CueCommandStats stats = getCueCommandStats();
+      const char *result = nullptr;
+      uint32_t value = 0;
+      switch (item) {
+        case 0: result = "submitted"; value = stats.submitted; break;
+        case 1: result = "rejected"; value = stats.rejected; break;
+        case 2: result = "applied"; value = stats.applied; break;
+        default: return false;
+      }
+      return formatLine("%s{result=\"%s\"} %lu\n", name, result,
+                        static_cast<unsigned long>(value));
+    }
+
+    default:
+      break;
+  }
+
+  if (item != 0U) {
+    return false;
+  }
+
+  uint32_t value = 0;
+  switch (static_cast<Family>(family)) {
+    case Family::kCommandQueueHighWater:
+      value = getCueCommandStats().highWater;
+      break;
+    case Family::kLoopIdle:
+      value = getRunLoopIdlePercent();
+      break;
+    case Family::kTimersPending:
+      value = getCueTimerStats().pending;
+      break;
+    case Family::kTimersFired:
+      value = getCueTimerStats().fired;
+      break;
+    case Family::kCueStoreCommits:
+      value = getCueStoreStats().commits;
+      break;
+    case Family::kHeapFree:
+      value = ESP.getFreeHeap();
+      break;
+    case Family::kHeapMinFree:
+      value = ESP.getMinFreeHeap();
+      break;
+    case Family::kUptime:
+      value = millis() / 1000U;
+      break;
+    case Family::kTraceSpans:
+      value = getTraceSpanTotal();
+      break;
+    case Family::kTraceEnabled:
+      value = isTraceEnabled() ? 1U : 0U;
+      break;
+    default:
+      return false;
+  }
+  return formatLine("%s %lu\n", name, static_cast<unsigned long>(value));
+}
+
+bool MetricsStream::loadNext() {
+  while (family_ < kFamilyCount) {
+    const FamilyInfo &info = kFamilies[family_];
+    switch (stage_) {
+      case Stage::kHelp:
+        stage_ = Stage::kType;
+        formatLine("# HELP %s %s\n", info.name, info.help);
+        break;
+      case Stage::kType:
+        stage_ = Stage::kSamples;
+        item_ = 0;
+        formatLine("# TYPE %s %s\n", info.name, info.type);
+        break;
+      case Stage::kSamples:
+        if (!formatSample(family_, item_++)) {
+          ++family_;
+          stage_ = Stage::kHelp;
+        }
+        break;
+    }
+    if (pendingLength_ != 0U) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t MetricsStream::fill(uint8_t *buffer, size_t maxLen) {
+  size_t written = 0;
+  while (written < maxLen && !done_) {
+    if (pendingLength_ == 0U) {
+      if (!loadNext()) {
+        done_ = true;
+      }
+      continue;
+    }
+
+    const size_t room = maxLen - written;
+    const size_t chunk = pendingLength_ < room ? pendingLength_ : room;
+    memcpy(buffer + written, line_ + pendingOffset_, chunk);
+    pendingOffset_ += chunk;
+    pendingLength_ -= chunk;
+    written += chunk;
+  }
+  return written;
+}
+
+}  // namespace stagecue
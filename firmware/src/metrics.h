@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "trace.h"
+
+namespace stagecue {
+
+// Renders trace spans, latency probes and engine counters in the Prometheus
+// text exposition format, one line at a time through a chunked response.
+class MetricsStream {
+ public:
+  // ESPAsyncWebServer filler contract: returns 0 once everything was sent.
+  size_t fill(uint8_t *buffer, size_t maxLen);
+
+ private:
+  enum class Stage : uint8_t { kHelp, kType, kSamples };
+
+  bool loadNext();
+  bool formatSample(size_t family, size_t item);
+  // Always true, so formatSample() can return it; an overlong line is dropped.
+  bool formatLine(const char *format, ...);
+  void loadHistogram(TraceEvent event);
+
+  char line_[kMetricsLineMaxLength];
+  size_t pendingOffset_ = 0;
+  size_t pendingLength_ = 0;
+  size_t family_ = 0;
+  size_t item_ = 0;
+  Stage stage_ = Stage::kHelp;
+  bool done_ = false;
+  // One event's histogram, read once so its buckets stay cumulative.
+  uint32_t cumulative_[kTraceHistogramBuckets] = {};
+  uint64_t histogramSumUs_ = 0;
+};
+
+}  // namespace stagecue
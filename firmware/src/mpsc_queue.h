@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+
+namespace stagecue {
+
+// Bounded, lock-free multi-producer / single-consumer queue (Vyukov's
+// sequenced ring). push() may be called from any task; pop() from one only.
+template <typename T, size_t Capacity>
+class MpscQueue {
+  static_assert(Capacity >= 2U && (Capacity & (Capacity - 1U)) == 0U,
+                "Queue capacity must be a power of two");
+
+ public:
+  MpscQueue() {
+    for (size_t i = 0; i < Capacity; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  // Returns false when the queue is full.
+  bool push(const T &value) {
+    Cell *cell = nullptr;
+    size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells_[position & kMask];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t distance =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (distance == 0) {
+        if (enqueuePosition_.compare_exchange_weak(position, position + 1U,
+                                                   std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (distance < 0) {
+        return false;
+      } else {
+        position = enqueuePosition_.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->value = value;
+    cell->sequence.store(position + 1U, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &value) {
+    const size_t position = dequeuePosition_.load(std::memory_order_relaxed);
+    Cell &cell = cells_[position & kMask];
+    const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != position + 1U) {
+      return false;
+    }
+
+    value = cell.value;
+    cell.sequence.store(position + Capacity, std::memory_order_release);
+    dequeuePosition_.store(position + 1U, std::memory_order_relaxed);
+    return true;
+  }
+
+  // The loads are not atomic together: with a dequeue in between, the
+  // difference could go negative and wrap, or, read the other way round,
+  // exceed the capacity.
+  size_t sizeApprox() const {
+    const size_t dequeued = dequeuePosition_.load(std::memory_order_relaxed);
+    const size_t enqueued = enqueuePosition_.load(std::memory_order_relaxed);
+    const auto size = static_cast<ptrdiff_t>(enqueued - dequeued);
+    return size <= 0 ? 0U : std::min(static_cast<size_t>(size), Capacity);
+  }
+
+ private:
+  static constexpr size_t kMask = Capacity - 1U;
+
+  struct Cell {
+    std::atomic<size_t> sequence{0};
+    T value{};
+  };
+
+  Cell cells_[Capacity];
+  std::atomic<size_t> enqueuePosition_{0};
+  std::atomic<size_t> dequeuePosition_{0};
+};
+
+}  // namespace stagecue
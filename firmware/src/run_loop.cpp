@@ -0,0 +1,140 @@
+#include "run_loop.h"
+
+#include <algorithm>
+#include <array>
+
+#include "config.h"
+#include "cue_fabric.h"
+#include "cue_store.h"
+#include "cues.h"
+#include "web_server.h"
+#include "wifi_portal.h"
+#include "wifi_supervisor.h"
+
+namespace stagecue {
+
+namespace {
+
+uint32_t clockMicros() {
+  return micros();
+}
+
+CoopScheduler gScheduler(clockMicros);
+TaskHandle_t gLoopTask = nullptr;
+
+// Loop task only.
+uint32_t gSleptUs = 0;
+uint32_t gStatsWindowStartUs = 0;
+
+// Published by the metrics task.
+std::array<CoopTaskStats, kRunLoopTaskCount> gPublishedStats{};
+uint8_t gIdlePercent = 0;
+portMUX_TYPE gStatsLock = portMUX_INITIALIZER_UNLOCKED;
+
+void runWifi(uint32_t nowMs) {
+  if (serviceWifiScan()) {
+    notifyWifiScanResults();
+  }
+  serviceWifiSupervisor(nowMs);
+  if (isWifiStationUp()) {
+    startCueFabric();  // no-op once running
+  }
+}
+
+uint32_t millisUntilWifiDue(uint32_t nowMs, uint32_t limitMs) {
+  return millisUntilWifiSupervisor(nowMs, millisUntilWifiScanService(nowMs, limitMs));
+}
+
+void publishStats(uint32_t) {
+  const uint32_t nowUs = micros();
+  const uint32_t windowUs = nowUs - gStatsWindowStartUs;
+  const auto idle = static_cast<uint8_t>(
+      windowUs == 0U ? 0U
+                     : std::min<uint64_t>(100U, static_cast<uint64_t>(gSleptUs) * 100U / windowUs));
+  gStatsWindowStartUs = nowUs;
+  gSleptUs = 0;
+
+  std::array<CoopTaskStats, kRunLoopTaskCount> stats;
+  for (size_t i = 0; i < stats.size(); ++i) {
+    stats[i] = gScheduler.stats(i);
+  }
+  portENTER_CRITICAL(&gStatsLock);
+  gPublishedStats = stats;
+  gIdlePercent = idle;
+  portEXIT_CRITICAL(&gStatsLock);
+}
+
+// Indexed by RunLoopTask. The cue I/O period retries broadcasts deferred for
+// lack of a buffer and drains slow clients' backlogs.
+constexpr CoopTaskSpec kTasks[kRunLoopTaskCount] = {
+    {"cue_io", 0U, kRunLoopMaxSleepMillis, [](uint32_t) { updateCues(); }, millisUntilCueDeadline},
+    {"fabric", 1U, 0U, serviceCueFabric, millisUntilCueFabricService},
+    {"wifi", 2U, 0U, runWifi, millisUntilWifiDue},
+    {"persistence", 3U, 0U, serviceCueStore, millisUntilCueStoreFlush},
+    {"metrics", 4U, kRunLoopStatsPeriodMillis, publishStats, nullptr},
+};
+
+}  // namespace
+
+void initRunLoop() {
+  gLoopTask = xTaskGetCurrentTaskHandle();
+  gStatsWindowStartUs = micros();
+  const uint32_t now = millis();
+  for (const auto &spec : kTasks) {
+    gScheduler.add(spec, now);
+  }
+  // Names and priorities are readable before the first metrics period.
+  std::array<CoopTaskStats, kRunLoopTaskCount> stats;
+  for (size_t i = 0; i < stats.size(); ++i) {
+    stats[i] = gScheduler.stats(i);
+  }
+  portENTER_CRITICAL(&gStatsLock);
+  gPublishedStats = stats;
+  portEXIT_CRITICAL(&gStatsLock);
+}
+
+void runLoop() {
+  if (gScheduler.runNext(millis())) {
+    return;
+  }
+
+  const uint32_t timeoutMs = gScheduler.millisUntilNext(millis(), kRunLoopMaxSleepMillis);
+  if (timeoutMs == 0U) {
+    return;
+  }
+
+  const uint32_t startUs = micros();
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+  gSleptUs += micros() - startUs;
+}
+
+void wakeRunLoopTask(RunLoopTask task) {
+  gScheduler.wake(static_cast<size_t>(task));
+  if (gLoopTask != nullptr && xTaskGetCurrentTaskHandle() != gLoopTask) {
+    xTaskNotifyGive(gLoopTask);
+  }
+}
+
+TaskHandle_t getRunLoopTaskHandle() {
+  return gLoopTask;
+}
+
+uint8_t getRunLoopIdlePercent() {
+  portENTER_CRITICAL(&gStatsLock);
+  const uint8_t idle = gIdlePercent;
+  portEXIT_CRITICAL(&gStatsLock);
+  return idle;
+}
+
+CoopTaskStats getRunLoopTaskStats(RunLoopTask task) {
+  const auto index = static_cast<size_t>(task);
+  if (index >= kRunLoopTaskCount) {
+    return CoopTaskStats{};
+  }
+  portENTER_CRITICAL(&gStatsLock);
+  const CoopTaskStats stats = gPublishedStats[index];
+  portEXIT_CRITICAL(&gStatsLock);
+  return stats;
+}
+
+}  // namespace stagecue
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "coop_scheduler.h"
+
+namespace stagecue {
+
+// Cooperative tasks on the loop task, in priority order. The display flush
+// keeps its own FreeRTOS task: an I2C frame blocks for milliseconds.
+enum class RunLoopTask : uint8_t {
+  kCueIo = 0,    // buttons, commands, timers, LEDs and client broadcasts
+  kFabric,       // peer announcements and digests
+  kWifi,         // link supervision and the scan service
+  kPersistence,  // debounced label writes to NVS
+  kMetrics,      // idle share and per-task stats for readers
+  kCount,
+};
+
+inline constexpr size_t kRunLoopTaskCount = static_cast<size_t>(RunLoopTask::kCount);
+static_assert(kRunLoopTaskCount <= kCoopMaxTasks, "Raise kCoopMaxTasks");
+
+// Call from setup() before anything that wakes a task.
+void initRunLoop();
+// One pass from loop(): runs the highest-priority ready task, or sleeps
+// until the next deadline or wake-up.
+void runLoop();
+// Thread-safe.
+void wakeRunLoopTask(RunLoopTask task);
+TaskHandle_t getRunLoopTaskHandle();
+
+// As of the last metrics task run.
+uint8_t getRunLoopIdlePercent();
+CoopTaskStats getRunLoopTaskStats(RunLoopTask task);
+
+}  // namespace stagecue
@@ -0,0 +1,177 @@
+#include "show.h"
+
+#include <new>
+
+#include "config.h"
+#include "cue_label.h"
+
+namespace stagecue {
+
+namespace {
+
+// Hands out one line at a time from a small read buffer. Overlong lines are
+// cut at kShowLineMaxLength and the remainder skipped.
+class LineReader {
+ public:
+  explicit LineReader(fs::File &file) : file_(file) {}
+
+  bool next(char *&line, size_t &length) {
+    length = 0;
+    bool sawData = false;
+    while (true) {
+      if (position_ == filled_) {
+        filled_ = file_.read(reinterpret_cast<uint8_t *>(chunk_), sizeof(chunk_));
+        position_ = 0;
+        if (filled_ == 0U) {
+          break;
+        }
+      }
+      const char c = chunk_[position_++];
+      sawData = true;
+      if (c == '\n') {
+        break;
+      }
+      if (c != '\r' && length < kShowLineMaxLength) {
+        line_[length++] = c;
+      }
+    }
+    line_[length] = '\0';
+    line = line_;
+    return sawData;
+  }
+
+ private:
+  fs::File &file_;
+  char chunk_[kShowReadChunkBytes];
+  char line_[kShowLineMaxLength + 1];
+  size_t filled_ = 0;
+  size_t position_ = 0;
+};
+
+bool parseNumber(const char *begin, const char *end, uint32_t &value) {
+  if (begin == end) {
+    return false;
+  }
+  value = 0;
+  for (const char *p = begin; p < end; ++p) {
+    if (*p < '0' || *p > '9' || value > (UINT32_MAX - 9U) / 10U) {
+      return false;
+    }
+    value = value * 10U + static_cast<uint32_t>(*p - '0');
+  }
+  return true;
+}
+
+enum class LineKind : uint8_t { kBlank, kCue, kInvalid };
+
+LineKind parseLine(char *line, size_t length, ShowCueRecord &record, CueLabel &label) {
+  if (length == 0U || line[0] == '#') {
+    return LineKind::kBlank;
+  }
+
+  char *const end = line + length;
+  char *firstTab = static_cast<char *>(memchr(line, '\t', length));
+  if (firstTab == nullptr) {
+    return LineKind::kInvalid;
+  }
+  char *secondTab = static_cast<char *>(memchr(firstTab + 1, '\t', end - firstTab - 1));
+  if (secondTab == nullptr) {
+    return LineKind::kInvalid;
+  }
+
+  uint32_t channel = 0;
+  if (!parseNumber(line, firstTab, channel) || channel == 0U || channel > kCueCount) {
+    return LineKind::kInvalid;
+  }
+
+  uint32_t autoReleaseMs = kCueAutoReleaseMillis;
+  if (firstTab + 1 != secondTab && !parseNumber(firstTab + 1, secondTab, autoReleaseMs)) {
+    return LineKind::kInvalid;
+  }
+
+  label.assign(secondTab + 1, static_cast<size_t>(end - secondTab - 1));
+  record.channel = static_cast<uint8_t>(channel - 1U);
+  record.autoReleaseMs = autoReleaseMs;
+  record.textLength = static_cast<uint8_t>(label.length());
+  return LineKind::kCue;
+}
+
+}  // namespace
+
+std::unique_ptr<CompiledShow> compileShowFile(fs::FS &fs, const char *path) {
+  const uint32_t startUs = micros();
+  fs::File file = fs.open(path, "r");
+  if (!file) {
+    return nullptr;
+  }
+
+  auto show = std::unique_ptr<CompiledShow>(new (std::nothrow) CompiledShow());
+  if (!show) {
+    file.close();
+    return nullptr;
+  }
+
+  // Pass 1: count cues and text bytes so both arrays are allocated once.
+  uint32_t cues = 0;
+  uint32_t textBytes = 0;
+  {
+    LineReader reader(file);
+    char *line = nullptr;
+    size_t length = 0;
+    ShowCueRecord record;
+    CueLabel label;
+    while (reader.next(line, length)) {
+      const LineKind kind = parseLine(line, length, record, label);
+      if (kind == LineKind::kCue) {
+        ++cues;
+        textBytes += record.textLength + 1U;
+      } else if (kind == LineKind::kInvalid) {
+        ++show->skippedLines;
+      }
+    }
+  }
+
+  if (cues == 0U || cues > kShowMaxCues) {
+    Serial.printf("[Show] %s holds %u cues, expected 1..%u\n", path,
+                  static_cast<unsigned>(cues), static_cast<unsigned>(kShowMaxCues));
+    file.close();
+    return nullptr;
+  }
+
+  show->records.reset(new (std::nothrow) ShowCueRecord[cues]);
+  show->texts.reset(new (std::nothrow) char[textBytes]);
+  if (!show->records || !show->texts) {
+    Serial.println(F("[Show] Not enough memory for show"));
+    file.close();
+    return nullptr;
+  }
+
+  // Pass 2: fill the records and the text pool.
+  file.seek(0);
+  {
+    LineReader reader(file);
+    char *line = nullptr;
+    size_t length = 0;
+    CueLabel label;
+    uint32_t offset = 0;
+    uint16_t index = 0;
+    while (index < cues && reader.next(line, length)) {
+      ShowCueRecord &record = show->records[index];
+      if (parseLine(line, length, record, label) != LineKind::kCue) {
+        continue;
+      }
+      record.textOffset = offset;
+      memcpy(&show->texts[offset], label.c_str(), record.textLength + 1U);
+      offset += record.textLength + 1U;
+      ++index;
+    }
+    show->count = index;
+  }
+  file.close();
+
+  show->textBytes = textBytes;
+  show->loadUs = micros() - startUs;
+  return show;
+}
+
+}  // namespace stagecue
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <memory>
+
+namespace stagecue {
+
+// One compiled show cue. Labels live NUL-terminated in the show's text pool.
+struct ShowCueRecord {
+  uint32_t textOffset = 0;
+  uint32_t autoReleaseMs = 0;  // 0 holds the cue until it is released
+  uint8_t channel = 0;
+  uint8_t textLength = 0;
+};
+
+struct CompiledShow {
+  std::unique_ptr<ShowCueRecord[]> records;
+  std::unique_ptr<char[]> texts;
+  uint16_t count = 0;
+  uint32_t textBytes = 0;
+  uint32_t skippedLines = 0;
+  uint32_t loadUs = 0;
+
+  const char *text(const ShowCueRecord &record) const { return &texts[record.textOffset]; }
+};
+
+// Compiles a show file into one record array plus one text pool, streaming
+// the file twice (size, then fill) so nothing but the result is held in RAM.
+// Lines read `<channel>\t<autoReleaseMs>\t<text>` with 1-based channels; an
+// empty auto-release uses kCueAutoReleaseMillis, `#` starts a comment.
+// Returns nullptr when the file is missing, empty or too large.
+std::unique_ptr<CompiledShow> compileShowFile(fs::FS &fs, const char *path);
+
+}  // namespace stagecue
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+namespace stagecue {
+
+struct SlabPoolStats {
+  size_t slotSize = 0;
+  size_t slots = 0;
+  size_t inUse = 0;
+  size_t highWater = 0;
+  uint32_t acquires = 0;
+  uint32_t exhausted = 0;  // acquires refused because every slot was taken
+  uint32_t oversize = 0;   // requests larger than a slot
+};
+
+// Fixed-size blocks carved out of static storage, so long-running traffic
+// never touches (or fragments) the heap. acquire() and release() are
+// lock-free and may be called from any task.
+template <size_t SlotSize, size_t SlotCount>
+class SlabPool {
+  static_assert(SlotCount >= 1U && SlotCount <= 32U, "Slab pools hold 1 to 32 slots");
+
+ public:
+  static constexpr size_t kSlotSize = (SlotSize + alignof(max_align_t) - 1U) &
+                                      ~(alignof(max_align_t) - 1U);
+  static constexpr size_t kSlotCount = SlotCount;
+
+  SlabPool() = default;
+  SlabPool(const SlabPool &) = delete;
+  SlabPool &operator=(const SlabPool &) = delete;
+
+  // nullptr when `size` does not fit a slot or the pool is exhausted.
+  void *acquire(size_t size = SlotSize) {
+    if (size > kSlotSize) {
+      oversize_.fetch_add(1U, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    uint32_t free = free_.load(std::memory_order_relaxed);
+    uint32_t bit = 0;
+    do {
+      if (free == 0U) {
+        exhausted_.fetch_add(1U, std::memory_order_relaxed);
+        return nullptr;
+      }
+      bit = free & (~free + 1U);
+    } while (!free_.compare_exchange_weak(free, free & ~bit, std::memory_order_acquire,
+                                          std::memory_order_relaxed));
+
+    acquires_.fetch_add(1U, std::memory_order_relaxed);
+    const size_t inUse = SlotCount - static_cast<size_t>(__builtin_popcount(free & ~bit));
+    size_t highWater = highWater_.load(std::memory_order_relaxed);
+    while (inUse > highWater &&
+           !highWater_.compare_exchange_weak(highWater, inUse, std::memory_order_relaxed)) {
+    }
+    return storage_[__builtin_ctz(bit)];
+  }
+
+  // Ignores pointers the pool does not own, so callers may release blindly.
+  void release(void *block) {
+    if (!owns(block)) {
+      return;
+    }
+    const auto offset = static_cast<size_t>(static_cast<uint8_t *>(block) - storage_[0]);
+    free_.fetch_or(static_cast<uint32_t>(1UL << (offset / kSlotSize)), std::memory_order_release);
+  }
+
+  bool owns(const void *block) const {
+    const auto *bytes = static_cast<const uint8_t *>(block);
+    return bytes >= storage_[0] && bytes < storage_[0] + sizeof(storage_) &&
+           static_cast<size_t>(bytes - storage_[0]) % kSlotSize == 0U;
+  }
+
+  SlabPoolStats stats() const {
+    SlabPoolStats stats;
+    stats.slotSize = kSlotSize;
+    stats.slots = SlotCount;
+    stats.inUse = SlotCount - static_cast<size_t>(
+                                  __builtin_popcount(free_.load(std::memory_order_relaxed)));
+    stats.highWater = highWater_.load(std::memory_order_relaxed);
+    stats.acquires = acquires_.load(std::memory_order_relaxed);
+    stats.exhausted = exhausted_.load(std::memory_order_relaxed);
+    stats.oversize = oversize_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+ private:
+  static constexpr uint32_t kAllFree =
+      SlotCount == 32U ? 0xFFFFFFFFUL : static_cast<uint32_t>((1UL << SlotCount) - 1U);
+
+  alignas(max_align_t) uint8_t storage_[SlotCount][kSlotSize] = {};
+  std::atomic<uint32_t> free_{kAllFree};
+  std::atomic<size_t> highWater_{0};
+  std::atomic<uint32_t> acquires_{0};
+  std::atomic<uint32_t> exhausted_{0};
+  std::atomic<uint32_t> oversize_{0};
+};
+
+}  // namespace stagecue
@@ -1,28 +1,20 @@
+#include "boot_sequence.h"
 #include "config.h"
 #include "cues.h"
-#include "display_manager.h"
-#include "web_server.h"
-#include "wifi_portal.h"
+#include "run_loop.h"
 
 using namespace stagecue;
 
 void setup() {
   Serial.begin(115200);
-  delay(200);
-
-  if (!initDisplay()) {
-    Serial.println(F("[Setup] Display initialisation failed"));
-  }
+  initRunLoop();
 
+  // Buttons and LEDs first; everything slow comes up behind them.
   initCues();
 
-  if (!startWiFiWithPortal()) {
-    Serial.println(F("[Setup] Operating in access point mode"));
-  }
-
-  startWebServer();
+  startBackgroundBringUp();
 }
 
 void loop() {
-  updateCues();
+  runLoop();
 }
@@ -0,0 +1,128 @@
+#include "static_assets.h"
+
+#include <LittleFS.h>
+#include <atomic>
+
+#if defined(ESP32) || defined(ARDUINO_ARCH_ESP32)
+#include <ESPAsyncWebServer.h>
+#endif
+
+#if __has_include("static_assets_data.h")
+#include "static_assets_data.h"
+#define STAGECUE_HAS_PACKED_ASSETS 1
+#else
+#define STAGECUE_HAS_PACKED_ASSETS 0
+#endif
+
+namespace stagecue {
+
+namespace {
+
+#if STAGECUE_HAS_PACKED_ASSETS
+constexpr size_t kAssetCount = sizeof(packed::kAssets) / sizeof(packed::kAssets[0]);
+const StaticAsset *assetAt(size_t slot) {
+  return &packed::kAssets[slot];
+}
+#else
+constexpr size_t kAssetCount = 0;
+const StaticAsset *assetAt(size_t) {
+  return nullptr;
+}
+#endif
+
+struct AssetCounters {
+  std::atomic<uint32_t> requests{0};
+  std::atomic<uint32_t> notModified{0};
+  std::atomic<uint32_t> bytesSent{0};
+  std::atomic<uint32_t> lastServeUs{0};
+  std::atomic<uint32_t> maxServeUs{0};
+};
+
+AssetCounters gCounters[kAssetCount > 0 ? kAssetCount : 1];
+
+bool acceptsGzip(AsyncWebServerRequest *request) {
+  if (!request->hasHeader("Accept-Encoding")) {
+    return false;
+  }
+  return request->getHeader("Accept-Encoding")->value().indexOf("gzip") >= 0;
+}
+
+void recordServe(AssetCounters &counters, uint32_t startUs) {
+  const uint32_t elapsedUs = micros() - startUs;
+  counters.lastServeUs.store(elapsedUs, std::memory_order_relaxed);
+  uint32_t previous = counters.maxServeUs.load(std::memory_order_relaxed);
+  while (elapsedUs > previous &&
+         !counters.maxServeUs.compare_exchange_weak(previous, elapsedUs,
+                                                    std::memory_order_relaxed)) {
+  }
+}
+
+void serveAsset(AsyncWebServerRequest *request, size_t slot) {
+  const uint32_t startUs = micros();
+  const StaticAsset &asset = *assetAt(slot);
+  AssetCounters &counters = gCounters[slot];
+  counters.requests.fetch_add(1U, std::memory_order_relaxed);
+
+  AsyncWebServerResponse *response = nullptr;
+  if (request->hasHeader("If-None-Match") &&
+      request->getHeader("If-None-Match")->value() == asset.etag) {
+    counters.notModified.fetch_add(1U, std::memory_order_relaxed);
+    response = request->beginResponse(304);
+  } else if (acceptsGzip(request)) {
+    response = request->beginResponse_P(200, asset.contentType, asset.data, asset.length);
+    response->addHeader("Content-Encoding", "gzip");
+    counters.bytesSent.fetch_add(static_cast<uint32_t>(asset.length),
+                                 std::memory_order_relaxed);
+  } else {
+    // Rare client without gzip support: fall back to the plain file.
+    response = request->beginResponse(LittleFS, asset.path, asset.contentType);
+  }
+
+  response->addHeader("ETag", asset.etag);
+  response->addHeader("Cache-Control",
+                      asset.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+  request->send(response);
+  recordServe(counters, startUs);
+}
+
+}  // namespace
+
+bool registerStaticAssets(AsyncWebServer &server) {
+  if (kAssetCount == 0U) {
+    Serial.println(F("[Web] No packed assets, serving LittleFS directly"));
+    return false;
+  }
+
+  for (size_t slot = 0; slot < kAssetCount; ++slot) {
+    const StaticAsset &asset = *assetAt(slot);
+    server.on(asset.path, HTTP_GET,
+              [slot](AsyncWebServerRequest *request) { serveAsset(request, slot); });
+    if (strcmp(asset.path, "/index.html") == 0) {
+      server.on("/", HTTP_GET,
+                [slot](AsyncWebServerRequest *request) { serveAsset(request, slot); });
+    }
+  }
+  return true;
+}
+
+size_t getStaticAssetCount() {
+  return kAssetCount;
+}
+
+StaticAssetStats getStaticAssetStats(size_t slot) {
+  StaticAssetStats stats;
+  if (slot >= kAssetCount) {
+    return stats;
+  }
+
+  const AssetCounters &counters = gCounters[slot];
+  stats.path = assetAt(slot)->path;
+  stats.requests = counters.requests.load(std::memory_order_relaxed);
+  stats.notModified = counters.notModified.load(std::memory_order_relaxed);
+  stats.bytesSent = counters.bytesSent.load(std::memory_order_relaxed);
+  stats.lastServeUs = counters.lastServeUs.load(std::memory_order_relaxed);
+  stats.maxServeUs = counters.maxServeUs.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace stagecue
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Arduino.h>
+
+class AsyncWebServer;
+
+namespace stagecue {
+
+// One gzip'd asset compiled into flash by tools/pack_assets.py.
+struct StaticAsset {
+  const char *path;
+  const char *contentType;
+  const char *etag;  // quoted, strong
+  const uint8_t *data;
+  size_t length;
+  bool immutable;  // referenced with ?v=<hash>, safe to cache forever
+};
+
+struct StaticAssetStats {
+  const char *path = nullptr;
+  uint32_t requests = 0;
+  uint32_t notModified = 0;
+  uint32_t bytesSent = 0;
+  uint32_t lastServeUs = 0;
+  uint32_t maxServeUs = 0;
+};
+
+// Registers a route per packed asset; false when the firmware was built
+// without running the pack step, in which case LittleFS serves everything.
+bool registerStaticAssets(AsyncWebServer &server);
+size_t getStaticAssetCount();
+StaticAssetStats getStaticAssetStats(size_t slot);
+
+}  // namespace stagecue
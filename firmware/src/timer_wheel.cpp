@@ -0,0 +1,250 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+
+namespace stagecue {
+
+namespace {
+
+constexpr uint32_t kRootMask = 0xFFU;
+constexpr uint32_t kOuterMask = 0x3FU;
+constexpr uint8_t kOuterShift[] = {8U, 14U, 20U};
+constexpr uint32_t kHorizonMs = (1UL << 26U) - 1U;
+
+}  // namespace
+
+TimerWheel::TimerWheel(uint32_t nowMs) : currentMs_(nowMs) {
+  heads_.fill(kNone);
+  for (uint16_t i = 0; i < timers_.size(); ++i) {
+    timers_[i].next = static_cast<uint16_t>(i + 1U < timers_.size() ? i + 1U : kNone);
+    timers_[i].generation = 1;
+  }
+  freeHead_ = timers_.empty() ? kNone : 0;
+}
+
+uint16_t TimerWheel::bucketFor(uint32_t deadlineMs) const {
+  int32_t delta = static_cast<int32_t>(deadlineMs - currentMs_);
+  if (delta < 0) {
+    delta = 0;
+    deadlineMs = currentMs_;
+  }
+  if (static_cast<uint32_t>(delta) > kHorizonMs) {
+    deadlineMs = currentMs_ + kHorizonMs;
+    delta = static_cast<int32_t>(kHorizonMs);
+  }
+
+  if (delta < static_cast<int32_t>(kRootSlots)) {
+    return static_cast<uint16_t>(deadlineMs & kRootMask);
+  }
+  for (size_t level = 0; level < kLevels - 1U; ++level) {
+    const uint32_t span = 1UL << (kOuterShift[level] + 6U);
+    if (static_cast<uint32_t>(delta) < span || level == kLevels - 2U) {
+      return static_cast<uint16_t>(kRootSlots + level * kOuterSlots +
+                                   ((deadlineMs >> kOuterShift[level]) & kOuterMask));
+    }
+  }
+  return kNone;  // unreachable
+}
+
+void TimerWheel::link(uint16_t index) {
+  Timer &timer = timers_[index];
+  const uint16_t bucket = bucketFor(timer.deadlineMs);
+  timer.bucket = bucket;
+  timer.prev = kNone;
+  timer.next = heads_[bucket];
+  if (timer.next != kNone) {
+    timers_[timer.next].prev = index;
+  }
+  heads_[bucket] = index;
+
+  if (bucket < kRootSlots) {
+    rootOccupied_[bucket / 64U] |= 1ULL << (bucket % 64U);
+  } else {
+    const size_t outer = bucket - kRootSlots;
+    outerOccupied_[outer / kOuterSlots] |= 1ULL << (outer % kOuterSlots);
+  }
+}
+
+void TimerWheel::unlink(uint16_t index) {
+  Timer &timer = timers_[index];
+  const uint16_t bucket = timer.bucket;
+  if (timer.prev != kNone) {
+    timers_[timer.prev].next = timer.next;
+  } else {
+    heads_[bucket] = timer.next;
+  }
+  if (timer.next != kNone) {
+    timers_[timer.next].prev = timer.prev;
+  }
+
+  if (heads_[bucket] == kNone) {
+    if (bucket < kRootSlots) {
+      rootOccupied_[bucket / 64U] &= ~(1ULL << (bucket % 64U));
+    } else {
+      const size_t outer = bucket - kRootSlots;
+      outerOccupied_[outer / kOuterSlots] &= ~(1ULL << (outer % kOuterSlots));
+    }
+  }
+  timer.bucket = kNone;
+}
+
+void TimerWheel::release(uint16_t index) {
+  Timer &timer = timers_[index];
+  timer.callback = nullptr;
+  timer.generation = static_cast<uint16_t>(timer.generation + 1U);
+  if (timer.generation == 0U) {
+    timer.generation = 1;  // keep ids non-zero
+  }
+  timer.next = freeHead_;
+  freeHead_ = index;
+  --stats_.pending;
+}
+
+TimerId TimerWheel::schedule(uint32_t deadlineMs, Callback callback, uint32_t arg) {
+  if (callback == nullptr) {
+    return kInvalidTimer;
+  }
+  if (freeHead_ == kNone) {
+    ++stats_.exhausted;
+    return kInvalidTimer;
+  }
+
+  const uint16_t index = freeHead_;
+  Timer &timer = timers_[index];
+  freeHead_ = timer.next;
+  timer.deadlineMs = deadlineMs;
+  timer.callback = callback;
+  timer.arg = arg;
+  link(index);
+
+  ++stats_.scheduled;
+  ++stats_.pending;
+  if (stats_.pending > stats_.highWater) {
+    stats_.highWater = stats_.pending;
+  }
+  return (static_cast<TimerId>(timer.generation) << 16U) | index;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+  const uint16_t index = static_cast<uint16_t>(id & 0xFFFFU);
+  if (id == kInvalidTimer || index >= timers_.size()) {
+    return false;
+  }
+  Timer &timer = timers_[index];
+  if (timer.bucket == kNone || timer.generation != static_cast<uint16_t>(id >> 16U)) {
+    return false;
+  }
+
+  unlink(index);
+  release(index);
+  ++stats_.cancelled;
+  return true;
+}
+
+void TimerWheel::cascade(size_t level) {
+  const uint16_t bucket = static_cast<uint16_t>(
+      kRootSlots + level * kOuterSlots + ((currentMs_ >> kOuterShift[level]) & kOuterMask));
+  uint16_t index = heads_[bucket];
+  heads_[bucket] = kNone;
+  outerOccupied_[level] &= ~(1ULL << (bucket - kRootSlots - level * kOuterSlots));
+
+  while (index != kNone) {
+    const uint16_t next = timers_[index].next;
+    link(index);
+    ++stats_.cascaded;
+    index = next;
+  }
+}
+
+bool TimerWheel::rootSlotOccupied(size_t slot) const {
+  return (rootOccupied_[slot / 64U] & (1ULL << (slot % 64U))) != 0U;
+}
+
+namespace {
+
+// Distance from `from` to the next set bit of a 256-bit ring, or -1.
+int32_t nextOccupied(const std::array<uint64_t, 4> &bits, size_t from) {
+  for (size_t step = 0; step <= 4U; ++step) {
+    const size_t word = (from / 64U + step) % 4U;
+    uint64_t mask = bits[word];
+    if (step == 0U) {
+      mask &= ~0ULL << (from % 64U);
+    } else if (step == 4U) {
+      mask &= (from % 64U) == 0U ? 0ULL : ~(~0ULL << (from % 64U));
+    }
+    if (mask != 0U) {
+      const size_t slot = word * 64U + static_cast<size_t>(__builtin_ctzll(mask));
+      return static_cast<int32_t>((slot - from) & kRootMask);
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
+size_t TimerWheel::advance(uint32_t nowMs) {
+  size_t fired = 0;
+  while (static_cast<int32_t>(nowMs - currentMs_) >= 0) {
+    if ((currentMs_ & kRootMask) == 0U) {
+      for (size_t level = 0; level < kLevels - 1U; ++level) {
+        cascade(level);
+        if (((currentMs_ >> kOuterShift[level]) & kOuterMask) != 0U) {
+          break;
+        }
+      }
+    }
+
+    const uint16_t slot = static_cast<uint16_t>(currentMs_ & kRootMask);
+    while (heads_[slot] != kNone) {
+      const uint16_t index = heads_[slot];
+      const Callback callback = timers_[index].callback;
+      const uint32_t arg = timers_[index].arg;
+      unlink(index);
+      release(index);
+      ++stats_.fired;
+      ++fired;
+      callback(arg);
+    }
+
+    // Skip straight to the next occupied slot, cascade boundary or `nowMs`.
+    uint32_t step = (nowMs - currentMs_) + 1U;
+    const int32_t occupied = nextOccupied(rootOccupied_, (slot + 1U) & kRootMask);
+    if (occupied >= 0) {
+      step = std::min<uint32_t>(step, static_cast<uint32_t>(occupied) + 1U);
+    }
+    const bool outerPending =
+        outerOccupied_[0] != 0U || outerOccupied_[1] != 0U || outerOccupied_[2] != 0U;
+    if (outerPending) {
+      step = std::min<uint32_t>(step, kRootSlots - slot);
+    }
+    currentMs_ += step;
+  }
+  return fired;
+}
+
+uint32_t TimerWheel::millisUntilNext(uint32_t nowMs, uint32_t limitMs) const {
+  if (stats_.pending == 0U) {
+    return limitMs;
+  }
+
+  const size_t slot = currentMs_ & kRootMask;
+  uint32_t nextMs = currentMs_ + kHorizonMs;
+  const int32_t occupied = nextOccupied(rootOccupied_, slot);
+  if (occupied >= 0) {
+    nextMs = currentMs_ + static_cast<uint32_t>(occupied);
+  }
+  if (outerOccupied_[0] != 0U || outerOccupied_[1] != 0U || outerOccupied_[2] != 0U) {
+    const uint32_t boundary = slot == 0U ? currentMs_ : currentMs_ + (kRootSlots - slot);
+    if (static_cast<int32_t>(boundary - nextMs) < 0) {
+      nextMs = boundary;
+    }
+  }
+
+  const int32_t remaining = static_cast<int32_t>(nextMs - nowMs);
+  if (remaining <= 0) {
+    return 0;
+  }
+  return std::min(limitMs, static_cast<uint32_t>(remaining));
+}
+
+}  // namespace stagecue
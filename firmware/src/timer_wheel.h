@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+#include "config.h"
+
+namespace stagecue {
+
+using TimerId = uint32_t;  // slot in the low half, generation in the high half
+inline constexpr TimerId kInvalidTimer = 0;
+
+struct TimerWheelStats {
+  uint32_t pending = 0;
+  uint32_t highWater = 0;
+  uint32_t scheduled = 0;
+  uint32_t fired = 0;
+  uint32_t cancelled = 0;
+  uint32_t exhausted = 0;  // schedule() calls refused because the pool was full
+  uint32_t cascaded = 0;   // timers moved down a level
+};
+
+// Hierarchical timing wheel with 1 ms resolution over a fixed pool of
+// kTimerPoolSize timers. Four levels of 256/64/64/64 slots cover about 18 h;
+// later deadlines are parked at the horizon and re-filed as it approaches.
+// Scheduling and cancelling are O(1); advance() costs one step per occupied
+// slot or cascade boundary plus one per timer fired. Not thread-safe: the
+// cue engine owns it.
+class TimerWheel {
+ public:
+  using Callback = void (*)(uint32_t arg);
+
+  explicit TimerWheel(uint32_t nowMs = 0);
+
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+
+  // Deadlines already in the past fire on the next advance(). Returns
+  // kInvalidTimer when the pool is exhausted.
+  TimerId schedule(uint32_t deadlineMs, Callback callback, uint32_t arg);
+  // False when the timer already fired or was cancelled.
+  bool cancel(TimerId id);
+  // Fires every timer due at or before `nowMs`; returns how many fired.
+  size_t advance(uint32_t nowMs);
+  // Time until advance() next has work (a deadline or a cascade), capped at
+  // `limitMs`. Never later than the earliest deadline.
+  uint32_t millisUntilNext(uint32_t nowMs, uint32_t limitMs) const;
+
+  size_t pending() const { return stats_.pending; }
+  const TimerWheelStats &stats() const { return stats_; }
+
+ private:
+  static constexpr size_t kLevels = 4U;
+  static constexpr uint8_t kLevelBits[kLevels] = {8U, 6U, 6U, 6U};
+  static constexpr size_t kRootSlots = 1U << 8U;
+  static constexpr size_t kOuterSlots = 1U << 6U;
+  static constexpr size_t kSlotCount = kRootSlots + (kLevels - 1U) * kOuterSlots;
+  static constexpr uint16_t kNone = UINT16_MAX;
+
+  struct Timer {
+    uint32_t deadlineMs = 0;
+    uint32_t arg = 0;
+    Callback callback = nullptr;
+    uint16_t next = kNone;
+    uint16_t prev = kNone;
+    uint16_t bucket = kNone;  // kNone while on the free list
+    uint16_t generation = 0;
+  };
+
+  static_assert(kTimerPoolSize < kNone, "Timer indices are 16-bit");
+
+  uint16_t bucketFor(uint32_t deadlineMs) const;
+  void link(uint16_t index);
+  void unlink(uint16_t index);
+  void release(uint16_t index);
+  void cascade(size_t level);
+  bool rootSlotOccupied(size_t slot) const;
+
+  std::array<Timer, kTimerPoolSize> timers_{};
+  std::array<uint16_t, kSlotCount> heads_{};
+  std::array<uint64_t, kRootSlots / 64U> rootOccupied_{};
+  std::array<uint64_t, kLevels - 1U> outerOccupied_{};
+  uint16_t freeHead_ = kNone;
+  uint32_t currentMs_ = 0;  // next tick advance() will process
+  TimerWheelStats stats_;
+};
+
+}  // namespace stagecue
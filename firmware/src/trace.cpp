@@ -0,0 +1,166 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <string.h>
+
+namespace stagecue {
+
+namespace {
+
+// Each core only ever writes its own row, with local interrupts masked, so
+// rows need no cross-core lock. Readers retry while `sequence` is odd or
+// moves under them.
+struct TraceRow {
+  std::atomic<uint32_t> sequence{0};
+  std::array<TraceCounters, kTraceEventCount> counters{};
+  std::array<std::array<uint32_t, kTraceHistogramBuckets>, kTraceEventCount> histogram{};
+};
+
+std::array<TraceRow, portNUM_PROCESSORS> gRows;
+std::array<TraceRecord, kTraceRingSize> gRing{};
+std::atomic<uint32_t> gRingHead{0};
+std::atomic<bool> gTraceEnabled{true};
+
+constexpr const char *kEventNames[kTraceEventCount] = {
+    "button_edge",
+    "apply_cue_state",
+    "display_render",
+    "display_flush",
+    "json_encode",
+    "json_decode",
+    "ws_send",
+};
+
+size_t bucketFor(uint32_t durationUs) {
+  if (durationUs <= 1U) {
+    return 0U;
+  }
+  const size_t bucket = 32U - static_cast<size_t>(__builtin_clz(durationUs - 1U));
+  return std::min(bucket, kTraceHistogramBuckets - 1U);
+}
+
+template <typename Fn>
+void readRow(const TraceRow &row, Fn &&read) {
+  for (;;) {
+    const uint32_t before = row.sequence.load(std::memory_order_acquire);
+    if ((before & 1U) == 0U) {
+      read();
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (row.sequence.load(std::memory_order_relaxed) == before) {
+        return;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+#if STAGECUE_TRACE
+
+void recordTrace(TraceEvent event, uint32_t startUs, uint32_t durationUs, uint16_t arg) {
+  const size_t slot = static_cast<size_t>(event);
+  if (slot >= kTraceEventCount || !gTraceEnabled.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  const uint32_t position = gRingHead.fetch_add(1U, std::memory_order_relaxed);
+  const uint32_t interrupts = portSET_INTERRUPT_MASK_FROM_ISR();
+  const uint8_t core = static_cast<uint8_t>(xPortGetCoreID());
+
+  gRing[position % kTraceRingSize] = {startUs, durationUs, static_cast<uint8_t>(slot), core, arg};
+
+  TraceRow &row = gRows[core];
+  row.sequence.fetch_add(1U, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  TraceCounters &counters = row.counters[slot];
+  ++counters.count;
+  counters.totalUs += durationUs;
+  counters.maxUs = std::max(counters.maxUs, durationUs);
+  ++row.histogram[slot][bucketFor(durationUs)];
+  row.sequence.fetch_add(1U, std::memory_order_release);
+
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(interrupts);
+}
+
+#endif
+
+bool isTraceCompiledIn() { return STAGECUE_TRACE != 0; }
+
+void setTraceEnabled(bool enabled) { gTraceEnabled.store(enabled, std::memory_order_relaxed); }
+
+bool isTraceEnabled() {
+  return isTraceCompiledIn() && gTraceEnabled.load(std::memory_order_relaxed);
+}
+
+const char *traceEventName(TraceEvent event) {
+  const size_t slot = static_cast<size_t>(event);
+  return slot < kTraceEventCount ? kEventNames[slot] : "unknown";
+}
+
+uint32_t getTraceSpanTotal() { return gRingHead.load(std::memory_order_relaxed); }
+
+TraceCounters getTraceCounters(TraceEvent event, uint8_t core) {
+  TraceCounters counters;
+  const size_t slot = static_cast<size_t>(event);
+  if (slot >= kTraceEventCount || core >= gRows.size()) {
+    return counters;
+  }
+
+  const TraceRow &row = gRows[core];
+  readRow(row, [&] { counters = row.counters[slot]; });
+  return counters;
+}
+
+void getTraceHistogram(TraceEvent event, uint32_t (&buckets)[kTraceHistogramBuckets]) {
+  std::fill(std::begin(buckets), std::end(buckets), 0U);
+  const size_t slot = static_cast<size_t>(event);
+  if (slot >= kTraceEventCount) {
+    return;
+  }
+
+  for (const TraceRow &row : gRows) {
+    std::array<uint32_t, kTraceHistogramBuckets> copy;
+    readRow(row, [&] { copy = row.histogram[slot]; });
+    for (size_t i = 0; i < kTraceHistogramBuckets; ++i) {
+      buckets[i] += copy[i];
+    }
+  }
+}
+
+uint32_t traceHistogramBound(size_t bucket) {
+  return bucket + 1U < kTraceHistogramBuckets ? 1UL << bucket : 0U;
+}
+
+size_t traceDumpCapacity() { return sizeof(TraceDumpHeader) + sizeof(gRing); }
+
+// Spans written while the copy runs may come out torn or newer than their
+// neighbours; the dump is a debugging aid, not a consistent snapshot.
+size_t copyTraceDump(uint8_t *buffer, size_t capacity) {
+  if (capacity < sizeof(TraceDumpHeader)) {
+    return 0U;
+  }
+
+  const uint32_t total = gRingHead.load(std::memory_order_acquire);
+  const size_t fit = (capacity - sizeof(TraceDumpHeader)) / sizeof(TraceRecord);
+  const size_t count = std::min<size_t>({total, kTraceRingSize, fit});
+
+  TraceDumpHeader header;
+  memcpy(header.magic, "SCTR", sizeof(header.magic));
+  header.version = 1U;
+  header.recordSize = sizeof(TraceRecord);
+  header.recordCount = static_cast<uint32_t>(count);
+  header.totalSpans = total;
+  memcpy(buffer, &header, sizeof(header));
+
+  uint8_t *out = buffer + sizeof(header);
+  for (size_t i = 0; i < count; ++i) {
+    const uint32_t position = total - static_cast<uint32_t>(count) + static_cast<uint32_t>(i);
+    memcpy(out, &gRing[position % kTraceRingSize], sizeof(TraceRecord));
+    out += sizeof(TraceRecord);
+  }
+  return static_cast<size_t>(out - buffer);
+}
+
+}  // namespace stagecue
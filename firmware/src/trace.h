@@ -0,0 +1,106 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+// Hot-path spans and counters. Build with -DSTAGECUE_TRACE=0 to compile every
+// STAGECUE_TRACE_* macro out of the firmware.
+#ifndef STAGECUE_TRACE
+#define STAGECUE_TRACE 1
+#endif
+
+namespace stagecue {
+
+enum class TraceEvent : uint8_t {
+  kButtonEdge = 0,  // edge interrupt to the cue engine picking it up
+  kApplyCueState,
+  kDisplayRender,
+  kDisplayFlush,    // I2C transfer of one panel, on the flush task
+  kJsonEncode,
+  kJsonDecode,
+  kWsSend,
+  kCount,
+};
+
+inline constexpr size_t kTraceEventCount = static_cast<size_t>(TraceEvent::kCount);
+// Histogram upper bounds are 1, 2, 4, ... 2^(n-2) µs, plus +Inf.
+inline constexpr size_t kTraceHistogramBuckets = 18U;
+
+// One span as stored in the ring and in the /api/trace dump (little endian).
+struct TraceRecord {
+  uint32_t startUs;
+  uint32_t durationUs;
+  uint8_t event;
+  uint8_t core;
+  uint16_t arg;  // cue index or byte count, depending on the event
+};
+static_assert(sizeof(TraceRecord) == 12U, "Trace dump format expects 12-byte records");
+
+struct TraceDumpHeader {
+  char magic[4];  // "SCTR"
+  uint16_t version;
+  uint16_t recordSize;
+  uint32_t recordCount;
+  uint32_t totalSpans;  // spans recorded since boot; older ones were overwritten
+};
+static_assert(sizeof(TraceDumpHeader) == 16U, "Trace dump header is 16 bytes");
+
+struct TraceCounters {
+  uint32_t count = 0;
+  uint64_t totalUs = 0;
+  uint32_t maxUs = 0;
+};
+
+#if STAGECUE_TRACE
+
+void recordTrace(TraceEvent event, uint32_t startUs, uint32_t durationUs, uint16_t arg);
+
+class TraceScope {
+ public:
+  TraceScope(TraceEvent event, uint16_t arg) : event_(event), arg_(arg), startUs_(micros()) {}
+  ~TraceScope() { recordTrace(event_, startUs_, micros() - startUs_, arg_); }
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+ private:
+  TraceEvent event_;
+  uint16_t arg_;
+  uint32_t startUs_;
+};
+
+#define STAGECUE_TRACE_CONCAT_(a, b) a##b
+#define STAGECUE_TRACE_CONCAT(a, b) STAGECUE_TRACE_CONCAT_(a, b)
+// Records a span covering the rest of the enclosing scope.
+#define STAGECUE_TRACE_SCOPE(event, arg)                                         \
+  ::stagecue::TraceScope STAGECUE_TRACE_CONCAT(stagecueTraceScope, __LINE__)( \
+      ::stagecue::TraceEvent::event, static_cast<uint16_t>(arg))
+// Records a span from `startUs` until now.
+#define STAGECUE_TRACE_SINCE(event, startUs, arg)                                \
+  ::stagecue::recordTrace(::stagecue::TraceEvent::event, (startUs),              \
+                          micros() - (startUs), static_cast<uint16_t>(arg))
+
+#else
+
+#define STAGECUE_TRACE_SCOPE(event, arg) static_cast<void>(0)
+#define STAGECUE_TRACE_SINCE(event, startUs, arg) static_cast<void>(startUs)
+
+#endif
+
+bool isTraceCompiledIn();
+// Runtime switch; recording stays compiled in but returns straight away.
+void setTraceEnabled(bool enabled);
+bool isTraceEnabled();
+const char *traceEventName(TraceEvent event);
+uint32_t getTraceSpanTotal();  // spans recorded since boot
+TraceCounters getTraceCounters(TraceEvent event, uint8_t core);
+// Non-cumulative bucket counts across both cores.
+void getTraceHistogram(TraceEvent event, uint32_t (&buckets)[kTraceHistogramBuckets]);
+uint32_t traceHistogramBound(size_t bucket);  // 0 for the +Inf bucket
+
+// Copies the ring, oldest span first, behind a TraceDumpHeader. Returns the
+// bytes written; `capacity` of traceDumpCapacity() always fits.
+size_t copyTraceDump(uint8_t *buffer, size_t capacity);
+size_t traceDumpCapacity();
+
+}  // namespace stagecue
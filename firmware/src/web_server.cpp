@@ -4,10 +4,29 @@
 #include <FS.h>
 #include <LittleFS.h>
 #include <WiFi.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <new>
 
+#include "binary_protocol.h"
+#include "boot_timeline.h"
 #include "config.h"
+#include "cue_fabric.h"
+#include "cue_store.h"
 #include "cues.h"
+#include "display_manager.h"
+#include "json_stream.h"
+#include "latency_stats.h"
+#include "message_pools.h"
+#include "metrics.h"
+#include "run_loop.h"
+#include "static_assets.h"
+#include "trace.h"
 #include "wifi_portal.h"
+#include "wifi_supervisor.h"
 
 #if defined(ESP32) || defined(ARDUINO_ARCH_ESP32)
 #include <AsyncTCP.h>
@@ -20,10 +39,223 @@ namespace stagecue {
 
 namespace {
 
-constexpr size_t kMaxIncomingMessageSize = 512U;
+// Cue entries link label text by pointer, so only the JSON nodes count here.
+constexpr size_t kCueListJsonCapacity =
+    JSON_ARRAY_SIZE(kCueCount) + kCueCount * JSON_OBJECT_SIZE(4);
+constexpr size_t kInitJsonCapacity =
+    JSON_OBJECT_SIZE(5) + kCueListJsonCapacity + JSON_OBJECT_SIZE(2) + 64U;
+constexpr size_t kSnapshotJsonCapacity = JSON_OBJECT_SIZE(3) + kCueListJsonCapacity;
+constexpr size_t kDeltaJsonCapacity = JSON_OBJECT_SIZE(4) + kCueListJsonCapacity;
+constexpr size_t kLatencyJsonCapacity = JSON_OBJECT_SIZE(4) + JSON_ARRAY_SIZE(kLatencyProbeCount) +
+                                        kLatencyProbeCount * JSON_OBJECT_SIZE(5) +
+                                        JSON_OBJECT_SIZE(4) + JSON_OBJECT_SIZE(7) +
+                                        JSON_OBJECT_SIZE(3);
+constexpr size_t kDisplayStatsJsonCapacity =
+    JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(kCueCount) + kCueCount * JSON_OBJECT_SIZE(5);
+constexpr size_t kAssetStatsJsonCapacity =
+    JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(kMaxPackedAssets) + kMaxPackedAssets * JSON_OBJECT_SIZE(6);
+constexpr size_t kFabricJsonCapacity = JSON_OBJECT_SIZE(13) + JSON_ARRAY_SIZE(kFabricMaxPeers) +
+                                       kFabricMaxPeers * JSON_OBJECT_SIZE(4);
+constexpr size_t kWifiJsonCapacity = JSON_OBJECT_SIZE(15) + JSON_ARRAY_SIZE(kWifiMaxSavedNetworks) +
+                                     kWifiMaxSavedNetworks * JSON_OBJECT_SIZE(2);
+constexpr size_t kTaskStatsJsonCapacity =
+    JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(kRunLoopTaskCount) + kRunLoopTaskCount * JSON_OBJECT_SIZE(6);
+constexpr size_t kWebSocketStatsJsonCapacity =
+    JSON_OBJECT_SIZE(6) + JSON_ARRAY_SIZE(kMaxWebSocketClients) +
+    kMaxWebSocketClients * JSON_OBJECT_SIZE(7) + 2U * JSON_OBJECT_SIZE(4) +
+    JSON_OBJECT_SIZE(7) + JSON_OBJECT_SIZE(4) + JSON_ARRAY_SIZE(kMessagePoolCount) +
+    kMessagePoolCount * JSON_OBJECT_SIZE(7);
 AsyncWebServer gServer(80);
 AsyncWebSocket gWebSocket("/ws");
 
+enum ProtocolEncoding : uint8_t {
+  kEncodingJson = 0,
+  kEncodingBinary,
+  kEncodingCount,
+};
+
+struct ClientSession {
+  uint32_t id = 0;  // 0 marks a free slot
+  bool binary = false;
+  // Cues whose latest state could not be queued to this client yet. Newer
+  // changes to the same cue replace, rather than queue behind, older ones.
+  uint32_t pendingMask = 0;
+  uint32_t pendingTextMask = 0;
+  uint32_t stalledSinceMs = 0;
+  // Best clock sample the client reported: its offset to device time and
+  // the round trip it was measured over.
+  bool clockSynced = false;
+  float clockOffsetMs = 0.0f;
+  float clockRttMs = 0.0f;
+};
+
+struct ProtocolCounters {
+  std::atomic<uint32_t> framesIn{0};
+  std::atomic<uint32_t> bytesIn{0};
+  std::atomic<uint32_t> framesOut{0};
+  std::atomic<uint32_t> bytesOut{0};
+};
+
+using SessionTable = std::array<ClientSession, kMaxWebSocketClients>;
+
+// Written from the AsyncTCP task on connect/disconnect/hello, read by the cue
+// engine when it broadcasts; both sides go through gSessionLock.
+SessionTable gSessions{};
+portMUX_TYPE gSessionLock = portMUX_INITIALIZER_UNLOCKED;
+std::array<ProtocolCounters, kEncodingCount> gProtocolCounters;
+std::atomic<uint16_t> gStateSequence{0};
+std::atomic<bool> gShowReloadRunning{false};
+
+// Which cue each recent sequence number changed, oldest first. The epoch is
+// drawn at boot so a client never resumes against a restarted device.
+struct StateDelta {
+  uint16_t sequence = 0;
+  uint8_t index = 0;
+};
+
+std::array<StateDelta, kStateDeltaRingSize> gDeltaRing{};
+size_t gDeltaHead = 0;
+size_t gDeltaCount = 0;
+uint32_t gSessionEpoch = 0;
+portMUX_TYPE gDeltaLock = portMUX_INITIALIZER_UNLOCKED;
+
+struct ResumeCounters {
+  std::atomic<uint32_t> deltas{0};
+  std::atomic<uint32_t> snapshots{0};
+  std::atomic<uint32_t> deltaBytes{0};
+  std::atomic<uint32_t> snapshotBytes{0};
+};
+
+ResumeCounters gResumeCounters;
+
+struct BroadcastCounters {
+  std::atomic<uint32_t> notifications{0};
+  std::atomic<uint32_t> coalesced{0};
+  std::atomic<uint32_t> encodes{0};
+  std::atomic<uint32_t> deliveries{0};
+  std::atomic<uint32_t> deferred{0};
+  std::atomic<uint32_t> slowClientsDropped{0};
+  std::atomic<uint32_t> bufferFailures{0};  // makeBuffer() refused a shared payload
+};
+
+// A scan notification that found no buffer, resent by flushCueBroadcasts().
+std::atomic<bool> gScanNotifyPending{false};
+
+// Cues changed since the last flushCueBroadcasts(); cue engine task only.
+uint32_t gDirtyCueMask = 0;
+uint32_t gTextDirtyCueMask = 0;
+std::array<uint16_t, kCueCount> gCueSequences{};
+BroadcastCounters gBroadcastCounters;
+
+bool openSession(uint32_t id) {
+  bool opened = false;
+  portENTER_CRITICAL(&gSessionLock);
+  for (auto &session : gSessions) {
+    if (session.id == 0U) {
+      session = ClientSession{id, false};
+      opened = true;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&gSessionLock);
+  return opened;
+}
+
+void closeSession(uint32_t id) {
+  portENTER_CRITICAL(&gSessionLock);
+  for (auto &session : gSessions) {
+    if (session.id == id) {
+      session = ClientSession{};
+    }
+  }
+  portEXIT_CRITICAL(&gSessionLock);
+}
+
+void deferForSession(uint32_t id, uint32_t cueBit, bool textChanged) {
+  portENTER_CRITICAL(&gSessionLock);
+  for (auto &session : gSessions) {
+    if (session.id == id) {
+      if (session.pendingMask == 0U) {
+        session.stalledSinceMs = millis();
+      }
+      session.pendingMask |= cueBit;
+      if (textChanged) {
+        session.pendingTextMask |= cueBit;
+      }
+    }
+  }
+  portEXIT_CRITICAL(&gSessionLock);
+}
+
+// Removes and returns a session's backlog so it can be retried.
+ClientSession takeSessionBacklog(uint32_t id) {
+  ClientSession backlog;
+  portENTER_CRITICAL(&gSessionLock);
+  for (auto &session : gSessions) {
+    if (session.id == id) {
+      backlog = session;
+      session.pendingMask = 0;
+      session.pendingTextMask = 0;
+    }
+  }
+  portEXIT_CRITICAL(&gSessionLock);
+  return backlog;
+}
+
+void setSessionBinary(uint32_t id, bool binary) {
+  portENTER_CRITICAL(&gSessionLock);
+  for (auto &session : gSessions) {
+    if (session.id == id) {
+      session.binary = binary;
+    }
+  }
+  portEXIT_CRITICAL(&gSessionLock);
+}
+
+void setSessionClock(uint32_t id, float offsetMs, float rttMs) {
+  portENTER_CRITICAL(&gSessionLock);
+  for (auto &session : gSessions) {
+    if (session.id == id) {
+      session.clockSynced = true;
+      session.clockOffsetMs = offsetMs;
+      session.clockRttMs = rttMs;
+    }
+  }
+  portEXIT_CRITICAL(&gSessionLock);
+}
+
+size_t copySessions(SessionTable &out) {
+  size_t count = 0;
+  portENTER_CRITICAL(&gSessionLock);
+  for (const auto &session : gSessions) {
+    if (session.id != 0U) {
+      out[count++] = session;
+    }
+  }
+  portEXIT_CRITICAL(&gSessionLock);
+  return count;
+}
+
+void countInbound(ProtocolEncoding encoding, size_t bytes) {
+  auto &counters = gProtocolCounters[encoding];
+  counters.framesIn.fetch_add(1U, std::memory_order_relaxed);
+  counters.bytesIn.fetch_add(static_cast<uint32_t>(bytes), std::memory_order_relaxed);
+}
+
+void countOutbound(ProtocolEncoding encoding, size_t bytes) {
+  auto &counters = gProtocolCounters[encoding];
+  counters.framesOut.fetch_add(1U, std::memory_order_relaxed);
+  counters.bytesOut.fetch_add(static_cast<uint32_t>(bytes), std::memory_order_relaxed);
+}
+
+void writeProtocolCounters(JsonObject entry, ProtocolEncoding encoding) {
+  const auto &counters = gProtocolCounters[encoding];
+  entry["framesIn"] = counters.framesIn.load(std::memory_order_relaxed);
+  entry["bytesIn"] = counters.bytesIn.load(std::memory_order_relaxed);
+  entry["framesOut"] = counters.framesOut.load(std::memory_order_relaxed);
+  entry["bytesOut"] = counters.bytesOut.load(std::memory_order_relaxed);
+}
+
 String wifiModeToString(wifi_mode_t mode) {
   switch (mode) {
     case WIFI_MODE_NULL:
@@ -39,19 +271,67 @@ String wifiModeToString(wifi_mode_t mode) {
   }
 }
 
-void sendJson(AsyncWebSocketClient &client, const JsonDocument &doc) {
-  String payload;
-  serializeJson(doc, payload);
-  client.text(payload);
+// Serializes into a pooled frame, which text() copies into a message of the
+// library's own; only our side of the send is pooled. With the pool empty, or
+// for a snapshot full of escaped labels that outgrows a slot, the frame goes
+// out through a heap String instead: a reply the client waits for, or the
+// state it resumes from, must not be dropped.
+size_t sendJson(AsyncWebSocketClient &client, const JsonDocument &doc) {
+  const size_t length = measureJson(doc);
+  MessageBuffer frame(MessagePool::kOutbound, length + 1U);
+  if (frame) {
+    {
+      STAGECUE_TRACE_SCOPE(kJsonEncode, client.id());
+      serializeJson(doc, frame.data(), length + 1U);
+    }
+    STAGECUE_TRACE_SCOPE(kWsSend, length);
+    client.text(frame.data(), length);
+  } else {
+    String payload;
+    {
+      STAGECUE_TRACE_SCOPE(kJsonEncode, client.id());
+      serializeJson(doc, payload);
+    }
+    STAGECUE_TRACE_SCOPE(kWsSend, length);
+    client.text(payload);
+  }
+  countOutbound(kEncodingJson, length);
+  return length;
 }
 
-void broadcastJson(const JsonDocument &doc) {
-  if (gWebSocket.count() == 0) {
-    return;
+void sendBinary(AsyncWebSocketClient &client, const BinaryFrame &frame) {
+  uint8_t encoded[kBinaryFrameSize];
+  encodeBinaryFrame(frame, encoded);
+  STAGECUE_TRACE_SCOPE(kWsSend, sizeof(encoded));
+  client.binary(encoded, sizeof(encoded));
+  countOutbound(kEncodingBinary, sizeof(encoded));
+}
+
+// One library buffer shared by every client: a heap block per broadcast
+// rather than per client, allocated by AsyncWebSocket and not pooled. False
+// when the library had no buffer; the caller decides how the message is
+// made up for.
+bool broadcastJson(const JsonDocument &doc) {
+  const size_t clients = gWebSocket.count();
+  if (clients == 0) {
+    return true;
   }
-  String payload;
-  serializeJson(doc, payload);
+
+  const uint32_t encodeStartUs = micros();
+  const size_t length = measureJson(doc);
+  AsyncWebSocketMessageBuffer *payload = gWebSocket.makeBuffer(length);
+  if (payload == nullptr) {
+    gBroadcastCounters.bufferFailures.fetch_add(1U, std::memory_order_relaxed);
+    return false;
+  }
+  serializeJson(doc, reinterpret_cast<char *>(payload->get()), length + 1U);
+  STAGECUE_TRACE_SINCE(kJsonEncode, encodeStartUs, length);
+  STAGECUE_TRACE_SCOPE(kWsSend, length);
   gWebSocket.textAll(payload);
+  for (size_t i = 0; i < clients; ++i) {
+    countOutbound(kEncodingJson, length);
+  }
+  return true;
 }
 
 void sendAck(AsyncWebSocketClient &client, const char *action,
@@ -71,17 +351,6 @@ void sendError(AsyncWebSocketClient &client, const char *action,
   sendAck(client, action, false, detail);
 }
 
-void publishCueState(uint8_t index) {
-  const auto &state = getCueState(index);
-  StaticJsonDocument<192> doc;
-  doc["type"] = "cue";
-  doc["index"] = index;
-  doc["text"] = gCueTexts[index];
-  doc["active"] = state.active;
-  doc["updatedAt"] = state.lastChangeMs;
-  broadcastJson(doc);
-}
-
 void handleTriggerRequest(uint8_t index, const char *text,
                           AsyncWebSocketClient &client) {
   if (index >= kCueCount) {
@@ -89,11 +358,10 @@ void handleTriggerRequest(uint8_t index, const char *text,
     return;
   }
 
-  if (text != nullptr) {
-    setCueText(index, text);
+  if (!requestCueTrigger(index, text)) {
+    sendError(client, "trigger", "queue full");
+    return;
   }
-
-  triggerCue(index);
   sendAck(client, "trigger", true);
 }
 
@@ -103,10 +371,21 @@ void handleReleaseRequest(uint8_t index, AsyncWebSocketClient &client) {
     return;
   }
 
-  releaseCue(index);
+  if (!requestCueRelease(index)) {
+    sendError(client, "release", "queue full");
+    return;
+  }
   sendAck(client, "release", true);
 }
 
+void handleShowResult(const char *action, bool queued, AsyncWebSocketClient &client) {
+  if (!queued) {
+    sendError(client, action, "queue full");
+    return;
+  }
+  sendAck(client, action, true);
+}
+
 void handleRenameRequest(uint8_t index, const char *text,
                          AsyncWebSocketClient &client) {
   if (index >= kCueCount) {
@@ -115,30 +394,464 @@ void handleRenameRequest(uint8_t index, const char *text,
   }
 
   const char *safeText = text != nullptr ? text : "";
-  setCueText(index, safeText);
+  if (!requestCueRename(index, safeText)) {
+    sendError(client, "rename", "queue full");
+    return;
+  }
   sendAck(client, "rename", true);
-  publishCueState(index);
+}
+
+// Fills `batch` from [{"op":"trigger","cue":0,"text":"..."}, ...]; "cue" may
+// also be "all". Returns nullptr, or why the batch was refused.
+const char *parseCueBatch(JsonArrayConst ops, CueBatch &batch) {
+  if (ops.isNull() || ops.size() == 0U) {
+    return "missing ops";
+  }
+
+  batch.count = 0;
+  for (JsonObjectConst op : ops) {
+    const char *name = op["op"] | "";
+    CueCommandType type;
+    if (strcmp(name, "trigger") == 0) {
+      type = CueCommandType::kTrigger;
+    } else if (strcmp(name, "release") == 0) {
+      type = CueCommandType::kRelease;
+    } else if (strcmp(name, "rename") == 0) {
+      type = CueCommandType::kRename;
+    } else {
+      return "unknown op";
+    }
+
+    const char *cueName = op["cue"] | "";
+    uint8_t first = 0;
+    uint8_t last = kCueCount - 1U;
+    if (strcmp(cueName, "all") != 0) {
+      const int cue = op["cue"] | -1;
+      if (cue < 0 || cue >= static_cast<int>(kCueCount)) {
+        return "invalid cue index";
+      }
+      first = last = static_cast<uint8_t>(cue);
+    }
+
+    const char *text = op["text"] | "";
+    for (uint8_t index = first; index <= last; ++index) {
+      if (batch.count >= kCueBatchMaxOps) {
+        return "too many ops";
+      }
+      CueBatchOp &entry = batch.ops[batch.count++];
+      entry.type = type;
+      entry.index = index;
+      entry.hasText = type == CueCommandType::kRename || text[0] != '\0';
+      entry.text.assign(text);
+    }
+  }
+  return nullptr;
+}
+
+void handleBatchRequest(JsonArrayConst ops, AsyncWebSocketClient &client) {
+  CueBatch batch;
+  const char *error = parseCueBatch(ops, batch);
+  if (error != nullptr) {
+    sendError(client, "batch", error);
+    return;
+  }
+
+  if (!submitCueBatch(batch)) {
+    sendError(client, "batch", "queue full");
+    return;
+  }
+  sendAck(client, "batch", true);
+}
+
+// Device time as clients see it: milliseconds since boot from the 64-bit
+// timer, whose low 32 bits in microseconds are what micros() returns.
+double deviceTimeMs() {
+  return static_cast<double>(esp_timer_get_time()) / 1000.0;
+}
+
+// NTP-style exchange: the client stamps t0 on send and t3 on receipt; t1 is
+// taken when the frame arrived, t2 just before the reply goes out.
+void sendClockPong(AsyncWebSocketClient &client, double t0, double t1) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(4)> doc;
+  doc["type"] = "pong";
+  doc["t0"] = t0;
+  doc["t1"] = t1;
+  doc["t2"] = deviceTimeMs();
+  sendJson(client, doc);
+}
+
+void handleClockReport(double offsetMs, double rttMs, AsyncWebSocketClient &client) {
+  if (!(rttMs >= 0.0)) {
+    sendError(client, "clock", "invalid sample");
+    return;
+  }
+  setSessionClock(client.id(), static_cast<float>(offsetMs), static_cast<float>(rttMs));
+  sendAck(client, "clock", true);
+}
+
+// {"type":"schedule","cue":0,"op":"trigger","at":<device ms>,"text":"..."}
+void handleScheduleRequest(uint8_t index, const char *op, double atMs, const char *text,
+                           AsyncWebSocketClient &client) {
+  if (index >= kCueCount) {
+    sendError(client, "schedule", "invalid cue index");
+    return;
+  }
+
+  bool active;
+  if (strcmp(op, "trigger") == 0) {
+    active = true;
+  } else if (strcmp(op, "release") == 0) {
+    active = false;
+  } else {
+    sendError(client, "schedule", "unknown op");
+    return;
+  }
+
+  const double aheadMs = atMs - deviceTimeMs();
+  if (!(aheadMs >= -static_cast<double>(kCueScheduleMaxLateMillis))) {
+    sendError(client, "schedule", "too late");
+    return;
+  }
+  if (aheadMs > static_cast<double>(kCueScheduleMaxAheadMillis)) {
+    sendError(client, "schedule", "too far ahead");
+    return;
+  }
+
+  // Up to kCueScheduleMaxLateMillis late may still lie before boot; that fires
+  // at once either way, and a negative double must not reach the cast.
+  const auto fireAtUs = static_cast<uint32_t>(static_cast<uint64_t>(std::max(atMs, 0.0) * 1000.0));
+  if (!requestCueSchedule(index, active, fireAtUs, text)) {
+    sendError(client, "schedule", "queue full");
+    return;
+  }
+  sendAck(client, "schedule", true);
+}
+
+uint16_t nextStateSequence(uint8_t index) {
+  portENTER_CRITICAL(&gDeltaLock);
+  const uint16_t sequence = static_cast<uint16_t>(gStateSequence.fetch_add(1U) + 1U);
+  gDeltaRing[gDeltaHead] = StateDelta{sequence, index};
+  gDeltaHead = (gDeltaHead + 1U) % gDeltaRing.size();
+  if (gDeltaCount < gDeltaRing.size()) {
+    ++gDeltaCount;
+  }
+  portEXIT_CRITICAL(&gDeltaLock);
+  return sequence;
+}
+
+// Collects the cues changed after `since`; false when the ring no longer
+// covers the gap.
+bool collectDeltaMask(uint16_t since, uint32_t &mask, uint16_t &current) {
+  mask = 0;
+  portENTER_CRITICAL(&gDeltaLock);
+  current = gStateSequence.load();
+  const uint16_t gap = static_cast<uint16_t>(current - since);
+  const bool covered = gap <= gDeltaCount;
+  if (covered) {
+    size_t slot = (gDeltaHead + gDeltaRing.size() - gap) % gDeltaRing.size();
+    for (uint16_t i = 0; i < gap; ++i) {
+      mask |= 1UL << gDeltaRing[slot].index;
+      slot = (slot + 1U) % gDeltaRing.size();
+    }
+  }
+  portEXIT_CRITICAL(&gDeltaLock);
+  return covered;
+}
+
+void writeCueEntry(JsonArray cues, uint8_t index, const CueSnapshot &snapshot) {
+  JsonObject cue = cues.createNestedObject();
+  cue["index"] = index;
+  cue["text"] = snapshot.text.c_str();
+  cue["active"] = snapshot.state.active;
+  cue["updatedAt"] = snapshot.state.lastChangeMs;
 }
 
 void sendInitialState(AsyncWebSocketClient &client) {
-  StaticJsonDocument<512> doc;
+  StaticJsonDocument<kInitJsonCapacity> doc;
   doc["type"] = "init";
+  doc["seq"] = gStateSequence.load();
+  doc["epoch"] = gSessionEpoch;
 
+  std::array<CueSnapshot, kCueCount> snapshots;
   JsonArray cues = doc.createNestedArray("cues");
   for (uint8_t i = 0; i < kCueCount; ++i) {
-    const auto &state = getCueState(i);
-    JsonObject cue = cues.createNestedObject();
-    cue["index"] = i;
-    cue["text"] = gCueTexts[i];
-    cue["active"] = state.active;
+    snapshots[i] = getCueSnapshot(i);
+    writeCueEntry(cues, i, snapshots[i]);
   }
 
   JsonObject wifi = doc.createNestedObject("wifi");
   wifi["mode"] = wifiModeToString(WiFi.getMode());
-  wifi["ip"] = WiFi.getMode() == WIFI_MODE_AP ? WiFi.softAPIP().toString()
-                                                : WiFi.localIP().toString();
+  wifi["ip"] = isWifiStationUp() ? WiFi.localIP().toString() : WiFi.softAPIP().toString();
 
-  sendJson(client, doc);
+  const size_t bytes = sendJson(client, doc);
+  gResumeCounters.snapshots.fetch_add(1U, std::memory_order_relaxed);
+  gResumeCounters.snapshotBytes.fetch_add(static_cast<uint32_t>(bytes),
+                                          std::memory_order_relaxed);
+}
+
+// A client reconnecting with ?since=<seq>&epoch=<epoch> only gets the cues
+// that changed while it was away.
+void sendResumeState(AsyncWebSocketClient &client, AsyncWebServerRequest *request) {
+  const uint32_t startUs = micros();
+  uint32_t mask = 0;
+  uint16_t current = 0;
+  const bool resumable =
+      request != nullptr && request->hasParam("since") && request->hasParam("epoch") &&
+      strtoul(request->getParam("epoch")->value().c_str(), nullptr, 10) == gSessionEpoch &&
+      collectDeltaMask(static_cast<uint16_t>(request->getParam("since")->value().toInt()), mask,
+                       current);
+
+  if (!resumable) {
+    sendInitialState(client);
+    recordLatency(LatencyProbe::kWsConnectSync, micros() - startUs);
+    return;
+  }
+
+  std::array<CueSnapshot, kCueCount> snapshots;
+  StaticJsonDocument<kDeltaJsonCapacity> doc;
+  doc["type"] = "delta";
+  doc["seq"] = current;
+  doc["epoch"] = gSessionEpoch;
+  JsonArray cues = doc.createNestedArray("cues");
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    if ((mask & (1UL << i)) != 0U) {
+      snapshots[i] = getCueSnapshot(i);
+      writeCueEntry(cues, i, snapshots[i]);
+    }
+  }
+
+  const size_t bytes = sendJson(client, doc);
+  gResumeCounters.deltas.fetch_add(1U, std::memory_order_relaxed);
+  gResumeCounters.deltaBytes.fetch_add(static_cast<uint32_t>(bytes), std::memory_order_relaxed);
+  recordLatency(LatencyProbe::kWsConnectSync, micros() - startUs);
+}
+
+// Encodes one cue change at most once per encoding and hands the same
+// ref-counted buffer to every JSON client instead of a String per client.
+// Like broadcastJson() and broadcastDelta(), the buffer comes from
+// makeBuffer(), i.e. the library's heap, not the message pools.
+void broadcastCue(uint8_t index, bool textChanged, SessionTable &sessions,
+                  size_t sessionCount) {
+  const CueSnapshot snapshot = getCueSnapshot(index);
+  const uint16_t sequence = gCueSequences[index];
+  const uint32_t cueBit = 1UL << index;
+
+  AsyncWebSocketMessageBuffer *payload = nullptr;
+  uint8_t frame[kBinaryFrameSize];
+  bool frameEncoded = false;
+  bool bufferFailed = false;
+
+  for (size_t i = 0; i < sessionCount; ++i) {
+    AsyncWebSocketClient *client = gWebSocket.client(sessions[i].id);
+    if (client == nullptr) {
+      continue;
+    }
+
+    // A client whose outbound queue is full, or that still has older changes
+    // pending, gets this one with its backlog instead of ahead of it.
+    if (!client->canSend() || sessions[i].pendingMask != 0U) {
+      deferForSession(sessions[i].id, cueBit, textChanged);
+      sessions[i].pendingMask |= cueBit;
+      gBroadcastCounters.deferred.fetch_add(1U, std::memory_order_relaxed);
+      continue;
+    }
+
+    if (sessions[i].binary && !textChanged) {
+      if (!frameEncoded) {
+        const uint32_t startUs = micros();
+        BinaryFrame state;
+        state.opcode = snapshot.state.active ? BinaryOpcode::kStateActive
+                                             : BinaryOpcode::kStateIdle;
+        state.cue = index;
+        state.sequence = sequence;
+        state.timestamp = snapshot.state.lastChangeMs;
+        encodeBinaryFrame(state, frame);
+        frameEncoded = true;
+        gBroadcastCounters.encodes.fetch_add(1U, std::memory_order_relaxed);
+        recordLatency(LatencyProbe::kWsEncodeBinary, micros() - startUs);
+      }
+      {
+        STAGECUE_TRACE_SCOPE(kWsSend, sizeof(frame));
+        client->binary(frame, sizeof(frame));
+      }
+      countOutbound(kEncodingBinary, sizeof(frame));
+      gBroadcastCounters.deliveries.fetch_add(1U, std::memory_order_relaxed);
+      continue;
+    }
+
+    if (payload == nullptr && !bufferFailed) {
+      const uint32_t startUs = micros();
+      StaticJsonDocument<192> doc;
+      doc["type"] = "cue";
+      doc["index"] = index;
+      doc["text"] = snapshot.text.c_str();
+      doc["active"] = snapshot.state.active;
+      doc["updatedAt"] = snapshot.state.lastChangeMs;
+      doc["seq"] = sequence;
+      const size_t length = measureJson(doc);
+      payload = gWebSocket.makeBuffer(length);
+      if (payload == nullptr) {
+        gBroadcastCounters.bufferFailures.fetch_add(1U, std::memory_order_relaxed);
+        bufferFailed = true;
+      } else {
+        serializeJson(doc, reinterpret_cast<char *>(payload->get()), length + 1U);
+        payload->lock();
+        gBroadcastCounters.encodes.fetch_add(1U, std::memory_order_relaxed);
+        recordLatency(LatencyProbe::kWsEncodeJson, micros() - startUs);
+        STAGECUE_TRACE_SINCE(kJsonEncode, startUs, length);
+      }
+    }
+    // Without a buffer this and every later JSON client catch up from their
+    // backlog on the next cue I/O pass; binary clients still get the frame.
+    if (bufferFailed) {
+      deferForSession(sessions[i].id, cueBit, textChanged);
+      sessions[i].pendingMask |= cueBit;
+      gBroadcastCounters.deferred.fetch_add(1U, std::memory_order_relaxed);
+      continue;
+    }
+    {
+      STAGECUE_TRACE_SCOPE(kWsSend, payload->length());
+      client->text(payload);
+    }
+    countOutbound(kEncodingJson, payload->length());
+    gBroadcastCounters.deliveries.fetch_add(1U, std::memory_order_relaxed);
+  }
+
+  if (payload != nullptr) {
+    payload->unlock();
+    // Per-client sends do not prune finished buffers; textAll() would.
+    gWebSocket._cleanBuffers();
+  }
+}
+
+// Several cues changed in one tick: JSON clients that can take a frame get
+// them all in one "delta" message. `sessions` was filtered by the caller.
+void broadcastDelta(uint32_t mask, const SessionTable &sessions, size_t sessionCount) {
+  if (sessionCount == 0U) {
+    return;
+  }
+
+  const uint32_t startUs = micros();
+  std::array<CueSnapshot, kCueCount> snapshots;
+  StaticJsonDocument<kDeltaJsonCapacity> doc;
+  doc["type"] = "delta";
+  doc["seq"] = gStateSequence.load();
+  doc["epoch"] = gSessionEpoch;
+  JsonArray cues = doc.createNestedArray("cues");
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    if ((mask & (1UL << i)) != 0U) {
+      snapshots[i] = getCueSnapshot(i);
+      writeCueEntry(cues, i, snapshots[i]);
+    }
+  }
+
+  const size_t length = measureJson(doc);
+  AsyncWebSocketMessageBuffer *payload = gWebSocket.makeBuffer(length);
+  if (payload == nullptr) {
+    // Leave the cues to the per-client catch-up.
+    gBroadcastCounters.bufferFailures.fetch_add(1U, std::memory_order_relaxed);
+    for (size_t i = 0; i < sessionCount; ++i) {
+      deferForSession(sessions[i].id, mask, true);
+    }
+    return;
+  }
+  serializeJson(doc, reinterpret_cast<char *>(payload->get()), length + 1U);
+  payload->lock();
+  gBroadcastCounters.encodes.fetch_add(1U, std::memory_order_relaxed);
+  recordLatency(LatencyProbe::kWsEncodeJson, micros() - startUs);
+  STAGECUE_TRACE_SINCE(kJsonEncode, startUs, length);
+
+  for (size_t i = 0; i < sessionCount; ++i) {
+    AsyncWebSocketClient *client = gWebSocket.client(sessions[i].id);
+    if (client == nullptr) {
+      continue;
+    }
+    {
+      STAGECUE_TRACE_SCOPE(kWsSend, length);
+      client->text(payload);
+    }
+    countOutbound(kEncodingJson, length);
+    gBroadcastCounters.deliveries.fetch_add(1U, std::memory_order_relaxed);
+  }
+
+  payload->unlock();
+  gWebSocket._cleanBuffers();
+}
+
+// Retries each backlogged client that can take frames again, oldest change
+// first (sequence numbers wrap). Cues that changed again this tick are left
+// to the fresh broadcast, which carries their newer state; a label change
+// still owed to the client travels with it through `textDirty`.
+void flushSessionBacklogs(uint32_t dirty, uint32_t &textDirty) {
+  SessionTable sessions;
+  const size_t sessionCount = copySessions(sessions);
+  const uint32_t now = millis();
+  for (size_t s = 0; s < sessionCount; ++s) {
+    if (sessions[s].pendingMask == 0U) {
+      continue;
+    }
+    AsyncWebSocketClient *client = gWebSocket.client(sessions[s].id);
+    if (client == nullptr) {
+      continue;
+    }
+
+    if (!client->canSend()) {
+      if (now - sessions[s].stalledSinceMs >= kWsSlowClientTimeoutMillis) {
+        Serial.printf("[WS] Dropping slow client #%u\n", sessions[s].id);
+        gBroadcastCounters.slowClientsDropped.fetch_add(1U, std::memory_order_relaxed);
+        client->close();
+      }
+      continue;
+    }
+
+    const ClientSession backlog = takeSessionBacklog(sessions[s].id);
+    textDirty |= backlog.pendingTextMask & dirty;
+
+    // Insertion sort: at most kCueCount entries.
+    std::array<uint8_t, kCueCount> order;
+    size_t count = 0;
+    for (uint8_t i = 0; i < kCueCount; ++i) {
+      if ((backlog.pendingMask & ~dirty & (1UL << i)) == 0U) {
+        continue;
+      }
+      size_t k = count++;
+      while (k > 0U && static_cast<int16_t>(gCueSequences[i] - gCueSequences[order[k - 1U]]) < 0) {
+        order[k] = order[k - 1U];
+        --k;
+      }
+      order[k] = i;
+    }
+
+    SessionTable single{};
+    single[0] = backlog;
+    single[0].pendingMask = 0;
+    for (size_t k = 0; k < count; ++k) {
+      const uint32_t cueBit = 1UL << order[k];
+      broadcastCue(order[k], (backlog.pendingTextMask & cueBit) != 0U, single, 1U);
+    }
+  }
+}
+
+void handleBinaryMessage(AsyncWebSocketClient &client, const uint8_t *data, size_t len) {
+  countInbound(kEncodingBinary, len);
+
+  const uint32_t startUs = micros();
+  BinaryFrame request;
+  const bool valid = decodeBinaryFrame(data, len, request);
+  recordLatency(LatencyProbe::kWsDecodeBinary, micros() - startUs);
+
+  bool accepted = false;
+  if (valid && request.cue < kCueCount) {
+    accepted = request.opcode == BinaryOpcode::kTrigger ? requestCueTrigger(request.cue)
+                                                        : requestCueRelease(request.cue);
+  }
+
+  BinaryFrame reply;
+  reply.opcode = accepted ? BinaryOpcode::kAck : BinaryOpcode::kNack;
+  reply.cue = request.cue;
+  reply.sequence = request.sequence;
+  reply.timestamp = millis();
+  sendBinary(client, reply);
 }
 
 void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
@@ -148,11 +861,18 @@ void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
   switch (type) {
     case WS_EVT_CONNECT:
       Serial.printf("[WS] client #%u connected\n", client->id());
-      sendInitialState(*client);
+      if (!openSession(client->id())) {
+        Serial.printf("[WS] no session slot for client #%u\n", client->id());
+        client->close();
+        return;
+      }
+      // For WS_EVT_CONNECT the library passes the upgrade request as `arg`.
+      sendResumeState(*client, static_cast<AsyncWebServerRequest *>(arg));
       break;
 
     case WS_EVT_DISCONNECT:
       Serial.printf("[WS] client #%u disconnected\n", client->id());
+      closeSession(client->id());
       break;
 
     case WS_EVT_ERROR:
@@ -160,24 +880,39 @@ void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
       break;
 
     case WS_EVT_DATA: {
+      const double receivedAtMs = deviceTimeMs();
       AwsFrameInfo *info = static_cast<AwsFrameInfo *>(arg);
       if (!(info->final && info->index == 0 && info->len == len &&
-            info->opcode == WS_TEXT)) {
+            (info->opcode == WS_TEXT || info->opcode == WS_BINARY))) {
         sendError(*client, "parse", "unsupported frame");
         return;
       }
 
+      if (info->opcode == WS_BINARY) {
+        handleBinaryMessage(*client, data, len);
+        return;
+      }
+
       if (len > kMaxIncomingMessageSize) {
         sendError(*client, "parse", "payload too large");
         return;
       }
 
-      String payload;
-      payload.reserve(len + 1);
-      payload.concat(reinterpret_cast<const char *>(data), len);
+      countInbound(kEncodingJson, len);
+      // Parsed in place: the document's strings point into `payload`.
+      MessageBuffer payload(MessagePool::kInbound, len + 1U);
+      PooledJsonDocument doc(kInboundJsonCapacity);
+      if (!payload || doc.capacity() == 0U) {
+        sendError(*client, "parse", "busy");
+        return;
+      }
+      memcpy(payload.data(), data, len);
+      payload.data()[len] = '\0';
 
-      DynamicJsonDocument doc(kMaxIncomingMessageSize);
-      const auto error = deserializeJson(doc, payload);
+      const uint32_t decodeStartUs = micros();
+      const auto error = deserializeJson(doc, payload.data(), len);
+      recordLatency(LatencyProbe::kWsDecodeJson, micros() - decodeStartUs);
+      STAGECUE_TRACE_SINCE(kJsonDecode, decodeStartUs, len);
       if (error) {
         sendError(*client, "parse", error.c_str());
         return;
@@ -198,8 +933,28 @@ void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
         handleReleaseRequest(cueIndex, *client);
       } else if (strcmp(typeValue, "rename") == 0) {
         handleRenameRequest(cueIndex, textValue, *client);
+      } else if (strcmp(typeValue, "batch") == 0) {
+        handleBatchRequest(doc["ops"].as<JsonArrayConst>(), *client);
+      } else if (strcmp(typeValue, "go") == 0) {
+        handleShowResult("go", requestShowGo(), *client);
+      } else if (strcmp(typeValue, "back") == 0) {
+        handleShowResult("back", requestShowBack(), *client);
+      } else if (strcmp(typeValue, "jump") == 0) {
+        handleShowResult("jump", requestShowJump(doc["position"] | 0), *client);
+      } else if (strcmp(typeValue, "hello") == 0) {
+        setSessionBinary(client->id(), doc["binary"] | false);
+        sendAck(*client, "hello", true);
       } else if (strcmp(typeValue, "ping") == 0) {
-        sendAck(*client, "ping", true);
+        if (doc["t0"].is<double>()) {
+          sendClockPong(*client, doc["t0"].as<double>(), receivedAtMs);
+        } else {
+          sendAck(*client, "ping", true);
+        }
+      } else if (strcmp(typeValue, "clock") == 0) {
+        handleClockReport(doc["offset"] | 0.0, doc["rtt"] | -1.0, *client);
+      } else if (strcmp(typeValue, "schedule") == 0) {
+        handleScheduleRequest(cueIndex, doc["op"] | "trigger", doc["at"] | -1.0e12, textValue,
+                              *client);
       } else {
         sendError(*client, "parse", "unknown type");
       }
@@ -211,26 +966,91 @@ void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
   }
 }
 
+bool writeCueRecord(size_t index, JsonRecordWriter &record) {
+  if (index >= kCueCount) {
+    return false;
+  }
+
+  const CueSnapshot snapshot = getCueSnapshot(static_cast<uint8_t>(index));
+  record.beginObject();
+  record.key("index");
+  record.number(static_cast<uint32_t>(index));
+  record.key("text");
+  record.string(snapshot.text.c_str());
+  record.key("active");
+  record.boolean(snapshot.state.active);
+  record.endObject();
+  return true;
+}
+
+bool writeNetworkRecord(size_t index, JsonRecordWriter &record) {
+  WifiNetwork network;
+  if (!getWifiNetwork(index, network)) {
+    return false;
+  }
+
+  record.beginObject();
+  record.key("ssid");
+  record.string(network.ssid);
+  record.key("rssi");
+  record.number(static_cast<int32_t>(network.rssi));
+  record.key("secure");
+  record.boolean(network.secure);
+  record.endObject();
+  return true;
+}
+
+void sendShowCommandResult(AsyncWebServerRequest *request, bool queued) {
+  if (!queued) {
+    request->send(503, "text/plain", "Cue queue full");
+    return;
+  }
+  auto *response = request->beginResponse(200, "text/plain", "OK");
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+void reloadShow() {
+  if (!loadShowFile()) {
+    Serial.println(F("[Show] Reload found no usable show file"));
+  }
+  gShowReloadRunning.store(false, std::memory_order_release);
+}
+
+void showReloadTask(void *) {
+  reloadShow();
+  vTaskDelete(nullptr);
+}
+
+// False while an earlier reload is still compiling.
+bool startShowReload() {
+  if (gShowReloadRunning.exchange(true, std::memory_order_acq_rel)) {
+    return false;
+  }
+  if (xTaskCreatePinnedToCore(showReloadTask, "show_reload", kShowReloadTaskStackSize, nullptr,
+                              kBootTaskPriority, nullptr, kBootTaskCore) != pdPASS) {
+    // Compile inline instead; the request stalls, but the reload still happens.
+    Serial.println(F("[Show] Unable to start reload task"));
+    reloadShow();
+  }
+  return true;
+}
+
 void registerHttpRoutes() {
+  // Packed assets are matched before the LittleFS fallback below.
+  registerStaticAssets(gServer);
   gServer.serveStatic("/", LittleFS, "/")
       .setDefaultFile("index.html")
       .setCacheControl("max-age=3600, public");
 
   gServer.on("/api/cues", HTTP_GET, [](AsyncWebServerRequest *request) {
-    StaticJsonDocument<384> doc;
-    JsonArray cues = doc.createNestedArray("cues");
-    for (uint8_t i = 0; i < kCueCount; ++i) {
-      const auto &state = getCueState(i);
-      JsonObject cue = cues.createNestedObject();
-      cue["index"] = i;
-      cue["text"] = gCueTexts[i];
-      cue["active"] = state.active;
-    }
-    doc["count"] = kCueCount;
-
-    String payload;
-    serializeJson(doc, payload);
-    auto *response = request->beginResponse(200, "application/json", payload);
+    char suffix[24];
+    snprintf(suffix, sizeof(suffix), ",\"count\":%u}", static_cast<unsigned>(kCueCount));
+    JsonArrayStream stream("{\"cues\":", suffix, writeCueRecord);
+    auto *response = request->beginChunkedResponse(
+        "application/json", [stream](uint8_t *buffer, size_t maxLen, size_t) mutable {
+          return stream.fill(buffer, maxLen);
+        });
     response->addHeader("Cache-Control", "no-store");
     request->send(response);
   });
@@ -242,19 +1062,57 @@ void registerHttpRoutes() {
     }
 
     const uint8_t index = static_cast<uint8_t>(request->getParam("cue", true)->value().toInt());
-    const String text = request->hasParam("text", true)
-                            ? request->getParam("text", true)->value()
-                            : String();
+    const AsyncWebParameter *text =
+        request->hasParam("text", true) ? request->getParam("text", true) : nullptr;
 
     if (index >= kCueCount) {
       request->send(400, "text/plain", "Invalid cue index");
       return;
     }
 
-    if (text.length() > 0) {
-      setCueText(index, text);
+    const bool hasText = text != nullptr && text->value().length() > 0;
+    if (!requestCueTrigger(index, hasText ? text->value().c_str() : nullptr)) {
+      request->send(503, "text/plain", "Cue queue full");
+      return;
+    }
+    auto *response = request->beginResponse(200, "text/plain", "OK");
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  // `ops` holds the same JSON array as the WebSocket "batch" message.
+  gServer.on("/api/cues/batch", HTTP_POST, [](AsyncWebServerRequest *request) {
+    if (!request->hasParam("ops", true)) {
+      request->send(400, "text/plain", "Missing ops parameter");
+      return;
+    }
+    const String &ops = request->getParam("ops", true)->value();
+    if (ops.length() > kMaxIncomingMessageSize) {
+      request->send(413, "text/plain", "Batch too large");
+      return;
+    }
+
+    MessageBuffer buffer(MessagePool::kInbound, ops.length() + 1U);
+    PooledJsonDocument doc(kInboundJsonCapacity);
+    if (!buffer || doc.capacity() == 0U) {
+      request->send(503, "text/plain", "Busy");
+      return;
+    }
+    memcpy(buffer.data(), ops.c_str(), ops.length() + 1U);
+    if (deserializeJson(doc, buffer.data(), ops.length())) {
+      request->send(400, "text/plain", "Invalid ops");
+      return;
+    }
+    CueBatch batch;
+    const char *error = parseCueBatch(doc.as<JsonArrayConst>(), batch);
+    if (error != nullptr) {
+      request->send(400, "text/plain", error);
+      return;
+    }
+    if (!submitCueBatch(batch)) {
+      request->send(503, "text/plain", "Cue queue full");
+      return;
     }
-    triggerCue(index);
     auto *response = request->beginResponse(200, "text/plain", "OK");
     response->addHeader("Cache-Control", "no-store");
     request->send(response);
@@ -272,31 +1130,85 @@ void registerHttpRoutes() {
       return;
     }
 
-    releaseCue(index);
+    if (!requestCueRelease(index)) {
+      request->send(503, "text/plain", "Cue queue full");
+      return;
+    }
     auto *response = request->beginResponse(200, "text/plain", "OK");
     response->addHeader("Cache-Control", "no-store");
     request->send(response);
   });
 
-  gServer.on("/scan", HTTP_GET, [](AsyncWebServerRequest *request) {
-    const int16_t networkCount = WiFi.scanNetworks();
-    DynamicJsonDocument doc(1024);
-    JsonArray networks = doc.to<JsonArray>();
-    for (int16_t i = 0; i < networkCount; ++i) {
-      JsonObject entry = networks.createNestedObject();
-      entry["ssid"] = WiFi.SSID(i);
-      entry["rssi"] = WiFi.RSSI(i);
-      entry["secure"] = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
-    }
-    WiFi.scanDelete();
+  gServer.on("/api/show", HTTP_GET, [](AsyncWebServerRequest *request) {
+    const ShowStatus status = getShowStatus();
+    StaticJsonDocument<JSON_OBJECT_SIZE(6)> doc;
+    doc["loaded"] = status.loaded;
+    doc["count"] = status.count;
+    doc["position"] = status.position;
+    doc["textBytes"] = status.textBytes;
+    doc["loadUs"] = status.loadUs;
+    doc["skippedLines"] = status.skippedLines;
 
     String payload;
-    serializeJson(networks, payload);
+    serializeJson(doc, payload);
     auto *response = request->beginResponse(200, "application/json", payload);
     response->addHeader("Cache-Control", "no-store");
     request->send(response);
   });
 
+  gServer.on("/api/show/go", HTTP_POST, [](AsyncWebServerRequest *request) {
+    sendShowCommandResult(request, requestShowGo());
+  });
+
+  gServer.on("/api/show/back", HTTP_POST, [](AsyncWebServerRequest *request) {
+    sendShowCommandResult(request, requestShowBack());
+  });
+
+  gServer.on("/api/show/jump", HTTP_POST, [](AsyncWebServerRequest *request) {
+    if (!request->hasParam("position", true)) {
+      request->send(400, "text/plain", "Missing position parameter");
+      return;
+    }
+    const long position = request->getParam("position", true)->value().toInt();
+    if (position < 0 || position > UINT16_MAX) {
+      request->send(400, "text/plain", "Invalid position");
+      return;
+    }
+    sendShowCommandResult(request, requestShowJump(static_cast<uint16_t>(position)));
+  });
+
+  // The compile runs off the AsyncTCP task; GET /api/show reports the result.
+  gServer.on("/api/show/reload", HTTP_POST, [](AsyncWebServerRequest *request) {
+    if (!startShowReload()) {
+      request->send(409, "text/plain", "Reload already running");
+      return;
+    }
+    auto *response = request->beginResponse(202, "text/plain", "Reloading");
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  // Answers from the scan cache at once; a stale cache only schedules a
+  // background refresh, announced to WebSocket clients as a "scan" message.
+  gServer.on("/scan", HTTP_GET, [](AsyncWebServerRequest *request) {
+    const WifiScanStatus status = getWifiScanStatus();
+    const uint32_t ageMs = status.valid ? millis() - status.completedAtMs : 0U;
+    const bool refresh = !status.valid || ageMs >= kWifiScanMaxAgeMillis;
+    if (refresh) {
+      requestWifiScan();
+    }
+
+    JsonArrayStream stream("", "", writeNetworkRecord);
+    auto *response = request->beginChunkedResponse(
+        "application/json", [stream](uint8_t *buffer, size_t maxLen, size_t) mutable {
+          return stream.fill(buffer, maxLen);
+        });
+    response->addHeader("Cache-Control", "no-store");
+    response->addHeader("X-Scan-Age-Ms", String(ageMs));
+    response->addHeader("X-Scan-Pending", refresh || status.scanning ? "1" : "0");
+    request->send(response);
+  });
+
   gServer.on("/save_wifi", HTTP_POST, [](AsyncWebServerRequest *request) {
     if (!request->hasParam("ssid", true) || !request->hasParam("password", true)) {
       request->send(400, "text/plain", "Missing credentials");
@@ -312,11 +1224,54 @@ void registerHttpRoutes() {
     }
 
     auto *response =
-        request->beginResponse(200, "text/plain", "Credentials saved. Rebooting...");
+        request->beginResponse(200, "text/plain", "Credentials saved. Connecting...");
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/wifi", HTTP_GET, [](AsyncWebServerRequest *request) {
+    const WifiSupervisorStats stats = getWifiSupervisorStats();
+    StaticJsonDocument<kWifiJsonCapacity> doc;
+    doc["state"] = wifiLinkStateName(stats.state);
+    doc["ssid"] = stats.ssid;
+    doc["rssi"] = stats.rssi;
+    doc["accessPoint"] = stats.accessPoint;
+    doc["connects"] = stats.connects;
+    doc["drops"] = stats.drops;
+    doc["failures"] = stats.failures;
+    doc["roams"] = stats.roams;
+    doc["backoffMs"] = stats.backoffMs;
+    doc["lastReconnectMs"] = stats.lastReconnectMs;
+    doc["maxReconnectMs"] = stats.maxReconnectMs;
+    doc["downMs"] = stats.downMs;
+    doc["uptimeMs"] = millis();
+
+    // Priority order; passwords never leave the device.
+    const SavedNetworks saved = getSavedNetworks();
+    JsonArray networks = doc.createNestedArray("saved");
+    for (size_t i = 0; i < saved.count; ++i) {
+      JsonObject entry = networks.createNestedObject();
+      entry["ssid"] = saved.entries[i].ssid;
+      entry["channel"] = saved.entries[i].channel;
+    }
+
+    String payload;
+    serializeJson(doc, payload);
+    auto *response = request->beginResponse(200, "application/json", payload);
     response->addHeader("Cache-Control", "no-store");
     request->send(response);
-    delay(100);
-    ESP.restart();
+  });
+
+  gServer.on("/api/wifi/forget", HTTP_POST, [](AsyncWebServerRequest *request) {
+    if (!request->hasParam("ssid", true)) {
+      request->send(400, "text/plain", "Missing ssid");
+      return;
+    }
+    if (!forgetWifiCredentials(request->getParam("ssid", true)->value())) {
+      request->send(404, "text/plain", "Unknown network");
+      return;
+    }
+    request->send(204);
   });
 
   gServer.on("/api/health", HTTP_GET, [](AsyncWebServerRequest *request) {
@@ -325,6 +1280,303 @@ void registerHttpRoutes() {
     request->send(response);
   });
 
+  gServer.on("/api/metrics", HTTP_GET, [](AsyncWebServerRequest *request) {
+    MetricsStream stream;
+    auto *response = request->beginChunkedResponse(
+        "text/plain; version=0.0.4", [stream](uint8_t *buffer, size_t maxLen, size_t) mutable {
+          return stream.fill(buffer, maxLen);
+        });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  // Raw span ring: a TraceDumpHeader followed by TraceRecords, oldest first.
+  gServer.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+    const size_t capacity = traceDumpCapacity();
+    std::shared_ptr<uint8_t> dump(new (std::nothrow) uint8_t[capacity],
+                                  std::default_delete<uint8_t[]>());
+    if (!dump) {
+      request->send(503, "text/plain", "Out of memory");
+      return;
+    }
+    const size_t length = copyTraceDump(dump.get(), capacity);
+    auto *response = request->beginResponse(
+        "application/octet-stream", length,
+        [dump, length](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+          const size_t chunk = std::min(maxLen, length - index);
+          memcpy(buffer, dump.get() + index, chunk);
+          return chunk;
+        });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/trace", HTTP_POST, [](AsyncWebServerRequest *request) {
+    if (!request->hasParam("enabled", true)) {
+      request->send(400, "text/plain", "Missing enabled parameter");
+      return;
+    }
+    if (!isTraceCompiledIn()) {
+      request->send(501, "text/plain", "Built without STAGECUE_TRACE");
+      return;
+    }
+    setTraceEnabled(request->getParam("enabled", true)->value().toInt() != 0);
+    auto *response = request->beginResponse(200, "text/plain", "OK");
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/latency", HTTP_GET, [](AsyncWebServerRequest *request) {
+    StaticJsonDocument<kLatencyJsonCapacity> doc;
+    doc["loopIdlePercent"] = getRunLoopIdlePercent();
+    const CueCommandStats commands = getCueCommandStats();
+    JsonObject queue = doc.createNestedObject("commandQueue");
+    queue["submitted"] = commands.submitted;
+    queue["rejected"] = commands.rejected;
+    queue["applied"] = commands.applied;
+    queue["highWater"] = commands.highWater;
+    const TimerWheelStats timerStats = getCueTimerStats();
+    JsonObject timers = doc.createNestedObject("timers");
+    timers["pending"] = timerStats.pending;
+    timers["highWater"] = timerStats.highWater;
+    timers["scheduled"] = timerStats.scheduled;
+    timers["fired"] = timerStats.fired;
+    timers["cancelled"] = timerStats.cancelled;
+    timers["exhausted"] = timerStats.exhausted;
+    timers["cascaded"] = timerStats.cascaded;
+    JsonArray probes = doc.createNestedArray("probes");
+    for (size_t i = 0; i < kLatencyProbeCount; ++i) {
+      const auto probe = static_cast<LatencyProbe>(i);
+      const LatencySummary summary = summarizeLatency(probe);
+      JsonObject entry = probes.createNestedObject();
+      entry["name"] = latencyProbeName(probe);
+      entry["samples"] = summary.samples;
+      entry["p50Us"] = summary.p50Us;
+      entry["p99Us"] = summary.p99Us;
+      entry["maxUs"] = summary.maxUs;
+    }
+    const CueScheduleStats scheduleStats = getCueScheduleStats();
+    JsonObject schedules = doc.createNestedObject("schedules");
+    schedules["armed"] = scheduleStats.armed;
+    schedules["fired"] = scheduleStats.fired;
+    schedules["rejected"] = scheduleStats.rejected;
+
+    String payload;
+    serializeJson(doc, payload);
+    auto *response = request->beginResponse(200, "application/json", payload);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/displays", HTTP_GET, [](AsyncWebServerRequest *request) {
+    StaticJsonDocument<kDisplayStatsJsonCapacity> doc;
+    doc["labelCache"] = isDisplayCacheEnabled();
+    JsonArray displays = doc.createNestedArray("displays");
+    for (uint8_t i = 0; i < kCueCount; ++i) {
+      const DisplayFlushStats stats = getDisplayFlushStats(i);
+      JsonObject entry = displays.createNestedObject();
+      entry["index"] = i;
+      entry["ready"] = isDisplayReady(i);
+      entry["updates"] = stats.updates;
+      entry["bytesPushed"] = stats.bytesPushed;
+      entry["lastUpdateBytes"] = stats.lastUpdateBytes;
+    }
+
+    String payload;
+    serializeJson(doc, payload);
+    auto *response = request->beginResponse(200, "application/json", payload);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/displays/cache", HTTP_POST, [](AsyncWebServerRequest *request) {
+    if (!request->hasParam("enabled", true)) {
+      request->send(400, "text/plain", "Missing enabled parameter");
+      return;
+    }
+
+    setDisplayCacheEnabled(request->getParam("enabled", true)->value().toInt() != 0);
+    auto *response = request->beginResponse(200, "text/plain", "OK");
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/ws", HTTP_GET, [](AsyncWebServerRequest *request) {
+    StaticJsonDocument<kWebSocketStatsJsonCapacity> doc;
+    SessionTable sessions;
+    const size_t sessionCount = copySessions(sessions);
+    JsonArray clients = doc.createNestedArray("clients");
+    for (size_t i = 0; i < sessionCount; ++i) {
+      JsonObject entry = clients.createNestedObject();
+      entry["id"] = sessions[i].id;
+      entry["binary"] = sessions[i].binary;
+      entry["pending"] = __builtin_popcount(sessions[i].pendingMask);
+      entry["stalledMs"] =
+          sessions[i].pendingMask != 0U ? millis() - sessions[i].stalledSinceMs : 0U;
+      AsyncWebSocketClient *client = gWebSocket.client(sessions[i].id);
+      entry["canSend"] = client != nullptr && client->canSend();
+      if (sessions[i].clockSynced) {
+        entry["clockOffsetMs"] = sessions[i].clockOffsetMs;
+        entry["clockRttMs"] = sessions[i].clockRttMs;
+      }
+    }
+    writeProtocolCounters(doc.createNestedObject("json"), kEncodingJson);
+    writeProtocolCounters(doc.createNestedObject("binary"), kEncodingBinary);
+    JsonObject broadcast = doc.createNestedObject("broadcast");
+    broadcast["notifications"] = gBroadcastCounters.notifications.load(std::memory_order_relaxed);
+    broadcast["coalesced"] = gBroadcastCounters.coalesced.load(std::memory_order_relaxed);
+    broadcast["encodes"] = gBroadcastCounters.encodes.load(std::memory_order_relaxed);
+    broadcast["deliveries"] = gBroadcastCounters.deliveries.load(std::memory_order_relaxed);
+    broadcast["deferred"] = gBroadcastCounters.deferred.load(std::memory_order_relaxed);
+    broadcast["slowClientsDropped"] =
+        gBroadcastCounters.slowClientsDropped.load(std::memory_order_relaxed);
+    broadcast["bufferFailures"] = gBroadcastCounters.bufferFailures.load(std::memory_order_relaxed);
+    JsonObject resume = doc.createNestedObject("resume");
+    resume["deltas"] = gResumeCounters.deltas.load(std::memory_order_relaxed);
+    resume["snapshots"] = gResumeCounters.snapshots.load(std::memory_order_relaxed);
+    resume["deltaBytes"] = gResumeCounters.deltaBytes.load(std::memory_order_relaxed);
+    resume["snapshotBytes"] = gResumeCounters.snapshotBytes.load(std::memory_order_relaxed);
+    JsonArray pools = doc.createNestedArray("pools");
+    for (size_t i = 0; i < kMessagePoolCount; ++i) {
+      const auto pool = static_cast<MessagePool>(i);
+      const SlabPoolStats stats = getMessagePoolStats(pool);
+      JsonObject entry = pools.createNestedObject();
+      entry["name"] = messagePoolName(pool);
+      entry["slotSize"] = stats.slotSize;
+      entry["slots"] = stats.slots;
+      entry["highWater"] = stats.highWater;
+      entry["acquires"] = stats.acquires;
+      entry["exhausted"] = stats.exhausted;
+      entry["oversize"] = stats.oversize;
+    }
+
+    String payload;
+    serializeJson(doc, payload);
+    auto *response = request->beginResponse(200, "application/json", payload);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/assets", HTTP_GET, [](AsyncWebServerRequest *request) {
+    StaticJsonDocument<kAssetStatsJsonCapacity> doc;
+    JsonArray assets = doc.createNestedArray("assets");
+    const size_t count = std::min(getStaticAssetCount(), kMaxPackedAssets);
+    for (size_t i = 0; i < count; ++i) {
+      const StaticAssetStats stats = getStaticAssetStats(i);
+      JsonObject entry = assets.createNestedObject();
+      entry["path"] = stats.path;
+      entry["requests"] = stats.requests;
+      entry["notModified"] = stats.notModified;
+      entry["bytesSent"] = stats.bytesSent;
+      entry["lastServeUs"] = stats.lastServeUs;
+      entry["maxServeUs"] = stats.maxServeUs;
+    }
+
+    String payload;
+    serializeJson(doc, payload);
+    auto *response = request->beginResponse(200, "application/json", payload);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/storage", HTTP_GET, [](AsyncWebServerRequest *request) {
+    const CueStoreStats stats = getCueStoreStats();
+    StaticJsonDocument<JSON_OBJECT_SIZE(6)> doc;
+    doc["staged"] = stats.staged;
+    doc["coalesced"] = stats.coalesced;
+    doc["unchanged"] = stats.unchanged;
+    doc["keysWritten"] = stats.keysWritten;
+    doc["commits"] = stats.commits;
+    doc["lastFlushUs"] = stats.lastFlushUs;
+
+    String payload;
+    serializeJson(doc, payload);
+    auto *response = request->beginResponse(200, "application/json", payload);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/fabric", HTTP_GET, [](AsyncWebServerRequest *request) {
+    const CueFabricStats stats = getCueFabricStats();
+    StaticJsonDocument<kFabricJsonCapacity> doc;
+    doc["running"] = stats.running;
+    doc["node"] = stats.node;
+    doc["clock"] = stats.clock;
+    doc["statesSent"] = stats.statesSent;
+    doc["repairsSent"] = stats.repairsSent;
+    doc["digestsSent"] = stats.digestsSent;
+    doc["sendFailures"] = stats.sendFailures;
+    doc["received"] = stats.received;
+    doc["malformed"] = stats.malformed;
+    doc["applied"] = stats.applied;
+    doc["stale"] = stats.stale;
+    doc["rejected"] = stats.rejected;
+
+    std::array<CueFabricPeer, kFabricMaxPeers> peers;
+    const size_t peerCount = copyCueFabricPeers(peers.data(), peers.size());
+    JsonArray list = doc.createNestedArray("peers");
+    const uint32_t now = millis();
+    for (size_t i = 0; i < peerCount; ++i) {
+      JsonObject entry = list.createNestedObject();
+      entry["node"] = peers[i].node;
+      entry["silentMs"] = now - peers[i].lastSeenMs;
+      entry["datagrams"] = peers[i].datagrams;
+      entry["lost"] = peers[i].lost;
+    }
+
+    String payload;
+    serializeJson(doc, payload);
+    auto *response = request->beginResponse(200, "application/json", payload);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/tasks", HTTP_GET, [](AsyncWebServerRequest *request) {
+    StaticJsonDocument<kTaskStatsJsonCapacity> doc;
+    doc["idlePercent"] = getRunLoopIdlePercent();
+    JsonArray tasks = doc.createNestedArray("tasks");
+    for (size_t i = 0; i < kRunLoopTaskCount; ++i) {
+      const CoopTaskStats stats = getRunLoopTaskStats(static_cast<RunLoopTask>(i));
+      JsonObject entry = tasks.createNestedObject();
+      entry["name"] = stats.name;
+      entry["priority"] = stats.priority;
+      entry["runs"] = stats.runs;
+      entry["runUs"] = stats.runUs;
+      entry["maxRunUs"] = stats.maxRunUs;
+      entry["maxDispatchUs"] = stats.maxDispatchUs;
+    }
+
+    String payload;
+    serializeJson(doc, payload);
+    auto *response = request->beginResponse(200, "application/json", payload);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/boot", HTTP_GET, [](AsyncWebServerRequest *request) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(kBootPhaseCount)> doc;
+    for (size_t i = 0; i < kBootPhaseCount; ++i) {
+      const BootPhase phase = static_cast<BootPhase>(i);
+      const uint32_t atUs = getBootPhaseMicros(phase);
+      if (atUs != 0U) {
+        doc[bootPhaseName(phase)] = atUs;
+      }
+    }
+
+    String payload;
+    serializeJson(doc, payload);
+    auto *response = request->beginResponse(200, "application/json", payload);
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
+  gServer.on("/api/latency/reset", HTTP_POST, [](AsyncWebServerRequest *request) {
+    resetLatencyStats();
+    auto *response = request->beginResponse(200, "text/plain", "OK");
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+  });
+
   gServer.onNotFound([](AsyncWebServerRequest *request) {
     request->send(404, "text/plain", "Not found");
   });
@@ -333,6 +1585,7 @@ void registerHttpRoutes() {
 }  // namespace
 
 void startWebServer() {
+  gSessionEpoch = esp_random() & 0x7FFFFFFFU;  // fits String::toInt()
   if (!LittleFS.begin()) {
     Serial.println(F("[Web] LittleFS mount failed, attempting format"));
     if (!LittleFS.begin(true)) {
@@ -349,32 +1602,123 @@ void startWebServer() {
   gServer.addHandler(&gWebSocket);
 
   gServer.begin();
+  markBootPhase(BootPhase::kWebServerReady);
   Serial.println(F("[Web] HTTP server started on port 80"));
 }
 
-void notifyCueState(uint8_t index, const String &text, bool active) {
-  StaticJsonDocument<192> doc;
-  doc["type"] = "cue";
-  doc["index"] = index;
-  doc["text"] = text;
-  doc["active"] = active;
-  doc["updatedAt"] = millis();
-  broadcastJson(doc);
+void notifyCueState(uint8_t index, bool textChanged) {
+  if (index >= kCueCount) {
+    return;
+  }
+
+  const uint32_t bit = 1UL << index;
+  gBroadcastCounters.notifications.fetch_add(1U, std::memory_order_relaxed);
+  if ((gDirtyCueMask & bit) != 0U) {
+    gBroadcastCounters.coalesced.fetch_add(1U, std::memory_order_relaxed);
+  }
+  gDirtyCueMask |= bit;
+  if (textChanged) {
+    gTextDirtyCueMask |= bit;
+  }
+}
+
+void flushCueBroadcasts() {
+  if (gScanNotifyPending.exchange(false)) {
+    notifyWifiScanResults();
+  }
+
+  const uint32_t dirty = gDirtyCueMask;
+  uint32_t textDirty = gTextDirtyCueMask;
+  gDirtyCueMask = 0;
+  gTextDirtyCueMask = 0;
+
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    if ((dirty & (1UL << i)) != 0U) {
+      gCueSequences[i] = nextStateSequence(i);
+    }
+  }
+
+  // Backlogs go first so that a catching-up client sees every change in
+  // sequence order.
+  flushSessionBacklogs(dirty, textDirty);
+
+  SessionTable sessions;
+  const size_t sessionCount = copySessions(sessions);
+  if (sessionCount == 0U || dirty == 0U) {
+    return;
+  }
+
+  // With more than one cue dirty, JSON clients that are caught up take a
+  // single delta; binary and backlogged clients keep the per-cue path.
+  SessionTable perCue{};
+  size_t perCueCount = 0;
+  if (__builtin_popcount(dirty) > 1) {
+    SessionTable coalesced{};
+    size_t coalescedCount = 0;
+    for (size_t s = 0; s < sessionCount; ++s) {
+      AsyncWebSocketClient *client = gWebSocket.client(sessions[s].id);
+      if (client != nullptr && !sessions[s].binary && client->canSend() &&
+          sessions[s].pendingMask == 0U) {
+        coalesced[coalescedCount++] = sessions[s];
+      } else {
+        perCue[perCueCount++] = sessions[s];
+      }
+    }
+    broadcastDelta(dirty, coalesced, coalescedCount);
+  } else {
+    perCue = sessions;
+    perCueCount = sessionCount;
+  }
+
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    if ((dirty & (1UL << i)) != 0U) {
+      broadcastCue(i, (textDirty & (1UL << i)) != 0U, perCue, perCueCount);
+    }
+  }
+}
+
+bool loadShowFile() {
+  std::unique_ptr<CompiledShow> show = compileShowFile(LittleFS, kShowFilePath);
+  if (!show) {
+    return false;
+  }
+  installShow(std::move(show));
+  return true;
+}
+
+void notifyWifiScanResults() {
+  const WifiScanStatus status = getWifiScanStatus();
+  StaticJsonDocument<JSON_OBJECT_SIZE(3)> doc;
+  doc["type"] = "scan";
+  doc["count"] = status.count;
+  doc["generation"] = status.generation;
+  if (!broadcastJson(doc)) {
+    gScanNotifyPending = true;
+  }
 }
 
 void notifyAllCueStates() {
-  StaticJsonDocument<512> doc;
+  StaticJsonDocument<kSnapshotJsonCapacity> doc;
   doc["type"] = "snapshot";
+  doc["seq"] = gStateSequence.load();
+  std::array<CueSnapshot, kCueCount> snapshots;
   JsonArray cues = doc.createNestedArray("cues");
   for (uint8_t i = 0; i < kCueCount; ++i) {
-    const auto &state = getCueState(i);
-    JsonObject cue = cues.createNestedObject();
-    cue["index"] = i;
-    cue["text"] = gCueTexts[i];
-    cue["active"] = state.active;
-    cue["updatedAt"] = state.lastChangeMs;
-  }
-  broadcastJson(doc);
+    snapshots[i] = getCueSnapshot(i);
+    writeCueEntry(cues, i, snapshots[i]);
+  }
+  if (broadcastJson(doc)) {
+    return;
+  }
+
+  // Without a buffer every client catches up cue by cue from its backlog.
+  SessionTable sessions;
+  const size_t sessionCount = copySessions(sessions);
+  const uint32_t allCues = kCueCount >= 32U ? UINT32_MAX : (1UL << kCueCount) - 1U;
+  for (size_t i = 0; i < sessionCount; ++i) {
+    deferForSession(sessions[i].id, allCues, true);
+    gBroadcastCounters.deferred.fetch_add(1U, std::memory_order_relaxed);
+  }
 }
 
 }  // namespace stagecue
@@ -5,8 +5,18 @@
 namespace stagecue {
 
 void startWebServer();
-void notifyCueState(uint8_t index, const String &text, bool active);
+// Marks a cue for broadcast; notifications for the same cue within one cue
+// engine tick merge into a single message carrying the latest state. Binary
+// clients get a state frame unless the label changed.
+void notifyCueState(uint8_t index, bool textChanged = false);
+// Sends every pending cue notification; called by the cue engine each tick.
+void flushCueBroadcasts();
 void notifyAllCueStates();
+// Compiles kShowFilePath from LittleFS and hands it to the cue engine;
+// call after startWebServer() has mounted the filesystem.
+bool loadShowFile();
+// Tells WebSocket clients that fresh Wi-Fi scan results are cached.
+void notifyWifiScanResults();
 
 }  // namespace stagecue
 
@@ -2,20 +2,38 @@
 
 #include <Preferences.h>
 #include <WiFi.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
 
 #include "config.h"
+#include "run_loop.h"
 
 namespace stagecue {
 
 namespace {
 
 constexpr char kWifiPreferencesNamespace[] = "wifi";
-constexpr char kWifiSsidKey[] = "ssid";
-constexpr char kWifiPassKey[] = "pass";
+constexpr char kWifiCountKey[] = "count";
+// Single-network layout from earlier firmware, migrated on first load.
+constexpr char kLegacySsidKey[] = "ssid";
+constexpr char kLegacyPassKey[] = "pass";
+constexpr char kLegacyBssidKey[] = "bssid";
+constexpr char kLegacyChannelKey[] = "chan";
 
 Preferences gWifiPreferences;
 bool gWifiPreferencesReady = false;
 
+SavedNetworks gSaved;
+bool gSavedDirty = false;
+portMUX_TYPE gSavedLock = portMUX_INITIALIZER_UNLOCKED;
+
+std::array<WifiNetwork, kWifiScanCacheSize> gScanResults{};
+WifiScanStatus gScanStatus;
+portMUX_TYPE gScanLock = portMUX_INITIALIZER_UNLOCKED;
+std::atomic<bool> gScanRequested{false};
+uint32_t gNextScanPollMs = 0;  // Wi-Fi task only
+
 bool ensurePreferences() {
   if (gWifiPreferencesReady) {
     return true;
@@ -27,97 +45,333 @@ bool ensurePreferences() {
   return gWifiPreferencesReady;
 }
 
-bool loadCredentials(String &ssid, String &password) {
-  if (!ensurePreferences()) {
+void networkKey(size_t index, char (&key)[8]) {
+  snprintf(key, sizeof(key), "net%u", static_cast<unsigned>(index));
+}
+
+bool loadLegacyNetwork(WifiCredentials &out) {
+  if (!gWifiPreferences.isKey(kLegacySsidKey)) {
     return false;
   }
 
-  if (!gWifiPreferences.isKey(kWifiSsidKey)) {
-    return false;
+  gWifiPreferences.getString(kLegacySsidKey, out.ssid, sizeof(out.ssid));
+  gWifiPreferences.getString(kLegacyPassKey, out.password, sizeof(out.password));
+  if (gWifiPreferences.getBytes(kLegacyBssidKey, out.bssid, kBssidLength) == kBssidLength) {
+    out.channel = gWifiPreferences.getUChar(kLegacyChannelKey, 0);
+  }
+  for (const char *key : {kLegacySsidKey, kLegacyPassKey, kLegacyBssidKey, kLegacyChannelKey}) {
+    gWifiPreferences.remove(key);
   }
+  return out.ssid[0] != '\0';
+}
 
-  ssid = gWifiPreferences.getString(kWifiSsidKey);
-  password = gWifiPreferences.getString(kWifiPassKey);
-  return ssid.length() > 0;
+// Under gSavedLock. Moves entry `index` to the front of the priority list.
+void promoteNetwork(size_t index) {
+  const WifiCredentials entry = gSaved.entries[index];
+  for (size_t i = index; i > 0U; --i) {
+    gSaved.entries[i] = gSaved.entries[i - 1U];
+  }
+  gSaved.entries[0] = entry;
+}
+
+// Under gSavedLock.
+size_t indexOfNetwork(const char *ssid) {
+  for (size_t i = 0; i < gSaved.count; ++i) {
+    if (strcmp(gSaved.entries[i].ssid, ssid) == 0) {
+      return i;
+    }
+  }
+  return gSaved.count;
+}
+
+void markSavedChanged() {
+  gSavedDirty = true;
+  ++gSaved.generation;
+}
+
+// Keeps the strongest entry per SSID, strongest first, dropping hidden
+// networks and whatever does not fit the cache.
+size_t collectScanResults(int16_t found, std::array<WifiNetwork, kWifiScanCacheSize> &out) {
+  size_t count = 0;
+  for (int16_t i = 0; i < found; ++i) {
+    const String ssid = WiFi.SSID(i);
+    if (ssid.isEmpty()) {
+      continue;
+    }
+    const int8_t rssi = static_cast<int8_t>(WiFi.RSSI(i));
+
+    size_t slot = count;
+    for (size_t j = 0; j < count; ++j) {
+      if (strcmp(out[j].ssid, ssid.c_str()) == 0) {
+        slot = j;
+        break;
+      }
+    }
+    if (slot < count && out[slot].rssi >= rssi) {
+      continue;
+    }
+    if (slot == count) {
+      if (count == out.size()) {
+        if (out[count - 1U].rssi >= rssi) {
+          continue;
+        }
+        slot = count - 1U;
+      } else {
+        ++count;
+      }
+    }
+
+    WifiNetwork network;
+    strncpy(network.ssid, ssid.c_str(), sizeof(network.ssid) - 1U);
+    network.rssi = rssi;
+    network.secure = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
+    const uint8_t *bssid = WiFi.BSSID(i);
+    if (bssid != nullptr) {
+      memcpy(network.bssid, bssid, kBssidLength);
+      network.channel = static_cast<uint8_t>(WiFi.channel(i));
+    }
+    while (slot > 0U && out[slot - 1U].rssi < rssi) {
+      out[slot] = out[slot - 1U];
+      --slot;
+    }
+    out[slot] = network;
+  }
+  return count;
 }
 
 }  // namespace
 
+void loadSavedNetworks() {
+  if (!ensurePreferences()) {
+    return;
+  }
+
+  SavedNetworks loaded;
+  const size_t stored = std::min<size_t>(gWifiPreferences.getUChar(kWifiCountKey, 0),
+                                         kWifiMaxSavedNetworks);
+  for (size_t i = 0; i < stored; ++i) {
+    char key[8];
+    networkKey(i, key);
+    WifiCredentials &entry = loaded.entries[loaded.count];
+    if (gWifiPreferences.getBytesLength(key) == sizeof(entry) &&
+        gWifiPreferences.getBytes(key, &entry, sizeof(entry)) == sizeof(entry) &&
+        entry.ssid[0] != '\0') {
+      entry.ssid[sizeof(entry.ssid) - 1U] = '\0';
+      entry.password[sizeof(entry.password) - 1U] = '\0';
+      ++loaded.count;
+    } else {
+      entry = WifiCredentials{};
+    }
+  }
+
+  const bool migrated = loaded.count == 0U && loadLegacyNetwork(loaded.entries[0]);
+  if (migrated) {
+    loaded.count = 1U;
+    Serial.println(F("[WiFi] Migrated saved network to the priority list"));
+  }
+
+  portENTER_CRITICAL(&gSavedLock);
+  loaded.generation = gSaved.generation + 1U;
+  gSaved = loaded;
+  gSavedDirty = migrated;
+  portEXIT_CRITICAL(&gSavedLock);
+  Serial.printf("[WiFi] %u saved networks\n", static_cast<unsigned>(loaded.count));
+}
+
 bool saveWifiCredentials(const String &ssid, const String &password) {
-  if (ssid.isEmpty()) {
-    Serial.println(F("[WiFi] SSID cannot be empty"));
+  WifiCredentials entry;
+  if (ssid.isEmpty() || ssid.length() >= sizeof(entry.ssid) ||
+      password.length() >= sizeof(entry.password)) {
+    Serial.println(F("[WiFi] Invalid SSID or password length"));
     return false;
   }
+  strncpy(entry.ssid, ssid.c_str(), sizeof(entry.ssid) - 1U);
+  strncpy(entry.password, password.c_str(), sizeof(entry.password) - 1U);
 
-  if (!ensurePreferences()) {
-    return false;
+  portENTER_CRITICAL(&gSavedLock);
+  size_t index = indexOfNetwork(entry.ssid);
+  if (index == gSaved.count) {
+    index = std::min(gSaved.count, kWifiMaxSavedNetworks - 1U);
+    gSaved.count = std::max(gSaved.count, index + 1U);
+  } else if (strcmp(gSaved.entries[index].password, entry.password) == 0) {
+    // Same credentials: keep the cached access point.
+    memcpy(entry.bssid, gSaved.entries[index].bssid, kBssidLength);
+    entry.channel = gSaved.entries[index].channel;
   }
+  gSaved.entries[index] = entry;
+  promoteNetwork(index);
+  markSavedChanged();
+  portEXIT_CRITICAL(&gSavedLock);
 
-  gWifiPreferences.putString(kWifiSsidKey, ssid);
-  gWifiPreferences.putString(kWifiPassKey, password);
-  Serial.println(F("[WiFi] Credentials stored"));
+  Serial.printf("[WiFi] Saved %s as the preferred network\n", entry.ssid);
+  wakeRunLoopTask(RunLoopTask::kWifi);
   return true;
 }
 
-bool connectToSavedNetwork(uint32_t timeoutMs) {
-  String ssid;
-  String password;
-  if (!loadCredentials(ssid, password)) {
-    Serial.println(F("[WiFi] No saved credentials"));
-    return false;
+bool forgetWifiCredentials(const String &ssid) {
+  portENTER_CRITICAL(&gSavedLock);
+  const size_t index = indexOfNetwork(ssid.c_str());
+  const bool found = index < gSaved.count;
+  if (found) {
+    for (size_t i = index; i + 1U < gSaved.count; ++i) {
+      gSaved.entries[i] = gSaved.entries[i + 1U];
+    }
+    gSaved.entries[--gSaved.count] = WifiCredentials{};
+    markSavedChanged();
   }
+  portEXIT_CRITICAL(&gSavedLock);
 
-  WiFi.mode(WIFI_STA);
-  WiFi.setSleep(false);
-  WiFi.disconnect(true);
-  delay(100);
-  WiFi.setAutoReconnect(true);
-  WiFi.begin(ssid.c_str(), password.c_str());
+  if (found) {
+    wakeRunLoopTask(RunLoopTask::kWifi);
+  }
+  return found;
+}
 
-  Serial.print(F("[WiFi] Connecting to "));
-  Serial.println(ssid);
+SavedNetworks getSavedNetworks() {
+  portENTER_CRITICAL(&gSavedLock);
+  const SavedNetworks saved = gSaved;
+  portEXIT_CRITICAL(&gSavedLock);
+  return saved;
+}
 
-  const uint32_t start = millis();
-  while (WiFi.status() != WL_CONNECTED && (millis() - start) < timeoutMs) {
-    delay(200);
+void rememberAccessPoint(const char *ssid, const uint8_t *bssid, int32_t channel) {
+  if (bssid == nullptr || channel <= 0) {
+    return;
   }
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.print(F("[WiFi] Connected. IP: "));
-    Serial.println(WiFi.localIP());
-    return true;
+  portENTER_CRITICAL(&gSavedLock);
+  const size_t index = indexOfNetwork(ssid);
+  if (index < gSaved.count) {
+    WifiCredentials &entry = gSaved.entries[index];
+    if (entry.channel != channel || memcmp(entry.bssid, bssid, kBssidLength) != 0) {
+      memcpy(entry.bssid, bssid, kBssidLength);
+      entry.channel = static_cast<uint8_t>(channel);
+      gSavedDirty = true;  // not a new list: the supervisor need not restart
+    }
   }
-
-  Serial.println(F("[WiFi] Connection timeout"));
-  return false;
+  portEXIT_CRITICAL(&gSavedLock);
 }
 
-void startFallbackAccessPoint() {
-  WiFi.disconnect(true);
-  WiFi.mode(WIFI_AP);
-  WiFi.setSleep(false);
-  if (!WiFi.softAP(kFallbackApSsid, kFallbackApPass)) {
-    Serial.println(F("[WiFi] Failed to start access point"));
+void persistSavedNetworks() {
+  portENTER_CRITICAL(&gSavedLock);
+  const bool dirty = gSavedDirty;
+  gSavedDirty = false;
+  const SavedNetworks saved = gSaved;
+  portEXIT_CRITICAL(&gSavedLock);
+
+  if (!dirty || !ensurePreferences()) {
     return;
   }
-  WiFi.softAPsetHostname("StageCue-AP");
+  for (size_t i = 0; i < kWifiMaxSavedNetworks; ++i) {
+    char key[8];
+    networkKey(i, key);
+    if (i < saved.count) {
+      gWifiPreferences.putBytes(key, &saved.entries[i], sizeof(saved.entries[i]));
+    } else if (gWifiPreferences.isKey(key)) {
+      gWifiPreferences.remove(key);
+    }
+  }
+  gWifiPreferences.putUChar(kWifiCountKey, static_cast<uint8_t>(saved.count));
+}
 
-  Serial.println(F("[WiFi] Access point active"));
-  Serial.print(F("[WiFi] SSID: "));
-  Serial.println(kFallbackApSsid);
-  Serial.print(F("[WiFi] IP: "));
-  Serial.println(WiFi.softAPIP());
+void requestWifiScan() {
+  gScanRequested.store(true, std::memory_order_relaxed);
+  wakeRunLoopTask(RunLoopTask::kWifi);
 }
 
-bool startWiFiWithPortal() {
-  WiFi.persistent(false);
-  WiFi.setHostname("StageCue");
-  if (connectToSavedNetwork()) {
-    return true;
+bool serviceWifiScan() {
+  portENTER_CRITICAL(&gScanLock);
+  const bool scanning = gScanStatus.scanning;
+  portEXIT_CRITICAL(&gScanLock);
+
+  if (!scanning) {
+    if (!gScanRequested.exchange(false, std::memory_order_relaxed)) {
+      return false;
+    }
+    if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED) {
+      Serial.println(F("[WiFi] Unable to start scan"));
+      return false;
+    }
+    portENTER_CRITICAL(&gScanLock);
+    gScanStatus.scanning = true;
+    portEXIT_CRITICAL(&gScanLock);
+    gNextScanPollMs = millis() + kWifiScanPollMillis;
+    return false;
+  }
+
+  const int16_t found = WiFi.scanComplete();
+  if (found == WIFI_SCAN_RUNNING) {
+    gNextScanPollMs = millis() + kWifiScanPollMillis;
+    return false;
+  }
+
+  if (found < 0) {
+    Serial.println(F("[WiFi] Scan failed"));
+    portENTER_CRITICAL(&gScanLock);
+    gScanStatus.scanning = false;
+    portEXIT_CRITICAL(&gScanLock);
+    return false;
+  }
+
+  std::array<WifiNetwork, kWifiScanCacheSize> results{};
+  const size_t count = collectScanResults(found, results);
+  WiFi.scanDelete();
+
+  portENTER_CRITICAL(&gScanLock);
+  gScanResults = results;
+  gScanStatus.count = count;
+  gScanStatus.completedAtMs = millis();
+  ++gScanStatus.generation;
+  gScanStatus.valid = true;
+  gScanStatus.scanning = false;
+  portEXIT_CRITICAL(&gScanLock);
+
+  Serial.printf("[WiFi] Scan cached %u networks\n", static_cast<unsigned>(count));
+  return true;
+}
+
+uint32_t millisUntilWifiScanService(uint32_t nowMs, uint32_t limitMs) {
+  if (gScanRequested.load(std::memory_order_relaxed)) {
+    return 0U;
   }
+  portENTER_CRITICAL(&gScanLock);
+  const bool scanning = gScanStatus.scanning;
+  portEXIT_CRITICAL(&gScanLock);
+  if (!scanning) {
+    return limitMs;
+  }
+  const int32_t remaining = static_cast<int32_t>(gNextScanPollMs - nowMs);
+  return remaining <= 0 ? 0U : std::min(limitMs, static_cast<uint32_t>(remaining));
+}
+
+bool getWifiNetwork(size_t index, WifiNetwork &out) {
+  portENTER_CRITICAL(&gScanLock);
+  const bool available = index < gScanStatus.count;
+  if (available) {
+    out = gScanResults[index];
+  }
+  portEXIT_CRITICAL(&gScanLock);
+  return available;
+}
+
+bool findWifiNetwork(const char *ssid, WifiNetwork &out) {
+  portENTER_CRITICAL(&gScanLock);
+  bool found = false;
+  for (size_t i = 0; i < gScanStatus.count && !found; ++i) {
+    if (strcmp(gScanResults[i].ssid, ssid) == 0) {
+      out = gScanResults[i];
+      found = true;
+    }
+  }
+  portEXIT_CRITICAL(&gScanLock);
+  return found;
+}
 
-  startFallbackAccessPoint();
-  return false;
+WifiScanStatus getWifiScanStatus() {
+  portENTER_CRITICAL(&gScanLock);
+  const WifiScanStatus status = gScanStatus;
+  portEXIT_CRITICAL(&gScanLock);
+  return status;
 }
 
 }  // namespace stagecue
@@ -1,13 +1,68 @@
 #pragma once
 
 #include <Arduino.h>
+#include <array>
+
+#include "config.h"
 
 namespace stagecue {
 
-bool startWiFiWithPortal();
+inline constexpr size_t kBssidLength = 6U;
+
+struct WifiCredentials {
+  char ssid[33] = {};
+  char password[65] = {};
+  // Access point this network was last joined on; channel 0 when unknown.
+  uint8_t bssid[kBssidLength] = {};
+  uint8_t channel = 0;
+};
+
+struct SavedNetworks {
+  std::array<WifiCredentials, kWifiMaxSavedNetworks> entries{};
+  size_t count = 0;
+  uint32_t generation = 0;  // bumped by every save or forget
+};
+
+// Reads the saved networks from flash; call once before the supervisor runs.
+void loadSavedNetworks();
+// Puts the network first in the priority list, replacing an entry with the
+// same SSID and dropping the last one when the list is full. Takes effect
+// without a reboot: the Wi-Fi task writes it to flash and reconnects.
 bool saveWifiCredentials(const String &ssid, const String &password);
-bool connectToSavedNetwork(uint32_t timeoutMs = 10000);
-void startFallbackAccessPoint();
+bool forgetWifiCredentials(const String &ssid);
+SavedNetworks getSavedNetworks();
+// Wi-Fi task side: caches the access point a saved network was joined on,
+// and writes pending changes to flash.
+void rememberAccessPoint(const char *ssid, const uint8_t *bssid, int32_t channel);
+void persistSavedNetworks();
 
-}  // namespace stagecue
+struct WifiNetwork {
+  char ssid[33] = {};
+  int8_t rssi = 0;
+  bool secure = false;
+  uint8_t bssid[kBssidLength] = {};  // of the strongest access point seen
+  uint8_t channel = 0;
+};
+
+struct WifiScanStatus {
+  size_t count = 0;
+  uint32_t completedAtMs = 0;
+  uint32_t generation = 0;  // bumped each time fresh results are cached
+  bool valid = false;
+  bool scanning = false;
+};
 
+// Scans run in the background; callers only ever read the cache. Requests
+// are picked up by serviceWifiScan(), which returns true when a scan has
+// just refreshed the cache.
+void requestWifiScan();
+bool serviceWifiScan();
+// Time until serviceWifiScan() has work: a pending request, or the next
+// completion poll while a scan runs.
+uint32_t millisUntilWifiScanService(uint32_t nowMs, uint32_t limitMs);
+bool getWifiNetwork(size_t index, WifiNetwork &out);
+// Strongest cached entry for `ssid`, if the last scan saw it.
+bool findWifiNetwork(const char *ssid, WifiNetwork &out);
+WifiScanStatus getWifiScanStatus();
+
+}  // namespace stagecue
@@ -0,0 +1,396 @@
+#include "wifi_supervisor.h"
+
+#include <WiFi.h>
+#include <algorithm>
+#include <atomic>
+
+#include "boot_timeline.h"
+#include "config.h"
+#include "run_loop.h"
+#include "wifi_portal.h"
+
+namespace stagecue {
+
+namespace {
+
+constexpr uint32_t kEventGotIp = 1U << 0;
+constexpr uint32_t kEventDisconnected = 1U << 1;
+
+// Set by the Arduino event task, consumed by the Wi-Fi task.
+std::atomic<uint32_t> gEvents{0};
+std::atomic<uint8_t> gDisconnectReason{0};
+std::atomic<bool> gStarted{false};
+std::atomic<bool> gStationUp{false};
+
+// Wi-Fi task only.
+SavedNetworks gNetworks;
+WifiLinkState gState = WifiLinkState::kIdle;
+size_t gCandidate = 0;
+bool gFastAttempt = false;  // joining a known BSSID/channel rather than scanning
+uint32_t gDeadlineMs = 0;   // attempt timeout or end of backoff
+uint32_t gFailedRounds = 0;
+bool gLinkDown = true;
+uint32_t gDownSinceMs = 0;
+uint32_t gConnectedSinceMs = 0;
+bool gApUp = false;
+uint32_t gNextRoamCheckMs = 0;
+uint32_t gNextRoamScanMs = 0;
+bool gRoamScanPending = false;
+uint32_t gRoamScanGeneration = 0;
+
+WifiSupervisorStats gStats;  // Wi-Fi task's working copy
+WifiSupervisorStats gPublishedStats;
+portMUX_TYPE gStatsLock = portMUX_INITIALIZER_UNLOCKED;
+
+void onWifiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    gEvents.fetch_or(kEventGotIp, std::memory_order_release);
+  } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+    gDisconnectReason.store(info.wifi_sta_disconnected.reason, std::memory_order_relaxed);
+    gEvents.fetch_or(kEventDisconnected, std::memory_order_release);
+  } else {
+    return;
+  }
+  wakeRunLoopTask(RunLoopTask::kWifi);
+}
+
+bool isDue(uint32_t nowMs, uint32_t deadlineMs) {
+  return static_cast<int32_t>(nowMs - deadlineMs) >= 0;
+}
+
+void setState(WifiLinkState state) {
+  gState = state;
+  gStats.state = state;
+}
+
+void beginAttempt(uint32_t nowMs, size_t index, bool fast) {
+  const WifiCredentials &network = gNetworks.entries[index];
+  gCandidate = index;
+  gFastAttempt = fast && network.channel != 0U;
+  strncpy(gStats.ssid, network.ssid, sizeof(gStats.ssid) - 1U);
+
+  if (gFastAttempt) {
+    WiFi.begin(network.ssid, network.password, network.channel, network.bssid);
+    gDeadlineMs = nowMs + kWifiFastConnectTimeoutMillis;
+  } else {
+    WiFi.begin(network.ssid, network.password);
+    gDeadlineMs = nowMs + kWifiConnectTimeoutMillis;
+  }
+  setState(WifiLinkState::kConnecting);
+}
+
+void markLinkDown(uint32_t nowMs) {
+  if (!gLinkDown) {
+    gLinkDown = true;
+    gDownSinceMs = nowMs;
+  }
+  gStationUp.store(false, std::memory_order_relaxed);
+}
+
+void attemptFailed(uint32_t nowMs) {
+  ++gStats.failures;
+  if (gFastAttempt) {
+    // The cached access point is gone; let the driver find the network.
+    beginAttempt(nowMs, gCandidate, false);
+    return;
+  }
+  if (gCandidate + 1U < gNetworks.count) {
+    beginAttempt(nowMs, gCandidate + 1U, true);
+    return;
+  }
+
+  // Every network failed this round. While someone is on the portal, wait the
+  // longest: a join attempt drags the AP's channel along with it.
+  uint32_t backoffMs = kWifiBackoffBaseMillis << std::min<uint32_t>(gFailedRounds, 16U);
+  backoffMs = std::min(backoffMs, kWifiBackoffMaxMillis);
+  if (gApUp && WiFi.softAPgetStationNum() > 0) {
+    backoffMs = kWifiBackoffMaxMillis;
+  }
+  backoffMs += esp_random() % (backoffMs / 4U + 1U);
+  ++gFailedRounds;
+
+  WiFi.disconnect();
+  gStats.backoffMs = backoffMs;
+  gDeadlineMs = nowMs + backoffMs;
+  setState(WifiLinkState::kBackoff);
+  Serial.printf("[WiFi] No saved network reachable, retrying in %lu ms\n",
+                static_cast<unsigned long>(backoffMs));
+}
+
+void handleLinkUp(uint32_t nowMs) {
+  const uint32_t downForMs = gLinkDown ? nowMs - gDownSinceMs : 0U;
+  if (gState == WifiLinkState::kRoaming) {
+    ++gStats.roams;
+  }
+  ++gStats.connects;
+  gStats.lastReconnectMs = downForMs;
+  gStats.maxReconnectMs = std::max(gStats.maxReconnectMs, downForMs);
+  gStats.downMs += downForMs;
+  gStats.backoffMs = 0;
+
+  gLinkDown = false;
+  gFailedRounds = 0;
+  gConnectedSinceMs = nowMs;
+  gNextRoamCheckMs = nowMs + kWifiRoamCheckMillis;
+  gNextRoamScanMs = nowMs;
+  gRoamScanPending = false;
+  setState(WifiLinkState::kConnected);
+  gStationUp.store(true, std::memory_order_relaxed);
+
+  WifiCredentials &network = gNetworks.entries[gCandidate];
+  const uint8_t *bssid = WiFi.BSSID();
+  const int32_t channel = WiFi.channel();
+  if (bssid != nullptr && channel > 0) {
+    memcpy(network.bssid, bssid, kBssidLength);
+    network.channel = static_cast<uint8_t>(channel);
+    rememberAccessPoint(network.ssid, bssid, channel);
+  }
+
+  markBootPhase(BootPhase::kWifiConnected);
+  Serial.printf("[WiFi] Connected to %s, IP %s, after %lu ms\n", network.ssid,
+                WiFi.localIP().toString().c_str(), static_cast<unsigned long>(downForMs));
+}
+
+void handleDisconnect(uint32_t nowMs, uint8_t reason) {
+  switch (gState) {
+    case WifiLinkState::kConnected:
+      ++gStats.drops;
+      markLinkDown(nowMs);
+      Serial.printf("[WiFi] Link lost (reason %u), reconnecting\n", static_cast<unsigned>(reason));
+      beginAttempt(nowMs, gCandidate, true);
+      break;
+    case WifiLinkState::kConnecting:
+    case WifiLinkState::kRoaming:
+      // Leaving the previous access point is part of every new join.
+      if (reason != WIFI_REASON_ASSOC_LEAVE) {
+        attemptFailed(nowMs);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void applySavedNetworks(uint32_t nowMs, const SavedNetworks &saved) {
+  const bool keepLink = gState == WifiLinkState::kConnected && saved.count > 0U &&
+                        strcmp(saved.entries[0].ssid, gNetworks.entries[gCandidate].ssid) == 0;
+  gNetworks = saved;
+  if (keepLink) {
+    gCandidate = 0;
+    return;
+  }
+
+  markLinkDown(nowMs);
+  gFailedRounds = 0;
+  if (gNetworks.count == 0U) {
+    WiFi.disconnect();
+    gStats.ssid[0] = '\0';
+    setState(WifiLinkState::kIdle);
+    return;
+  }
+  beginAttempt(nowMs, 0, true);
+}
+
+void startAccessPoint() {
+  WiFi.mode(WIFI_AP_STA);
+  if (!WiFi.softAP(kFallbackApSsid, kFallbackApPass)) {
+    Serial.println(F("[WiFi] Failed to start access point"));
+    return;
+  }
+  WiFi.softAPsetHostname("StageCue-AP");
+  gApUp = true;
+
+  markBootPhase(BootPhase::kAccessPointUp);
+  Serial.printf("[WiFi] Access point %s up at %s\n", kFallbackApSsid,
+                WiFi.softAPIP().toString().c_str());
+  // The portal is the likely next stop; have networks ready for it.
+  requestWifiScan();
+}
+
+void serviceAccessPoint(uint32_t nowMs) {
+  const bool wanted =
+      gNetworks.count == 0U || (gLinkDown && isDue(nowMs, gDownSinceMs + kWifiApFallbackMillis));
+  if (wanted && !gApUp) {
+    startAccessPoint();
+  } else if (gApUp && gState == WifiLinkState::kConnected &&
+             isDue(nowMs, gConnectedSinceMs + kWifiApLingerMillis) &&
+             WiFi.softAPgetStationNum() == 0) {
+    WiFi.softAPdisconnect(true);
+    gApUp = false;
+    Serial.println(F("[WiFi] Station link stable, access point off"));
+  }
+}
+
+void serviceRoaming(uint32_t nowMs) {
+  if (!isDue(nowMs, gNextRoamCheckMs)) {
+    return;
+  }
+  gNextRoamCheckMs = nowMs + kWifiRoamCheckMillis;
+  const auto rssi = static_cast<int8_t>(WiFi.RSSI());
+  gStats.rssi = rssi;
+
+  if (gRoamScanPending) {
+    const WifiScanStatus scan = getWifiScanStatus();
+    if (scan.scanning || scan.generation == gRoamScanGeneration) {
+      return;
+    }
+    gRoamScanPending = false;
+
+    const WifiCredentials &network = gNetworks.entries[gCandidate];
+    WifiNetwork best;
+    const uint8_t *current = WiFi.BSSID();
+    if (!findWifiNetwork(network.ssid, best) || best.channel == 0U ||
+        (current != nullptr && memcmp(best.bssid, current, kBssidLength) == 0) ||
+        best.rssi < rssi + static_cast<int>(kWifiRoamHysteresisDb)) {
+      return;
+    }
+
+    Serial.printf("[WiFi] Roaming to %02x:%02x:%02x:%02x:%02x:%02x (%d dBm, was %d dBm)\n",
+                  best.bssid[0], best.bssid[1], best.bssid[2], best.bssid[3], best.bssid[4],
+                  best.bssid[5], best.rssi, rssi);
+    markLinkDown(nowMs);
+    WiFi.begin(network.ssid, network.password, best.channel, best.bssid);
+    gFastAttempt = true;  // on failure, fall back to a plain join
+    gDeadlineMs = nowMs + kWifiFastConnectTimeoutMillis;
+    setState(WifiLinkState::kRoaming);
+    return;
+  }
+
+  if (rssi < kWifiRoamRssiThreshold && isDue(nowMs, gNextRoamScanMs)) {
+    gNextRoamScanMs = nowMs + kWifiRoamScanIntervalMillis;
+    gRoamScanGeneration = getWifiScanStatus().generation;
+    gRoamScanPending = true;
+    requestWifiScan();
+  }
+}
+
+void publishStats(uint32_t nowMs) {
+  gStats.accessPoint = gApUp;
+  WifiSupervisorStats published = gStats;
+  if (gLinkDown) {
+    published.downMs += nowMs - gDownSinceMs;
+  }
+  portENTER_CRITICAL(&gStatsLock);
+  gPublishedStats = published;
+  portEXIT_CRITICAL(&gStatsLock);
+}
+
+}  // namespace
+
+void startWifiSupervisor() {
+  loadSavedNetworks();
+  WiFi.persistent(false);
+  WiFi.setHostname("StageCue");
+  WiFi.setAutoReconnect(false);  // reconnection timing is ours
+  WiFi.onEvent(onWifiEvent);
+  WiFi.mode(WIFI_STA);
+  WiFi.setSleep(false);
+
+  gDownSinceMs = millis();
+  gStarted.store(true, std::memory_order_release);
+  wakeRunLoopTask(RunLoopTask::kWifi);
+}
+
+void serviceWifiSupervisor(uint32_t nowMs) {
+  if (!gStarted.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  persistSavedNetworks();
+  const SavedNetworks saved = getSavedNetworks();
+  if (saved.generation != gNetworks.generation) {
+    applySavedNetworks(nowMs, saved);
+  }
+
+  const uint32_t events = gEvents.exchange(0U, std::memory_order_acquire);
+  if (events != 0U) {
+    const bool up = WiFi.status() == WL_CONNECTED;
+    if (up && (events & kEventGotIp) != 0U && gState != WifiLinkState::kConnected) {
+      handleLinkUp(nowMs);
+    } else if (!up && (events & kEventDisconnected) != 0U) {
+      handleDisconnect(nowMs, gDisconnectReason.load(std::memory_order_relaxed));
+    }
+  }
+
+  switch (gState) {
+    case WifiLinkState::kConnecting:
+    case WifiLinkState::kRoaming:
+      if (isDue(nowMs, gDeadlineMs)) {
+        attemptFailed(nowMs);
+      }
+      break;
+    case WifiLinkState::kBackoff:
+      if (isDue(nowMs, gDeadlineMs)) {
+        beginAttempt(nowMs, 0, true);
+      }
+      break;
+    case WifiLinkState::kConnected:
+      serviceRoaming(nowMs);
+      break;
+    case WifiLinkState::kIdle:
+      break;
+  }
+
+  serviceAccessPoint(nowMs);
+  publishStats(nowMs);
+}
+
+uint32_t millisUntilWifiSupervisor(uint32_t nowMs, uint32_t limitMs) {
+  if (!gStarted.load(std::memory_order_acquire)) {
+    return limitMs;
+  }
+  if (gEvents.load(std::memory_order_relaxed) != 0U) {
+    return 0U;
+  }
+
+  uint32_t timeoutMs = limitMs;
+  const auto clampTo = [&timeoutMs, nowMs](uint32_t deadline) {
+    const int32_t remaining = static_cast<int32_t>(deadline - nowMs);
+    timeoutMs = remaining <= 0 ? 0U : std::min(timeoutMs, static_cast<uint32_t>(remaining));
+  };
+  switch (gState) {
+    case WifiLinkState::kConnecting:
+    case WifiLinkState::kRoaming:
+    case WifiLinkState::kBackoff:
+      clampTo(gDeadlineMs);
+      break;
+    case WifiLinkState::kConnected:
+      clampTo(gNextRoamCheckMs);
+      break;
+    case WifiLinkState::kIdle:
+      break;
+  }
+  if (gLinkDown && !gApUp && gNetworks.count > 0U) {
+    clampTo(gDownSinceMs + kWifiApFallbackMillis);
+  }
+  return timeoutMs;
+}
+
+bool isWifiStationUp() {
+  return gStationUp.load(std::memory_order_relaxed);
+}
+
+WifiSupervisorStats getWifiSupervisorStats() {
+  portENTER_CRITICAL(&gStatsLock);
+  const WifiSupervisorStats stats = gPublishedStats;
+  portEXIT_CRITICAL(&gStatsLock);
+  return stats;
+}
+
+const char *wifiLinkStateName(WifiLinkState state) {
+  switch (state) {
+    case WifiLinkState::kIdle:
+      return "idle";
+    case WifiLinkState::kConnecting:
+      return "connecting";
+    case WifiLinkState::kBackoff:
+      return "backoff";
+    case WifiLinkState::kConnected:
+      return "connected";
+    case WifiLinkState::kRoaming:
+      return "roaming";
+  }
+  return "unknown";
+}
+
+}  // namespace stagecue
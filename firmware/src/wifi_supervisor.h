@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace stagecue {
+
+enum class WifiLinkState : uint8_t {
+  kIdle,        // nothing saved; the portal AP is the only way in
+  kConnecting,  // joining a saved network
+  kBackoff,     // every saved network failed; waiting before the next round
+  kConnected,
+  kRoaming,     // moving to a stronger access point of the same network
+};
+
+struct WifiSupervisorStats {
+  WifiLinkState state = WifiLinkState::kIdle;
+  bool accessPoint = false;
+  char ssid[33] = {};  // network joined or being joined
+  int8_t rssi = 0;
+  uint32_t connects = 0;
+  uint32_t drops = 0;     // links lost after being established
+  uint32_t failures = 0;  // join attempts that timed out or were refused
+  uint32_t roams = 0;
+  uint32_t backoffMs = 0;
+  // Time from losing the link (or boot) to having an address again.
+  uint32_t lastReconnectMs = 0;
+  uint32_t maxReconnectMs = 0;
+  uint32_t downMs = 0;  // total time without a station link
+};
+
+// Keeps the station link up without ever blocking the caller: saved
+// networks are tried in priority order, cached BSSID/channel first, with
+// exponential backoff between rounds. A weak link roams to a stronger access
+// point of the same SSID, and the fallback AP runs next to the retries
+// whenever the link has been down for a while.
+//
+// Call start from the boot network task; it configures the radio and leaves
+// everything else to serviceWifiSupervisor() on the Wi-Fi task.
+void startWifiSupervisor();
+void serviceWifiSupervisor(uint32_t nowMs);
+uint32_t millisUntilWifiSupervisor(uint32_t nowMs, uint32_t limitMs);
+
+bool isWifiStationUp();
+WifiSupervisorStats getWifiSupervisorStats();
+const char *wifiLinkStateName(WifiLinkState state);
+
+}  // namespace stagecue
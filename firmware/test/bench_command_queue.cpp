@@ -0,0 +1,98 @@
+// Cue command throughput: one, two and four web tasks submitting triggers,
+// releases and renames while the loop task drains the queue with
+// updateCues(). Reports commands applied per second and how often a
+// producer found the queue full and had to retry.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+constexpr uint32_t kCommandsEach = 30000;
+
+struct Throughput {
+  double commandsPerSecond = 0.0;
+  uint32_t applied = 0;
+  uint32_t retries = 0;
+};
+
+// Every third command renames, the rest trigger and release in turn.
+bool submitCommand(uint8_t cue, uint32_t i, const std::string &label) {
+  switch (i % 3U) {
+    case 0:
+      return requestCueTrigger(cue);
+    case 1:
+      return requestCueRelease(cue);
+    default:
+      return requestCueRename(cue, label.c_str());
+  }
+}
+
+Throughput measure(uint32_t producerCount) {
+  std::atomic<uint32_t> producersLeft{producerCount};
+  std::atomic<uint32_t> retries{0};
+  const CueCommandStats before = getCueCommandStats();
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> producers;
+  for (uint32_t p = 0; p < producerCount; ++p) {
+    producers.emplace_back([&, p] {
+      const uint8_t cue = static_cast<uint8_t>(p % kCueCount);
+      const std::string label = "Producer " + std::to_string(p);
+      for (uint32_t i = 0; i < kCommandsEach;) {
+        if (submitCommand(cue, i, label)) {
+          ++i;
+        } else {
+          retries.fetch_add(1U, std::memory_order_relaxed);
+          std::this_thread::yield();
+        }
+      }
+      producersLeft.fetch_sub(1U);
+    });
+  }
+  // The loop task sleeps between wakes; the host thread yields instead.
+  while (producersLeft.load() != 0U) {
+    updateCues();
+    std::this_thread::yield();
+  }
+  updateCues();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  for (auto &producer : producers) {
+    producer.join();
+  }
+
+  const CueCommandStats after = getCueCommandStats();
+  Throughput result;
+  result.applied = after.applied - before.applied;
+  result.retries = retries.load();
+  result.commandsPerSecond =
+      result.applied / std::chrono::duration<double>(elapsed).count();
+  EXPECT_EQ(result.applied, producerCount * kCommandsEach);
+  EXPECT_EQ(after.rejected - before.rejected, result.retries);
+  return result;
+}
+
+TEST(CommandQueueBench, ProducersAgainstTheLoopTask) {
+  ASSERT_TRUE(test::bootDevice());
+  sim::freezeClock(true);
+
+  for (uint32_t producers : {1U, 2U, 4U}) {
+    const Throughput result = measure(producers);
+    printf("command_queue producers=%u applied=%u rate=%.0f/s full_retries=%u high_water=%u/%zu\n",
+           producers, result.applied, result.commandsPerSecond, result.retries,
+           getCueCommandStats().highWater, kCueCommandQueueSize);
+  }
+  sim::freezeClock(false);
+}
+
+}  // namespace
+}  // namespace stagecue
@@ -0,0 +1,70 @@
+// Cost of one updateCues() pass at this build's kCueCount: idle, and with
+// every channel pending inside its debounce window, which makes the unrolled
+// channel scan read and compare each button. Built for the default and the
+// eight-cue configuration; compare the per-channel figures across the two.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+constexpr int kPasses = 20000;
+
+// Median wall time of one updateCues() pass, in nanoseconds.
+double measurePasses() {
+  std::vector<double> samples(kPasses);
+  for (double &sample : samples) {
+    const auto start = std::chrono::steady_clock::now();
+    updateCues();
+    sample = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                 .count();
+  }
+  std::nth_element(samples.begin(), samples.begin() + kPasses / 2, samples.end());
+  return samples[kPasses / 2];
+}
+
+TEST(CueScanBench, PassCostAgainstChannelCount) {
+  ASSERT_TRUE(test::bootDevice());
+  // Only the scan itself moves while the clock stands still: no debounce
+  // window closes and no timer expires between passes.
+  sim::freezeClock(true);
+
+  const double idleNs = measurePasses();
+
+  // A press is accepted on its leading edge; the release that follows stays
+  // pending until the debounce window closes, which the frozen clock never
+  // lets happen.
+  for (uint8_t pin : kCueButtons) {
+    sim::setPinInput(pin, false);
+  }
+  updateCues();
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    EXPECT_TRUE(getCueSnapshot(i).state.active) << "cue " << int(i);
+  }
+  for (uint8_t pin : kCueButtons) {
+    sim::setPinInput(pin, true);
+  }
+  const double pendingNs = measurePasses();
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    EXPECT_TRUE(getCueSnapshot(i).state.active) << "cue " << int(i);
+  }
+
+  printf("cue_scan cues=%u idle=%.0fns pending=%.0fns pending_per_cue=%.0fns\n",
+         static_cast<unsigned>(kCueCount), idleNs, pendingNs, pendingNs / kCueCount);
+
+  sim::freezeClock(false);
+  test::runFor(kButtonDebounceMillis * 2U);
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    EXPECT_FALSE(getCueSnapshot(i).state.active) << "cue " << int(i);
+  }
+}
+
+}  // namespace
+}  // namespace stagecue
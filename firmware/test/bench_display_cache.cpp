@@ -0,0 +1,44 @@
+// Label render cost with the rasterized-label cache on and off, from the
+// kDisplayRender probe.
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+#include "display_manager.h"
+#include "latency_stats.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+constexpr int kRenders = 500;
+
+LatencySummary measureRenders(bool cached) {
+  setDisplayCacheEnabled(cached);
+  updateDisplay(0, CueLabel("Warm up"));
+  resetLatencyStats();
+  const CueLabel labels[] = {CueLabel("Cue 12 - Blackout"), CueLabel("Cue 13 - Fly out")};
+  for (int i = 0; i < kRenders; ++i) {
+    updateDisplay(static_cast<uint8_t>(i % 2), labels[i % 2]);
+  }
+  const LatencySummary summary = summarizeLatency(LatencyProbe::kDisplayRender);
+  printf("display_render cache=%-3s samples=%4u p50=%6uus p99=%6uus max=%6uus\n",
+         cached ? "on" : "off", summary.samples, summary.p50Us, summary.p99Us, summary.maxUs);
+  return summary;
+}
+
+TEST(DisplayCacheBench, CachedVersusUncachedRenders) {
+  ASSERT_TRUE(test::bootDevice());
+
+  const LatencySummary uncached = measureRenders(false);
+  const LatencySummary cached = measureRenders(true);
+  EXPECT_EQ(uncached.samples, static_cast<uint32_t>(kRenders));
+  EXPECT_EQ(cached.samples, static_cast<uint32_t>(kRenders));
+  // On the host both sides sit at the timer's resolution, so the comparison
+  // is reported, not asserted.
+  printf("display_render p50 cached/uncached = %u/%uus\n", cached.p50Us, uncached.p50Us);
+}
+
+}  // namespace
+}  // namespace stagecue
@@ -0,0 +1,73 @@
+// End-to-end cue latencies on the host build: triggers through the command
+// queue and the cue engine tick (updateCues() → triggerCue() →
+// notifyCueState() → flush), and button edges through the ISR, debounce and
+// label render. Prints p50/p99/max from the firmware's own probes.
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+#include "latency_stats.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+constexpr int kRounds = 400;
+
+class LatencyBench : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { ASSERT_TRUE(test::bootDevice()); }
+
+  void SetUp() override {
+    client_ = sim::connectWebSocket("/ws");
+    ASSERT_NE(client_, 0U);
+    test::runFor(100);
+    sim::takeWebSocketMessages(client_);
+    resetLatencyStats();
+  }
+
+  void TearDown() override {
+    sim::disconnectWebSocket(client_);
+    test::runFor(100);
+  }
+
+  static void report(LatencyProbe probe) {
+    const LatencySummary summary = summarizeLatency(probe);
+    printf("%-22s samples=%4u p50=%6uus p99=%6uus max=%6uus\n", latencyProbeName(probe),
+           summary.samples, summary.p50Us, summary.p99Us, summary.maxUs);
+    EXPECT_GT(summary.samples, 0U);
+    EXPECT_LE(summary.p50Us, summary.p99Us);
+    EXPECT_LE(summary.p99Us, summary.maxUs);
+  }
+
+  uint32_t client_ = 0;
+};
+
+TEST_F(LatencyBench, TriggerToLedAndBroadcast) {
+  for (int round = 0; round < kRounds; ++round) {
+    const auto index = static_cast<uint8_t>(round % 2);
+    ASSERT_TRUE(requestCueTrigger(index));
+    ASSERT_TRUE(test::runUntil([&] { return !sim::takeWebSocketMessages(client_).empty(); }));
+    EXPECT_TRUE(sim::pinLevel(kCueLEDs[index]));
+    ASSERT_TRUE(requestCueRelease(index));
+    test::runFor(5);
+    sim::takeWebSocketMessages(client_);
+  }
+  report(LatencyProbe::kTriggerToLed);
+  report(LatencyProbe::kTriggerToBroadcast);
+}
+
+TEST_F(LatencyBench, ButtonToDisplay) {
+  for (int round = 0; round < kRounds / 4; ++round) {
+    const auto index = static_cast<uint8_t>(round % 2);
+    test::pressButton(index);
+    test::runFor(kButtonDebounceMillis * 2U);
+    EXPECT_FALSE(getCueSnapshot(index).state.active);
+  }
+  report(LatencyProbe::kButtonToDisplay);
+  report(LatencyProbe::kPressToTrigger);
+}
+
+}  // namespace
+}  // namespace stagecue
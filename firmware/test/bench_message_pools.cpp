@@ -0,0 +1,118 @@
+// Message pool cost against the heap it replaces: one slot acquire/release
+// next to malloc()/free() and the String the outbound fallback builds, then
+// a million pings whose acks go out through pooled frames, with firmware
+// heap use counted throughout.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "message_pools.h"
+#include "test_support.h"
+
+extern "C" void *__libc_malloc(size_t size);
+
+namespace {
+
+std::atomic<bool> gCountAllocations{false};
+std::atomic<uint32_t> gFirmwareAllocations{0};
+
+}  // namespace
+
+// Counts heap blocks taken by firmware code while counting is on; library
+// code (AsyncWebSocket's own message copies) is left out.
+extern "C" void *malloc(size_t size) {
+  if (gCountAllocations.load(std::memory_order_relaxed) && !sim::inLibraryCode()) {
+    gFirmwareAllocations.fetch_add(1U, std::memory_order_relaxed);
+  }
+  return __libc_malloc(size);
+}
+
+namespace stagecue {
+namespace {
+
+constexpr int kAllocations = 1000000;
+constexpr int kMessages = 1000000;
+constexpr size_t kFrameSize = 200U;  // a cue message with a long label
+
+template <typename Fn>
+double nanosPer(int count, Fn &&body) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i) {
+    body(i);
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+             .count() /
+         count;
+}
+
+TEST(MessagePoolBench, SlotAgainstHeapAllocation) {
+  // Keeps the compiler from dropping the blocks unused.
+  std::atomic<uintptr_t> sink{0};
+
+  const double pooledNs = nanosPer(kAllocations, [&](int i) {
+    MessageBuffer frame(MessagePool::kOutbound, kFrameSize);
+    frame.data()[0] = static_cast<char>(i);
+    sink.fetch_xor(reinterpret_cast<uintptr_t>(frame.data()), std::memory_order_relaxed);
+  });
+  const double mallocNs = nanosPer(kAllocations, [&](int i) {
+    auto *block = static_cast<char *>(malloc(kFrameSize));
+    block[0] = static_cast<char>(i);
+    sink.fetch_xor(reinterpret_cast<uintptr_t>(block), std::memory_order_relaxed);
+    free(block);
+  });
+  const double stringNs = nanosPer(kAllocations, [&](int i) {
+    String payload;
+    payload.reserve(kFrameSize);
+    payload += static_cast<char>('a' + i % 26);
+    sink.fetch_xor(reinterpret_cast<uintptr_t>(payload.c_str()), std::memory_order_relaxed);
+  });
+
+  printf("alloc size=%zu pooled=%.1fns malloc=%.1fns string_fallback=%.1fns\n", kFrameSize,
+         pooledNs, mallocNs, stringNs);
+  const SlabPoolStats stats = getMessagePoolStats(MessagePool::kOutbound);
+  EXPECT_GE(stats.acquires, static_cast<uint32_t>(kAllocations));
+  EXPECT_EQ(stats.exhausted, 0U);
+}
+
+TEST(MessagePoolBench, MillionMessageSoak) {
+  ASSERT_TRUE(test::bootDevice());
+  const uint32_t client = sim::connectWebSocket("/ws");
+  ASSERT_NE(client, 0U);
+  test::runFor(100);
+  sim::takeWebSocketMessages(client);
+
+  const std::string ping = R"({"type":"ping"})";
+  const size_t libraryBuffers = sim::webSocketBuffers();
+  const SlabPoolStats before = getMessagePoolStats(MessagePool::kOutbound);
+
+  size_t acks = 0;
+  gCountAllocations = true;
+  const double messageNs = nanosPer(kMessages, [&](int i) {
+    sim::sendWebSocketText(client, ping);
+    if (i % 32 == 31) {
+      gCountAllocations = false;
+      acks += sim::takeWebSocketMessages(client).size();
+      gCountAllocations = true;
+    }
+  });
+  gCountAllocations = false;
+  acks += sim::takeWebSocketMessages(client).size();
+
+  const SlabPoolStats after = getMessagePoolStats(MessagePool::kOutbound);
+  printf("soak messages=%d per_message=%.0fns firmware_mallocs=%u pooled_frames=%u "
+         "high_water=%u/%u\n",
+         kMessages, messageNs, gFirmwareAllocations.load(), after.acquires - before.acquires,
+         after.highWater, after.slots);
+  EXPECT_EQ(acks, static_cast<size_t>(kMessages));
+  EXPECT_EQ(gFirmwareAllocations.load(), 0U);
+  EXPECT_EQ(after.exhausted, before.exhausted);
+  EXPECT_EQ(sim::webSocketBuffers(), libraryBuffers);
+  EXPECT_EQ(sim::webSocketDropped(client), 0U);
+}
+
+}  // namespace
+}  // namespace stagecue
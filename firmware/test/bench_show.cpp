@@ -0,0 +1,100 @@
+// Show engine at 2000 cues: compile time of the file, GO cost from the
+// kShowGo probe at the start, middle and end of the list, and the tick that
+// applies a JUMP. GO and JUMP only move a cursor over the compiled records,
+// so neither should depend on the position.
+
+#include <gtest/gtest.h>
+
+#include <LittleFS.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "latency_stats.h"
+#include "show.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+constexpr uint16_t kShowCues = 2000;
+constexpr int kRounds = 400;
+
+std::string makeShow(uint16_t cues) {
+  std::string show = "# channel\tauto-release\ttext\n";
+  for (uint16_t i = 0; i < cues; ++i) {
+    show += std::to_string(i % kCueCount + 1U) + "\t0\tAct " + std::to_string(i / 100U + 1U) +
+            " cue " + std::to_string(i + 1U) + " - lighting state\n";
+  }
+  return show;
+}
+
+// GO from `position` again and again; returns the kShowGo summary.
+LatencySummary measureGo(uint16_t position) {
+  resetLatencyStats();
+  for (int round = 0; round < kRounds; ++round) {
+    EXPECT_TRUE(requestShowJump(position));
+    updateCues();
+    EXPECT_TRUE(requestShowGo());
+    updateCues();
+  }
+  EXPECT_EQ(getShowStatus().position, position + 1U);
+  return summarizeLatency(LatencyProbe::kShowGo);
+}
+
+// Median wall time of a cue engine tick that applies a JUMP, alternating
+// between both ends of the list.
+double measureJumps() {
+  std::vector<double> samples(kRounds);
+  for (int round = 0; round < kRounds; ++round) {
+    EXPECT_TRUE(requestShowJump(round % 2 == 0 ? 0U : kShowCues - 1U));
+    const auto start = std::chrono::steady_clock::now();
+    updateCues();
+    samples[round] =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  }
+  std::nth_element(samples.begin(), samples.begin() + kRounds / 2, samples.end());
+  return samples[kRounds / 2];
+}
+
+TEST(ShowBench, CompileGoAndJumpAtTwoThousandCues) {
+  ASSERT_TRUE(test::bootDevice());
+  sim::writeFile(kShowFilePath, makeShow(kShowCues));
+
+  const auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<CompiledShow> show = compileShowFile(LittleFS, kShowFilePath);
+  const auto compileUs =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start)
+          .count();
+  ASSERT_TRUE(show);
+  EXPECT_EQ(show->count, kShowCues);
+  EXPECT_EQ(show->skippedLines, 0U);
+  printf("show_compile cues=%u text_bytes=%u wall=%lldus load=%uus\n", show->count,
+         show->textBytes, static_cast<long long>(compileUs), show->loadUs);
+
+  installShow(std::move(show));
+  ASSERT_TRUE(test::runUntil([] { return getShowStatus().count == kShowCues; }));
+
+  const std::pair<const char *, uint16_t> positions[] = {
+      {"first", 0U}, {"middle", kShowCues / 2U}, {"last", kShowCues - 1U}};
+  for (const auto &[name, position] : positions) {
+    const LatencySummary summary = measureGo(position);
+    printf("show_go cue=%-6s samples=%4u p50=%6uus p99=%6uus max=%6uus\n", name,
+           summary.samples, summary.p50Us, summary.p99Us, summary.maxUs);
+    EXPECT_EQ(summary.samples, static_cast<uint32_t>(kRounds));
+    EXPECT_LE(summary.p50Us, summary.p99Us);
+  }
+  // GO sits near the timer's resolution on the host and its order varies
+  // from run to run, so the positions are compared by eye, not asserted.
+
+  const double jumpNs = measureJumps();
+  printf("show_jump tick p50=%.0fns\n", jumpNs);
+  EXPECT_EQ(getShowStatus().position, kShowCues - 1U);
+}
+
+}  // namespace
+}  // namespace stagecue
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Text rendering modelled on Adafruit_GFX's classic 6x8 cell font: every
+// glyph is drawn pixel by pixel through drawPixel(), as the library does.
+class Adafruit_GFX : public Print {
+ public:
+  Adafruit_GFX(int16_t width, int16_t height) : width_(width), height_(height) {}
+
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+  virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t background,
+                uint8_t size);
+
+  void setTextSize(uint8_t size) { textSize_ = size > 0 ? size : 1; }
+  void setTextColor(uint16_t color) { textColor_ = textBackground_ = color; }
+  void setTextColor(uint16_t color, uint16_t background) {
+    textColor_ = color;
+    textBackground_ = background;
+  }
+  void setCursor(int16_t x, int16_t y) {
+    cursorX_ = x;
+    cursorY_ = y;
+  }
+  void setTextWrap(bool wrap) { wrap_ = wrap; }
+  int16_t width() const { return width_; }
+  int16_t height() const { return height_; }
+
+  using Print::write;
+  size_t write(uint8_t c) override;
+
+ protected:
+  int16_t width_;
+  int16_t height_;
+  int16_t cursorX_ = 0;
+  int16_t cursorY_ = 0;
+  uint8_t textSize_ = 1;
+  uint16_t textColor_ = 0xFFFF;
+  uint16_t textBackground_ = 0xFFFF;
+  bool wrap_ = true;
+};
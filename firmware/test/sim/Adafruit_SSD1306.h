@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include <Wire.h>
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_INVERSE 2
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+
+class Adafruit_SSD1306 : public Adafruit_GFX {
+ public:
+  Adafruit_SSD1306(uint8_t width, uint8_t height, TwoWire *wire, int8_t resetPin);
+  Adafruit_SSD1306(Adafruit_SSD1306 &&other) noexcept;
+  ~Adafruit_SSD1306() override;
+
+  Adafruit_SSD1306(const Adafruit_SSD1306 &) = delete;
+  Adafruit_SSD1306 &operator=(const Adafruit_SSD1306 &) = delete;
+
+  // Like the real driver this only fails when the frame buffer cannot be
+  // allocated; a missing panel shows up as NACKed I2C transactions.
+  bool begin(uint8_t vccState, uint8_t address, bool reset = true, bool periphBegin = true);
+  void clearDisplay();
+  void display();
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+  uint8_t *getBuffer() { return buffer_; }
+
+ private:
+  TwoWire *wire_;
+  uint8_t address_ = 0;
+  uint8_t *buffer_;
+};
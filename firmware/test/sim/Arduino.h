@@ -0,0 +1,243 @@
+#pragma once
+
+// Host stand-in for the ESP32 Arduino core: just enough of its API for the
+// firmware sources to build and run on a PC. Hardware behaviour (pins, clock,
+// tasks) is driven by the tests through sim.h.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define ESP32 1
+#define ARDUINO_ARCH_ESP32 1
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define DEC 10
+#define HEX 16
+
+#define IRAM_ATTR
+#define ARDUINO_ISR_ATTR
+#define PROGMEM
+#define F(string_literal) (string_literal)
+
+class String {
+ public:
+  String() = default;
+  String(const char *text) : value_(text != nullptr ? text : "") {}
+  String(const std::string &text) : value_(text) {}
+  explicit String(char c) : value_(1, c) {}
+  explicit String(int value) : value_(std::to_string(value)) {}
+  explicit String(unsigned value) : value_(std::to_string(value)) {}
+  explicit String(long value) : value_(std::to_string(value)) {}
+  explicit String(unsigned long value) : value_(std::to_string(value)) {}
+
+  size_t length() const { return value_.size(); }
+  const char *c_str() const { return value_.c_str(); }
+  bool isEmpty() const { return value_.empty(); }
+  bool reserve(size_t size) {
+    value_.reserve(size);
+    return true;
+  }
+  bool concat(const char *text, size_t length) {
+    value_.append(text, length);
+    return true;
+  }
+  bool concat(const char *text) {
+    value_.append(text);
+    return true;
+  }
+  bool concat(char c) {
+    value_.push_back(c);
+    return true;
+  }
+  long toInt() const { return atol(value_.c_str()); }
+  int indexOf(const char *needle) const {
+    const auto position = value_.find(needle);
+    return position == std::string::npos ? -1 : static_cast<int>(position);
+  }
+  bool startsWith(const char *prefix) const { return value_.rfind(prefix, 0) == 0; }
+  bool endsWith(const char *suffix) const {
+    const size_t length = strlen(suffix);
+    return value_.size() >= length && value_.compare(value_.size() - length, length, suffix) == 0;
+  }
+  bool equals(const String &other) const { return value_ == other.value_; }
+  String substring(size_t from, size_t to = std::string::npos) const {
+    if (from >= value_.size()) {
+      return String();
+    }
+    return String(value_.substr(from, to == std::string::npos ? to : to - from));
+  }
+
+  String &operator=(const char *text) {
+    value_ = text != nullptr ? text : "";
+    return *this;
+  }
+  String &operator+=(const char *text) {
+    value_ += text;
+    return *this;
+  }
+  String &operator+=(const String &text) {
+    value_ += text.value_;
+    return *this;
+  }
+  String &operator+=(char c) {
+    value_ += c;
+    return *this;
+  }
+  bool operator==(const char *text) const { return value_ == text; }
+  bool operator==(const String &other) const { return value_ == other.value_; }
+  bool operator!=(const char *text) const { return value_ != text; }
+  bool operator!=(const String &other) const { return value_ != other.value_; }
+  bool operator<(const String &other) const { return value_ < other.value_; }
+  char operator[](size_t index) const { return value_[index]; }
+
+  friend String operator+(const String &a, const String &b) {
+    String result(a);
+    result += b;
+    return result;
+  }
+  friend String operator+(const String &a, const char *b) {
+    String result(a);
+    result += b;
+    return result;
+  }
+
+  const std::string &str() const { return value_; }
+
+ private:
+  std::string value_;
+};
+
+class Print {
+ public:
+  virtual ~Print() = default;
+
+  virtual size_t write(uint8_t byte) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t written = 0;
+    while (size-- > 0U) {
+      written += write(*buffer++);
+    }
+    return written;
+  }
+
+  size_t write(const char *text) { return text == nullptr ? 0 : write(text, strlen(text)); }
+  size_t write(const char *buffer, size_t size) {
+    return write(reinterpret_cast<const uint8_t *>(buffer), size);
+  }
+
+  size_t print(const char *text) { return write(text); }
+  size_t print(const String &text) { return write(text.c_str(), text.length()); }
+  size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+  size_t print(int value, int base = DEC) { return print(static_cast<long>(value), base); }
+  size_t print(unsigned value, int base = DEC) {
+    return print(static_cast<unsigned long>(value), base);
+  }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T &value) {
+    const size_t written = print(value);
+    return written + println();
+  }
+  template <typename T>
+  size_t println(const T &value, int format) {
+    const size_t written = print(value, format);
+    return written + println();
+  }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long baud) { (void)baud; }
+  using Print::write;
+  size_t write(uint8_t byte) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+};
+
+extern HardwareSerial Serial;
+
+class IPAddress {
+ public:
+  IPAddress() = default;
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets_{a, b, c, d} {}
+
+  uint8_t operator[](size_t index) const { return octets_[index]; }
+  bool operator==(const IPAddress &other) const { return memcmp(octets_, other.octets_, 4) == 0; }
+  String toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", octets_[0], octets_[1], octets_[2], octets_[3]);
+    return String(text);
+  }
+
+ private:
+  uint8_t octets_[4] = {};
+};
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode);
+void detachInterrupt(uint8_t pin);
+inline uint8_t digitalPinToInterrupt(uint8_t pin) {
+  return pin;
+}
+
+uint32_t esp_random();
+
+class EspClass {
+ public:
+  void restart();
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint64_t getEfuseMac();
+};
+
+extern EspClass ESP;
+
+// GPIO matrix registers, backed by the simulated pin levels.
+#define GPIO_OUT_W1TS_REG 0x3FF44008U
+#define GPIO_OUT_W1TC_REG 0x3FF4400CU
+#define GPIO_OUT1_W1TS_REG 0x3FF44014U
+#define GPIO_OUT1_W1TC_REG 0x3FF44018U
+#define GPIO_IN_REG 0x3FF4403CU
+#define GPIO_IN1_REG 0x3FF44040U
+
+uint32_t simRegisterRead(uint32_t address);
+void simRegisterWrite(uint32_t address, uint32_t value);
+
+#define REG_READ(reg) simRegisterRead(reg)
+#define REG_WRITE(reg, value) simRegisterWrite((reg), (value))
@@ -0,0 +1,1621 @@
+#pragma once
+
+// Host replacement for the ArduinoJson 6 API subset the firmware uses. Like
+// the library, a document is a fixed arena: nodes are bump-allocated from
+// the front, copied strings from the back, `const char *` values and keys
+// are stored by reference, and parsing a mutable `char *` input is
+// zero-copy. A document never touches the heap beyond its arena, and one
+// that runs out of room reports overflowed() instead of growing.
+
+#include <Arduino.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <string>
+#include <type_traits>
+
+namespace sjson {
+
+enum : uint8_t {
+  kNull = 0,
+  kBool,
+  kSigned,
+  kUnsigned,
+  kFloat,
+  kString,
+  kArray,
+  kObject,
+};
+
+struct Collection {
+  uint32_t head;  // slot ids, 0 = none
+  uint32_t tail;
+};
+
+union Content {
+  bool asBool;
+  int64_t asSigned;
+  uint64_t asUnsigned;
+  double asFloat;
+  const char *asString;
+  Collection asCollection;
+};
+
+struct VariantData {
+  Content content;
+  uint32_t next;  // sibling slot id when this is a collection member
+  uint8_t type;
+};
+
+struct Slot {
+  VariantData value;
+  const char *key;
+};
+
+class Pool {
+ public:
+  void init(void *buffer, size_t capacity) {
+    begin_ = static_cast<char *>(buffer);
+    capacity_ = buffer != nullptr ? capacity : 0U;
+    clear();
+  }
+  void clear() {
+    left_ = 0;
+    right_ = capacity_;
+    overflowed_ = false;
+  }
+
+  Slot *slot(uint32_t id) const { return reinterpret_cast<Slot *>(begin_) + (id - 1U); }
+
+  uint32_t allocSlot() {
+    if (right_ - left_ < sizeof(Slot)) {
+      overflowed_ = true;
+      return 0;
+    }
+    Slot *slot = new (begin_ + left_) Slot();
+    slot->value.type = kNull;
+    slot->value.next = 0;
+    slot->key = nullptr;
+    left_ += sizeof(Slot);
+    return static_cast<uint32_t>(left_ / sizeof(Slot));
+  }
+
+  char *allocString(size_t length) {
+    if (right_ - left_ < length + 1U) {
+      overflowed_ = true;
+      return nullptr;
+    }
+    right_ -= length + 1U;
+    begin_[right_ + length] = '\0';
+    return begin_ + right_;
+  }
+
+  const char *saveString(const char *text, size_t length) {
+    char *copy = allocString(length);
+    if (copy != nullptr) {
+      memcpy(copy, text, length);
+    }
+    return copy;
+  }
+
+  void *buffer() const { return begin_; }
+  size_t capacity() const { return capacity_; }
+  size_t used() const { return left_ + (capacity_ - right_); }
+  bool overflowed() const { return overflowed_; }
+
+ private:
+  char *begin_ = nullptr;
+  size_t capacity_ = 0;
+  size_t left_ = 0;
+  size_t right_ = 0;
+  bool overflowed_ = false;
+};
+
+inline void setNull(VariantData *data) {
+  if (data != nullptr) {
+    data->type = kNull;
+  }
+}
+
+inline bool toCollection(VariantData *data, uint8_t type) {
+  if (data == nullptr) {
+    return false;
+  }
+  data->type = type;
+  data->content.asCollection = Collection{0, 0};
+  return true;
+}
+
+inline VariantData *appendSlot(VariantData *collection, Pool *pool, const char *key) {
+  if (collection == nullptr || pool == nullptr) {
+    return nullptr;
+  }
+  const uint32_t id = pool->allocSlot();
+  if (id == 0U) {
+    return nullptr;
+  }
+  Slot *slot = pool->slot(id);
+  slot->key = key;
+  Collection &items = collection->content.asCollection;
+  if (items.tail != 0U) {
+    pool->slot(items.tail)->value.next = id;
+  } else {
+    items.head = id;
+  }
+  items.tail = id;
+  return &slot->value;
+}
+
+inline const Slot *findMember(const VariantData *object, const Pool *pool, const char *key) {
+  if (object == nullptr || pool == nullptr || object->type != kObject || key == nullptr) {
+    return nullptr;
+  }
+  for (uint32_t id = object->content.asCollection.head; id != 0U;) {
+    const Slot *slot = pool->slot(id);
+    if (slot->key != nullptr && strcmp(slot->key, key) == 0) {
+      return slot;
+    }
+    id = slot->value.next;
+  }
+  return nullptr;
+}
+
+inline VariantData *getOrAddMember(VariantData *object, Pool *pool, const char *key,
+                                   bool copyKey) {
+  if (object == nullptr || pool == nullptr || key == nullptr) {
+    return nullptr;
+  }
+  if (object->type == kNull) {
+    toCollection(object, kObject);
+  }
+  if (object->type != kObject) {
+    return nullptr;
+  }
+  const Slot *existing = findMember(object, pool, key);
+  if (existing != nullptr) {
+    return const_cast<VariantData *>(&existing->value);
+  }
+  const char *storedKey = copyKey ? pool->saveString(key, strlen(key)) : key;
+  if (storedKey == nullptr) {
+    return nullptr;
+  }
+  return appendSlot(object, pool, storedKey);
+}
+
+inline const VariantData *getElement(const VariantData *array, const Pool *pool, size_t index) {
+  if (array == nullptr || pool == nullptr || array->type != kArray) {
+    return nullptr;
+  }
+  for (uint32_t id = array->content.asCollection.head; id != 0U;) {
+    const Slot *slot = pool->slot(id);
+    if (index-- == 0U) {
+      return &slot->value;
+    }
+    id = slot->value.next;
+  }
+  return nullptr;
+}
+
+inline size_t collectionSize(const VariantData *data, const Pool *pool) {
+  if (data == nullptr || pool == nullptr || (data->type != kArray && data->type != kObject)) {
+    return 0;
+  }
+  size_t count = 0;
+  for (uint32_t id = data->content.asCollection.head; id != 0U; id = pool->slot(id)->value.next) {
+    ++count;
+  }
+  return count;
+}
+
+template <typename T>
+struct IsIntegral
+    : std::integral_constant<bool, std::is_integral<T>::value && !std::is_same<T, bool>::value> {};
+
+template <typename T>
+bool isInteger(const VariantData *data) {
+  if (data == nullptr) {
+    return false;
+  }
+  if (data->type == kSigned) {
+    const int64_t value = data->content.asSigned;
+    if (std::is_unsigned<T>::value) {
+      return value >= 0 &&
+             static_cast<uint64_t>(value) <= static_cast<uint64_t>(std::numeric_limits<T>::max());
+    }
+    return value >= static_cast<int64_t>(std::numeric_limits<T>::min()) &&
+           value <= static_cast<int64_t>(std::numeric_limits<T>::max());
+  }
+  if (data->type == kUnsigned) {
+    return data->content.asUnsigned <= static_cast<uint64_t>(std::numeric_limits<T>::max());
+  }
+  return false;
+}
+
+inline double toDouble(const VariantData *data) {
+  if (data == nullptr) {
+    return 0.0;
+  }
+  switch (data->type) {
+    case kSigned:
+      return static_cast<double>(data->content.asSigned);
+    case kUnsigned:
+      return static_cast<double>(data->content.asUnsigned);
+    case kFloat:
+      return data->content.asFloat;
+    case kBool:
+      return data->content.asBool ? 1.0 : 0.0;
+    default:
+      return 0.0;
+  }
+}
+
+template <typename T>
+T toInteger(const VariantData *data) {
+  if (data == nullptr) {
+    return 0;
+  }
+  switch (data->type) {
+    case kSigned:
+      return static_cast<T>(data->content.asSigned);
+    case kUnsigned:
+      return static_cast<T>(data->content.asUnsigned);
+    case kFloat:
+      return static_cast<T>(data->content.asFloat);
+    case kBool:
+      return data->content.asBool ? 1 : 0;
+    default:
+      return 0;
+  }
+}
+
+// ── Serialization ───────────────────────────────────────────────────────────
+
+struct CountingWriter {
+  size_t count = 0;
+  void write(const char *, size_t length) { count += length; }
+};
+
+struct BufferWriter {
+  char *buffer;
+  size_t capacity;  // excluding the terminator
+  size_t count = 0;
+  void write(const char *text, size_t length) {
+    const size_t room = capacity - count;
+    const size_t chunk = length < room ? length : room;
+    memcpy(buffer + count, text, chunk);
+    count += chunk;
+  }
+};
+
+struct StringWriter {
+  String &out;
+  size_t count = 0;
+  void write(const char *text, size_t length) {
+    out.concat(text, length);
+    count += length;
+  }
+};
+
+struct StdStringWriter {
+  std::string &out;
+  size_t count = 0;
+  void write(const char *text, size_t length) {
+    out.append(text, length);
+    count += length;
+  }
+};
+
+struct PrintWriter {
+  Print &out;
+  size_t count = 0;
+  void write(const char *text, size_t length) {
+    count += out.write(reinterpret_cast<const uint8_t *>(text), length);
+  }
+};
+
+template <typename Writer>
+void writeString(Writer &writer, const char *text) {
+  writer.write("\"", 1);
+  const char *run = text;
+  for (const char *p = text; *p != '\0'; ++p) {
+    const unsigned char c = static_cast<unsigned char>(*p);
+    const char *escape = nullptr;
+    char unicode[7];
+    switch (c) {
+      case '"':
+        escape = "\\\"";
+        break;
+      case '\\':
+        escape = "\\\\";
+        break;
+      case '\b':
+        escape = "\\b";
+        break;
+      case '\f':
+        escape = "\\f";
+        break;
+      case '\n':
+        escape = "\\n";
+        break;
+      case '\r':
+        escape = "\\r";
+        break;
+      case '\t':
+        escape = "\\t";
+        break;
+      default:
+        if (c < 0x20U) {
+          snprintf(unicode, sizeof(unicode), "\\u%04x", c);
+          escape = unicode;
+        }
+        break;
+    }
+    if (escape != nullptr) {
+      writer.write(run, static_cast<size_t>(p - run));
+      writer.write(escape, strlen(escape));
+      run = p + 1;
+    }
+  }
+  writer.write(run, strlen(run));
+  writer.write("\"", 1);
+}
+
+template <typename Writer>
+void writeVariant(Writer &writer, const VariantData *data, const Pool *pool) {
+  char number[32];
+  if (data == nullptr) {
+    writer.write("null", 4);
+    return;
+  }
+  switch (data->type) {
+    case kBool:
+      if (data->content.asBool) {
+        writer.write("true", 4);
+      } else {
+        writer.write("false", 5);
+      }
+      break;
+    case kSigned:
+      writer.write(number, static_cast<size_t>(snprintf(number, sizeof(number), "%lld",
+                                                        static_cast<long long>(data->content.asSigned))));
+      break;
+    case kUnsigned:
+      writer.write(number,
+                   static_cast<size_t>(snprintf(number, sizeof(number), "%llu",
+                                                static_cast<unsigned long long>(data->content.asUnsigned))));
+      break;
+    case kFloat: {
+      const double value = data->content.asFloat;
+      if (isnan(value)) {
+        writer.write("NaN", 3);
+      } else if (isinf(value)) {
+        writer.write(value > 0 ? "Infinity" : "-Infinity", value > 0 ? 8 : 9);
+      } else {
+        writer.write(number, static_cast<size_t>(snprintf(number, sizeof(number), "%.15g", value)));
+      }
+      break;
+    }
+    case kString:
+      writeString(writer, data->content.asString);
+      break;
+    case kArray:
+    case kObject: {
+      const bool object = data->type == kObject;
+      writer.write(object ? "{" : "[", 1);
+      bool first = true;
+      for (uint32_t id = data->content.asCollection.head; id != 0U;) {
+        const Slot *slot = pool->slot(id);
+        if (!first) {
+          writer.write(",", 1);
+        }
+        first = false;
+        if (object) {
+          writeString(writer, slot->key);
+          writer.write(":", 1);
+        }
+        writeVariant(writer, &slot->value, pool);
+        id = slot->value.next;
+      }
+      writer.write(object ? "}" : "]", 1);
+      break;
+    }
+    default:
+      writer.write("null", 4);
+      break;
+  }
+}
+
+}  // namespace sjson
+
+#define JSON_ARRAY_SIZE(n) ((n) * sizeof(sjson::Slot))
+#define JSON_OBJECT_SIZE(n) ((n) * sizeof(sjson::Slot))
+#define JSON_STRING_SIZE(n) ((n) + 1)
+
+class JsonVariant;
+class JsonVariantConst;
+class JsonArray;
+class JsonArrayConst;
+class JsonObject;
+class JsonObjectConst;
+
+namespace sjson {
+
+// Read side shared by variants, proxies and documents. Derived classes
+// provide readData() and readPool().
+template <typename Derived>
+class VariantReader {
+ public:
+  bool isNull() const { return data() == nullptr || data()->type == kNull; }
+  size_t size() const { return collectionSize(data(), pool()); }
+
+  template <typename T>
+  typename std::enable_if<std::is_same<T, bool>::value, bool>::type is() const {
+    return data() != nullptr && data()->type == kBool;
+  }
+  template <typename T>
+  typename std::enable_if<IsIntegral<T>::value, bool>::type is() const {
+    return isInteger<T>(data());
+  }
+  template <typename T>
+  typename std::enable_if<std::is_floating_point<T>::value, bool>::type is() const {
+    return data() != nullptr &&
+           (data()->type == kSigned || data()->type == kUnsigned || data()->type == kFloat);
+  }
+  template <typename T>
+  typename std::enable_if<std::is_same<T, const char *>::value || std::is_same<T, String>::value,
+                          bool>::type
+  is() const {
+    return data() != nullptr && data()->type == kString;
+  }
+  template <typename T>
+  typename std::enable_if<std::is_same<T, JsonArray>::value ||
+                              std::is_same<T, JsonArrayConst>::value,
+                          bool>::type
+  is() const {
+    return data() != nullptr && data()->type == kArray;
+  }
+  template <typename T>
+  typename std::enable_if<std::is_same<T, JsonObject>::value ||
+                              std::is_same<T, JsonObjectConst>::value,
+                          bool>::type
+  is() const {
+    return data() != nullptr && data()->type == kObject;
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_same<T, bool>::value, bool>::type as() const {
+    if (data() == nullptr) {
+      return false;
+    }
+    return data()->type == kBool ? data()->content.asBool : toDouble(data()) != 0.0;
+  }
+  template <typename T>
+  typename std::enable_if<IsIntegral<T>::value, T>::type as() const {
+    return toInteger<T>(data());
+  }
+  template <typename T>
+  typename std::enable_if<std::is_floating_point<T>::value, T>::type as() const {
+    return static_cast<T>(toDouble(data()));
+  }
+  template <typename T>
+  typename std::enable_if<std::is_same<T, const char *>::value, const char *>::type as() const {
+    return is<const char *>() ? data()->content.asString : nullptr;
+  }
+  template <typename T>
+  typename std::enable_if<std::is_same<T, String>::value, String>::type as() const {
+    return String(is<const char *>() ? data()->content.asString : "");
+  }
+  template <typename T>
+  typename std::enable_if<std::is_same<T, JsonArrayConst>::value ||
+                              std::is_same<T, JsonObjectConst>::value ||
+                              std::is_same<T, JsonVariantConst>::value,
+                          T>::type
+  as() const {
+    return T(data(), pool());
+  }
+
+  template <typename T>
+  typename std::enable_if<!std::is_same<T, std::nullptr_t>::value &&
+                              !std::is_same<typename std::decay<T>::type, char *>::value &&
+                              !std::is_same<typename std::decay<T>::type, const char *>::value,
+                          T>::type
+  operator|(const T &fallback) const {
+    return is<T>() ? as<T>() : fallback;
+  }
+  const char *operator|(const char *fallback) const {
+    return is<const char *>() ? data()->content.asString : fallback;
+  }
+  const char *operator|(std::nullptr_t) const {
+    return is<const char *>() ? data()->content.asString : nullptr;
+  }
+
+  bool operator==(const char *text) const {
+    return is<const char *>() && text != nullptr && strcmp(data()->content.asString, text) == 0;
+  }
+  bool operator!=(const char *text) const { return !(*this == text); }
+
+  JsonVariantConst operator[](const char *key) const;
+  JsonVariantConst operator[](const String &key) const;
+  JsonVariantConst operator[](int index) const;
+  JsonVariantConst operator[](size_t index) const;
+  bool containsKey(const char *key) const { return findMember(data(), pool(), key) != nullptr; }
+
+ private:
+  const VariantData *data() const { return static_cast<const Derived *>(this)->readData(); }
+  const Pool *pool() const { return static_cast<const Derived *>(this)->readPool(); }
+};
+
+// Write side: Derived provides writeData() (creating the node if needed)
+// and writePool().
+template <typename Derived>
+class VariantWriter {
+ public:
+  template <typename T>
+  bool set(const T &value) {
+    return assign(static_cast<Derived *>(this)->writeData(),
+                  static_cast<Derived *>(this)->writePool(), value);
+  }
+
+  JsonArray createNestedArray() const;
+  JsonObject createNestedObject() const;
+  JsonArray createNestedArray(const char *key) const;
+  JsonObject createNestedObject(const char *key) const;
+  template <typename T>
+  T to() const;
+  template <typename T>
+  bool add(const T &value) const;
+
+ protected:
+  static bool assignString(VariantData *data, const char *text) {
+    if (text == nullptr) {
+      setNull(data);
+      return true;
+    }
+    data->type = kString;
+    data->content.asString = text;
+    return true;
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_same<T, bool>::value, bool>::type assign(
+      VariantData *data, Pool *, const T &value) {
+    if (data == nullptr) {
+      return false;
+    }
+    data->type = kBool;
+    data->content.asBool = value;
+    return true;
+  }
+  template <typename T>
+  static typename std::enable_if<IsIntegral<T>::value && std::is_signed<T>::value, bool>::type
+  assign(VariantData *data, Pool *, const T &value) {
+    if (data == nullptr) {
+      return false;
+    }
+    data->type = kSigned;
+    data->content.asSigned = value;
+    return true;
+  }
+  template <typename T>
+  static typename std::enable_if<IsIntegral<T>::value && std::is_unsigned<T>::value, bool>::type
+  assign(VariantData *data, Pool *, const T &value) {
+    if (data == nullptr) {
+      return false;
+    }
+    data->type = kUnsigned;
+    data->content.asUnsigned = value;
+    return true;
+  }
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value, bool>::type assign(
+      VariantData *data, Pool *, const T &value) {
+    if (data == nullptr) {
+      return false;
+    }
+    data->type = kFloat;
+    data->content.asFloat = static_cast<double>(value);
+    return true;
+  }
+  static bool assign(VariantData *data, Pool *, const char *const &value) {
+    return data != nullptr && assignString(data, value);
+  }
+  static bool assign(VariantData *data, Pool *pool, char *const &value) {
+    if (data == nullptr) {
+      return false;
+    }
+    if (value == nullptr) {
+      setNull(data);
+      return true;
+    }
+    const char *copy = pool->saveString(value, strlen(value));
+    return copy != nullptr && assignString(data, copy);
+  }
+  template <size_t N>
+  static bool assign(VariantData *data, Pool *pool, const char (&value)[N]) {
+    return assign(data, pool, static_cast<const char *const &>(static_cast<const char *>(value)));
+  }
+  template <size_t N>
+  static bool assign(VariantData *data, Pool *pool, char (&value)[N]) {
+    char *pointer = value;
+    return assign(data, pool, static_cast<char *const &>(pointer));
+  }
+  static bool assign(VariantData *data, Pool *pool, const String &value) {
+    if (data == nullptr) {
+      return false;
+    }
+    const char *copy = pool->saveString(value.c_str(), value.length());
+    return copy != nullptr && assignString(data, copy);
+  }
+  static bool assign(VariantData *data, Pool *pool, const std::string &value) {
+    if (data == nullptr) {
+      return false;
+    }
+    const char *copy = pool->saveString(value.data(), value.size());
+    return copy != nullptr && assignString(data, copy);
+  }
+  static bool assign(VariantData *data, Pool *, const std::nullptr_t &) {
+    setNull(data);
+    return data != nullptr;
+  }
+};
+
+}  // namespace sjson
+
+class JsonVariantConst : public sjson::VariantReader<JsonVariantConst> {
+ public:
+  JsonVariantConst() = default;
+  JsonVariantConst(const sjson::VariantData *data, const sjson::Pool *pool)
+      : data_(data), pool_(pool) {}
+
+  operator JsonArrayConst() const;
+  operator JsonObjectConst() const;
+
+  const sjson::VariantData *readData() const { return data_; }
+  const sjson::Pool *readPool() const { return pool_; }
+
+ private:
+  const sjson::VariantData *data_ = nullptr;
+  const sjson::Pool *pool_ = nullptr;
+};
+
+class JsonVariant : public sjson::VariantReader<JsonVariant>,
+                    public sjson::VariantWriter<JsonVariant> {
+ public:
+  JsonVariant() = default;
+  JsonVariant(sjson::VariantData *data, sjson::Pool *pool) : data_(data), pool_(pool) {}
+
+  template <typename T>
+  JsonVariant &operator=(const T &value) {
+    set(value);
+    return *this;
+  }
+  JsonVariant &operator=(const JsonVariant &) = default;
+  JsonVariant(const JsonVariant &) = default;
+
+  using sjson::VariantReader<JsonVariant>::operator[];
+  operator JsonVariantConst() const { return JsonVariantConst(data_, pool_); }
+  operator JsonArray() const;
+  operator JsonObject() const;
+  operator JsonArrayConst() const;
+  operator JsonObjectConst() const;
+
+  const sjson::VariantData *readData() const { return data_; }
+  const sjson::Pool *readPool() const { return pool_; }
+  sjson::VariantData *writeData() const { return data_; }
+  sjson::Pool *writePool() const { return pool_; }
+
+ private:
+  sjson::VariantData *data_ = nullptr;
+  sjson::Pool *pool_ = nullptr;
+};
+
+namespace sjson {
+
+// doc["key"] / object["key"]: looks the member up on read, adds it on write.
+class MemberProxy : public VariantReader<MemberProxy>, public VariantWriter<MemberProxy> {
+ public:
+  MemberProxy(VariantData *object, Pool *pool, const char *key, bool copyKey)
+      : object_(object), pool_(pool), key_(key), copyKey_(copyKey) {}
+  MemberProxy(const MemberProxy &) = default;
+
+  template <typename T>
+  MemberProxy &operator=(const T &value) {
+    set(value);
+    return *this;
+  }
+  MemberProxy &operator=(const MemberProxy &other) {
+    const VariantData *source = other.readData();
+    if (source == nullptr) {
+      setNull(writeData());
+    } else if (source->type == kString) {
+      set(source->content.asString);
+    } else if (VariantData *target = writeData()) {
+      const uint32_t next = target->next;
+      *target = *source;
+      target->next = next;
+    }
+    return *this;
+  }
+
+  using VariantReader<MemberProxy>::operator[];
+  operator JsonVariant() const { return JsonVariant(const_cast<VariantData *>(readData()), pool_); }
+  operator JsonVariantConst() const { return JsonVariantConst(readData(), pool_); }
+  operator JsonArrayConst() const;
+  operator JsonObjectConst() const;
+
+  const VariantData *readData() const {
+    const Slot *slot = findMember(object_, pool_, key_);
+    return slot != nullptr ? &slot->value : nullptr;
+  }
+  const Pool *readPool() const { return pool_; }
+  VariantData *writeData() const { return getOrAddMember(object_, pool_, key_, copyKey_); }
+  Pool *writePool() const { return pool_; }
+
+ private:
+  VariantData *object_;
+  Pool *pool_;
+  const char *key_;
+  bool copyKey_;
+};
+
+}  // namespace sjson
+
+class JsonArrayConst {
+ public:
+  class iterator {
+   public:
+    iterator(const sjson::Pool *pool, uint32_t id) : pool_(pool), id_(id) {}
+    JsonVariantConst operator*() const { return JsonVariantConst(&pool_->slot(id_)->value, pool_); }
+    iterator &operator++() {
+      id_ = pool_->slot(id_)->value.next;
+      return *this;
+    }
+    bool operator!=(const iterator &other) const { return id_ != other.id_; }
+
+   private:
+    const sjson::Pool *pool_;
+    uint32_t id_;
+  };
+
+  JsonArrayConst() = default;
+  JsonArrayConst(const sjson::VariantData *data, const sjson::Pool *pool)
+      : data_(data != nullptr && data->type == sjson::kArray ? data : nullptr), pool_(pool) {}
+
+  bool isNull() const { return data_ == nullptr; }
+  size_t size() const { return sjson::collectionSize(data_, pool_); }
+  JsonVariantConst operator[](size_t index) const {
+    return JsonVariantConst(sjson::getElement(data_, pool_, index), pool_);
+  }
+  iterator begin() const { return iterator(pool_, data_ != nullptr ? data_->content.asCollection.head : 0U); }
+  iterator end() const { return iterator(pool_, 0U); }
+
+ private:
+  const sjson::VariantData *data_ = nullptr;
+  const sjson::Pool *pool_ = nullptr;
+};
+
+class JsonArray {
+ public:
+  class iterator {
+   public:
+    iterator(sjson::Pool *pool, uint32_t id) : pool_(pool), id_(id) {}
+    JsonVariant operator*() const { return JsonVariant(&pool_->slot(id_)->value, pool_); }
+    iterator &operator++() {
+      id_ = pool_->slot(id_)->value.next;
+      return *this;
+    }
+    bool operator!=(const iterator &other) const { return id_ != other.id_; }
+
+   private:
+    sjson::Pool *pool_;
+    uint32_t id_;
+  };
+
+  JsonArray() = default;
+  JsonArray(sjson::VariantData *data, sjson::Pool *pool)
+      : data_(data != nullptr && data->type == sjson::kArray ? data : nullptr), pool_(pool) {}
+
+  bool isNull() const { return data_ == nullptr; }
+  size_t size() const { return sjson::collectionSize(data_, pool_); }
+  JsonVariant add() const { return JsonVariant(sjson::appendSlot(data_, pool_, nullptr), pool_); }
+  template <typename T>
+  bool add(const T &value) const {
+    return add().set(value);
+  }
+  JsonObject createNestedObject() const;
+  JsonArray createNestedArray() const;
+  JsonVariantConst operator[](size_t index) const {
+    return JsonVariantConst(sjson::getElement(data_, pool_, index), pool_);
+  }
+  operator JsonArrayConst() const { return JsonArrayConst(data_, pool_); }
+  iterator begin() const { return iterator(pool_, data_ != nullptr ? data_->content.asCollection.head : 0U); }
+  iterator end() const { return iterator(pool_, 0U); }
+
+ private:
+  sjson::VariantData *data_ = nullptr;
+  sjson::Pool *pool_ = nullptr;
+};
+
+class JsonPairConst {
+ public:
+  JsonPairConst(const sjson::Slot *slot, const sjson::Pool *pool) : slot_(slot), pool_(pool) {}
+  const char *key() const { return slot_->key; }
+  JsonVariantConst value() const { return JsonVariantConst(&slot_->value, pool_); }
+
+ private:
+  const sjson::Slot *slot_;
+  const sjson::Pool *pool_;
+};
+
+class JsonObjectConst {
+ public:
+  class iterator {
+   public:
+    iterator(const sjson::Pool *pool, uint32_t id) : pool_(pool), id_(id) {}
+    JsonPairConst operator*() const { return JsonPairConst(pool_->slot(id_), pool_); }
+    iterator &operator++() {
+      id_ = pool_->slot(id_)->value.next;
+      return *this;
+    }
+    bool operator!=(const iterator &other) const { return id_ != other.id_; }
+
+   private:
+    const sjson::Pool *pool_;
+    uint32_t id_;
+  };
+
+  JsonObjectConst() = default;
+  JsonObjectConst(const sjson::VariantData *data, const sjson::Pool *pool)
+      : data_(data != nullptr && data->type == sjson::kObject ? data : nullptr), pool_(pool) {}
+
+  bool isNull() const { return data_ == nullptr; }
+  size_t size() const { return sjson::collectionSize(data_, pool_); }
+  bool containsKey(const char *key) const { return sjson::findMember(data_, pool_, key) != nullptr; }
+  JsonVariantConst operator[](const char *key) const {
+    const sjson::Slot *slot = sjson::findMember(data_, pool_, key);
+    return JsonVariantConst(slot != nullptr ? &slot->value : nullptr, pool_);
+  }
+  iterator begin() const { return iterator(pool_, data_ != nullptr ? data_->content.asCollection.head : 0U); }
+  iterator end() const { return iterator(pool_, 0U); }
+
+ private:
+  const sjson::VariantData *data_ = nullptr;
+  const sjson::Pool *pool_ = nullptr;
+};
+
+class JsonObject {
+ public:
+  JsonObject() = default;
+  JsonObject(sjson::VariantData *data, sjson::Pool *pool)
+      : data_(data != nullptr && data->type == sjson::kObject ? data : nullptr), pool_(pool) {}
+
+  bool isNull() const { return data_ == nullptr; }
+  size_t size() const { return sjson::collectionSize(data_, pool_); }
+  sjson::MemberProxy operator[](const char *key) const {
+    return sjson::MemberProxy(data_, pool_, key, false);
+  }
+  sjson::MemberProxy operator[](char *key) const {
+    return sjson::MemberProxy(data_, pool_, key, true);
+  }
+  sjson::MemberProxy operator[](const String &key) const {
+    return sjson::MemberProxy(data_, pool_, key.c_str(), true);
+  }
+  JsonArray createNestedArray(const char *key) const;
+  JsonObject createNestedObject(const char *key) const;
+  operator JsonObjectConst() const { return JsonObjectConst(data_, pool_); }
+
+ private:
+  sjson::VariantData *data_ = nullptr;
+  sjson::Pool *pool_ = nullptr;
+};
+
+class DeserializationError {
+ public:
+  enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+
+  DeserializationError() = default;
+  DeserializationError(Code code) : code_(code) {}
+
+  explicit operator bool() const { return code_ != Ok; }
+  Code code() const { return code_; }
+  bool operator==(Code code) const { return code_ == code; }
+  bool operator!=(Code code) const { return code_ != code; }
+  const char *c_str() const {
+    static const char *const kNames[] = {"Ok",           "EmptyInput", "IncompleteInput",
+                                         "InvalidInput", "NoMemory",   "TooDeep"};
+    return kNames[code_];
+  }
+
+ private:
+  Code code_ = Ok;
+};
+
+class JsonDocument : public sjson::VariantReader<JsonDocument> {
+ public:
+  JsonDocument(const JsonDocument &) = delete;
+  JsonDocument &operator=(const JsonDocument &) = delete;
+
+  size_t capacity() const { return pool_.capacity(); }
+  size_t memoryUsage() const { return pool_.used(); }
+  bool overflowed() const { return pool_.overflowed(); }
+  void clear() {
+    pool_.clear();
+    root_ = sjson::VariantData{};
+  }
+
+  sjson::MemberProxy operator[](const char *key) {
+    return sjson::MemberProxy(&root_, &pool_, key, false);
+  }
+  sjson::MemberProxy operator[](char *key) { return sjson::MemberProxy(&root_, &pool_, key, true); }
+  sjson::MemberProxy operator[](const String &key) {
+    return sjson::MemberProxy(&root_, &pool_, key.c_str(), true);
+  }
+  using sjson::VariantReader<JsonDocument>::operator[];
+
+  JsonArray createNestedArray(const char *key) {
+    return JsonVariant(&root_, &pool_).createNestedArray(key);
+  }
+  JsonObject createNestedObject(const char *key) {
+    return JsonVariant(&root_, &pool_).createNestedObject(key);
+  }
+  JsonArray createNestedArray() { return JsonVariant(&root_, &pool_).createNestedArray(); }
+  template <typename T>
+  T to() {
+    clear();
+    return JsonVariant(&root_, &pool_).to<T>();
+  }
+  template <typename T>
+  typename std::enable_if<std::is_same<T, JsonArray>::value || std::is_same<T, JsonObject>::value ||
+                              std::is_same<T, JsonVariant>::value,
+                          T>::type
+  as() {
+    return T(&root_, &pool_);
+  }
+  template <typename T>
+  typename std::enable_if<!std::is_same<T, JsonArray>::value &&
+                              !std::is_same<T, JsonObject>::value &&
+                              !std::is_same<T, JsonVariant>::value,
+                          T>::type
+  as() const {
+    return sjson::VariantReader<JsonDocument>::as<T>();
+  }
+  template <typename T>
+  bool add(const T &value) {
+    return JsonVariant(&root_, &pool_).add(value);
+  }
+
+  const sjson::VariantData *readData() const { return &root_; }
+  const sjson::Pool *readPool() const { return &pool_; }
+  sjson::VariantData *root() { return &root_; }
+  sjson::Pool *pool() { return &pool_; }
+
+ protected:
+  JsonDocument() { root_ = sjson::VariantData{}; }
+  ~JsonDocument() = default;
+
+  sjson::Pool pool_;
+  sjson::VariantData root_;
+};
+
+template <size_t Capacity>
+class StaticJsonDocument : public JsonDocument {
+ public:
+  StaticJsonDocument() { pool_.init(buffer_, Capacity); }
+
+ private:
+  alignas(8) char buffer_[Capacity];
+};
+
+template <typename Allocator>
+class BasicJsonDocument : public JsonDocument, private Allocator {
+ public:
+  explicit BasicJsonDocument(size_t capacity, Allocator allocator = Allocator())
+      : Allocator(allocator) {
+    pool_.init(Allocator::allocate(capacity), capacity);
+  }
+  ~BasicJsonDocument() {
+    if (pool_.buffer() != nullptr) {
+      Allocator::deallocate(pool_.buffer());
+    }
+  }
+};
+
+struct DefaultAllocator {
+  void *allocate(size_t size) { return malloc(size); }
+  void deallocate(void *pointer) { free(pointer); }
+  void *reallocate(void *pointer, size_t size) { return realloc(pointer, size); }
+};
+
+using DynamicJsonDocument = BasicJsonDocument<DefaultAllocator>;
+
+// ── Inline definitions ─────────────────────────────────────────────────────
+
+inline JsonVariantConst::operator JsonArrayConst() const {
+  return JsonArrayConst(data_, pool_);
+}
+inline JsonVariantConst::operator JsonObjectConst() const {
+  return JsonObjectConst(data_, pool_);
+}
+inline JsonVariant::operator JsonArray() const {
+  return JsonArray(data_, pool_);
+}
+inline JsonVariant::operator JsonObject() const {
+  return JsonObject(data_, pool_);
+}
+inline JsonVariant::operator JsonArrayConst() const {
+  return JsonArrayConst(data_, pool_);
+}
+inline JsonVariant::operator JsonObjectConst() const {
+  return JsonObjectConst(data_, pool_);
+}
+inline sjson::MemberProxy::operator JsonArrayConst() const {
+  return JsonArrayConst(readData(), pool_);
+}
+inline sjson::MemberProxy::operator JsonObjectConst() const {
+  return JsonObjectConst(readData(), pool_);
+}
+
+inline JsonObject JsonArray::createNestedObject() const {
+  sjson::VariantData *element = sjson::appendSlot(data_, pool_, nullptr);
+  sjson::toCollection(element, sjson::kObject);
+  return JsonObject(element, pool_);
+}
+
+inline JsonArray JsonArray::createNestedArray() const {
+  sjson::VariantData *element = sjson::appendSlot(data_, pool_, nullptr);
+  sjson::toCollection(element, sjson::kArray);
+  return JsonArray(element, pool_);
+}
+
+namespace sjson {
+
+template <typename Derived>
+JsonVariantConst VariantReader<Derived>::operator[](const char *key) const {
+  const Slot *slot = findMember(data(), pool(), key);
+  return JsonVariantConst(slot != nullptr ? &slot->value : nullptr, pool());
+}
+template <typename Derived>
+JsonVariantConst VariantReader<Derived>::operator[](const String &key) const {
+  return (*this)[key.c_str()];
+}
+template <typename Derived>
+JsonVariantConst VariantReader<Derived>::operator[](int index) const {
+  return JsonVariantConst(index < 0 ? nullptr : getElement(data(), pool(), static_cast<size_t>(index)),
+                          pool());
+}
+template <typename Derived>
+JsonVariantConst VariantReader<Derived>::operator[](size_t index) const {
+  return JsonVariantConst(getElement(data(), pool(), index), pool());
+}
+
+template <typename Derived>
+JsonArray VariantWriter<Derived>::createNestedArray() const {
+  VariantData *data = static_cast<const Derived *>(this)->writeData();
+  Pool *pool = static_cast<const Derived *>(this)->writePool();
+  if (data == nullptr) {
+    return JsonArray();
+  }
+  if (data->type == kArray) {
+    VariantData *element = appendSlot(data, pool, nullptr);
+    toCollection(element, kArray);
+    return JsonArray(element, pool);
+  }
+  toCollection(data, kArray);
+  return JsonArray(data, pool);
+}
+
+template <typename Derived>
+JsonObject VariantWriter<Derived>::createNestedObject() const {
+  VariantData *data = static_cast<const Derived *>(this)->writeData();
+  Pool *pool = static_cast<const Derived *>(this)->writePool();
+  if (data == nullptr) {
+    return JsonObject();
+  }
+  if (data->type == kArray) {
+    VariantData *element = appendSlot(data, pool, nullptr);
+    toCollection(element, kObject);
+    return JsonObject(element, pool);
+  }
+  toCollection(data, kObject);
+  return JsonObject(data, pool);
+}
+
+template <typename Derived>
+JsonArray VariantWriter<Derived>::createNestedArray(const char *key) const {
+  VariantData *data = static_cast<const Derived *>(this)->writeData();
+  Pool *pool = static_cast<const Derived *>(this)->writePool();
+  VariantData *member = getOrAddMember(data, pool, key, false);
+  toCollection(member, kArray);
+  return JsonArray(member, pool);
+}
+
+template <typename Derived>
+JsonObject VariantWriter<Derived>::createNestedObject(const char *key) const {
+  VariantData *data = static_cast<const Derived *>(this)->writeData();
+  Pool *pool = static_cast<const Derived *>(this)->writePool();
+  VariantData *member = getOrAddMember(data, pool, key, false);
+  toCollection(member, kObject);
+  return JsonObject(member, pool);
+}
+
+template <typename Derived>
+template <typename T>
+T VariantWriter<Derived>::to() const {
+  VariantData *data = static_cast<const Derived *>(this)->writeData();
+  Pool *pool = static_cast<const Derived *>(this)->writePool();
+  if (std::is_same<T, JsonArray>::value) {
+    toCollection(data, kArray);
+  } else if (std::is_same<T, JsonObject>::value) {
+    toCollection(data, kObject);
+  } else {
+    setNull(data);
+  }
+  return T(data, pool);
+}
+
+template <typename Derived>
+template <typename T>
+bool VariantWriter<Derived>::add(const T &value) const {
+  VariantData *data = static_cast<const Derived *>(this)->writeData();
+  Pool *pool = static_cast<const Derived *>(this)->writePool();
+  if (data == nullptr) {
+    return false;
+  }
+  if (data->type == kNull) {
+    toCollection(data, kArray);
+  }
+  if (data->type != kArray) {
+    return false;
+  }
+  return JsonVariant(appendSlot(data, pool, nullptr), pool).set(value);
+}
+
+// ── Parsing ───────────────────────────────────────────────────────────────
+
+class Parser {
+ public:
+  static constexpr uint8_t kNestingLimit = 10;
+
+  // In place when `zeroCopy`: strings are unescaped inside `input`, which
+  // must then be writable and outlive the document.
+  Parser(char *input, size_t length, Pool *pool, bool zeroCopy)
+      : cursor_(input), end_(input + length), pool_(pool), zeroCopy_(zeroCopy) {}
+
+  DeserializationError::Code parse(VariantData *root) {
+    skipSpace();
+    if (cursor_ == end_ || *cursor_ == '\0') {
+      return DeserializationError::EmptyInput;
+    }
+    return parseValue(root, kNestingLimit);
+  }
+
+ private:
+  void skipSpace() {
+    while (cursor_ != end_ && (*cursor_ == ' ' || *cursor_ == '\t' || *cursor_ == '\n' ||
+                               *cursor_ == '\r')) {
+      ++cursor_;
+    }
+  }
+  bool atEnd() const { return cursor_ == end_ || *cursor_ == '\0'; }
+
+  DeserializationError::Code parseValue(VariantData *out, uint8_t depth) {
+    skipSpace();
+    if (atEnd()) {
+      return DeserializationError::IncompleteInput;
+    }
+    switch (*cursor_) {
+      case '{':
+        return depth == 0 ? DeserializationError::TooDeep : parseObject(out, depth - 1U);
+      case '[':
+        return depth == 0 ? DeserializationError::TooDeep : parseArray(out, depth - 1U);
+      case '"': {
+        const char *text = nullptr;
+        const auto error = parseString(text);
+        if (error != DeserializationError::Ok) {
+          return error;
+        }
+        out->type = kString;
+        out->content.asString = text;
+        return DeserializationError::Ok;
+      }
+      case 't':
+        return parseLiteral("true", out, kBool, true);
+      case 'f':
+        return parseLiteral("false", out, kBool, false);
+      case 'n':
+        return parseLiteral("null", out, kNull, false);
+      default:
+        return parseNumber(out);
+    }
+  }
+
+  DeserializationError::Code parseLiteral(const char *word, VariantData *out, uint8_t type,
+                                          bool value) {
+    for (const char *p = word; *p != '\0'; ++p) {
+      if (atEnd()) {
+        return DeserializationError::IncompleteInput;
+      }
+      if (*cursor_++ != *p) {
+        return DeserializationError::InvalidInput;
+      }
+    }
+    out->type = type;
+    out->content.asBool = value;
+    return DeserializationError::Ok;
+  }
+
+  DeserializationError::Code parseNumber(VariantData *out) {
+    char token[64];
+    size_t length = 0;
+    bool integer = true;
+    while (!atEnd() && strchr("+-0123456789.eE", *cursor_) != nullptr) {
+      if (*cursor_ == '.' || *cursor_ == 'e' || *cursor_ == 'E') {
+        integer = false;
+      }
+      if (length + 1U >= sizeof(token)) {
+        return DeserializationError::InvalidInput;
+      }
+      token[length++] = *cursor_++;
+    }
+    token[length] = '\0';
+    if (length == 0U) {
+      return DeserializationError::InvalidInput;
+    }
+
+    char *parsedEnd = nullptr;
+    errno = 0;
+    if (integer && token[0] == '-') {
+      const long long value = strtoll(token, &parsedEnd, 10);
+      if (*parsedEnd == '\0' && errno == 0) {
+        out->type = kSigned;
+        out->content.asSigned = value;
+        return DeserializationError::Ok;
+      }
+    } else if (integer) {
+      const unsigned long long value = strtoull(token, &parsedEnd, 10);
+      if (*parsedEnd == '\0' && errno == 0) {
+        out->type = kUnsigned;
+        out->content.asUnsigned = value;
+        return DeserializationError::Ok;
+      }
+    }
+    const double value = strtod(token, &parsedEnd);
+    if (*parsedEnd != '\0') {
+      return DeserializationError::InvalidInput;
+    }
+    out->type = kFloat;
+    out->content.asFloat = value;
+    return DeserializationError::Ok;
+  }
+
+  static size_t encodeUtf8(uint32_t codepoint, char *out) {
+    if (codepoint < 0x80U) {
+      out[0] = static_cast<char>(codepoint);
+      return 1;
+    }
+    if (codepoint < 0x800U) {
+      out[0] = static_cast<char>(0xC0U | (codepoint >> 6));
+      out[1] = static_cast<char>(0x80U | (codepoint & 0x3FU));
+      return 2;
+    }
+    if (codepoint < 0x10000U) {
+      out[0] = static_cast<char>(0xE0U | (codepoint >> 12));
+      out[1] = static_cast<char>(0x80U | ((codepoint >> 6) & 0x3FU));
+      out[2] = static_cast<char>(0x80U | (codepoint & 0x3FU));
+      return 3;
+    }
+    out[0] = static_cast<char>(0xF0U | (codepoint >> 18));
+    out[1] = static_cast<char>(0x80U | ((codepoint >> 12) & 0x3FU));
+    out[2] = static_cast<char>(0x80U | ((codepoint >> 6) & 0x3FU));
+    out[3] = static_cast<char>(0x80U | (codepoint & 0x3FU));
+    return 4;
+  }
+
+  bool readHex4(const char *&p, uint32_t &value) const {
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+      if (p == end_) {
+        return false;
+      }
+      const char c = *p++;
+      value <<= 4;
+      if (c >= '0' && c <= '9') {
+        value |= static_cast<uint32_t>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        value |= static_cast<uint32_t>(c - 'a' + 10);
+      } else if (c >= 'A' && c <= 'F') {
+        value |= static_cast<uint32_t>(c - 'A' + 10);
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Decodes the string at the cursor into `out` (nullptr: measure only).
+  DeserializationError::Code decodeString(const char *&p, char *out, size_t &length) const {
+    length = 0;
+    ++p;  // opening quote
+    for (;;) {
+      if (p == end_ || *p == '\0') {
+        return DeserializationError::IncompleteInput;
+      }
+      char c = *p++;
+      if (c == '"') {
+        return DeserializationError::Ok;
+      }
+      if (c != '\\') {
+        if (out != nullptr) {
+          out[length] = c;
+        }
+        ++length;
+        continue;
+      }
+      if (p == end_) {
+        return DeserializationError::IncompleteInput;
+      }
+      c = *p++;
+      char decoded[4];
+      size_t decodedLength = 1;
+      switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+          decoded[0] = c;
+          break;
+        case 'b':
+          decoded[0] = '\b';
+          break;
+        case 'f':
+          decoded[0] = '\f';
+          break;
+        case 'n':
+          decoded[0] = '\n';
+          break;
+        case 'r':
+          decoded[0] = '\r';
+          break;
+        case 't':
+          decoded[0] = '\t';
+          break;
+        case 'u': {
+          uint32_t codepoint = 0;
+          if (!readHex4(p, codepoint)) {
+            return DeserializationError::InvalidInput;
+          }
+          if (codepoint >= 0xD800U && codepoint < 0xDC00U && end_ - p >= 6 && p[0] == '\\' &&
+              p[1] == 'u') {
+            const char *low = p + 2;
+            uint32_t trail = 0;
+            if (readHex4(low, trail) && trail >= 0xDC00U && trail < 0xE000U) {
+              codepoint = 0x10000U + ((codepoint - 0xD800U) << 10) + (trail - 0xDC00U);
+              p = low;
+            }
+          }
+          decodedLength = encodeUtf8(codepoint, decoded);
+          break;
+        }
+        default:
+          return DeserializationError::InvalidInput;
+      }
+      if (out != nullptr) {
+        memcpy(out + length, decoded, decodedLength);
+      }
+      length += decodedLength;
+    }
+  }
+
+  DeserializationError::Code parseString(const char *&text) {
+    size_t length = 0;
+    if (zeroCopy_) {
+      // The decoded text never outgrows the escaped one, so it fits in place.
+      char *out = cursor_ + 1;
+      const char *p = cursor_;
+      const auto error = decodeString(p, out, length);
+      if (error != DeserializationError::Ok) {
+        return error;
+      }
+      out[length] = '\0';
+      cursor_ = const_cast<char *>(p);
+      text = out;
+      return DeserializationError::Ok;
+    }
+
+    const char *p = cursor_;
+    auto error = decodeString(p, nullptr, length);
+    if (error != DeserializationError::Ok) {
+      return error;
+    }
+    char *copy = pool_->allocString(length);
+    if (copy == nullptr) {
+      return DeserializationError::NoMemory;
+    }
+    p = cursor_;
+    error = decodeString(p, copy, length);
+    cursor_ = const_cast<char *>(p);
+    text = copy;
+    return error;
+  }
+
+  DeserializationError::Code parseArray(VariantData *out, uint8_t depth) {
+    toCollection(out, kArray);
+    ++cursor_;
+    skipSpace();
+    if (atEnd()) {
+      return DeserializationError::IncompleteInput;
+    }
+    if (*cursor_ == ']') {
+      ++cursor_;
+      return DeserializationError::Ok;
+    }
+    for (;;) {
+      VariantData *element = appendSlot(out, pool_, nullptr);
+      if (element == nullptr) {
+        return DeserializationError::NoMemory;
+      }
+      const auto error = parseValue(element, depth);
+      if (error != DeserializationError::Ok) {
+        return error;
+      }
+      skipSpace();
+      if (atEnd()) {
+        return DeserializationError::IncompleteInput;
+      }
+      const char c = *cursor_++;
+      if (c == ']') {
+        return DeserializationError::Ok;
+      }
+      if (c != ',') {
+        return DeserializationError::InvalidInput;
+      }
+    }
+  }
+
+  DeserializationError::Code parseObject(VariantData *out, uint8_t depth) {
+    toCollection(out, kObject);
+    ++cursor_;
+    skipSpace();
+    if (atEnd()) {
+      return DeserializationError::IncompleteInput;
+    }
+    if (*cursor_ == '}') {
+      ++cursor_;
+      return DeserializationError::Ok;
+    }
+    for (;;) {
+      skipSpace();
+      if (atEnd()) {
+        return DeserializationError::IncompleteInput;
+      }
+      if (*cursor_ != '"') {
+        return DeserializationError::InvalidInput;
+      }
+      const char *key = nullptr;
+      auto error = parseString(key);
+      if (error != DeserializationError::Ok) {
+        return error;
+      }
+      skipSpace();
+      if (atEnd()) {
+        return DeserializationError::IncompleteInput;
+      }
+      if (*cursor_++ != ':') {
+        return DeserializationError::InvalidInput;
+      }
+      VariantData *member = nullptr;
+      const Slot *existing = findMember(out, pool_, key);
+      member = existing != nullptr ? const_cast<VariantData *>(&existing->value)
+                                   : appendSlot(out, pool_, key);
+      if (member == nullptr) {
+        return DeserializationError::NoMemory;
+      }
+      error = parseValue(member, depth);
+      if (error != DeserializationError::Ok) {
+        return error;
+      }
+      skipSpace();
+      if (atEnd()) {
+        return DeserializationError::IncompleteInput;
+      }
+      const char c = *cursor_++;
+      if (c == '}') {
+        return DeserializationError::Ok;
+      }
+      if (c != ',') {
+        return DeserializationError::InvalidInput;
+      }
+    }
+  }
+
+  char *cursor_;
+  char *end_;
+  Pool *pool_;
+  bool zeroCopy_;
+};
+
+inline DeserializationError deserialize(JsonDocument &doc, char *input, size_t length,
+                                        bool zeroCopy) {
+  doc.clear();
+  if (input == nullptr) {
+    return DeserializationError::EmptyInput;
+  }
+  Parser parser(input, length, doc.pool(), zeroCopy);
+  const auto error = parser.parse(doc.root());
+  if (error != DeserializationError::Ok) {
+    return error;
+  }
+  return doc.overflowed() ? DeserializationError::NoMemory : DeserializationError::Ok;
+}
+
+template <typename Source>
+inline size_t serializeTo(const Source &source, CountingWriter &writer) {
+  writeVariant(writer, source.readData(), source.readPool());
+  return writer.count;
+}
+
+}  // namespace sjson
+
+inline DeserializationError deserializeJson(JsonDocument &doc, char *input, size_t length) {
+  return sjson::deserialize(doc, input, length, true);
+}
+inline DeserializationError deserializeJson(JsonDocument &doc, char *input) {
+  return sjson::deserialize(doc, input, input != nullptr ? strlen(input) : 0U, true);
+}
+inline DeserializationError deserializeJson(JsonDocument &doc, const char *input, size_t length) {
+  return sjson::deserialize(doc, const_cast<char *>(input), length, false);
+}
+inline DeserializationError deserializeJson(JsonDocument &doc, const char *input) {
+  return deserializeJson(doc, input, input != nullptr ? strlen(input) : 0U);
+}
+inline DeserializationError deserializeJson(JsonDocument &doc, const String &input) {
+  return deserializeJson(doc, input.c_str(), input.length());
+}
+inline DeserializationError deserializeJson(JsonDocument &doc, const std::string &input) {
+  return deserializeJson(doc, input.data(), input.size());
+}
+
+template <typename Source>
+size_t measureJson(const Source &source) {
+  sjson::CountingWriter writer;
+  sjson::writeVariant(writer, source.readData(), source.readPool());
+  return writer.count;
+}
+
+template <typename Source>
+size_t serializeJson(const Source &source, char *buffer, size_t size) {
+  if (buffer == nullptr || size == 0U) {
+    return 0;
+  }
+  sjson::BufferWriter writer{buffer, size - 1U};
+  sjson::writeVariant(writer, source.readData(), source.readPool());
+  buffer[writer.count] = '\0';
+  return writer.count;
+}
+template <typename Source>
+size_t serializeJson(const Source &source, void *buffer, size_t size) {
+  return serializeJson(source, static_cast<char *>(buffer), size);
+}
+template <typename Source>
+size_t serializeJson(const Source &source, String &out) {
+  sjson::StringWriter writer{out};
+  sjson::writeVariant(writer, source.readData(), source.readPool());
+  return writer.count;
+}
+template <typename Source>
+size_t serializeJson(const Source &source, std::string &out) {
+  sjson::StdStringWriter writer{out};
+  sjson::writeVariant(writer, source.readData(), source.readPool());
+  return writer.count;
+}
+template <typename Source>
+size_t serializeJson(const Source &source, Print &out) {
+  sjson::PrintWriter writer{out};
+  sjson::writeVariant(writer, source.readData(), source.readPool());
+  return writer.count;
+}
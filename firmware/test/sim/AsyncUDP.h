@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <functional>
+
+class AsyncUDPPacket {
+ public:
+  AsyncUDPPacket(const uint8_t *data, size_t length, const IPAddress &remote)
+      : data_(data), length_(length), remote_(remote) {}
+
+  uint8_t *data() { return const_cast<uint8_t *>(data_); }
+  size_t length() { return length_; }
+  IPAddress remoteIP() { return remote_; }
+
+ private:
+  const uint8_t *data_;
+  size_t length_;
+  IPAddress remote_;
+};
+
+typedef std::function<void(AsyncUDPPacket &packet)> AuPacketHandlerFunction;
+
+// Datagrams written here land in sim::takeUdpPackets(); sim::deliverUdpPacket()
+// feeds the registered handler as the AsyncUDP task would.
+class AsyncUDP {
+ public:
+  AsyncUDP();
+  ~AsyncUDP();
+
+  bool listenMulticast(const IPAddress &group, uint16_t port, uint8_t ttl = 1);
+  void onPacket(AuPacketHandlerFunction handler) { handler_ = handler; }
+  size_t writeTo(const uint8_t *data, size_t length, const IPAddress &address, uint16_t port);
+  bool connected() const { return listening_; }
+  void close() { listening_ = false; }
+
+  void deliver(AsyncUDPPacket &packet) {
+    if (listening_ && handler_) {
+      handler_(packet);
+    }
+  }
+  uint16_t port() const { return port_; }
+
+ private:
+  AuPacketHandlerFunction handler_;
+  bool listening_ = false;
+  uint16_t port_ = 0;
+};
@@ -0,0 +1,380 @@
+#pragma once
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <FS.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The slice of ESPAsyncWebServer 1.2 the firmware uses. Requests and
+// WebSocket clients are created by the tests (sim::httpRequest(),
+// sim::connectWebSocket()); ownership and buffer reference counting follow
+// the library so that leaks and use-after-free show up on the host.
+
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+typedef enum { WS_DISCONNECTED, WS_CONNECTED, WS_DISCONNECTING } AwsClientStatus;
+
+#define WS_CONTINUATION 0x00
+#define WS_TEXT 0x01
+#define WS_BINARY 0x02
+#define WS_MAX_QUEUED_MESSAGES 32
+
+typedef struct {
+  uint8_t message_opcode;
+  uint32_t num;
+  uint8_t final;
+  uint8_t masked;
+  uint8_t opcode;
+  uint64_t len;
+  uint8_t mask[4];
+  uint64_t index;
+} AwsFrameInfo;
+
+typedef enum {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_DELETE = 0b00000100,
+  HTTP_PUT = 0b00001000,
+  HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+typedef std::function<size_t(uint8_t *buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+class AsyncWebParameter {
+ public:
+  AsyncWebParameter(const String &name, const String &value, bool form = false,
+                    bool file = false)
+      : name_(name), value_(value), form_(form), file_(file) {}
+
+  const String &name() const { return name_; }
+  const String &value() const { return value_; }
+  bool isPost() const { return form_; }
+  bool isFile() const { return file_; }
+
+ private:
+  String name_;
+  String value_;
+  bool form_;
+  bool file_;
+};
+
+class AsyncWebHeader {
+ public:
+  AsyncWebHeader(const String &name, const String &value) : name_(name), value_(value) {}
+
+  const String &name() const { return name_; }
+  const String &value() const { return value_; }
+
+ private:
+  String name_;
+  String value_;
+};
+
+class AsyncWebServerResponse {
+ public:
+  AsyncWebServerResponse(int code, const String &contentType) : code_(code), contentType_(contentType) {}
+
+  void setCode(int code) { code_ = code; }
+  void addHeader(const String &name, const String &value) { headers_.emplace_back(name, value); }
+
+  int code() const { return code_; }
+  const String &contentType() const { return contentType_; }
+  const std::vector<AsyncWebHeader> &headers() const { return headers_; }
+
+  // Produces the whole body the way the library would stream it.
+  std::string render(size_t chunkSize);
+
+  std::string content_;
+  AwsResponseFiller filler_;
+  size_t fillerLength_ = 0;  // 0 for chunked
+  bool chunked_ = false;
+
+ private:
+  int code_;
+  String contentType_;
+  std::vector<AsyncWebHeader> headers_;
+};
+
+class AsyncWebServerRequest {
+ public:
+  AsyncWebServerRequest(WebRequestMethod method, const String &url);
+  ~AsyncWebServerRequest();
+
+  AsyncWebServerRequest(const AsyncWebServerRequest &) = delete;
+  AsyncWebServerRequest &operator=(const AsyncWebServerRequest &) = delete;
+
+  WebRequestMethodComposite method() const { return method_; }
+  const String &url() const { return url_; }
+
+  bool hasParam(const String &name, bool post = false, bool file = false) const;
+  AsyncWebParameter *getParam(const String &name, bool post = false, bool file = false) const;
+  size_t params() const { return params_.size(); }
+  bool hasHeader(const String &name) const;
+  AsyncWebHeader *getHeader(const String &name) const;
+
+  AsyncWebServerResponse *beginResponse(int code, const String &contentType = String(),
+                                        const String &content = String());
+  AsyncWebServerResponse *beginResponse(fs::FS &fs, const String &path,
+                                        const String &contentType = String(),
+                                        bool download = false);
+  AsyncWebServerResponse *beginResponse(const String &contentType, size_t length,
+                                        AwsResponseFiller callback);
+  AsyncWebServerResponse *beginResponse_P(int code, const String &contentType,
+                                          const uint8_t *content, size_t length);
+  AsyncWebServerResponse *beginChunkedResponse(const String &contentType,
+                                               AwsResponseFiller callback);
+
+  void send(AsyncWebServerResponse *response);
+  void send(int code, const String &contentType = String(), const String &content = String());
+  void onDisconnect(std::function<void()> callback) { onDisconnect_ = std::move(callback); }
+
+  void addParam(const String &name, const String &value, bool post) {
+    params_.push_back(std::unique_ptr<AsyncWebParameter>(new AsyncWebParameter(name, value, post)));
+  }
+  void addHeader(const String &name, const String &value) {
+    headers_.push_back(std::unique_ptr<AsyncWebHeader>(new AsyncWebHeader(name, value)));
+  }
+  AsyncWebServerResponse *response() const { return sent_; }
+
+  void *_tempObject = nullptr;
+
+ private:
+  WebRequestMethodComposite method_;
+  String url_;
+  std::vector<std::unique_ptr<AsyncWebParameter>> params_;
+  std::vector<std::unique_ptr<AsyncWebHeader>> headers_;
+  std::vector<std::unique_ptr<AsyncWebServerResponse>> responses_;
+  AsyncWebServerResponse *sent_ = nullptr;
+  std::function<void()> onDisconnect_;
+};
+
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, const String &filename, size_t index,
+                           uint8_t *data, size_t len, bool final)>
+    ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, uint8_t *data, size_t len,
+                           size_t index, size_t total)>
+    ArBodyHandlerFunction;
+
+class AsyncWebHandler {
+ public:
+  virtual ~AsyncWebHandler() = default;
+  virtual bool canHandle(AsyncWebServerRequest *request) = 0;
+  virtual void handleRequest(AsyncWebServerRequest *request) = 0;
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+ public:
+  AsyncCallbackWebHandler(const String &uri, WebRequestMethodComposite method,
+                          ArRequestHandlerFunction handler)
+      : uri_(uri), method_(method), handler_(std::move(handler)) {}
+
+  bool canHandle(AsyncWebServerRequest *request) override;
+  void handleRequest(AsyncWebServerRequest *request) override { handler_(request); }
+
+ private:
+  String uri_;
+  WebRequestMethodComposite method_;
+  ArRequestHandlerFunction handler_;
+};
+
+class AsyncStaticWebHandler : public AsyncWebHandler {
+ public:
+  AsyncStaticWebHandler(const String &uri, fs::FS &fs, const String &path,
+                        const char *cacheControl)
+      : uri_(uri), fs_(fs), path_(path), cacheControl_(cacheControl != nullptr ? cacheControl : "") {}
+
+  AsyncStaticWebHandler &setDefaultFile(const char *filename) {
+    defaultFile_ = filename;
+    return *this;
+  }
+  AsyncStaticWebHandler &setCacheControl(const char *cacheControl) {
+    cacheControl_ = cacheControl;
+    return *this;
+  }
+
+  bool canHandle(AsyncWebServerRequest *request) override;
+  void handleRequest(AsyncWebServerRequest *request) override;
+
+ private:
+  String filePath(const AsyncWebServerRequest *request) const;
+
+  String uri_;
+  fs::FS &fs_;
+  String path_;
+  String cacheControl_;
+  String defaultFile_ = "index.htm";
+};
+
+class AsyncWebSocket;
+
+// Ref-counted payload shared by several clients; deleted by
+// AsyncWebSocket::_cleanBuffers() once unlocked and no queued message holds it.
+class AsyncWebSocketMessageBuffer {
+ public:
+  explicit AsyncWebSocketMessageBuffer(size_t size);
+  ~AsyncWebSocketMessageBuffer();
+
+  AsyncWebSocketMessageBuffer(const AsyncWebSocketMessageBuffer &) = delete;
+  AsyncWebSocketMessageBuffer &operator=(const AsyncWebSocketMessageBuffer &) = delete;
+
+  void operator++(int) { ++count_; }
+  void operator--(int) {
+    if (count_ > 0U) {
+      --count_;
+    }
+  }
+  void lock() { locked_ = true; }
+  void unlock() { locked_ = false; }
+  uint8_t *get() { return data_; }
+  size_t length() { return length_; }
+  uint32_t count() const { return count_; }
+  bool canDelete() const { return count_ == 0U && !locked_; }
+
+ private:
+  uint8_t *data_;
+  size_t length_;
+  bool locked_ = false;
+  uint32_t count_ = 0;
+};
+
+class AsyncWebSocketClient {
+ public:
+  struct Message {
+    bool binary = false;
+    std::string owned;                                  // basic message: its own copy
+    AsyncWebSocketMessageBuffer *shared = nullptr;      // multi message: shared buffer
+  };
+
+  AsyncWebSocketClient(AsyncWebSocket *server, uint32_t id) : server_(server), id_(id) {}
+  ~AsyncWebSocketClient();
+
+  uint32_t id() { return id_; }
+  AwsClientStatus status() { return status_; }
+  IPAddress remoteIP() { return IPAddress(192, 168, 4, static_cast<uint8_t>(2U + id_ % 250U)); }
+
+  void text(const char *message, size_t length);
+  void text(const char *message) { text(message, strlen(message)); }
+  void text(const String &message) { text(message.c_str(), message.length()); }
+  void text(AsyncWebSocketMessageBuffer *buffer);
+  void binary(const uint8_t *message, size_t length);
+  void binary(const char *message, size_t length) {
+    binary(reinterpret_cast<const uint8_t *>(message), length);
+  }
+  void binary(AsyncWebSocketMessageBuffer *buffer);
+  void ping(const uint8_t *data = nullptr, size_t length = 0) {
+    (void)data;
+    (void)length;
+  }
+  void close(uint16_t code = 0, const char *message = nullptr);
+
+  bool canSend() { return queue_.size() < WS_MAX_QUEUED_MESSAGES; }
+  bool queueIsFull() { return !canSend(); }
+  size_t queueLength() { return queue_.size(); }
+
+  // Simulation side: a stalled client keeps its messages queued, as when
+  // the peer stops acknowledging TCP segments.
+  void setStalled(bool stalled);
+  void deliverQueued();
+  std::vector<std::pair<bool, std::string>> takeDelivered() {
+    std::vector<std::pair<bool, std::string>> delivered;
+    delivered.swap(delivered_);
+    return delivered;
+  }
+  uint32_t dropped() const { return dropped_; }
+  uint32_t deliveredCount() const { return deliveredCount_; }
+  void markDisconnected() { status_ = WS_DISCONNECTED; }
+
+ private:
+  void queueMessage(Message &&message);
+
+  AsyncWebSocket *server_;
+  uint32_t id_;
+  AwsClientStatus status_ = WS_CONNECTED;
+  bool stalled_ = false;
+  std::deque<Message> queue_;
+  std::vector<std::pair<bool, std::string>> delivered_;
+  uint32_t dropped_ = 0;
+  uint32_t deliveredCount_ = 0;
+};
+
+typedef std::function<void(AsyncWebSocket *server, AsyncWebSocketClient *client,
+                           AwsEventType type, void *arg, uint8_t *data, size_t len)>
+    AwsEventHandler;
+
+class AsyncWebSocket : public AsyncWebHandler {
+ public:
+  explicit AsyncWebSocket(const String &url);
+  ~AsyncWebSocket() override;
+
+  const char *url() const { return url_.c_str(); }
+  void onEvent(AwsEventHandler handler) { handler_ = std::move(handler); }
+
+  size_t count() const;
+  AsyncWebSocketClient *client(uint32_t id);
+  void textAll(const char *message, size_t length);
+  void textAll(const String &message) { textAll(message.c_str(), message.length()); }
+  void textAll(AsyncWebSocketMessageBuffer *buffer);
+  AsyncWebSocketMessageBuffer *makeBuffer(size_t size = 0);
+  void _cleanBuffers();
+  void cleanupClients(uint16_t maxClients = 8);
+
+  bool canHandle(AsyncWebServerRequest *request) override;
+  void handleRequest(AsyncWebServerRequest *request) override;
+
+  // Simulation side.
+  uint32_t connect(AsyncWebServerRequest *request);
+  void receive(uint32_t id, uint8_t opcode, const uint8_t *data, size_t length);
+  void disconnect(uint32_t id);
+  void processClosing();
+  AsyncWebSocketClient *anyClient(uint32_t id);
+  size_t bufferCount() const { return buffers_.size(); }
+
+ private:
+  String url_;
+  AwsEventHandler handler_;
+  std::vector<std::unique_ptr<AsyncWebSocketClient>> clients_;
+  std::vector<AsyncWebSocketMessageBuffer *> buffers_;
+};
+
+class AsyncWebServer {
+ public:
+  explicit AsyncWebServer(uint16_t port);
+  ~AsyncWebServer();
+
+  void begin() { started_ = true; }
+  AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method,
+                              ArRequestHandlerFunction handler);
+  AsyncStaticWebHandler &serveStatic(const char *uri, fs::FS &fs, const char *path,
+                                     const char *cacheControl = nullptr);
+  AsyncWebHandler &addHandler(AsyncWebHandler *handler);
+  void onNotFound(ArRequestHandlerFunction handler) { notFound_ = std::move(handler); }
+
+  // Simulation side.
+  void handle(AsyncWebServerRequest *request);
+  bool started() const { return started_; }
+
+ private:
+  std::vector<AsyncWebHandler *> handlers_;
+  std::vector<std::unique_ptr<AsyncWebHandler>> owned_;
+  ArRequestHandlerFunction notFound_;
+  bool started_ = false;
+};
+
+class DefaultHeaders {
+ public:
+  static DefaultHeaders &Instance();
+  void addHeader(const String &name, const String &value) { headers_.emplace_back(name, value); }
+  const std::vector<AsyncWebHeader> &headers() const { return headers_; }
+
+ private:
+  std::vector<AsyncWebHeader> headers_;
+};
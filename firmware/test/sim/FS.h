@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <memory>
+#include <string>
+
+namespace fs {
+
+// Read-only handle onto an in-memory file of the simulated filesystem.
+class File : public Print {
+ public:
+  File() = default;
+  explicit File(std::shared_ptr<const std::string> contents, const char *name);
+
+  explicit operator bool() const { return contents_ != nullptr; }
+  size_t size() const { return contents_ != nullptr ? contents_->size() : 0U; }
+  int available() const { return static_cast<int>(size() - position_); }
+  int read();
+  size_t read(uint8_t *buffer, size_t length);
+  size_t readBytes(char *buffer, size_t length) {
+    return read(reinterpret_cast<uint8_t *>(buffer), length);
+  }
+  bool seek(uint32_t position);
+  size_t position() const { return position_; }
+  void close() { contents_.reset(); }
+  const char *name() const { return name_.c_str(); }
+  bool isDirectory() const { return false; }
+
+  using Print::write;
+  size_t write(uint8_t) override { return 0; }
+
+ private:
+  std::shared_ptr<const std::string> contents_;
+  std::string name_;
+  size_t position_ = 0;
+};
+
+class FS {
+ public:
+  File open(const char *path, const char *mode = "r");
+  bool exists(const char *path);
+  bool remove(const char *path);
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
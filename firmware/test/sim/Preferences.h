@@ -0,0 +1,31 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Namespaced key/value store over the simulated NVS partition.
+class Preferences {
+ public:
+  bool begin(const char *name, bool readOnly = false);
+  void end();
+
+  bool isKey(const char *key);
+  bool remove(const char *key);
+  bool clear();
+
+  size_t putString(const char *key, const char *value);
+  size_t putString(const char *key, const String &value) { return putString(key, value.c_str()); }
+  size_t getString(const char *key, char *value, size_t maxLength);
+  String getString(const char *key, const String &defaultValue = String());
+  size_t putBytes(const char *key, const void *value, size_t length);
+  size_t getBytes(const char *key, void *buffer, size_t maxLength);
+  size_t getBytesLength(const char *key);
+  size_t putUChar(const char *key, uint8_t value);
+  uint8_t getUChar(const char *key, uint8_t defaultValue = 0);
+  size_t putUInt(const char *key, uint32_t value);
+  uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+
+ private:
+  std::string namespace_;
+  bool open_ = false;
+  bool readOnly_ = false;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>
+
+typedef enum { WIFI_MODE_NULL = 0, WIFI_MODE_STA, WIFI_MODE_AP, WIFI_MODE_APSTA } wifi_mode_t;
+#define WIFI_OFF WIFI_MODE_NULL
+#define WIFI_STA WIFI_MODE_STA
+#define WIFI_AP WIFI_MODE_AP
+#define WIFI_AP_STA WIFI_MODE_APSTA
+
+typedef enum { WIFI_AUTH_OPEN = 0, WIFI_AUTH_WPA2_PSK = 3 } wifi_auth_mode_t;
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6,
+} wl_status_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+typedef int arduino_event_id_t;
+#define ARDUINO_EVENT_WIFI_STA_DISCONNECTED 5
+#define ARDUINO_EVENT_WIFI_STA_GOT_IP 7
+
+#define WIFI_REASON_ASSOC_LEAVE 8
+#define WIFI_REASON_BEACON_TIMEOUT 200
+#define WIFI_REASON_NO_AP_FOUND 201
+
+typedef union {
+  struct {
+    uint8_t reason;
+  } wifi_sta_disconnected;
+} arduino_event_info_t;
+
+typedef void (*WiFiEventFuncCb)(arduino_event_id_t event, arduino_event_info_t info);
+
+// Station and soft-AP over the access points scripted with sim::addAccessPoint();
+// joins, scans and link loss complete on the simulated clock (sim::serviceWifi()).
+class WiFiClass {
+ public:
+  wifi_mode_t getMode();
+  bool mode(wifi_mode_t mode);
+  void persistent(bool persistent);
+  bool setHostname(const char *hostname);
+  void setSleep(bool enabled);
+  void setAutoReconnect(bool autoReconnect);
+  int onEvent(WiFiEventFuncCb callback, arduino_event_id_t event = 0);
+
+  wl_status_t begin(const char *ssid, const char *passphrase = nullptr, int32_t channel = 0,
+                    const uint8_t *bssid = nullptr, bool connect = true);
+  bool disconnect(bool wifiOff = false, bool eraseAp = false);
+  wl_status_t status();
+  bool isConnected() { return status() == WL_CONNECTED; }
+  IPAddress localIP();
+  String SSID();
+  int32_t RSSI();
+  uint8_t *BSSID();
+  int32_t channel();
+
+  int16_t scanNetworks(bool async = false, bool showHidden = false, bool passive = false,
+                       uint32_t maxMsPerChannel = 300, uint8_t channel = 0);
+  int16_t scanComplete();
+  void scanDelete();
+  String SSID(uint8_t index);
+  int32_t RSSI(uint8_t index);
+  wifi_auth_mode_t encryptionType(uint8_t index);
+  uint8_t *BSSID(uint8_t index);
+  int32_t channel(uint8_t index);
+
+  bool softAP(const char *ssid, const char *passphrase = nullptr);
+  bool softAPdisconnect(bool wifiOff = false);
+  void softAPsetHostname(const char *hostname);
+  uint8_t softAPgetStationNum();
+  IPAddress softAPIP();
+};
+
+extern WiFiClass WiFi;
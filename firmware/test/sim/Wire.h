@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Records every transaction per 7-bit address; see sim::i2cBytes().
+class TwoWire : public Print {
+ public:
+  bool begin() { return true; }
+  bool setClock(uint32_t frequency) {
+    frequency_ = frequency;
+    return true;
+  }
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool sendStop = true);
+  using Print::write;
+  size_t write(uint8_t byte) override;
+  size_t write(const uint8_t *data, size_t length) override;
+
+  uint32_t clock() const { return frequency_; }
+
+ private:
+  uint32_t frequency_ = 100000U;
+  uint8_t address_ = 0;
+  bool transmitting_ = false;
+  uint8_t buffer_[256] = {};
+  size_t length_ = 0;
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <mutex>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFU
+#define portTICK_PERIOD_MS 1U
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
+#define portNUM_PROCESSORS 2
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define configMAX_PRIORITIES 25
+
+// A spinlock on the device; a recursive mutex here so that an ISR raised by
+// the test thread inside a critical section does not deadlock.
+struct portMUX_TYPE {
+  std::recursive_mutex mutex;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+
+void portENTER_CRITICAL(portMUX_TYPE *mux);
+void portEXIT_CRITICAL(portMUX_TYPE *mux);
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux) portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(...) ((void)0)
+
+uint32_t portSET_INTERRUPT_MASK_FROM_ISR();
+void portCLEAR_INTERRUPT_MASK_FROM_ISR(uint32_t state);
+BaseType_t xPortGetCoreID();
@@ -0,0 +1,178 @@
+#pragma once
+
+// Test-side control of the simulated ESP32: clock, pins, I2C devices, NVS,
+// the filesystem, Wi-Fi access points, UDP and web clients. Everything here
+// is thread-safe unless noted.
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sim {
+
+// ── Clock ──────────────────────────────────────────────────────────────────
+// micros() follows the host's monotonic clock plus an offset. An idle loop
+// task waiting on ulTaskNotifyTake() with a timeout jumps the offset ahead
+// instead of sleeping, so simulated seconds pass instantly while measured
+// work still costs real time.
+void advanceMicros(uint64_t us);
+inline void advanceMillis(uint32_t ms) {
+  advanceMicros(static_cast<uint64_t>(ms) * 1000U);
+}
+// Idle waits stop fast-forwarding at `us` (sim time) and return as if they
+// timed out; UINT64_MAX lifts the limit.
+void setIdleHorizon(uint64_t us);
+// Stops real time from leaking into micros() (only explicit advances and
+// idle waits move it); for tests that assert exact timings.
+void freezeClock(bool frozen);
+uint64_t nowMicros();
+
+// ── GPIO ───────────────────────────────────────────────────────────────────
+// Drives an input pin as external hardware would; an attached interrupt
+// fires on the calling thread when the edge matches its mode.
+void setPinInput(uint8_t pin, bool level);
+bool pinLevel(uint8_t pin);
+uint8_t pinMode(uint8_t pin);
+// Output transitions on `pin` so far.
+uint32_t pinEdges(uint8_t pin);
+
+// ── I2C ────────────────────────────────────────────────────────────────────
+void attachI2cDevice(uint8_t address);
+void detachI2cDevice(uint8_t address);
+// Bytes on the bus for `address`, counting the address byte of each
+// transaction.
+uint64_t i2cBytes(uint8_t address);
+uint32_t i2cTransactions(uint8_t address);
+
+// ── NVS / Preferences ──────────────────────────────────────────────────────
+// Committed writes (Preferences puts and nvs_commit()) since start-up.
+uint32_t nvsCommits();
+bool nvsHasKey(const char *space, const char *key);
+std::string nvsValue(const char *space, const char *key);
+void nvsErase();
+// The next `count` nvs_set_str() calls fail; the next `count` nvs_commit()
+// calls fail and lose the writes staged on the handle, as a worn sector would.
+void failNvsWrites(uint32_t count);
+void failNvsCommits(uint32_t count);
+void runShutdownHandlers();
+
+// ── Filesystem ─────────────────────────────────────────────────────────────
+void writeFile(const char *path, const std::string &contents);
+void removeFile(const char *path);
+void setFilesystemMountable(bool mountable);
+// Files opened for reading since start-up.
+uint32_t fileOpens();
+
+// ── Misc ───────────────────────────────────────────────────────────────────
+void seedRandom(uint32_t seed);
+void setEfuseMac(uint64_t mac);
+// Serial output is captured; set STAGECUE_SIM_SERIAL=1 to echo it.
+std::string serialOutput();
+void clearSerialOutput();
+
+// True while library code (not firmware) runs on this thread; lets
+// allocation hooks in tests tell the two apart.
+bool inLibraryCode();
+
+class LibraryScope {
+ public:
+  LibraryScope();
+  ~LibraryScope();
+  LibraryScope(const LibraryScope &) = delete;
+  LibraryScope &operator=(const LibraryScope &) = delete;
+
+ private:
+  bool previous_;
+};
+
+// Runs `body` as firmware code even inside a LibraryScope (callbacks).
+class FirmwareScope {
+ public:
+  FirmwareScope();
+  ~FirmwareScope();
+  FirmwareScope(const FirmwareScope &) = delete;
+  FirmwareScope &operator=(const FirmwareScope &) = delete;
+
+ private:
+  bool previous_;
+};
+
+// ── Wi-Fi ──────────────────────────────────────────────────────────────────
+struct AccessPoint {
+  std::string ssid;
+  uint8_t bssid[6] = {};
+  int32_t channel = 1;
+  int32_t rssi = -60;
+  bool up = true;
+};
+
+// Returns the access point's index for the setters below.
+size_t addAccessPoint(const AccessPoint &ap);
+void setAccessPointUp(size_t index, bool up);
+void setAccessPointRssi(size_t index, int32_t rssi);
+// Index of the associated access point, or -1.
+int connectedAccessPoint();
+bool softApActive();
+// Completes joins, scans and beacon loss that are due on the simulated
+// clock and raises the resulting events; call from the loop task.
+void serviceWifi();
+
+// ── UDP ────────────────────────────────────────────────────────────────────
+struct UdpPacket {
+  IPAddress address;
+  uint16_t port = 0;
+  std::vector<uint8_t> data;
+};
+
+std::vector<UdpPacket> takeUdpPackets();
+// Hands a datagram to whichever AsyncUDP listens on `port`.
+bool deliverUdpPacket(uint16_t port, const std::vector<uint8_t> &data, const IPAddress &remote);
+
+// ── HTTP / WebSocket ───────────────────────────────────────────────────────
+struct HttpResponse {
+  int code = 0;  // 0 when no handler replied
+  std::string contentType;
+  std::string body;
+  std::vector<std::pair<std::string, std::string>> headers;
+
+  std::string header(const char *name) const;
+};
+
+// `url` may carry a query string; `form` adds POST parameters.
+HttpResponse httpRequest(WebRequestMethod method, const std::string &url,
+                         const std::map<std::string, std::string> &form = {},
+                         const std::map<std::string, std::string> &headers = {});
+
+// Opens a WebSocket on the first AsyncWebSocket registered for the path
+// part of `url`; returns the client id, or 0 if nothing handles it.
+uint32_t connectWebSocket(const std::string &url);
+void sendWebSocketText(uint32_t client, const std::string &text);
+void sendWebSocketBinary(uint32_t client, const std::vector<uint8_t> &data);
+void disconnectWebSocket(uint32_t client);
+// A stalled client keeps its messages queued until released.
+void stallWebSocket(uint32_t client, bool stalled);
+
+struct WebSocketMessage {
+  bool binary = false;
+  std::string data;
+};
+
+// Messages the client has received since the last call.
+std::vector<WebSocketMessage> takeWebSocketMessages(uint32_t client);
+bool webSocketConnected(uint32_t client);
+// Messages the library refused because the client's queue was full.
+uint32_t webSocketDropped(uint32_t client);
+// Library message buffers alive right now.
+size_t webSocketBuffers();
+// The next `count` makeBuffer() calls return nullptr, as on a heap that is
+// too fragmented for the frame.
+void failWebSocketBuffers(uint32_t count);
+
+}  // namespace sim
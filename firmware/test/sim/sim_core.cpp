@@ -0,0 +1,594 @@
+// Clock, tasks, critical sections, GPIO and Serial of the simulated ESP32.
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include <stdarg.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "sim.h"
+#include "sim_internal.h"
+
+namespace {
+
+// ── Clock ──────────────────────────────────────────────────────────────────
+
+// ESP32 sketches reach setup() a few hundred milliseconds after reset.
+constexpr uint64_t kBootMicros = 350000U;
+
+uint64_t realMicros() {
+  static const auto start = std::chrono::steady_clock::now();
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count());
+}
+
+std::atomic<uint64_t> gOffsetUs{kBootMicros};
+std::atomic<uint64_t> gPausedUs{0};
+std::atomic<uint64_t> gFrozenAtUs{0};
+std::atomic<bool> gFrozen{false};
+std::mutex gFreezeMutex;
+std::atomic<uint64_t> gIdleHorizonUs{UINT64_MAX};
+
+// ── Tasks ──────────────────────────────────────────────────────────────────
+
+struct SimTask {
+  std::string name;
+  int core = 1;  // the Arduino loop task runs on core 1
+  std::mutex mutex;
+  std::condition_variable wake;
+  uint32_t notifications = 0;
+};
+
+struct TaskExit {};
+
+thread_local SimTask *tCurrentTask = nullptr;
+thread_local bool tInLibrary = false;
+
+SimTask *currentTask() {
+  if (tCurrentTask == nullptr) {
+    tCurrentTask = new SimTask();  // lives as long as the thread may be notified
+    tCurrentTask->name = "loopTask";
+  }
+  return tCurrentTask;
+}
+
+std::array<std::recursive_mutex, portNUM_PROCESSORS> gCoreMasks;
+
+// ── GPIO ───────────────────────────────────────────────────────────────────
+
+constexpr uint8_t kPinCount = 40;
+constexpr uint8_t kFirstInputOnlyPin = 34;  // GPIO34-39 have no pull resistors
+
+struct PinState {
+  uint8_t mode = 0;
+  bool level = false;
+  bool driven = false;  // set by the test as external hardware
+  uint32_t edges = 0;
+  void (*handler)() = nullptr;
+  int interruptMode = 0;
+};
+
+std::recursive_mutex gPinMutex;
+std::array<PinState, kPinCount> gPins;
+
+void writeOutput(uint8_t pin, bool level) {
+  if (pin >= kPinCount) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock(gPinMutex);
+  PinState &state = gPins[pin];
+  if (state.level != level) {
+    state.level = level;
+    ++state.edges;
+  }
+}
+
+void writeOutputMask(uint32_t mask, uint8_t firstPin, bool level) {
+  for (uint8_t bit = 0; bit < 32U && mask != 0U; ++bit, mask >>= 1U) {
+    if ((mask & 1U) != 0U) {
+      writeOutput(static_cast<uint8_t>(firstPin + bit), level);
+    }
+  }
+}
+
+// ── Serial ─────────────────────────────────────────────────────────────────
+
+constexpr size_t kSerialCaptureLimit = 1U << 20;
+
+std::mutex gSerialMutex;
+std::string gSerialCapture;
+
+bool echoSerial() {
+  static const bool echo = [] {
+    const char *value = getenv("STAGECUE_SIM_SERIAL");
+    return value != nullptr && value[0] != '\0' && value[0] != '0';
+  }();
+  return echo;
+}
+
+void captureSerial(const char *data, size_t length) {
+  std::lock_guard<std::mutex> lock(gSerialMutex);
+  if (gSerialCapture.size() + length > kSerialCaptureLimit) {
+    gSerialCapture.erase(0, gSerialCapture.size() / 2U);
+  }
+  gSerialCapture.append(data, length);
+  if (echoSerial()) {
+    fwrite(data, 1, length, stderr);
+  }
+}
+
+std::atomic<uint32_t> gRandomState{0x2545F491U};
+std::atomic<uint64_t> gEfuseMac{0x0000A4CF12345678ULL};
+
+}  // namespace
+
+// ── sim:: ──────────────────────────────────────────────────────────────────
+
+namespace sim {
+
+uint64_t nowMicros() {
+  const uint64_t real = gFrozen.load(std::memory_order_acquire)
+                            ? gFrozenAtUs.load(std::memory_order_relaxed)
+                            : realMicros();
+  return real - gPausedUs.load(std::memory_order_relaxed) +
+         gOffsetUs.load(std::memory_order_relaxed);
+}
+
+void advanceMicros(uint64_t us) {
+  gOffsetUs.fetch_add(us, std::memory_order_relaxed);
+}
+
+void setIdleHorizon(uint64_t us) {
+  gIdleHorizonUs.store(us, std::memory_order_relaxed);
+}
+
+void freezeClock(bool frozen) {
+  std::lock_guard<std::mutex> lock(gFreezeMutex);
+  if (frozen == gFrozen.load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (frozen) {
+    gFrozenAtUs.store(realMicros(), std::memory_order_relaxed);
+    gFrozen.store(true, std::memory_order_release);
+  } else {
+    gPausedUs.fetch_add(realMicros() - gFrozenAtUs.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+    gFrozen.store(false, std::memory_order_release);
+  }
+}
+
+void setPinInput(uint8_t pin, bool level) {
+  if (pin >= kPinCount) {
+    return;
+  }
+  void (*handler)() = nullptr;
+  {
+    std::lock_guard<std::recursive_mutex> lock(gPinMutex);
+    PinState &state = gPins[pin];
+    state.driven = true;
+    const bool previous = state.level;
+    state.level = level;
+    if (previous != level && state.handler != nullptr) {
+      const bool rising = level;
+      if (state.interruptMode == CHANGE || (state.interruptMode == RISING && rising) ||
+          (state.interruptMode == FALLING && !rising)) {
+        handler = state.handler;
+      }
+    }
+  }
+  if (handler != nullptr) {
+    handler();
+  }
+}
+
+bool pinLevel(uint8_t pin) {
+  std::lock_guard<std::recursive_mutex> lock(gPinMutex);
+  return pin < kPinCount && gPins[pin].level;
+}
+
+uint8_t pinMode(uint8_t pin) {
+  std::lock_guard<std::recursive_mutex> lock(gPinMutex);
+  return pin < kPinCount ? gPins[pin].mode : 0U;
+}
+
+uint32_t pinEdges(uint8_t pin) {
+  std::lock_guard<std::recursive_mutex> lock(gPinMutex);
+  return pin < kPinCount ? gPins[pin].edges : 0U;
+}
+
+void seedRandom(uint32_t seed) {
+  gRandomState.store(seed != 0U ? seed : 1U, std::memory_order_relaxed);
+}
+
+void setEfuseMac(uint64_t mac) {
+  gEfuseMac.store(mac, std::memory_order_relaxed);
+}
+
+std::string serialOutput() {
+  std::lock_guard<std::mutex> lock(gSerialMutex);
+  return gSerialCapture;
+}
+
+void clearSerialOutput() {
+  std::lock_guard<std::mutex> lock(gSerialMutex);
+  gSerialCapture.clear();
+}
+
+bool inLibraryCode() {
+  return tInLibrary;
+}
+
+LibraryScope::LibraryScope() : previous_(tInLibrary) {
+  tInLibrary = true;
+}
+
+LibraryScope::~LibraryScope() {
+  tInLibrary = previous_;
+}
+
+FirmwareScope::FirmwareScope() : previous_(tInLibrary) {
+  tInLibrary = false;
+}
+
+FirmwareScope::~FirmwareScope() {
+  tInLibrary = previous_;
+}
+
+namespace internal {
+
+void adoptTask(const char *name, int core) {
+  currentTask()->name = name;
+  currentTask()->core = core == 1 ? 1 : 0;
+}
+
+}  // namespace internal
+
+}  // namespace sim
+
+// ── Arduino core ───────────────────────────────────────────────────────────
+
+HardwareSerial Serial;
+EspClass ESP;
+
+uint32_t micros() {
+  return static_cast<uint32_t>(sim::nowMicros());
+}
+
+uint32_t millis() {
+  return static_cast<uint32_t>(sim::nowMicros() / 1000U);
+}
+
+int64_t esp_timer_get_time() {
+  return static_cast<int64_t>(sim::nowMicros());
+}
+
+void delay(uint32_t ms) {
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= kPinCount) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock(gPinMutex);
+  PinState &state = gPins[pin];
+  state.mode = mode;
+  if (!state.driven && (mode & INPUT) != 0U && (mode & OUTPUT) != OUTPUT) {
+    // Undriven inputs idle at their pull; the input-only pins have none and
+    // read low here, as a floating input often does.
+    state.level = (mode & PULLUP) != 0U && pin < kFirstInputOnlyPin;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  writeOutput(pin, value != LOW);
+}
+
+int digitalRead(uint8_t pin) {
+  return sim::pinLevel(pin) ? HIGH : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode) {
+  if (pin >= kPinCount) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock(gPinMutex);
+  gPins[pin].handler = handler;
+  gPins[pin].interruptMode = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin >= kPinCount) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock(gPinMutex);
+  gPins[pin].handler = nullptr;
+}
+
+uint32_t simRegisterRead(uint32_t address) {
+  std::lock_guard<std::recursive_mutex> lock(gPinMutex);
+  const uint8_t first = address == GPIO_IN1_REG ? 32U : 0U;
+  if (address != GPIO_IN_REG && address != GPIO_IN1_REG) {
+    return 0;
+  }
+  uint32_t value = 0;
+  for (uint8_t bit = 0; bit < 32U && first + bit < kPinCount; ++bit) {
+    if (gPins[first + bit].level) {
+      value |= 1UL << bit;
+    }
+  }
+  return value;
+}
+
+void simRegisterWrite(uint32_t address, uint32_t value) {
+  switch (address) {
+    case GPIO_OUT_W1TS_REG:
+      writeOutputMask(value, 0, true);
+      break;
+    case GPIO_OUT_W1TC_REG:
+      writeOutputMask(value, 0, false);
+      break;
+    case GPIO_OUT1_W1TS_REG:
+      writeOutputMask(value & 0xFFU, 32, true);
+      break;
+    case GPIO_OUT1_W1TC_REG:
+      writeOutputMask(value & 0xFFU, 32, false);
+      break;
+    default:
+      break;
+  }
+}
+
+uint32_t esp_random() {
+  uint32_t state = gRandomState.load(std::memory_order_relaxed);
+  uint32_t next = 0;
+  do {
+    next = state;
+    next ^= next << 13;
+    next ^= next >> 17;
+    next ^= next << 5;
+  } while (!gRandomState.compare_exchange_weak(state, next, std::memory_order_relaxed));
+  return next;
+}
+
+void EspClass::restart() {
+  sim::runShutdownHandlers();
+  fprintf(stderr, "[sim] ESP.restart() called\n");
+  abort();
+}
+
+uint32_t EspClass::getFreeHeap() {
+  return 180000U;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  return 150000U;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+  return 110000U;
+}
+
+uint64_t EspClass::getEfuseMac() {
+  return gEfuseMac.load(std::memory_order_relaxed);
+}
+
+// ── Print ──────────────────────────────────────────────────────────────────
+
+size_t Print::print(long value, int base) {
+  if (base == DEC) {
+    return write(std::to_string(value).c_str());
+  }
+  return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  if (base < 2 || base > 36) {
+    base = DEC;
+  }
+  char digits[sizeof(unsigned long) * 8U + 1U];
+  size_t position = sizeof(digits);
+  digits[--position] = '\0';
+  do {
+    const unsigned long digit = value % static_cast<unsigned long>(base);
+    digits[--position] = static_cast<char>(digit < 10U ? '0' + digit : 'A' + digit - 10U);
+    value /= static_cast<unsigned long>(base);
+  } while (value != 0U);
+  return write(digits + position);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[64];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return write(text);
+}
+
+size_t Print::printf(const char *format, ...) {
+  char stackBuffer[256];
+  va_list args;
+  va_start(args, format);
+  va_list copy;
+  va_copy(copy, args);
+  const int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+  va_end(args);
+  if (length < 0) {
+    va_end(copy);
+    return 0;
+  }
+  if (static_cast<size_t>(length) < sizeof(stackBuffer)) {
+    va_end(copy);
+    return write(stackBuffer, static_cast<size_t>(length));
+  }
+  std::string text(static_cast<size_t>(length) + 1U, '\0');
+  vsnprintf(&text[0], text.size(), format, copy);
+  va_end(copy);
+  return write(text.data(), static_cast<size_t>(length));
+}
+
+size_t HardwareSerial::write(uint8_t byte) {
+  const char c = static_cast<char>(byte);
+  captureSerial(&c, 1);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  captureSerial(reinterpret_cast<const char *>(buffer), size);
+  return size;
+}
+
+// ── FreeRTOS ───────────────────────────────────────────────────────────────
+
+void portENTER_CRITICAL(portMUX_TYPE *mux) {
+  mux->mutex.lock();
+}
+
+void portEXIT_CRITICAL(portMUX_TYPE *mux) {
+  mux->mutex.unlock();
+}
+
+// Masking interrupts makes the caller the only code running on its core;
+// here that is a per-core lock shared by every task pinned there.
+uint32_t portSET_INTERRUPT_MASK_FROM_ISR() {
+  const int core = currentTask()->core;
+  gCoreMasks[static_cast<size_t>(core)].lock();
+  return static_cast<uint32_t>(core);
+}
+
+void portCLEAR_INTERRUPT_MASK_FROM_ISR(uint32_t state) {
+  gCoreMasks[state].unlock();
+}
+
+BaseType_t xPortGetCoreID() {
+  return currentTask()->core;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t,
+                                   void *parameters, UBaseType_t, TaskHandle_t *created,
+                                   BaseType_t core) {
+  auto *task = new SimTask();
+  task->name = name != nullptr ? name : "";
+  task->core = core == 1 ? 1 : 0;
+  if (created != nullptr) {
+    *created = task;
+  }
+  std::thread([task, function, parameters] {
+    tCurrentTask = task;
+    try {
+      function(parameters);
+    } catch (const TaskExit &) {
+    }
+  }).detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stackDepth,
+                       void *parameters, UBaseType_t priority, TaskHandle_t *created) {
+  return xTaskCreatePinnedToCore(function, name, stackDepth, parameters, priority, created,
+                                 tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == nullptr || task == currentTask()) {
+    throw TaskExit{};
+  }
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (ticks == 0U) {
+    std::this_thread::yield();
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return currentTask();
+}
+
+TickType_t xTaskGetTickCount() {
+  return millis();
+}
+
+// A finite wait that nobody interrupts fast-forwards the clock rather than
+// sleeping, so idle simulated time costs nothing.
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+  SimTask *task = currentTask();
+  std::unique_lock<std::mutex> lock(task->mutex);
+  if (task->notifications == 0U) {
+    if (ticksToWait == portMAX_DELAY) {
+      task->wake.wait(lock, [task] { return task->notifications != 0U; });
+    } else {
+      lock.unlock();
+      std::this_thread::yield();
+      lock.lock();
+      if (task->notifications == 0U) {
+        lock.unlock();
+        // Stop early for radio events, which the Wi-Fi event task would
+        // deliver while this task sleeps, and at the test's horizon.
+        const uint64_t now = sim::nowMicros();
+        const uint64_t horizon = gIdleHorizonUs.load(std::memory_order_relaxed);
+        uint64_t deadline = now + static_cast<uint64_t>(ticksToWait) * 1000U;
+        deadline = std::min(deadline, std::max(horizon, now));
+        const uint64_t radio = sim::internal::nextWifiEventMicros();
+        sim::advanceMicros((radio < deadline ? (radio > now ? radio : now) : deadline) - now);
+        sim::serviceWifi();
+        return 0;
+      }
+    }
+  }
+  const uint32_t value = task->notifications;
+  task->notifications = clearOnExit == pdTRUE ? 0U : value - 1U;
+  return clearOnExit == pdTRUE ? value : 1U;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle) {
+  auto *task = static_cast<SimTask *>(handle);
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    ++task->notifications;
+  }
+  task->wake.notify_all();
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higherPriorityTaskWoken) {
+  xTaskNotifyGive(task);
+  if (higherPriorityTaskWoken != nullptr) {
+    *higherPriorityTaskWoken = pdTRUE;
+  }
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new std::timed_mutex();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+  auto *mutex = static_cast<std::timed_mutex *>(semaphore);
+  if (ticksToWait == portMAX_DELAY) {
+    mutex->lock();
+    return pdTRUE;
+  }
+  return mutex->try_lock_for(std::chrono::milliseconds(ticksToWait)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  static_cast<std::timed_mutex *>(semaphore)->unlock();
+  return pdTRUE;
+}
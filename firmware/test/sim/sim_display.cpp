@@ -0,0 +1,233 @@
+// I2C bus and SSD1306 panels of the simulated ESP32.
+
+#include <Adafruit_SSD1306.h>
+#include <Wire.h>
+
+#include <map>
+#include <mutex>
+#include <set>
+
+#include "sim.h"
+
+namespace {
+
+struct I2cTraffic {
+  uint64_t bytes = 0;
+  uint32_t transactions = 0;
+};
+
+std::mutex gI2cMutex;
+std::set<uint8_t> gI2cDevices;
+std::map<uint8_t, I2cTraffic> gI2cTraffic;
+
+constexpr size_t kWireMax = 32;  // Wire's transmit buffer on the ESP32 core
+
+// Classic 5x7 cell: glyph columns are derived from the character code so
+// that every printable character has a distinct, deterministic shape.
+uint8_t glyphColumn(unsigned char c, uint8_t column) {
+  if (c == ' ' || column >= 5U) {
+    return 0;
+  }
+  uint32_t mixed = (static_cast<uint32_t>(c) + 1U) * 0x9E3779B1U;
+  mixed ^= mixed >> (7U + column * 3U);
+  return static_cast<uint8_t>((mixed | 0x01U) & 0x7FU);
+}
+
+}  // namespace
+
+namespace sim {
+
+void attachI2cDevice(uint8_t address) {
+  std::lock_guard<std::mutex> lock(gI2cMutex);
+  gI2cDevices.insert(address);
+}
+
+void detachI2cDevice(uint8_t address) {
+  std::lock_guard<std::mutex> lock(gI2cMutex);
+  gI2cDevices.erase(address);
+}
+
+uint64_t i2cBytes(uint8_t address) {
+  std::lock_guard<std::mutex> lock(gI2cMutex);
+  return gI2cTraffic[address].bytes;
+}
+
+uint32_t i2cTransactions(uint8_t address) {
+  std::lock_guard<std::mutex> lock(gI2cMutex);
+  return gI2cTraffic[address].transactions;
+}
+
+}  // namespace sim
+
+TwoWire Wire;
+
+void TwoWire::beginTransmission(uint8_t address) {
+  address_ = address;
+  transmitting_ = true;
+  length_ = 0;
+}
+
+uint8_t TwoWire::endTransmission(bool) {
+  if (!transmitting_) {
+    return 4;
+  }
+  transmitting_ = false;
+  std::lock_guard<std::mutex> lock(gI2cMutex);
+  I2cTraffic &traffic = gI2cTraffic[address_];
+  ++traffic.transactions;
+  traffic.bytes += 1U + length_;
+  return gI2cDevices.count(address_) > 0U ? 0U : 2U;  // 2: address NACK
+}
+
+size_t TwoWire::write(uint8_t byte) {
+  if (!transmitting_ || length_ >= sizeof(buffer_)) {
+    return 0;
+  }
+  buffer_[length_++] = byte;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t length) {
+  size_t written = 0;
+  while (written < length && write(data[written]) == 1U) {
+    ++written;
+  }
+  return written;
+}
+
+// ── Adafruit_GFX ───────────────────────────────────────────────────────────
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  for (int16_t i = x; i < x + w; ++i) {
+    for (int16_t j = y; j < y + h; ++j) {
+      drawPixel(i, j, color);
+    }
+  }
+}
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
+                            uint16_t background, uint8_t size) {
+  if (x >= width_ || y >= height_ || x + 6 * size - 1 < 0 || y + 8 * size - 1 < 0) {
+    return;
+  }
+  for (uint8_t i = 0; i < 6U; ++i) {
+    uint8_t line = glyphColumn(c, i);
+    for (uint8_t j = 0; j < 8U; ++j, line >>= 1U) {
+      const bool set = (line & 1U) != 0U;
+      if (!set && background == color) {
+        continue;
+      }
+      const uint16_t pixel = set ? color : background;
+      if (size == 1U) {
+        drawPixel(static_cast<int16_t>(x + i), static_cast<int16_t>(y + j), pixel);
+      } else {
+        fillRect(static_cast<int16_t>(x + i * size), static_cast<int16_t>(y + j * size), size, size,
+                 pixel);
+      }
+    }
+  }
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+  if (c == '\n') {
+    cursorX_ = 0;
+    cursorY_ = static_cast<int16_t>(cursorY_ + textSize_ * 8);
+    return 1;
+  }
+  if (c == '\r') {
+    return 1;
+  }
+  if (wrap_ && cursorX_ + textSize_ * 6 > width_) {
+    cursorX_ = 0;
+    cursorY_ = static_cast<int16_t>(cursorY_ + textSize_ * 8);
+  }
+  drawChar(cursorX_, cursorY_, c, textColor_, textBackground_, textSize_);
+  cursorX_ = static_cast<int16_t>(cursorX_ + textSize_ * 6);
+  return 1;
+}
+
+// ── Adafruit_SSD1306 ───────────────────────────────────────────────────────
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t width, uint8_t height, TwoWire *wire, int8_t)
+    : Adafruit_GFX(width, height), wire_(wire), buffer_(nullptr) {}
+
+Adafruit_SSD1306::Adafruit_SSD1306(Adafruit_SSD1306 &&other) noexcept
+    : Adafruit_GFX(other.width_, other.height_),
+      wire_(other.wire_),
+      address_(other.address_),
+      buffer_(other.buffer_) {
+  other.buffer_ = nullptr;
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+  free(buffer_);
+}
+
+bool Adafruit_SSD1306::begin(uint8_t, uint8_t address, bool, bool) {
+  if (buffer_ == nullptr) {
+    buffer_ = static_cast<uint8_t *>(malloc(static_cast<size_t>(width_) * ((height_ + 7) / 8)));
+    if (buffer_ == nullptr) {
+      return false;
+    }
+  }
+  address_ = address;
+  clearDisplay();
+
+  // Display off, clock, multiplex, offset, charge pump, addressing, display on.
+  static const uint8_t kInit[] = {0xAE, 0xD5, 0x80, 0xA8, 0x3F, 0xD3, 0x00, 0x40, 0x8D,
+                                  0x14, 0x20, 0x00, 0xA1, 0xC8, 0xDA, 0x12, 0x81, 0xCF,
+                                  0xD9, 0xF1, 0xDB, 0x40, 0xA4, 0xA6, 0x2E, 0xAF};
+  wire_->beginTransmission(address_);
+  wire_->write(static_cast<uint8_t>(0x00));
+  wire_->write(kInit, sizeof(kInit));
+  wire_->endTransmission();
+  return true;
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+  if (buffer_ != nullptr) {
+    memset(buffer_, 0, static_cast<size_t>(width_) * ((height_ + 7) / 8));
+  }
+}
+
+void Adafruit_SSD1306::display() {
+  const uint8_t window[] = {SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0,
+                            static_cast<uint8_t>(width_ - 1)};
+  wire_->beginTransmission(address_);
+  wire_->write(static_cast<uint8_t>(0x00));
+  wire_->write(window, sizeof(window));
+  wire_->endTransmission();
+
+  size_t remaining = static_cast<size_t>(width_) * ((height_ + 7) / 8);
+  const uint8_t *data = buffer_;
+  while (remaining > 0U) {
+    const size_t chunk = remaining < kWireMax - 1U ? remaining : kWireMax - 1U;
+    wire_->beginTransmission(address_);
+    wire_->write(static_cast<uint8_t>(0x40));
+    wire_->write(data, chunk);
+    wire_->endTransmission();
+    data += chunk;
+    remaining -= chunk;
+  }
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if (buffer_ == nullptr || x < 0 || y < 0 || x >= width_ || y >= height_) {
+    return;
+  }
+  uint8_t &cell = buffer_[x + (y / 8) * width_];
+  const auto bit = static_cast<uint8_t>(1U << (y & 7));
+  switch (color) {
+    case SSD1306_WHITE:
+      cell |= bit;
+      break;
+    case SSD1306_BLACK:
+      cell &= static_cast<uint8_t>(~bit);
+      break;
+    case SSD1306_INVERSE:
+      cell ^= bit;
+      break;
+    default:
+      break;
+  }
+}
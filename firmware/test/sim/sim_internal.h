@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+
+// Hooks between the simulated peripherals; not for tests.
+namespace sim {
+namespace internal {
+
+// Simulated time of the next scheduled radio event, or UINT64_MAX.
+uint64_t nextWifiEventMicros();
+
+// Names the calling thread's task; for threads the sim starts itself.
+void adoptTask(const char *name, int core);
+
+// Runs `job` on the simulated AsyncTCP task, where the library raises its
+// callbacks; waits for it unless `wait` is false. Runs inline when already
+// on that task.
+void runOnTcpTask(std::function<void()> job, bool wait = true);
+
+}  // namespace internal
+}  // namespace sim
@@ -0,0 +1,949 @@
+// AsyncUDP and ESPAsyncWebServer of the simulated ESP32. The library's
+// callbacks run on a simulated AsyncTCP task, as on the device; the sim::
+// entry points hand their work to that task and wait for it.
+
+#include <AsyncUDP.h>
+#include <ESPAsyncWebServer.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "sim.h"
+#include "sim_internal.h"
+
+namespace {
+
+// ── AsyncTCP task ──────────────────────────────────────────────────────────
+
+class TcpTask {
+ public:
+  void post(std::function<void()> job, bool wait) {
+    if (tOnTcpTask) {
+      job();
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    start();
+    auto done = std::make_shared<bool>(false);
+    jobs_.push_back([job, done, this] {
+      job();
+      std::lock_guard<std::mutex> finished(mutex_);
+      *done = true;
+      idle_.notify_all();
+    });
+    work_.notify_one();
+    if (wait) {
+      idle_.wait(lock, [&done] { return *done; });
+    }
+  }
+
+ private:
+  void start() {
+    if (started_) {
+      return;
+    }
+    started_ = true;
+    std::thread([this] {
+      tOnTcpTask = true;
+      sim::internal::adoptTask("async_tcp", 0);
+      for (;;) {
+        std::function<void()> job;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          work_.wait(lock, [this] { return !jobs_.empty(); });
+          job = std::move(jobs_.front());
+          jobs_.pop_front();
+        }
+        sim::LibraryScope inLibrary;
+        job();
+      }
+    }).detach();
+  }
+
+  static thread_local bool tOnTcpTask;
+
+  std::mutex mutex_;
+  std::condition_variable work_;
+  std::condition_variable idle_;
+  std::deque<std::function<void()>> jobs_;
+  bool started_ = false;
+};
+
+thread_local bool TcpTask::tOnTcpTask = false;
+
+TcpTask &tcpTask() {
+  static auto *task = new TcpTask();  // outlives static destruction
+  return *task;
+}
+
+// Library state is reached through functions: the firmware's servers and
+// sockets are globals that register themselves during static
+// initialisation, possibly before this file's own globals exist.
+struct Library {
+  // Guards the lists and queues below; never held across a callback into
+  // the firmware.
+  std::recursive_mutex mutex;
+  std::vector<AsyncUDP *> udpSockets;
+  std::vector<sim::UdpPacket> udpSent;
+  std::vector<AsyncWebServer *> servers;
+  std::vector<AsyncWebSocket *> webSockets;
+  std::vector<std::unique_ptr<AsyncWebServerRequest>> unansweredRequests;
+  uint32_t failBuffers = 0;
+  uint32_t nextClientId = 1;  // unique across sockets, as the library's are per server
+};
+
+Library &library() {
+  static auto *state = new Library();
+  return *state;
+}
+
+
+constexpr size_t kTcpChunkBytes = 1436;  // one MSS less HTTP chunk framing
+
+std::string urlDecode(const std::string &text) {
+  std::string decoded;
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '+') {
+      decoded.push_back(' ');
+    } else if (text[i] == '%' && i + 2U < text.size()) {
+      decoded.push_back(static_cast<char>(strtol(text.substr(i + 1U, 2).c_str(), nullptr, 16)));
+      i += 2U;
+    } else {
+      decoded.push_back(text[i]);
+    }
+  }
+  return decoded;
+}
+
+bool equalsIgnoreCase(const String &a, const String &b) {
+  return a.length() == b.length() && strcasecmp(a.c_str(), b.c_str()) == 0;
+}
+
+AsyncWebSocket *findWebSocket(const std::string &path) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  for (auto *socket : library().webSockets) {
+    if (path == socket->url()) {
+      return socket;
+    }
+  }
+  return nullptr;
+}
+
+AsyncWebSocketClient *findClient(uint32_t id, AsyncWebSocket **owner = nullptr) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  for (auto *socket : library().webSockets) {
+    if (AsyncWebSocketClient *client = socket->anyClient(id)) {
+      if (owner != nullptr) {
+        *owner = socket;
+      }
+      return client;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+// ── sim:: ──────────────────────────────────────────────────────────────────
+
+namespace sim {
+
+namespace internal {
+
+void runOnTcpTask(std::function<void()> job, bool wait) {
+  tcpTask().post(std::move(job), wait);
+}
+
+}  // namespace internal
+
+std::vector<UdpPacket> takeUdpPackets() {
+  LibraryScope inLibrary;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  std::vector<UdpPacket> packets;
+  packets.swap(library().udpSent);
+  return packets;
+}
+
+bool deliverUdpPacket(uint16_t port, const std::vector<uint8_t> &data, const IPAddress &remote) {
+  LibraryScope inLibrary;
+  bool delivered = false;
+  internal::runOnTcpTask([&] {
+    AsyncUDP *target = nullptr;
+    {
+      std::lock_guard<std::recursive_mutex> lock(library().mutex);
+      for (auto *socket : library().udpSockets) {
+        if (socket->connected() && socket->port() == port) {
+          target = socket;
+          break;
+        }
+      }
+    }
+    if (target == nullptr) {
+      return;
+    }
+    std::vector<uint8_t> copy(data);  // the pbuf
+    AsyncUDPPacket packet(copy.data(), copy.size(), remote);
+    FirmwareScope firmware;
+    target->deliver(packet);
+    delivered = true;
+  });
+  return delivered;
+}
+
+std::string HttpResponse::header(const char *name) const {
+  for (const auto &entry : headers) {
+    if (strcasecmp(entry.first.c_str(), name) == 0) {
+      return entry.second;
+    }
+  }
+  return std::string();
+}
+
+HttpResponse httpRequest(WebRequestMethod method, const std::string &url,
+                         const std::map<std::string, std::string> &form,
+                         const std::map<std::string, std::string> &headers) {
+  LibraryScope inLibrary;
+  HttpResponse result;
+  internal::runOnTcpTask([&] {
+    AsyncWebServer *server = nullptr;
+    {
+      std::lock_guard<std::recursive_mutex> lock(library().mutex);
+      for (auto *candidate : library().servers) {
+        if (candidate->started()) {
+          server = candidate;
+        }
+      }
+    }
+    if (server == nullptr) {
+      return;
+    }
+
+    auto request = std::unique_ptr<AsyncWebServerRequest>(
+        new AsyncWebServerRequest(method, String(url)));
+    for (const auto &entry : form) {
+      request->addParam(String(entry.first), String(entry.second), true);
+    }
+    for (const auto &entry : headers) {
+      request->addHeader(String(entry.first), String(entry.second));
+    }
+    server->handle(request.get());
+
+    AsyncWebServerResponse *response = request->response();
+    if (response == nullptr) {
+      // The handler may answer later; keep the request alive like the library.
+      std::lock_guard<std::recursive_mutex> lock(library().mutex);
+      library().unansweredRequests.push_back(std::move(request));
+      return;
+    }
+    result.code = response->code();
+    result.contentType = response->contentType().str();
+    for (const auto &header : response->headers()) {
+      result.headers.emplace_back(header.name().str(), header.value().str());
+    }
+    result.body = response->render(kTcpChunkBytes);
+  });
+  return result;
+}
+
+uint32_t connectWebSocket(const std::string &url) {
+  LibraryScope inLibrary;
+  const std::string path = url.substr(0, url.find('?'));
+  AsyncWebSocket *socket = findWebSocket(path);
+  if (socket == nullptr) {
+    return 0;
+  }
+  uint32_t id = 0;
+  internal::runOnTcpTask([&] {
+    AsyncWebServerRequest request(HTTP_GET, String(url));
+    request.addHeader("Upgrade", "websocket");
+    id = socket->connect(&request);
+  });
+  return id;
+}
+
+void sendWebSocketText(uint32_t client, const std::string &text) {
+  LibraryScope inLibrary;
+  AsyncWebSocket *socket = nullptr;
+  if (findClient(client, &socket) == nullptr) {
+    return;
+  }
+  internal::runOnTcpTask([&] {
+    socket->receive(client, WS_TEXT, reinterpret_cast<const uint8_t *>(text.data()), text.size());
+  });
+}
+
+void sendWebSocketBinary(uint32_t client, const std::vector<uint8_t> &data) {
+  LibraryScope inLibrary;
+  AsyncWebSocket *socket = nullptr;
+  if (findClient(client, &socket) == nullptr) {
+    return;
+  }
+  internal::runOnTcpTask([&] { socket->receive(client, WS_BINARY, data.data(), data.size()); });
+}
+
+void disconnectWebSocket(uint32_t client) {
+  LibraryScope inLibrary;
+  AsyncWebSocket *socket = nullptr;
+  if (findClient(client, &socket) == nullptr) {
+    return;
+  }
+  internal::runOnTcpTask([&] { socket->disconnect(client); });
+}
+
+void stallWebSocket(uint32_t client, bool stalled) {
+  LibraryScope inLibrary;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  if (AsyncWebSocketClient *found = findClient(client)) {
+    found->setStalled(stalled);
+  }
+}
+
+std::vector<WebSocketMessage> takeWebSocketMessages(uint32_t client) {
+  LibraryScope inLibrary;
+  std::vector<WebSocketMessage> messages;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  AsyncWebSocketClient *found = findClient(client);
+  if (found == nullptr) {
+    return messages;
+  }
+  for (auto &delivered : found->takeDelivered()) {
+    messages.push_back(WebSocketMessage{delivered.first, std::move(delivered.second)});
+  }
+  return messages;
+}
+
+bool webSocketConnected(uint32_t client) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  AsyncWebSocketClient *found = findClient(client);
+  return found != nullptr && found->status() == WS_CONNECTED;
+}
+
+uint32_t webSocketDropped(uint32_t client) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  AsyncWebSocketClient *found = findClient(client);
+  return found != nullptr ? found->dropped() : 0U;
+}
+
+size_t webSocketBuffers() {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  size_t buffers = 0;
+  for (auto *socket : library().webSockets) {
+    buffers += socket->bufferCount();
+  }
+  return buffers;
+}
+
+void failWebSocketBuffers(uint32_t count) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  library().failBuffers = count;
+}
+
+}  // namespace sim
+
+// ── AsyncUDP ───────────────────────────────────────────────────────────────
+
+AsyncUDP::AsyncUDP() {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  library().udpSockets.push_back(this);
+}
+
+AsyncUDP::~AsyncUDP() {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  library().udpSockets.erase(std::remove(library().udpSockets.begin(), library().udpSockets.end(), this), library().udpSockets.end());
+}
+
+bool AsyncUDP::listenMulticast(const IPAddress &, uint16_t port, uint8_t) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  listening_ = true;
+  port_ = port;
+  return true;
+}
+
+size_t AsyncUDP::writeTo(const uint8_t *data, size_t length, const IPAddress &address,
+                         uint16_t port) {
+  sim::LibraryScope inLibrary;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  sim::UdpPacket packet;
+  packet.address = address;
+  packet.port = port;
+  packet.data.assign(data, data + length);
+  library().udpSent.push_back(std::move(packet));
+  return length;
+}
+
+// ── Requests and responses ─────────────────────────────────────────────────
+
+std::string AsyncWebServerResponse::render(size_t chunkSize) {
+  sim::LibraryScope inLibrary;
+  if (!filler_) {
+    return content_;
+  }
+  std::string body;
+  std::vector<uint8_t> chunk(chunkSize);
+  size_t retries = 0;
+  for (;;) {
+    const size_t room = chunked_ ? chunkSize : std::min(chunkSize, fillerLength_ - body.size());
+    if (!chunked_ && room == 0U) {
+      break;
+    }
+    size_t produced = 0;
+    {
+      sim::FirmwareScope firmware;
+      produced = filler_(chunk.data(), room, body.size());
+    }
+    if (produced == RESPONSE_TRY_AGAIN) {
+      if (++retries > 1000U) {
+        break;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    if (produced == 0U) {
+      break;
+    }
+    body.append(reinterpret_cast<const char *>(chunk.data()), std::min(produced, room));
+  }
+  return body;
+}
+
+AsyncWebServerRequest::AsyncWebServerRequest(WebRequestMethod method, const String &url)
+    : method_(static_cast<WebRequestMethodComposite>(method)) {
+  sim::LibraryScope inLibrary;
+  const std::string &full = url.str();
+  const size_t query = full.find('?');
+  url_ = String(urlDecode(full.substr(0, query)));
+  if (query == std::string::npos) {
+    return;
+  }
+  std::string rest = full.substr(query + 1U);
+  while (!rest.empty()) {
+    const size_t end = rest.find('&');
+    const std::string pair = rest.substr(0, end);
+    const size_t equals = pair.find('=');
+    addParam(String(urlDecode(pair.substr(0, equals))),
+             String(equals == std::string::npos ? std::string() : urlDecode(pair.substr(equals + 1U))),
+             false);
+    if (end == std::string::npos) {
+      break;
+    }
+    rest.erase(0, end + 1U);
+  }
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+  sim::LibraryScope inLibrary;
+  if (onDisconnect_) {
+    sim::FirmwareScope firmware;
+    onDisconnect_();
+  }
+  params_.clear();
+  headers_.clear();
+  responses_.clear();
+}
+
+bool AsyncWebServerRequest::hasParam(const String &name, bool post, bool file) const {
+  return getParam(name, post, file) != nullptr;
+}
+
+AsyncWebParameter *AsyncWebServerRequest::getParam(const String &name, bool post, bool file) const {
+  for (const auto &param : params_) {
+    if (param->name() == name && param->isPost() == post && param->isFile() == file) {
+      return param.get();
+    }
+  }
+  return nullptr;
+}
+
+bool AsyncWebServerRequest::hasHeader(const String &name) const {
+  return getHeader(name) != nullptr;
+}
+
+AsyncWebHeader *AsyncWebServerRequest::getHeader(const String &name) const {
+  for (const auto &header : headers_) {
+    if (equalsIgnoreCase(header->name(), name)) {
+      return header.get();
+    }
+  }
+  return nullptr;
+}
+
+namespace {
+
+AsyncWebServerResponse *withDefaultHeaders(AsyncWebServerResponse *response) {
+  for (const auto &header : DefaultHeaders::Instance().headers()) {
+    response->addHeader(header.name(), header.value());
+  }
+  return response;
+}
+
+}  // namespace
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(int code, const String &contentType,
+                                                             const String &content) {
+  sim::LibraryScope inLibrary;
+  auto *response = new AsyncWebServerResponse(code, contentType);
+  response->content_ = content.str();
+  responses_.emplace_back(response);
+  return withDefaultHeaders(response);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(fs::FS &fs, const String &path,
+                                                             const String &contentType, bool) {
+  sim::LibraryScope inLibrary;
+  fs::File file = fs.open(path.c_str(), "r");
+  auto *response = new AsyncWebServerResponse(file ? 200 : 404, contentType);
+  if (file) {
+    std::string contents(file.size(), '\0');
+    file.read(reinterpret_cast<uint8_t *>(&contents[0]), contents.size());
+    response->content_ = contents;
+  }
+  responses_.emplace_back(response);
+  return withDefaultHeaders(response);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(const String &contentType,
+                                                             size_t length,
+                                                             AwsResponseFiller callback) {
+  sim::LibraryScope inLibrary;
+  auto *response = new AsyncWebServerResponse(200, contentType);
+  response->filler_ = std::move(callback);
+  response->fillerLength_ = length;
+  responses_.emplace_back(response);
+  return withDefaultHeaders(response);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse_P(int code, const String &contentType,
+                                                               const uint8_t *content,
+                                                               size_t length) {
+  sim::LibraryScope inLibrary;
+  auto *response = new AsyncWebServerResponse(code, contentType);
+  response->content_.assign(reinterpret_cast<const char *>(content), length);
+  responses_.emplace_back(response);
+  return withDefaultHeaders(response);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginChunkedResponse(const String &contentType,
+                                                                    AwsResponseFiller callback) {
+  sim::LibraryScope inLibrary;
+  auto *response = new AsyncWebServerResponse(200, contentType);
+  response->filler_ = std::move(callback);
+  response->chunked_ = true;
+  responses_.emplace_back(response);
+  return withDefaultHeaders(response);
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse *response) {
+  if (sent_ == nullptr) {
+    sent_ = response;
+  }
+}
+
+void AsyncWebServerRequest::send(int code, const String &contentType, const String &content) {
+  send(beginResponse(code, contentType, content));
+}
+
+// ── Handlers and server ────────────────────────────────────────────────────
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest *request) {
+  if ((method_ & request->method()) == 0U) {
+    return false;
+  }
+  const std::string &uri = uri_.str();
+  const std::string &url = request->url().str();
+  if (!uri.empty() && uri.back() == '*') {
+    return url.compare(0, uri.size() - 1U, uri, 0, uri.size() - 1U) == 0;
+  }
+  return url == uri || url.rfind(uri + "/", 0) == 0;
+}
+
+String AsyncStaticWebHandler::filePath(const AsyncWebServerRequest *request) const {
+  std::string path = path_.str();
+  std::string rest = request->url().str().substr(uri_.length());
+  if (!path.empty() && path.back() == '/' && !rest.empty() && rest[0] == '/') {
+    rest.erase(0, 1);
+  }
+  path += rest;
+  if (path.empty() || path.back() == '/') {
+    path += defaultFile_.str();
+  }
+  return String(path);
+}
+
+bool AsyncStaticWebHandler::canHandle(AsyncWebServerRequest *request) {
+  if (request->method() != HTTP_GET || !request->url().startsWith(uri_.c_str())) {
+    return false;
+  }
+  return fs_.exists(filePath(request).c_str());
+}
+
+void AsyncStaticWebHandler::handleRequest(AsyncWebServerRequest *request) {
+  AsyncWebServerResponse *response = request->beginResponse(fs_, filePath(request));
+  if (!cacheControl_.isEmpty()) {
+    response->addHeader("Cache-Control", cacheControl_);
+  }
+  request->send(response);
+}
+
+AsyncWebServer::AsyncWebServer(uint16_t) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  library().servers.push_back(this);
+}
+
+AsyncWebServer::~AsyncWebServer() {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  library().servers.erase(std::remove(library().servers.begin(), library().servers.end(), this), library().servers.end());
+}
+
+AsyncCallbackWebHandler &AsyncWebServer::on(const char *uri, WebRequestMethodComposite method,
+                                            ArRequestHandlerFunction handler) {
+  sim::LibraryScope inLibrary;
+  auto *created = new AsyncCallbackWebHandler(uri, method, std::move(handler));
+  owned_.emplace_back(created);
+  handlers_.push_back(created);
+  return *created;
+}
+
+AsyncStaticWebHandler &AsyncWebServer::serveStatic(const char *uri, fs::FS &fs, const char *path,
+                                                   const char *cacheControl) {
+  sim::LibraryScope inLibrary;
+  auto *created = new AsyncStaticWebHandler(uri, fs, path, cacheControl);
+  owned_.emplace_back(created);
+  handlers_.push_back(created);
+  return *created;
+}
+
+AsyncWebHandler &AsyncWebServer::addHandler(AsyncWebHandler *handler) {
+  sim::LibraryScope inLibrary;
+  handlers_.push_back(handler);
+  return *handler;
+}
+
+void AsyncWebServer::handle(AsyncWebServerRequest *request) {
+  sim::LibraryScope inLibrary;
+  for (auto *handler : handlers_) {
+    if (handler->canHandle(request)) {
+      sim::FirmwareScope firmware;
+      handler->handleRequest(request);
+      return;
+    }
+  }
+  if (notFound_) {
+    sim::FirmwareScope firmware;
+    notFound_(request);
+    return;
+  }
+  request->send(404);
+}
+
+DefaultHeaders &DefaultHeaders::Instance() {
+  static auto *instance = new DefaultHeaders();
+  return *instance;
+}
+
+// ── WebSocket ──────────────────────────────────────────────────────────────
+
+AsyncWebSocketMessageBuffer::AsyncWebSocketMessageBuffer(size_t size)
+    : data_(new uint8_t[size + 1U]), length_(size) {
+  data_[size] = 0;
+}
+
+AsyncWebSocketMessageBuffer::~AsyncWebSocketMessageBuffer() {
+  sim::LibraryScope inLibrary;
+  delete[] data_;
+}
+
+AsyncWebSocketClient::~AsyncWebSocketClient() {
+  sim::LibraryScope inLibrary;
+  for (auto &message : queue_) {
+    if (message.shared != nullptr) {
+      (*message.shared)--;
+    }
+  }
+}
+
+void AsyncWebSocketClient::queueMessage(Message &&message) {
+  if (status_ != WS_CONNECTED) {
+    if (message.shared != nullptr) {
+      (*message.shared)--;
+    }
+    return;
+  }
+  if (queue_.size() >= WS_MAX_QUEUED_MESSAGES) {
+    ++dropped_;  // "ERROR: Too many messages queued"
+    if (message.shared != nullptr) {
+      (*message.shared)--;
+    }
+    return;
+  }
+  queue_.push_back(std::move(message));
+  if (!stalled_) {
+    deliverQueued();
+  }
+}
+
+void AsyncWebSocketClient::text(const char *message, size_t length) {
+  sim::LibraryScope inLibrary;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  Message queued;
+  queued.owned.assign(message, length);  // AsyncWebSocketBasicMessage copies
+  queueMessage(std::move(queued));
+}
+
+void AsyncWebSocketClient::text(AsyncWebSocketMessageBuffer *buffer) {
+  if (buffer == nullptr) {
+    return;
+  }
+  sim::LibraryScope inLibrary;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  Message queued;
+  queued.shared = buffer;
+  (*buffer)++;
+  queueMessage(std::move(queued));
+}
+
+void AsyncWebSocketClient::binary(const uint8_t *message, size_t length) {
+  sim::LibraryScope inLibrary;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  Message queued;
+  queued.binary = true;
+  queued.owned.assign(reinterpret_cast<const char *>(message), length);
+  queueMessage(std::move(queued));
+}
+
+void AsyncWebSocketClient::binary(AsyncWebSocketMessageBuffer *buffer) {
+  if (buffer == nullptr) {
+    return;
+  }
+  sim::LibraryScope inLibrary;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  Message queued;
+  queued.binary = true;
+  queued.shared = buffer;
+  (*buffer)++;
+  queueMessage(std::move(queued));
+}
+
+void AsyncWebSocketClient::close(uint16_t, const char *) {
+  {
+    std::lock_guard<std::recursive_mutex> lock(library().mutex);
+    if (status_ != WS_CONNECTED) {
+      return;
+    }
+    status_ = WS_DISCONNECTING;
+  }
+  // The peer's close frame comes back through the TCP task.
+  AsyncWebSocket *server = server_;
+  sim::internal::runOnTcpTask([server] { server->processClosing(); }, false);
+}
+
+void AsyncWebSocketClient::setStalled(bool stalled) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  stalled_ = stalled;
+  if (!stalled_) {
+    deliverQueued();
+  }
+}
+
+void AsyncWebSocketClient::deliverQueued() {
+  sim::LibraryScope inLibrary;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  while (!queue_.empty()) {
+    Message &message = queue_.front();
+    if (message.shared != nullptr) {
+      delivered_.emplace_back(message.binary,
+                              std::string(reinterpret_cast<const char *>(message.shared->get()),
+                                          message.shared->length()));
+      (*message.shared)--;
+    } else {
+      delivered_.emplace_back(message.binary, std::move(message.owned));
+    }
+    ++deliveredCount_;
+    queue_.pop_front();
+  }
+}
+
+AsyncWebSocket::AsyncWebSocket(const String &url) : url_(url) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  library().webSockets.push_back(this);
+}
+
+AsyncWebSocket::~AsyncWebSocket() {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  library().webSockets.erase(std::remove(library().webSockets.begin(), library().webSockets.end(), this), library().webSockets.end());
+  clients_.clear();
+  for (auto *buffer : buffers_) {
+    delete buffer;
+  }
+}
+
+size_t AsyncWebSocket::count() const {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  return static_cast<size_t>(std::count_if(
+      clients_.begin(), clients_.end(),
+      [](const std::unique_ptr<AsyncWebSocketClient> &client) { return client->status() == WS_CONNECTED; }));
+}
+
+AsyncWebSocketClient *AsyncWebSocket::client(uint32_t id) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  AsyncWebSocketClient *found = anyClient(id);
+  return found != nullptr && found->status() == WS_CONNECTED ? found : nullptr;
+}
+
+AsyncWebSocketClient *AsyncWebSocket::anyClient(uint32_t id) {
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  for (auto &client : clients_) {
+    if (client->id() == id) {
+      return client.get();
+    }
+  }
+  return nullptr;
+}
+
+void AsyncWebSocket::textAll(const char *message, size_t length) {
+  AsyncWebSocketMessageBuffer *buffer = makeBuffer(length);
+  if (buffer == nullptr) {
+    return;
+  }
+  memcpy(buffer->get(), message, length);
+  textAll(buffer);
+}
+
+void AsyncWebSocket::textAll(AsyncWebSocketMessageBuffer *buffer) {
+  if (buffer == nullptr) {
+    return;
+  }
+  {
+    sim::LibraryScope inLibrary;
+    std::lock_guard<std::recursive_mutex> lock(library().mutex);
+    buffer->lock();
+    for (auto &client : clients_) {
+      if (client->status() == WS_CONNECTED) {
+        client->text(buffer);
+      }
+    }
+    buffer->unlock();
+  }
+  _cleanBuffers();
+}
+
+AsyncWebSocketMessageBuffer *AsyncWebSocket::makeBuffer(size_t size) {
+  sim::LibraryScope inLibrary;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  if (library().failBuffers > 0U) {
+    --library().failBuffers;
+    return nullptr;
+  }
+  auto *buffer = new AsyncWebSocketMessageBuffer(size);
+  buffers_.push_back(buffer);
+  return buffer;
+}
+
+void AsyncWebSocket::_cleanBuffers() {
+  sim::LibraryScope inLibrary;
+  std::lock_guard<std::recursive_mutex> lock(library().mutex);
+  for (auto it = buffers_.begin(); it != buffers_.end();) {
+    if ((*it)->canDelete()) {
+      delete *it;
+      it = buffers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void AsyncWebSocket::cleanupClients(uint16_t maxClients) {
+  AsyncWebSocketClient *oldest = nullptr;
+  {
+    std::lock_guard<std::recursive_mutex> lock(library().mutex);
+    if (count() <= maxClients) {
+      return;
+    }
+    for (auto &client : clients_) {
+      if (client->status() == WS_CONNECTED) {
+        oldest = client.get();
+        break;
+      }
+    }
+  }
+  if (oldest != nullptr) {
+    oldest->close();
+  }
+}
+
+bool AsyncWebSocket::canHandle(AsyncWebServerRequest *request) {
+  return request->method() == HTTP_GET && request->url() == url_ && request->hasHeader("Upgrade");
+}
+
+void AsyncWebSocket::handleRequest(AsyncWebServerRequest *request) {
+  connect(request);
+}
+
+uint32_t AsyncWebSocket::connect(AsyncWebServerRequest *request) {
+  AsyncWebSocketClient *client = nullptr;
+  {
+    sim::LibraryScope inLibrary;
+    std::lock_guard<std::recursive_mutex> lock(library().mutex);
+    clients_.emplace_back(new AsyncWebSocketClient(this, library().nextClientId++));
+    client = clients_.back().get();
+  }
+  if (handler_) {
+    sim::FirmwareScope firmware;
+    handler_(this, client, WS_EVT_CONNECT, request, nullptr, 0);
+  }
+  return client->id();
+}
+
+void AsyncWebSocket::receive(uint32_t id, uint8_t opcode, const uint8_t *data, size_t length) {
+  processClosing();
+  AsyncWebSocketClient *found = client(id);
+  if (found == nullptr || !handler_) {
+    return;
+  }
+  // The library hands over its receive buffer, terminated for text frames.
+  std::vector<uint8_t> frame(data, data + length);
+  frame.push_back(0);
+  AwsFrameInfo info{};
+  info.message_opcode = opcode;
+  info.opcode = opcode;
+  info.final = 1;
+  info.len = length;
+  info.index = 0;
+  sim::FirmwareScope firmware;
+  handler_(this, found, WS_EVT_DATA, &info, frame.data(), length);
+}
+
+void AsyncWebSocket::disconnect(uint32_t id) {
+  AsyncWebSocketClient *found = anyClient(id);
+  if (found == nullptr || found->status() == WS_DISCONNECTED) {
+    return;
+  }
+  {
+    std::lock_guard<std::recursive_mutex> lock(library().mutex);
+    found->markDisconnected();
+  }
+  if (handler_) {
+    sim::FirmwareScope firmware;
+    handler_(this, found, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+  }
+  // Clients stay allocated so that stale pointers held elsewhere never
+  // dangle; client(id) stops returning them.
+}
+
+void AsyncWebSocket::processClosing() {
+  std::vector<uint32_t> closing;
+  {
+    std::lock_guard<std::recursive_mutex> lock(library().mutex);
+    for (auto &client : clients_) {
+      if (client->status() == WS_DISCONNECTING) {
+        closing.push_back(client->id());
+      }
+    }
+  }
+  for (uint32_t id : closing) {
+    disconnect(id);
+  }
+}
@@ -0,0 +1,407 @@
+// NVS, Preferences and the LittleFS partition of the simulated ESP32.
+
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <esp_system.h>
+#include <nvs.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "sim.h"
+
+namespace {
+
+using Namespace = std::map<std::string, std::string>;
+
+std::recursive_mutex gNvsMutex;
+std::map<std::string, Namespace> gNvs;
+uint32_t gNvsCommits = 0;
+uint32_t gFailNvsWrites = 0;
+uint32_t gFailNvsCommits = 0;
+
+struct NvsHandle {
+  std::string space;
+  Namespace pending;
+  bool writable = false;
+};
+
+std::vector<NvsHandle> gNvsHandles;  // handle n is gNvsHandles[n - 1]
+std::vector<shutdown_handler_t> gShutdownHandlers;
+
+NvsHandle *findHandle(nvs_handle_t handle) {
+  if (handle == 0U || handle > gNvsHandles.size()) {
+    return nullptr;
+  }
+  return &gNvsHandles[handle - 1U];
+}
+
+// Reads see staged writes first, as the NVS page cache does.
+const std::string *lookup(const std::string &space, const Namespace *pending, const char *key) {
+  if (pending != nullptr) {
+    const auto staged = pending->find(key);
+    if (staged != pending->end()) {
+      return &staged->second;
+    }
+  }
+  const auto found = gNvs.find(space);
+  if (found == gNvs.end()) {
+    return nullptr;
+  }
+  const auto value = found->second.find(key);
+  return value == found->second.end() ? nullptr : &value->second;
+}
+
+std::mutex gFsMutex;
+std::map<std::string, std::shared_ptr<const std::string>> gFiles;
+bool gFsMountable = true;
+uint32_t gFileOpens = 0;
+
+std::string normalizePath(const char *path) {
+  std::string normalized = path != nullptr ? path : "";
+  if (normalized.empty() || normalized[0] != '/') {
+    normalized.insert(normalized.begin(), '/');
+  }
+  return normalized;
+}
+
+}  // namespace
+
+namespace sim {
+
+uint32_t nvsCommits() {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  return gNvsCommits;
+}
+
+void failNvsWrites(uint32_t count) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  gFailNvsWrites = count;
+}
+
+void failNvsCommits(uint32_t count) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  gFailNvsCommits = count;
+}
+
+bool nvsHasKey(const char *space, const char *key) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  return lookup(space, nullptr, key) != nullptr;
+}
+
+std::string nvsValue(const char *space, const char *key) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  const std::string *value = lookup(space, nullptr, key);
+  return value != nullptr ? *value : std::string();
+}
+
+void nvsErase() {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  gNvs.clear();
+  for (auto &handle : gNvsHandles) {
+    handle.pending.clear();
+  }
+}
+
+void runShutdownHandlers() {
+  std::vector<shutdown_handler_t> handlers;
+  {
+    std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+    handlers = gShutdownHandlers;
+  }
+  for (auto handler : handlers) {
+    handler();
+  }
+}
+
+void writeFile(const char *path, const std::string &contents) {
+  std::lock_guard<std::mutex> lock(gFsMutex);
+  gFiles[normalizePath(path)] = std::make_shared<const std::string>(contents);
+}
+
+void removeFile(const char *path) {
+  std::lock_guard<std::mutex> lock(gFsMutex);
+  gFiles.erase(normalizePath(path));
+}
+
+void setFilesystemMountable(bool mountable) {
+  std::lock_guard<std::mutex> lock(gFsMutex);
+  gFsMountable = mountable;
+}
+
+uint32_t fileOpens() {
+  std::lock_guard<std::mutex> lock(gFsMutex);
+  return gFileOpens;
+}
+
+}  // namespace sim
+
+// ── ESP-IDF NVS ────────────────────────────────────────────────────────────
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle) {
+  if (name == nullptr || handle == nullptr) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  NvsHandle opened;
+  opened.space = name;
+  opened.writable = mode == NVS_READWRITE;
+  gNvsHandles.push_back(opened);
+  *handle = static_cast<nvs_handle_t>(gNvsHandles.size());
+  return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out, size_t *length) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  NvsHandle *opened = findHandle(handle);
+  if (opened == nullptr || key == nullptr || length == nullptr) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const std::string *value = lookup(opened->space, &opened->pending, key);
+  if (value == nullptr) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  const size_t required = value->size() + 1U;
+  if (out == nullptr) {
+    *length = required;
+    return ESP_OK;
+  }
+  if (*length < required) {
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+  memcpy(out, value->c_str(), required);
+  *length = required;
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  NvsHandle *opened = findHandle(handle);
+  if (opened == nullptr || key == nullptr || value == nullptr) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (!opened->writable) {
+    return ESP_FAIL;
+  }
+  if (gFailNvsWrites > 0U) {
+    --gFailNvsWrites;
+    return ESP_FAIL;
+  }
+  opened->pending[key] = value;
+  return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  NvsHandle *opened = findHandle(handle);
+  if (opened == nullptr) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (gFailNvsCommits > 0U) {
+    --gFailNvsCommits;
+    opened->pending.clear();
+    return ESP_FAIL;
+  }
+  Namespace &space = gNvs[opened->space];
+  for (auto &entry : opened->pending) {
+    space[entry.first] = entry.second;
+  }
+  opened->pending.clear();
+  ++gNvsCommits;
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  if (NvsHandle *opened = findHandle(handle)) {
+    opened->pending.clear();
+  }
+}
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  gShutdownHandlers.push_back(handler);
+  return ESP_OK;
+}
+
+void esp_restart() {
+  ESP.restart();
+}
+
+// ── Preferences ────────────────────────────────────────────────────────────
+// Every put commits straight away, as the Arduino wrapper does.
+
+bool Preferences::begin(const char *name, bool readOnly) {
+  if (name == nullptr) {
+    return false;
+  }
+  namespace_ = name;
+  readOnly_ = readOnly;
+  open_ = true;
+  return true;
+}
+
+void Preferences::end() {
+  open_ = false;
+}
+
+bool Preferences::isKey(const char *key) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  return open_ && lookup(namespace_, nullptr, key) != nullptr;
+}
+
+bool Preferences::remove(const char *key) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  if (!open_ || readOnly_) {
+    return false;
+  }
+  const bool removed = gNvs[namespace_].erase(key) > 0U;
+  ++gNvsCommits;
+  return removed;
+}
+
+bool Preferences::clear() {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  if (!open_ || readOnly_) {
+    return false;
+  }
+  gNvs[namespace_].clear();
+  ++gNvsCommits;
+  return true;
+}
+
+size_t Preferences::putString(const char *key, const char *value) {
+  if (value == nullptr) {
+    return 0;
+  }
+  return putBytes(key, value, strlen(value));
+}
+
+size_t Preferences::getString(const char *key, char *value, size_t maxLength) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  const std::string *stored = open_ ? lookup(namespace_, nullptr, key) : nullptr;
+  if (stored == nullptr || value == nullptr || maxLength < stored->size() + 1U) {
+    return 0;
+  }
+  memcpy(value, stored->c_str(), stored->size() + 1U);
+  return stored->size() + 1U;
+}
+
+String Preferences::getString(const char *key, const String &defaultValue) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  const std::string *stored = open_ ? lookup(namespace_, nullptr, key) : nullptr;
+  return stored != nullptr ? String(*stored) : defaultValue;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t length) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  if (!open_ || readOnly_ || key == nullptr || value == nullptr) {
+    return 0;
+  }
+  gNvs[namespace_][key].assign(static_cast<const char *>(value), length);
+  ++gNvsCommits;
+  return length;
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t maxLength) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  const std::string *stored = open_ ? lookup(namespace_, nullptr, key) : nullptr;
+  if (stored == nullptr || buffer == nullptr || stored->size() > maxLength) {
+    return 0;
+  }
+  memcpy(buffer, stored->data(), stored->size());
+  return stored->size();
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+  std::lock_guard<std::recursive_mutex> lock(gNvsMutex);
+  const std::string *stored = open_ ? lookup(namespace_, nullptr, key) : nullptr;
+  return stored != nullptr ? stored->size() : 0U;
+}
+
+size_t Preferences::putUChar(const char *key, uint8_t value) {
+  return putBytes(key, &value, sizeof(value));
+}
+
+uint8_t Preferences::getUChar(const char *key, uint8_t defaultValue) {
+  uint8_t value = defaultValue;
+  return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value) {
+  return putBytes(key, &value, sizeof(value));
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue) {
+  uint32_t value = defaultValue;
+  return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+// ── LittleFS ───────────────────────────────────────────────────────────────
+
+LittleFSFS LittleFS;
+
+bool LittleFSFS::begin(bool) {
+  std::lock_guard<std::mutex> lock(gFsMutex);
+  return gFsMountable;
+}
+
+namespace fs {
+
+File::File(std::shared_ptr<const std::string> contents, const char *name)
+    : contents_(std::move(contents)), name_(name != nullptr ? name : "") {}
+
+int File::read() {
+  if (contents_ == nullptr || position_ >= contents_->size()) {
+    return -1;
+  }
+  return static_cast<uint8_t>((*contents_)[position_++]);
+}
+
+size_t File::read(uint8_t *buffer, size_t length) {
+  if (contents_ == nullptr || buffer == nullptr) {
+    return 0;
+  }
+  const size_t count = std::min(length, contents_->size() - position_);
+  memcpy(buffer, contents_->data() + position_, count);
+  position_ += count;
+  return count;
+}
+
+bool File::seek(uint32_t position) {
+  if (contents_ == nullptr || position > contents_->size()) {
+    return false;
+  }
+  position_ = position;
+  return true;
+}
+
+File FS::open(const char *path, const char *mode) {
+  if (mode != nullptr && mode[0] != 'r') {
+    return File();  // the simulated partition is written by tests only
+  }
+  std::lock_guard<std::mutex> lock(gFsMutex);
+  const std::string normalized = normalizePath(path);
+  const auto found = gFiles.find(normalized);
+  if (found == gFiles.end()) {
+    return File();
+  }
+  ++gFileOpens;
+  return File(found->second, normalized.c_str());
+}
+
+bool FS::exists(const char *path) {
+  std::lock_guard<std::mutex> lock(gFsMutex);
+  return gFiles.count(normalizePath(path)) > 0U;
+}
+
+bool FS::remove(const char *path) {
+  std::lock_guard<std::mutex> lock(gFsMutex);
+  return gFiles.erase(normalizePath(path)) > 0U;
+}
+
+}  // namespace fs
@@ -0,0 +1,394 @@
+// Station, scanner and soft-AP of the simulated ESP32 radio.
+
+#include <WiFi.h>
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "sim.h"
+#include "sim_internal.h"
+
+namespace {
+
+// Association plus DHCP on a known channel and BSSID, versus a full
+// all-channel scan first.
+constexpr uint64_t kJoinKnownUs = 250000U;
+constexpr uint64_t kJoinScanUs = 2300000U;
+constexpr uint64_t kJoinFailKnownUs = 1200000U;
+constexpr uint64_t kJoinFailScanUs = 2200000U;
+constexpr uint64_t kBeaconLossUs = 2000000U;
+constexpr uint64_t kScanUs = 2000000U;
+constexpr uint64_t kNone = UINT64_MAX;
+
+struct PendingEvent {
+  uint64_t atUs;
+  arduino_event_id_t id;
+  uint8_t reason;
+};
+
+std::recursive_mutex gRadioMutex;
+std::vector<sim::AccessPoint> gAccessPoints;
+std::vector<PendingEvent> gEvents;
+WiFiEventFuncCb gCallback = nullptr;
+wifi_mode_t gMode = WIFI_MODE_NULL;
+bool gSoftAp = false;
+
+int gConnected = -1;
+bool gJoining = false;
+uint64_t gJoinDoneUs = 0;
+int gJoinTarget = -1;
+uint64_t gLinkLostUs = kNone;  // beacons stopped; drop reported at this time
+
+bool gScanning = false;
+uint64_t gScanDoneUs = 0;
+std::vector<int> gScanResults;
+
+IPAddress stationAddress() {
+  return IPAddress(192, 168, 1, 50);
+}
+
+void queueEvent(uint64_t atUs, arduino_event_id_t id, uint8_t reason) {
+  gEvents.push_back(PendingEvent{atUs, id, reason});
+}
+
+// Advances the radio state machine to `now`; returns the events now due.
+std::vector<PendingEvent> collectDue(uint64_t now) {
+  if (gJoining && now >= gJoinDoneUs) {
+    gJoining = false;
+    if (gJoinTarget >= 0 && gAccessPoints[static_cast<size_t>(gJoinTarget)].up) {
+      gConnected = gJoinTarget;
+      queueEvent(gJoinDoneUs, ARDUINO_EVENT_WIFI_STA_GOT_IP, 0);
+    } else {
+      queueEvent(gJoinDoneUs, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_NO_AP_FOUND);
+    }
+  }
+
+  if (gConnected >= 0 && !gAccessPoints[static_cast<size_t>(gConnected)].up) {
+    if (gLinkLostUs == kNone) {
+      gLinkLostUs = now + kBeaconLossUs;
+    } else if (now >= gLinkLostUs) {
+      gConnected = -1;
+      queueEvent(gLinkLostUs, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_BEACON_TIMEOUT);
+      gLinkLostUs = kNone;
+    }
+  } else {
+    gLinkLostUs = kNone;
+  }
+
+  std::vector<PendingEvent> due;
+  for (size_t i = 0; i < gEvents.size();) {
+    if (gEvents[i].atUs <= now) {
+      due.push_back(gEvents[i]);
+      gEvents.erase(gEvents.begin() + static_cast<std::ptrdiff_t>(i));
+    } else {
+      ++i;
+    }
+  }
+  return due;
+}
+
+void raise(const std::vector<PendingEvent> &due) {
+  WiFiEventFuncCb callback = nullptr;
+  {
+    std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+    callback = gCallback;
+  }
+  if (callback == nullptr) {
+    return;
+  }
+  for (const auto &event : due) {
+    arduino_event_info_t info{};
+    info.wifi_sta_disconnected.reason = event.reason;
+    callback(event.id, info);
+  }
+}
+
+const sim::AccessPoint *connectedAp() {
+  return gConnected >= 0 ? &gAccessPoints[static_cast<size_t>(gConnected)] : nullptr;
+}
+
+const sim::AccessPoint *scanResult(uint8_t index) {
+  if (index >= gScanResults.size()) {
+    return nullptr;
+  }
+  return &gAccessPoints[static_cast<size_t>(gScanResults[index])];
+}
+
+}  // namespace
+
+namespace sim {
+
+size_t addAccessPoint(const AccessPoint &ap) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  gAccessPoints.push_back(ap);
+  return gAccessPoints.size() - 1U;
+}
+
+void setAccessPointUp(size_t index, bool up) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  if (index < gAccessPoints.size()) {
+    gAccessPoints[index].up = up;
+  }
+}
+
+void setAccessPointRssi(size_t index, int32_t rssi) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  if (index < gAccessPoints.size()) {
+    gAccessPoints[index].rssi = rssi;
+  }
+}
+
+int connectedAccessPoint() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  return gConnected;
+}
+
+bool softApActive() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  return gSoftAp;
+}
+
+void serviceWifi() {
+  std::vector<PendingEvent> due;
+  {
+    std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+    due = collectDue(nowMicros());
+  }
+  raise(due);
+}
+
+namespace internal {
+
+uint64_t nextWifiEventMicros() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  uint64_t next = kNone;
+  if (gJoining) {
+    next = std::min(next, gJoinDoneUs);
+  }
+  if (gConnected >= 0 && !gAccessPoints[static_cast<size_t>(gConnected)].up) {
+    // The first look arms beacon loss, the second reports it.
+    next = std::min(next, gLinkLostUs == kNone ? nowMicros() : gLinkLostUs);
+  }
+  for (const auto &event : gEvents) {
+    next = std::min(next, event.atUs);
+  }
+  return next;
+}
+
+}  // namespace internal
+
+}  // namespace sim
+
+WiFiClass WiFi;
+
+wifi_mode_t WiFiClass::getMode() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  return gMode;
+}
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  gMode = mode;
+  if (mode != WIFI_MODE_AP && mode != WIFI_MODE_APSTA) {
+    gSoftAp = false;
+  }
+  return true;
+}
+
+void WiFiClass::persistent(bool) {}
+
+bool WiFiClass::setHostname(const char *) {
+  return true;
+}
+
+void WiFiClass::setSleep(bool) {}
+
+void WiFiClass::setAutoReconnect(bool) {}
+
+int WiFiClass::onEvent(WiFiEventFuncCb callback, arduino_event_id_t) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  gCallback = callback;
+  return 1;
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *, int32_t channel,
+                             const uint8_t *bssid, bool) {
+  // Events are raised later from serviceWifi(), as the event task would.
+  {
+    std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+    const uint64_t now = sim::nowMicros();
+    if (gConnected >= 0) {
+      gConnected = -1;
+      queueEvent(now, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE);
+    }
+    if (gMode == WIFI_MODE_NULL || gMode == WIFI_MODE_AP) {
+      gMode = gMode == WIFI_MODE_AP ? WIFI_MODE_APSTA : WIFI_MODE_STA;
+    }
+
+    int best = -1;
+    for (size_t i = 0; i < gAccessPoints.size(); ++i) {
+      const auto &ap = gAccessPoints[i];
+      if (!ap.up || ssid == nullptr || ap.ssid != ssid) {
+        continue;
+      }
+      if (bssid != nullptr) {
+        if (memcmp(ap.bssid, bssid, sizeof(ap.bssid)) == 0 && ap.channel == channel) {
+          best = static_cast<int>(i);
+        }
+      } else if (best < 0 || ap.rssi > gAccessPoints[static_cast<size_t>(best)].rssi) {
+        best = static_cast<int>(i);
+      }
+    }
+
+    gJoining = true;
+    gJoinTarget = best;
+    if (best >= 0) {
+      gJoinDoneUs = now + (bssid != nullptr ? kJoinKnownUs : kJoinScanUs);
+    } else {
+      gJoinDoneUs = now + (bssid != nullptr ? kJoinFailKnownUs : kJoinFailScanUs);
+    }
+  }
+  return WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool, bool) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  const bool active = gConnected >= 0 || gJoining;
+  gConnected = -1;
+  gJoining = false;
+  gLinkLostUs = kNone;
+  if (active) {
+    queueEvent(sim::nowMicros(), ARDUINO_EVENT_WIFI_STA_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE);
+  }
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  return gConnected >= 0 ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+IPAddress WiFiClass::localIP() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  return gConnected >= 0 ? stationAddress() : IPAddress();
+}
+
+String WiFiClass::SSID() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  const sim::AccessPoint *ap = connectedAp();
+  return ap != nullptr ? String(ap->ssid) : String();
+}
+
+int32_t WiFiClass::RSSI() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  const sim::AccessPoint *ap = connectedAp();
+  return ap != nullptr ? ap->rssi : 0;
+}
+
+uint8_t *WiFiClass::BSSID() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  return gConnected >= 0 ? gAccessPoints[static_cast<size_t>(gConnected)].bssid : nullptr;
+}
+
+int32_t WiFiClass::channel() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  const sim::AccessPoint *ap = connectedAp();
+  return ap != nullptr ? ap->channel : 0;
+}
+
+int16_t WiFiClass::scanNetworks(bool, bool, bool, uint32_t, uint8_t) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  gScanning = true;
+  gScanDoneUs = sim::nowMicros() + kScanUs;
+  gScanResults.clear();
+  return WIFI_SCAN_RUNNING;
+}
+
+int16_t WiFiClass::scanComplete() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  if (!gScanning) {
+    return gScanResults.empty() ? WIFI_SCAN_FAILED : static_cast<int16_t>(gScanResults.size());
+  }
+  if (sim::nowMicros() < gScanDoneUs) {
+    return WIFI_SCAN_RUNNING;
+  }
+  gScanning = false;
+  gScanResults.clear();
+  for (size_t i = 0; i < gAccessPoints.size(); ++i) {
+    if (gAccessPoints[i].up) {
+      gScanResults.push_back(static_cast<int>(i));
+    }
+  }
+  return static_cast<int16_t>(gScanResults.size());
+}
+
+void WiFiClass::scanDelete() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  gScanning = false;
+  gScanResults.clear();
+}
+
+String WiFiClass::SSID(uint8_t index) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  const sim::AccessPoint *ap = scanResult(index);
+  return ap != nullptr ? String(ap->ssid) : String();
+}
+
+int32_t WiFiClass::RSSI(uint8_t index) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  const sim::AccessPoint *ap = scanResult(index);
+  return ap != nullptr ? ap->rssi : 0;
+}
+
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t) {
+  return WIFI_AUTH_WPA2_PSK;
+}
+
+uint8_t *WiFiClass::BSSID(uint8_t index) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  return index < gScanResults.size()
+             ? gAccessPoints[static_cast<size_t>(gScanResults[index])].bssid
+             : nullptr;
+}
+
+int32_t WiFiClass::channel(uint8_t index) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  const sim::AccessPoint *ap = scanResult(index);
+  return ap != nullptr ? ap->channel : 0;
+}
+
+bool WiFiClass::softAP(const char *ssid, const char *) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  if (ssid == nullptr) {
+    return false;
+  }
+  gSoftAp = true;
+  if (gMode == WIFI_MODE_NULL || gMode == WIFI_MODE_STA) {
+    gMode = gMode == WIFI_MODE_STA ? WIFI_MODE_APSTA : WIFI_MODE_AP;
+  }
+  return true;
+}
+
+bool WiFiClass::softAPdisconnect(bool) {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  gSoftAp = false;
+  if (gMode == WIFI_MODE_APSTA) {
+    gMode = WIFI_MODE_STA;
+  } else if (gMode == WIFI_MODE_AP) {
+    gMode = WIFI_MODE_NULL;
+  }
+  return true;
+}
+
+void WiFiClass::softAPsetHostname(const char *) {}
+
+uint8_t WiFiClass::softAPgetStationNum() {
+  return 0;
+}
+
+IPAddress WiFiClass::softAPIP() {
+  std::lock_guard<std::recursive_mutex> lock(gRadioMutex);
+  return gSoftAp ? IPAddress(192, 168, 4, 1) : IPAddress();
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include "binary_protocol.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+std::vector<uint8_t> encode(const BinaryFrame &frame) {
+  std::vector<uint8_t> bytes(kBinaryFrameSize);
+  encodeBinaryFrame(frame, bytes.data());
+  return bytes;
+}
+
+BinaryFrame decodeReply(const std::string &data) {
+  // Replies are device frames, which decodeBinaryFrame() refuses by design.
+  EXPECT_EQ(data.size(), kBinaryFrameSize);
+  const auto *bytes = reinterpret_cast<const uint8_t *>(data.data());
+  BinaryFrame frame;
+  frame.opcode = static_cast<BinaryOpcode>(bytes[0]);
+  frame.cue = bytes[1];
+  frame.sequence = static_cast<uint16_t>(bytes[2] | (bytes[3] << 8));
+  frame.timestamp = static_cast<uint32_t>(bytes[4]) | (static_cast<uint32_t>(bytes[5]) << 8) |
+                    (static_cast<uint32_t>(bytes[6]) << 16) |
+                    (static_cast<uint32_t>(bytes[7]) << 24);
+  return frame;
+}
+
+TEST(BinaryProtocolTest, LittleEndianLayout) {
+  BinaryFrame frame;
+  frame.opcode = BinaryOpcode::kTrigger;
+  frame.cue = 2;
+  frame.sequence = 0xBEEF;
+  frame.timestamp = 0x01020304U;
+  EXPECT_EQ(encode(frame), (std::vector<uint8_t>{0x01, 0x02, 0xEF, 0xBE, 0x04, 0x03, 0x02, 0x01}));
+
+  BinaryFrame decoded;
+  const auto bytes = encode(frame);
+  ASSERT_TRUE(decodeBinaryFrame(bytes.data(), bytes.size(), decoded));
+  EXPECT_EQ(decoded.opcode, BinaryOpcode::kTrigger);
+  EXPECT_EQ(decoded.cue, 2U);
+  EXPECT_EQ(decoded.sequence, 0xBEEFU);
+  EXPECT_EQ(decoded.timestamp, 0x01020304U);
+}
+
+TEST(BinaryProtocolTest, RejectsMalformedRequests) {
+  BinaryFrame frame;
+  frame.opcode = BinaryOpcode::kRelease;
+  auto bytes = encode(frame);
+  BinaryFrame decoded;
+  EXPECT_FALSE(decodeBinaryFrame(bytes.data(), bytes.size() - 1U, decoded));
+  EXPECT_FALSE(decodeBinaryFrame(nullptr, bytes.size(), decoded));
+
+  bytes[0] = static_cast<uint8_t>(BinaryOpcode::kStateActive);  // device-only opcode
+  EXPECT_FALSE(decodeBinaryFrame(bytes.data(), bytes.size(), decoded));
+}
+
+TEST(BinaryProtocolTest, TriggerOverWebSocket) {
+  ASSERT_TRUE(test::bootDevice());
+  const uint32_t client = sim::connectWebSocket("/ws");
+  ASSERT_NE(client, 0U);
+  sim::sendWebSocketText(client, R"({"type":"hello","binary":true})");
+  test::runFor(kRunLoopMaxSleepMillis);
+  sim::takeWebSocketMessages(client);
+
+  BinaryFrame request;
+  request.opcode = BinaryOpcode::kTrigger;
+  request.cue = 1;
+  request.sequence = 41;
+  sim::sendWebSocketBinary(client, encode(request));
+  test::runFor(kRunLoopMaxSleepMillis);
+
+  bool acked = false;
+  bool stateSeen = false;
+  for (const auto &message : sim::takeWebSocketMessages(client)) {
+    ASSERT_TRUE(message.binary) << message.data;
+    const BinaryFrame reply = decodeReply(message.data);
+    EXPECT_EQ(reply.cue, 1U);
+    if (reply.opcode == BinaryOpcode::kAck) {
+      EXPECT_EQ(reply.sequence, 41U);
+      acked = true;
+    } else if (reply.opcode == BinaryOpcode::kStateActive) {
+      stateSeen = true;
+    }
+  }
+  EXPECT_TRUE(acked);
+  EXPECT_TRUE(stateSeen);
+  EXPECT_TRUE(getCueSnapshot(1).state.active);
+
+  request.cue = static_cast<uint8_t>(kCueCount);
+  request.sequence = 42;
+  sim::sendWebSocketBinary(client, encode(request));
+  const auto replies = sim::takeWebSocketMessages(client);
+  ASSERT_EQ(replies.size(), 1U);
+  const BinaryFrame nack = decodeReply(replies[0].data);
+  EXPECT_EQ(nack.opcode, BinaryOpcode::kNack);
+  EXPECT_EQ(nack.sequence, 42U);
+}
+
+}  // namespace
+}  // namespace stagecue
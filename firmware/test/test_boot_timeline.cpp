@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <ArduinoJson.h>
+#include <Preferences.h>
+
+#include "boot_timeline.h"
+#include "test_support.h"
+#include "wifi_supervisor.h"
+
+namespace stagecue {
+namespace {
+
+// A network saved by earlier firmware, without a cached BSSID: the station
+// join scans first, which the sim's radio makes take over two seconds.
+void saveVenueNetwork() {
+  sim::AccessPoint ap;
+  ap.ssid = "Stage";
+  sim::addAccessPoint(ap);
+  Preferences preferences;
+  ASSERT_TRUE(preferences.begin("wifi", false));
+  preferences.putString("ssid", "Stage");
+  preferences.putString("pass", "lighting");
+  preferences.end();
+}
+
+// Cue I/O is live when setup() returns: a trigger goes through while the
+// station link is still joining, and the timeline records it in that order.
+TEST(BootTimelineTest, TriggerWorksBeforeTheSlowBootTasksFinish) {
+  saveVenueNetwork();
+  test::powerOn();
+  EXPECT_NE(getBootPhaseMicros(BootPhase::kCuesLive), 0U);
+
+  ASSERT_TRUE(requestCueTrigger(0));
+  ASSERT_TRUE(test::runUntil([] { return getCueSnapshot(0).state.active; }, 100U));
+  EXPECT_TRUE(sim::pinLevel(kCueLEDs[0]));
+  EXPECT_NE(getBootPhaseMicros(BootPhase::kFirstTrigger), 0U);
+  EXPECT_FALSE(isWifiStationUp());
+  EXPECT_EQ(getBootPhaseMicros(BootPhase::kWifiConnected), 0U);
+
+  ASSERT_TRUE(test::runUntil(isWifiStationUp));
+  EXPECT_LT(getBootPhaseMicros(BootPhase::kCuesLive),
+            getBootPhaseMicros(BootPhase::kFirstTrigger));
+  EXPECT_LT(getBootPhaseMicros(BootPhase::kFirstTrigger),
+            getBootPhaseMicros(BootPhase::kWifiConnected));
+}
+
+// /api/boot lists the phases reached, in microseconds since reset; the
+// fallback access point was never needed.
+TEST(BootTimelineTest, ApiReportsReachedPhases) {
+  ASSERT_TRUE(test::runUntil([] {
+    return getBootPhaseMicros(BootPhase::kWebServerReady) != 0U &&
+           getBootPhaseMicros(BootPhase::kDisplayReady) != 0U;
+  }));
+  const sim::HttpResponse response = sim::httpRequest(HTTP_GET, "/api/boot");
+  ASSERT_EQ(response.code, 200);
+  EXPECT_EQ(response.header("Cache-Control"), "no-store");
+
+  DynamicJsonDocument doc(1024);
+  ASSERT_FALSE(deserializeJson(doc, response.body)) << response.body;
+  for (BootPhase phase : {BootPhase::kCuesLive, BootPhase::kDisplayReady,
+                          BootPhase::kWifiConnected, BootPhase::kWebServerReady,
+                          BootPhase::kFirstTrigger}) {
+    EXPECT_EQ(doc[bootPhaseName(phase)].as<uint32_t>(), getBootPhaseMicros(phase))
+        << bootPhaseName(phase);
+  }
+  EXPECT_FALSE(doc.containsKey(bootPhaseName(BootPhase::kAccessPointUp)));
+}
+
+}  // namespace
+}  // namespace stagecue
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "button_input.h"
+#include "latency_stats.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+class ButtonInputTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { ASSERT_TRUE(test::bootDevice()); }
+
+  void SetUp() override {
+    test::runFor(kButtonDebounceMillis * 2U);
+    resetLatencyStats();
+  }
+
+  void TearDown() override {
+    sim::setPinInput(kCueButtons[0], true);
+    test::runFor(kCueAutoReleaseMillis);
+  }
+
+  static uint32_t triggers() { return summarizeLatency(LatencyProbe::kPressToTrigger).samples; }
+  static bool active() { return getCueSnapshot(0).state.active; }
+};
+
+TEST_F(ButtonInputTest, LevelsComeFromOneRegisterRead) {
+  sim::setPinInput(kCueButtons[0], false);
+  uint64_t levels = readButtonLevels();
+  EXPECT_FALSE(buttonLevel(levels, kCueButtons[0]));
+  EXPECT_TRUE(buttonLevel(levels, kCueButtons[1]));
+
+  sim::setPinInput(kCueButtons[0], true);
+  levels = readButtonLevels();
+  EXPECT_TRUE(buttonLevel(levels, kCueButtons[0]));
+}
+
+TEST_F(ButtonInputTest, PressIsAcceptedOnTheLeadingEdge) {
+  sim::setPinInput(kCueButtons[0], false);
+  EXPECT_TRUE(hasButtonEdges());
+  EXPECT_EQ(millisUntilCueDeadline(millis(), kRunLoopMaxSleepMillis), 0U);
+
+  test::runUntil([] { return active(); }, 1);
+  EXPECT_TRUE(active());
+  EXPECT_EQ(triggers(), 1U);
+}
+
+TEST_F(ButtonInputTest, ContactBounceTriggersOnce) {
+  for (int bounce = 0; bounce < 5; ++bounce) {
+    sim::setPinInput(kCueButtons[0], false);
+    test::runFor(1);
+    sim::setPinInput(kCueButtons[0], true);
+    test::runFor(1);
+  }
+  sim::setPinInput(kCueButtons[0], false);
+  test::runFor(kButtonDebounceMillis * 2U);
+
+  EXPECT_TRUE(active());
+  EXPECT_EQ(triggers(), 1U);
+}
+
+TEST_F(ButtonInputTest, ReleaseInsideTheWindowIsCheckedWhenItCloses) {
+  const uint32_t pressedMs = millis();
+  sim::setPinInput(kCueButtons[0], false);
+  test::runFor(1);
+  ASSERT_TRUE(active());
+
+  sim::setPinInput(kCueButtons[0], true);
+  test::runFor(kButtonDebounceMillis / 2U);
+  EXPECT_TRUE(active());
+
+  ASSERT_TRUE(test::runUntil([] { return !active(); }, kButtonDebounceMillis));
+  EXPECT_GE(millis() - pressedMs, kButtonDebounceMillis);
+}
+
+TEST_F(ButtonInputTest, OverflowRescansTheLiveLevels) {
+  // More edges than the ring holds, with the loop task not running.
+  for (size_t i = 0; i < kButtonEdgeQueueSize + 3U; ++i) {
+    sim::setPinInput(kCueButtons[0], i % 2U != 0U);
+  }
+  ASSERT_FALSE(sim::pinLevel(kCueButtons[0]));
+
+  test::runFor(kButtonDebounceMillis * 2U);
+  EXPECT_TRUE(active());
+  EXPECT_EQ(triggers(), 1U);
+  EXPECT_FALSE(hasButtonEdges());
+  EXPECT_FALSE(takeButtonOverflow());
+}
+
+}  // namespace
+}  // namespace stagecue
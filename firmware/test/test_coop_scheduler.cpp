@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "coop_scheduler.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+uint32_t gClockUs = 0;
+uint32_t fakeClock() {
+  return gClockUs;
+}
+
+std::vector<std::string> gRuns;
+uint32_t gDueInMs = UINT32_MAX;  // for the deadline task; UINT32_MAX means none
+
+void runA(uint32_t) { gRuns.push_back("a"); }
+void runB(uint32_t) { gRuns.push_back("b"); }
+void runPeriodic(uint32_t nowMs) { gRuns.push_back("p@" + std::to_string(nowMs)); }
+void runDeadline(uint32_t) {
+  gRuns.push_back("d");
+  gDueInMs = UINT32_MAX;
+}
+uint32_t deadlineDue(uint32_t, uint32_t limitMs) {
+  return std::min(gDueInMs, limitMs);
+}
+void runSlow(uint32_t) {
+  gClockUs += 700U;
+  gRuns.push_back("s");
+}
+
+class CoopSchedulerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    gClockUs = 0;
+    gRuns.clear();
+    gDueInMs = UINT32_MAX;
+  }
+
+  CoopScheduler scheduler_{fakeClock};
+};
+
+TEST_F(CoopSchedulerTest, HigherPriorityRunsFirst) {
+  const size_t b = scheduler_.add({"b", 2U, 0U, runB, nullptr}, 0);
+  const size_t a = scheduler_.add({"a", 1U, 0U, runA, nullptr}, 0);
+  EXPECT_FALSE(scheduler_.runNext(0));
+
+  scheduler_.wake(b);
+  scheduler_.wake(a);
+  EXPECT_EQ(scheduler_.millisUntilNext(0, 100), 0U);
+  while (scheduler_.runNext(0)) {
+  }
+  EXPECT_EQ(gRuns, (std::vector<std::string>{"a", "b"}));
+  EXPECT_EQ(scheduler_.millisUntilNext(0, 100), 100U);
+}
+
+TEST_F(CoopSchedulerTest, PeriodicTaskSkipsMissedRuns) {
+  scheduler_.add({"p", 1U, 10U, runPeriodic, nullptr}, 0);
+  EXPECT_EQ(scheduler_.millisUntilNext(0, 100), 10U);
+  EXPECT_FALSE(scheduler_.runNext(9));
+  EXPECT_TRUE(scheduler_.runNext(10));
+  EXPECT_FALSE(scheduler_.runNext(15));
+  EXPECT_EQ(scheduler_.millisUntilNext(15, 100), 5U);
+
+  // 35 ms late: one catch-up run, then back on a 10 ms cadence from there.
+  EXPECT_TRUE(scheduler_.runNext(55));
+  EXPECT_FALSE(scheduler_.runNext(55));
+  EXPECT_FALSE(scheduler_.runNext(64));
+  EXPECT_TRUE(scheduler_.runNext(65));
+  EXPECT_EQ(gRuns, (std::vector<std::string>{"p@10", "p@55", "p@65"}));
+}
+
+TEST_F(CoopSchedulerTest, DeadlineTaskAndDispatchDelay) {
+  const size_t d = scheduler_.add({"d", 1U, 0U, runDeadline, deadlineDue}, 0);
+  const size_t s = scheduler_.add({"s", 0U, 0U, runSlow, nullptr}, 0);
+
+  gDueInMs = 3U;
+  EXPECT_EQ(scheduler_.millisUntilNext(0, 100), 3U);
+  gClockUs = 3000U;
+  gDueInMs = 0U;
+  // The slow, higher-priority task holds the deadline task back by 700 us.
+  scheduler_.wake(s);
+  EXPECT_TRUE(scheduler_.runNext(3));
+  EXPECT_TRUE(scheduler_.runNext(3));
+  EXPECT_EQ(gRuns, (std::vector<std::string>{"s", "d"}));
+
+  const CoopTaskStats stats = scheduler_.stats(d);
+  EXPECT_STREQ(stats.name, "d");
+  EXPECT_EQ(stats.runs, 1U);
+  EXPECT_EQ(stats.maxDispatchUs, 700U);
+  EXPECT_EQ(scheduler_.stats(s).maxRunUs, 700U);
+}
+
+TEST_F(CoopSchedulerTest, WakeFromAnotherThread) {
+  const size_t a = scheduler_.add({"a", 1U, 0U, runA, nullptr}, 0);
+  std::thread([&] { scheduler_.wake(a); }).join();
+  EXPECT_EQ(scheduler_.millisUntilNext(0, 100), 0U);
+  EXPECT_TRUE(scheduler_.runNext(0));
+  EXPECT_FALSE(scheduler_.runNext(0));
+}
+
+TEST_F(CoopSchedulerTest, TableIsBounded) {
+  EXPECT_EQ(scheduler_.add({"none", 0U, 0U, nullptr, nullptr}, 0), kCoopMaxTasks);
+  for (size_t i = 0; i < kCoopMaxTasks; ++i) {
+    EXPECT_EQ(scheduler_.add({"a", 1U, 0U, runA, nullptr}, 0), i);
+  }
+  EXPECT_EQ(scheduler_.add({"a", 1U, 0U, runA, nullptr}, 0), kCoopMaxTasks);
+  EXPECT_EQ(scheduler_.size(), kCoopMaxTasks);
+  scheduler_.wake(kCoopMaxTasks);  // ignored
+  EXPECT_FALSE(scheduler_.runNext(0));
+}
+
+TEST(RunLoopTest, TaskStatsCarryNamesFromTheStart) {
+  initRunLoop();
+  const char *names[] = {"cue_io", "fabric", "wifi", "persistence", "metrics"};
+  for (size_t i = 0; i < kRunLoopTaskCount; ++i) {
+    const CoopTaskStats stats = getRunLoopTaskStats(static_cast<RunLoopTask>(i));
+    EXPECT_STREQ(stats.name, names[i]);
+    EXPECT_EQ(stats.priority, i);
+  }
+}
+
+}  // namespace
+}  // namespace stagecue
@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+
+#include <ArduinoJson.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "test_support.h"
+#include "web_server.h"
+
+namespace stagecue {
+namespace {
+
+struct JsonFrames {
+  std::vector<std::string> types;
+  std::vector<int> cues;  // every cue index carried, in order
+};
+
+JsonFrames takeJsonFrames(uint32_t client) {
+  JsonFrames frames;
+  for (const sim::WebSocketMessage &message : sim::takeWebSocketMessages(client)) {
+    DynamicJsonDocument doc(4096);
+    if (message.binary || deserializeJson(doc, message.data)) {
+      continue;
+    }
+    const std::string type = doc["type"] | "";
+    if (type == "cue") {
+      frames.cues.push_back(doc["index"] | -1);
+    } else if (type == "delta") {
+      for (JsonVariantConst cue : doc["cues"].as<JsonArrayConst>()) {
+        frames.cues.push_back(cue["index"] | -1);
+      }
+    } else {
+      continue;
+    }
+    frames.types.push_back(type);
+  }
+  return frames;
+}
+
+uint32_t bufferFailures() {
+  DynamicJsonDocument doc(4096);
+  deserializeJson(doc, sim::httpRequest(HTTP_GET, "/api/ws").body);
+  return doc["broadcast"]["bufferFailures"].as<uint32_t>();
+}
+
+class CueBatchTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { ASSERT_TRUE(test::bootDevice()); }
+
+  void SetUp() override {
+    client_ = sim::connectWebSocket("/ws");
+    ASSERT_NE(client_, 0U);
+    test::runFor(100);
+    sim::takeWebSocketMessages(client_);
+  }
+
+  void TearDown() override {
+    sim::disconnectWebSocket(client_);
+    for (uint8_t i = 0; i < kCueCount; ++i) {
+      requestCueRelease(i);
+    }
+    test::runFor(100);
+  }
+
+  uint32_t client_ = 0;
+};
+
+TEST_F(CueBatchTest, AllChannelsSwitchInOneTickAndOneDelta) {
+  std::vector<uint32_t> edges;
+  for (uint8_t pin : kCueLEDs) {
+    edges.push_back(sim::pinEdges(pin));
+  }
+
+  sim::sendWebSocketText(client_, R"({"type":"batch","ops":[{"op":"trigger","cue":"all"}]})");
+  test::runFor(kRunLoopMaxSleepMillis);
+
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    EXPECT_TRUE(getCueSnapshot(i).state.active) << "cue " << int(i);
+    EXPECT_EQ(sim::pinEdges(kCueLEDs[i]), edges[i] + 1U) << "cue " << int(i);
+  }
+  const JsonFrames frames = takeJsonFrames(client_);
+  EXPECT_EQ(frames.types, std::vector<std::string>{"delta"});
+  EXPECT_EQ(frames.cues.size(), kCueCount);
+}
+
+TEST_F(CueBatchTest, RejectsMalformedBatches) {
+  const char *bad[] = {
+      R"({"ops":[]})",
+      R"({"ops":[{"op":"explode","cue":0}]})",
+      R"({"ops":[{"op":"trigger","cue":99}]})",
+  };
+  for (const char *body : bad) {
+    DynamicJsonDocument doc(512);
+    deserializeJson(doc, body);
+    std::string ops;
+    serializeJson(doc["ops"], ops);
+    EXPECT_EQ(sim::httpRequest(HTTP_POST, "/api/cues/batch", {{"ops", ops}}).code, 400) << body;
+  }
+  EXPECT_EQ(sim::httpRequest(HTTP_POST, "/api/cues/batch",
+                             {{"ops", R"([{"op":"trigger","cue":1,"text":"Go"}])"}})
+                .code,
+            200);
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_TRUE(getCueSnapshot(1).state.active);
+  EXPECT_STREQ(getCueSnapshot(1).text.c_str(), "Go");
+}
+
+// Within one batch the last operation on a cue decides both its state and
+// its LED, in either order.
+TEST_F(CueBatchTest, LastOperationOnACueWins) {
+  sim::sendWebSocketText(client_,
+                         R"({"type":"batch","ops":[{"op":"trigger","cue":0},{"op":"release","cue":0}]})");
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_FALSE(getCueSnapshot(0).state.active);
+  EXPECT_FALSE(sim::pinLevel(kCueLEDs[0]));
+
+  sim::sendWebSocketText(client_,
+                         R"({"type":"batch","ops":[{"op":"release","cue":0},{"op":"trigger","cue":0}]})");
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_TRUE(getCueSnapshot(0).state.active);
+  EXPECT_TRUE(sim::pinLevel(kCueLEDs[0]));
+}
+
+// The labels carried by the client's "cue" messages, in order.
+std::vector<std::string> takeCueLabels(uint32_t client) {
+  std::vector<std::string> labels;
+  for (const sim::WebSocketMessage &message : sim::takeWebSocketMessages(client)) {
+    DynamicJsonDocument doc(1024);
+    if (!message.binary && !deserializeJson(doc, message.data) && doc["type"] == "cue") {
+      labels.push_back(doc["text"] | "");
+    }
+  }
+  return labels;
+}
+
+// Re-triggering an active cue with a new label changes no state, but the
+// label must still reach every client, binary ones included.
+TEST_F(CueBatchTest, RetriggerWithNewTextIsBroadcast) {
+  const uint32_t binary = sim::connectWebSocket("/ws");
+  sim::sendWebSocketText(binary, R"({"type":"hello","binary":true})");
+  ASSERT_TRUE(requestCueTrigger(0, "First"));
+  test::runFor(kRunLoopMaxSleepMillis);
+  ASSERT_TRUE(getCueSnapshot(0).state.active);
+  sim::takeWebSocketMessages(client_);
+  sim::takeWebSocketMessages(binary);
+
+  ASSERT_TRUE(requestCueTrigger(0, "Second"));
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_STREQ(getCueSnapshot(0).text.c_str(), "Second");
+  EXPECT_EQ(takeCueLabels(client_), std::vector<std::string>{"Second"});
+  EXPECT_EQ(takeCueLabels(binary), std::vector<std::string>{"Second"});
+
+  ASSERT_TRUE(requestCueSchedule(0, true, micros() + 10000U, "Third"));
+  test::runFor(20);
+  EXPECT_STREQ(getCueSnapshot(0).text.c_str(), "Third");
+  EXPECT_EQ(takeCueLabels(client_), std::vector<std::string>{"Third"});
+  EXPECT_EQ(takeCueLabels(binary), std::vector<std::string>{"Third"});
+
+  sim::disconnectWebSocket(binary);
+}
+
+// A refused shared buffer defers the JSON clients instead of dropping the
+// change; binary clients need no buffer and still get it at once.
+TEST_F(CueBatchTest, BufferFailureDefersInsteadOfDropping) {
+  const uint32_t second = sim::connectWebSocket("/ws");
+  const uint32_t binary = sim::connectWebSocket("/ws");
+  sim::sendWebSocketText(binary, R"({"type":"hello","binary":true})");
+  test::runFor(100);
+  sim::takeWebSocketMessages(second);
+  sim::takeWebSocketMessages(binary);
+
+  const uint32_t failures = bufferFailures();
+  sim::failWebSocketBuffers(1);
+  ASSERT_TRUE(requestCueTrigger(0));
+  test::runFor(kRunLoopMaxSleepMillis * 2U);
+
+  EXPECT_EQ(bufferFailures(), failures + 1U);
+  EXPECT_EQ(takeJsonFrames(client_).cues, std::vector<int>{0});
+  EXPECT_EQ(takeJsonFrames(second).cues, std::vector<int>{0});
+  const auto frames = sim::takeWebSocketMessages(binary);
+  ASSERT_EQ(frames.size(), 1U);
+  EXPECT_TRUE(frames[0].binary);
+
+  sim::disconnectWebSocket(second);
+  sim::disconnectWebSocket(binary);
+}
+
+// Snapshot and scan broadcasts share one library buffer too; without it the
+// cues come through each client's backlog and the scan notice is resent.
+TEST_F(CueBatchTest, SharedBroadcastBufferFailureIsMadeUpFor) {
+  const uint32_t failures = bufferFailures();
+  sim::failWebSocketBuffers(1);
+  notifyAllCueStates();
+  test::runFor(kRunLoopMaxSleepMillis * 2U);
+  EXPECT_EQ(bufferFailures(), failures + 1U);
+  std::vector<int> expected;
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    expected.push_back(i);
+  }
+  std::vector<int> received = takeJsonFrames(client_).cues;
+  std::sort(received.begin(), received.end());  // backlogs go in sequence order
+  EXPECT_EQ(received, expected);
+
+  sim::failWebSocketBuffers(1);
+  notifyWifiScanResults();
+  test::runFor(kRunLoopMaxSleepMillis * 2U);
+  EXPECT_EQ(bufferFailures(), failures + 2U);
+  size_t scans = 0;
+  for (const sim::WebSocketMessage &message : sim::takeWebSocketMessages(client_)) {
+    scans += message.data.find(R"("type":"scan")") != std::string::npos ? 1U : 0U;
+  }
+  EXPECT_EQ(scans, 1U);
+}
+
+}  // namespace
+}  // namespace stagecue
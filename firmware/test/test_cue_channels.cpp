@@ -0,0 +1,62 @@
+// Every channel's button, LED and panel, at whatever STAGECUE_CUE_COUNT the
+// suite is built with.
+
+#include <gtest/gtest.h>
+
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+class CueChannelsTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { ASSERT_TRUE(test::bootDevice()); }
+};
+
+TEST_F(CueChannelsTest, ButtonPinsUseTheirPull) {
+  for (uint8_t pin : kCueButtons) {
+    EXPECT_EQ(sim::pinMode(pin), hasInternalPullUp(pin) ? INPUT_PULLUP : INPUT) << "GPIO" << +pin;
+    EXPECT_TRUE(sim::pinLevel(pin)) << "GPIO" << +pin << " idles pressed";
+  }
+}
+
+TEST_F(CueChannelsTest, NoCueActiveAtRest) {
+  test::runFor(kCueAutoReleaseMillis);
+  for (size_t i = 0; i < kCueCount; ++i) {
+    EXPECT_FALSE(getCueSnapshot(static_cast<uint8_t>(i)).state.active) << "cue " << i;
+  }
+}
+
+TEST_F(CueChannelsTest, EachButtonDrivesItsOwnCue) {
+  for (size_t i = 0; i < kCueCount; ++i) {
+    const auto index = static_cast<uint8_t>(i);
+    sim::setPinInput(kCueButtons[i], false);
+    test::runFor(kButtonDebounceMillis);
+    for (size_t j = 0; j < kCueCount; ++j) {
+      EXPECT_EQ(getCueSnapshot(static_cast<uint8_t>(j)).state.active, i == j) << i << "/" << j;
+      EXPECT_EQ(sim::pinLevel(kCueLEDs[j]), i == j) << i << "/" << j;
+    }
+    sim::setPinInput(kCueButtons[i], true);
+    test::runFor(kButtonDebounceMillis * 2U);
+    EXPECT_FALSE(getCueSnapshot(index).state.active);
+  }
+}
+
+TEST_F(CueChannelsTest, PanelsAreAddressable) {
+  for (size_t i = 0; i < kCueCount; ++i) {
+    EXPECT_TRUE(isDisplayReady(static_cast<uint8_t>(i))) << "panel " << i;
+  }
+  if (kOledUseMux) {
+    EXPECT_GT(sim::i2cTransactions(kOledMuxAddress), 0U);
+  } else {
+    EXPECT_EQ(sim::i2cTransactions(kOledMuxAddress), 0U);
+  }
+}
+
+TEST(CueConfigTest, BatchHoldsARenameAndTriggerPerCue) {
+  EXPECT_EQ(kCueBatchMaxOps, 2U * kCueCount);
+  EXPECT_EQ(CueBatch{}.ops.size(), kCueBatchMaxOps);
+}
+
+}  // namespace
+}  // namespace stagecue
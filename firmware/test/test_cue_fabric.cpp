@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include "cue_fabric.h"
+#include "fabric_protocol.h"
+#include "test_support.h"
+#include "wifi_portal.h"
+
+namespace stagecue {
+namespace {
+
+constexpr uint32_t kPeerNode = 0x00C0FFEEU;
+const IPAddress kPeerAddress(192, 168, 1, 20);
+
+// A second unit, modelled with the same last-writer-wins rules.
+struct PeerModel {
+  uint32_t clock = 0;
+  uint32_t sequence = 0;
+  std::array<FabricCueState, kCueCount> cues{};
+
+  PeerModel() {
+    for (size_t i = 0; i < kCueCount; ++i) {
+      cues[i].cue = static_cast<uint8_t>(i);
+    }
+  }
+
+  FabricHeader header(FabricMessage type) {
+    FabricHeader result;
+    result.type = type;
+    result.node = kPeerNode;
+    result.sequence = ++sequence;
+    return result;
+  }
+
+  std::vector<uint8_t> change(uint8_t index, bool active) {
+    cues[index].active = active;
+    cues[index].version = CueVersion{++clock, kPeerNode};
+    return state(index);
+  }
+
+  std::vector<uint8_t> state(uint8_t index) {
+    std::vector<uint8_t> datagram(kFabricStateSize);
+    encodeFabricState(header(FabricMessage::kState), cues[index], datagram.data());
+    return datagram;
+  }
+
+  std::vector<uint8_t> digest() {
+    std::vector<uint8_t> datagram(kFabricMaxDatagramSize);
+    datagram.resize(
+        encodeFabricDigest(header(FabricMessage::kDigest), cues.data(), kCueCount, datagram.data()));
+    return datagram;
+  }
+
+  void adopt(const FabricCueState &remote) {
+    clock = std::max(clock, remote.version.stamp);
+    if (isNewerVersion(remote.version, cues[remote.cue].version)) {
+      cues[remote.cue].active = remote.active;
+      cues[remote.cue].version = remote.version;
+    }
+  }
+
+  // Applies one of the device's datagrams; returns the repairs it owes back.
+  std::vector<std::vector<uint8_t>> receive(const std::vector<uint8_t> &data) {
+    FabricHeader fabricHeader;
+    EXPECT_TRUE(decodeFabricHeader(data.data(), data.size(), fabricHeader));
+    std::vector<std::vector<uint8_t>> replies;
+    if (fabricHeader.type == FabricMessage::kState) {
+      FabricCueState remote;
+      EXPECT_TRUE(decodeFabricState(data.data(), data.size(), remote));
+      adopt(remote);
+      return replies;
+    }
+    std::array<FabricCueState, kCueCount> remote;
+    size_t count = 0;
+    EXPECT_TRUE(decodeFabricDigest(data.data(), data.size(), remote.data(), remote.size(), count));
+    for (size_t i = 0; i < count; ++i) {
+      remote[i].cue = static_cast<uint8_t>(i);
+      if (isNewerVersion(cues[i].version, remote[i].version)) {
+        replies.push_back(state(static_cast<uint8_t>(i)));
+      } else {
+        adopt(remote[i]);
+      }
+    }
+    return replies;
+  }
+};
+
+std::vector<std::vector<uint8_t>> takeFabricDatagrams() {
+  std::vector<std::vector<uint8_t>> datagrams;
+  for (sim::UdpPacket &packet : sim::takeUdpPackets()) {
+    if (packet.port == kFabricPort) {
+      datagrams.push_back(std::move(packet.data));
+    }
+  }
+  return datagrams;
+}
+
+void deliver(const std::vector<uint8_t> &datagram) {
+  ASSERT_TRUE(sim::deliverUdpPacket(kFabricPort, datagram, kPeerAddress));
+}
+
+class CueFabricTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    sim::AccessPoint ap;
+    ap.ssid = "Stage";
+    sim::addAccessPoint(ap);
+    ASSERT_TRUE(test::bootDevice());
+    ASSERT_TRUE(saveWifiCredentials("Stage", "lighting"));
+    ASSERT_TRUE(test::runUntil([] { return getCueFabricStats().running; }, 60000U));
+  }
+
+  void SetUp() override {
+    peer_ = PeerModel{};
+    // Our clock must not trail the device's, or none of our changes would win.
+    peer_.clock = getCueFabricStats().clock;
+    takeFabricDatagrams();
+  }
+
+  PeerModel peer_;
+};
+
+TEST_F(CueFabricTest, LocalChangeGoesOutOnce) {
+  ASSERT_TRUE(requestCueTrigger(0));
+  test::runFor(kRunLoopMaxSleepMillis);
+
+  size_t states = 0;
+  for (const auto &datagram : takeFabricDatagrams()) {
+    FabricHeader header;
+    ASSERT_TRUE(decodeFabricHeader(datagram.data(), datagram.size(), header));
+    if (header.type != FabricMessage::kState) {
+      continue;
+    }
+    FabricCueState state;
+    ASSERT_TRUE(decodeFabricState(datagram.data(), datagram.size(), state));
+    EXPECT_EQ(state.cue, 0U);
+    EXPECT_TRUE(state.active);
+    EXPECT_EQ(state.version.node, getCueFabricStats().node);
+    ++states;
+  }
+  EXPECT_EQ(states, 1U);
+  ASSERT_TRUE(requestCueRelease(0));
+  test::runFor(kRunLoopMaxSleepMillis);
+}
+
+TEST_F(CueFabricTest, NewerPeerStateWinsAndStaleIsIgnored) {
+  const CueFabricStats before = getCueFabricStats();
+  deliver(peer_.change(1, true));
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_TRUE(getCueSnapshot(1).state.active);
+  EXPECT_EQ(getCueFabricStats().applied, before.applied + 1U);
+
+  // Replaying the same version changes nothing.
+  deliver(peer_.state(1));
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_EQ(getCueFabricStats().stale, before.stale + 1U);
+
+  // A peer state is not re-announced as a change of ours.
+  for (const auto &datagram : takeFabricDatagrams()) {
+    FabricHeader header;
+    ASSERT_TRUE(decodeFabricHeader(datagram.data(), datagram.size(), header));
+    EXPECT_NE(header.type, FabricMessage::kState);
+  }
+  deliver(peer_.change(1, false));
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_FALSE(getCueSnapshot(1).state.active);
+}
+
+TEST_F(CueFabricTest, DigestPullsAndPushes) {
+  // The peer missed our change to cue 0 and we missed its change to cue 1.
+  ASSERT_TRUE(requestCueTrigger(0));
+  test::runFor(kRunLoopMaxSleepMillis);
+  takeFabricDatagrams();
+  peer_.change(1, true);
+
+  const uint32_t repairs = getCueFabricStats().repairsSent;
+  deliver(peer_.digest());
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_TRUE(getCueSnapshot(1).state.active);
+  EXPECT_EQ(getCueFabricStats().repairsSent, repairs + 1U);
+  for (const auto &datagram : takeFabricDatagrams()) {
+    peer_.receive(datagram);
+  }
+  EXPECT_TRUE(peer_.cues[0].active);
+
+  ASSERT_TRUE(requestCueRelease(0));
+  deliver(peer_.change(1, false));
+  test::runFor(kRunLoopMaxSleepMillis);
+}
+
+// Interleaved local and peer changes over a lossy link, then a clean link
+// for a few digest rounds: both units end up with the same state.
+TEST_F(CueFabricTest, ConvergesAfterLoss) {
+  std::mt19937 rng(20);
+  std::bernoulli_distribution lost(0.3);
+  auto exchange = [&](bool lossy) {
+    for (const auto &datagram : takeFabricDatagrams()) {
+      if (lossy && lost(rng)) {
+        continue;
+      }
+      for (const auto &reply : peer_.receive(datagram)) {
+        if (!lossy || !lost(rng)) {
+          deliver(reply);
+        }
+      }
+    }
+  };
+
+  for (int round = 0; round < 300; ++round) {
+    const auto index = static_cast<uint8_t>(rng() % kCueCount);
+    const bool active = rng() % 2U != 0U;
+    if (rng() % 2U != 0U) {
+      active ? requestCueTrigger(index) : requestCueRelease(index);
+    } else {
+      const std::vector<uint8_t> datagram = peer_.change(index, active);
+      if (!lost(rng)) {
+        deliver(datagram);
+      }
+    }
+    if (rng() % 8U == 0U && !lost(rng)) {
+      deliver(peer_.digest());
+    }
+    test::runFor(1U + rng() % 40U);
+    exchange(true);
+  }
+
+  // Local auto-releases still replicate while the link heals.
+  const uint32_t healMs = kCueAutoReleaseMillis + 3U * kFabricDigestIntervalMillis;
+  for (uint32_t elapsed = 0; elapsed < healMs; elapsed += kFabricDigestIntervalMillis) {
+    deliver(peer_.digest());
+    test::runFor(kFabricDigestIntervalMillis);
+    exchange(false);
+  }
+
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    EXPECT_EQ(getCueSnapshot(i).state.active, peer_.cues[i].active) << "cue " << i;
+  }
+  const CueFabricStats stats = getCueFabricStats();
+  EXPECT_GT(stats.applied, 0U);
+  EXPECT_GT(stats.repairsSent, 0U);
+  EXPECT_EQ(stats.malformed, 0U);
+}
+
+}  // namespace
+}  // namespace stagecue
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#include "cue_label.h"
+#include "test_support.h"
+
+extern "C" void *__libc_malloc(size_t size);
+
+namespace {
+
+std::atomic<bool> gCountAllocations{false};
+std::atomic<uint32_t> gFirmwareAllocations{0};
+
+}  // namespace
+
+// Counts heap blocks taken by firmware code while counting is on.
+extern "C" void *malloc(size_t size) {
+  if (gCountAllocations.load(std::memory_order_relaxed) && !sim::inLibraryCode()) {
+    gFirmwareAllocations.fetch_add(1U, std::memory_order_relaxed);
+  }
+  return __libc_malloc(size);
+}
+
+namespace stagecue {
+namespace {
+
+size_t heapInUse() {
+  return mallinfo2().uordblks;
+}
+
+TEST(CueLabelTest, TruncatesOnACharacterBoundary) {
+  CueLabel label;
+  EXPECT_TRUE(label.assign("Blackout"));
+  EXPECT_STREQ(label.c_str(), "Blackout");
+  EXPECT_EQ(label.length(), 8U);
+
+  const std::string ascii(CueLabel::kCapacity + 5U, 'x');
+  EXPECT_FALSE(label.assign(ascii.c_str()));
+  EXPECT_EQ(label.length(), CueLabel::kCapacity);
+
+  // "é" is two bytes; the one that would straddle the limit is left out.
+  const std::string accented = std::string(CueLabel::kCapacity - 1U, 'x') + "\xC3\xA9";
+  EXPECT_FALSE(label.assign(accented.c_str()));
+  EXPECT_EQ(label.length(), CueLabel::kCapacity - 1U);
+
+  EXPECT_TRUE(label.assign("Fly\0out", 7U));
+  EXPECT_STREQ(label.c_str(), "Fly");
+  EXPECT_TRUE(label.assign(nullptr));
+  EXPECT_TRUE(label.empty());
+}
+
+TEST(CueLabelTest, EqualityComparesTheText) {
+  EXPECT_EQ(CueLabel("Go"), CueLabel("Go"));
+  EXPECT_NE(CueLabel("Go"), CueLabel("Gone"));
+  EXPECT_NE(CueLabel("Go"), CueLabel());
+}
+
+// Renames through the cue engine, labels, display and store staging, with
+// the heap's high-water mark checked along the way. Neither it nor the
+// number of blocks firmware code takes may move.
+TEST(CueLabelTest, RenamesLeaveTheHeapWatermarkAlone) {
+  ASSERT_TRUE(test::bootDevice());
+  constexpr int kRenames = 100000;
+  char text[CueLabel::kCapacity + 1];
+
+  // Warm-up: lazily sized state is allocated once, not per rename.
+  for (int round = 0; round < 64; ++round) {
+    snprintf(text, sizeof(text), "Warm up %d", round);
+    ASSERT_TRUE(requestCueRename(static_cast<uint8_t>(round % kCueCount), text));
+    updateCues();
+  }
+  test::settleDisplays();
+  const size_t baseline = heapInUse();
+  size_t watermark = baseline;
+
+  gCountAllocations = true;
+  for (int round = 0; round < kRenames; ++round) {
+    snprintf(text, sizeof(text), "Cue %d - Lighting state %d", round % kCueCount, round);
+    ASSERT_TRUE(requestCueRename(static_cast<uint8_t>(round % kCueCount), text));
+    updateCues();
+    if (round % 1000 == 999) {
+      watermark = std::max(watermark, heapInUse());
+    }
+  }
+  gCountAllocations = false;
+  test::settleDisplays();
+  watermark = std::max(watermark, heapInUse());
+
+  EXPECT_EQ(gFirmwareAllocations.load(), 0U);
+  EXPECT_EQ(watermark, baseline);
+  EXPECT_EQ(getCueSnapshot((kRenames - 1) % kCueCount).text,
+            CueLabel(("Cue " + std::to_string((kRenames - 1) % kCueCount) +
+                      " - Lighting state " + std::to_string(kRenames - 1))
+                         .c_str()));
+}
+
+}  // namespace
+}  // namespace stagecue
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+
+#include <string>
+
+#include "latency_stats.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+class CueScheduleTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { ASSERT_TRUE(test::bootDevice()); }
+
+  void SetUp() override {
+    // Only simulated time passes, so lateness is the scheduler's alone.
+    sim::freezeClock(true);
+    resetLatencyStats();
+  }
+
+  void TearDown() override {
+    sim::freezeClock(false);
+    for (uint8_t i = 0; i < kCueCount; ++i) {
+      requestCueRelease(i);
+    }
+    test::runFor(100);
+  }
+
+  // The action and outcome of the client's acks, in order.
+  static std::vector<std::string> acks(uint32_t client) {
+    std::vector<std::string> result;
+    for (const sim::WebSocketMessage &message : sim::takeWebSocketMessages(client)) {
+      DynamicJsonDocument doc(512);
+      if (!message.binary && !deserializeJson(doc, message.data) && doc["type"] == "ack") {
+        result.push_back(std::string(doc["action"] | "") + (doc["ok"].as<bool>() ? ":ok" : ":") +
+                         (doc["detail"] | ""));
+      }
+    }
+    return result;
+  }
+};
+
+TEST_F(CueScheduleTest, FiresWithinAMillisecondOfItsDeadline) {
+  const CueScheduleStats before = getCueScheduleStats();
+  ASSERT_TRUE(requestCueSchedule(0, true, micros() + 50000U, "Thunder"));
+  test::runFor(49);
+  EXPECT_FALSE(getCueSnapshot(0).state.active);
+  test::runFor(2);
+  EXPECT_TRUE(getCueSnapshot(0).state.active);
+  EXPECT_STREQ(getCueSnapshot(0).text.c_str(), "Thunder");
+
+  ASSERT_TRUE(requestCueSchedule(0, false, micros() + 20000U));
+  test::runFor(21);
+  EXPECT_FALSE(getCueSnapshot(0).state.active);
+
+  const LatencySummary lateness = summarizeLatency(LatencyProbe::kScheduleLateness);
+  EXPECT_EQ(lateness.samples, 2U);
+  EXPECT_LT(lateness.maxUs, 1000U);
+  const CueScheduleStats after = getCueScheduleStats();
+  EXPECT_EQ(after.armed, before.armed + 2U);
+  EXPECT_EQ(after.fired, before.fired + 2U);
+}
+
+TEST_F(CueScheduleTest, PastDeadlineFiresAtOnceAndRecordsLateness) {
+  ASSERT_TRUE(requestCueSchedule(1, true, micros() - 3000U));
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_TRUE(getCueSnapshot(1).state.active);
+
+  const LatencySummary lateness = summarizeLatency(LatencyProbe::kScheduleLateness);
+  ASSERT_EQ(lateness.samples, 1U);
+  EXPECT_GE(lateness.maxUs, 3000U);
+  EXPECT_LT(lateness.maxUs, 4000U + kRunLoopMaxSleepMillis * 1000U);
+}
+
+TEST_F(CueScheduleTest, RefusesWhenEverySlotIsArmed) {
+  const CueScheduleStats before = getCueScheduleStats();
+  for (size_t i = 0; i <= kCueScheduleSlots; ++i) {
+    ASSERT_TRUE(requestCueSchedule(0, true, micros() + 60000U));
+  }
+  test::runFor(kRunLoopMaxSleepMillis);
+  const CueScheduleStats armed = getCueScheduleStats();
+  EXPECT_EQ(armed.armed, before.armed + kCueScheduleSlots);
+  EXPECT_EQ(armed.rejected, before.rejected + 1U);
+
+  test::runFor(60);
+  EXPECT_EQ(getCueScheduleStats().fired, before.fired + kCueScheduleSlots);
+}
+
+TEST_F(CueScheduleTest, ScheduleOverWebSocket) {
+  const uint32_t client = sim::connectWebSocket("/ws");
+  ASSERT_NE(client, 0U);
+  test::runFor(100);
+  sim::takeWebSocketMessages(client);
+
+  auto schedule = [&](const char *op, double aheadMs) {
+    const double atMs = static_cast<double>(esp_timer_get_time()) / 1000.0 + aheadMs;
+    sim::sendWebSocketText(client, std::string(R"({"type":"schedule","cue":1,"op":")") + op +
+                                       R"(","at":)" + std::to_string(atMs) + "}");
+  };
+  schedule("trigger", 30.0);
+  schedule("trigger", kCueScheduleMaxAheadMillis + 1000.0);
+  schedule("trigger", -(kCueScheduleMaxLateMillis + 1000.0));
+  schedule("explode", 30.0);
+  EXPECT_EQ(acks(client), (std::vector<std::string>{"schedule:ok", "schedule:too far ahead",
+                                                    "schedule:too late", "schedule:unknown op"}));
+
+  test::runFor(29);
+  EXPECT_FALSE(getCueSnapshot(1).state.active);
+  test::runFor(2);
+  EXPECT_TRUE(getCueSnapshot(1).state.active);
+  sim::disconnectWebSocket(client);
+}
+
+}  // namespace
+}  // namespace stagecue
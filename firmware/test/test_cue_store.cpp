@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "cue_store.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+constexpr char kSpace[] = "cue_texts";
+
+std::string label(int round) {
+  return "Take " + std::to_string(round);
+}
+
+class CueStoreTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { ASSERT_TRUE(test::bootDevice()); }
+
+  void SetUp() override {
+    test::runFor(kCueStoreMaxDelayMillis);  // nothing left from the last test
+    commits_ = sim::nvsCommits();
+  }
+
+  uint32_t commits_ = 0;
+};
+
+// A burst of edits is one flash commit once the label has been quiet, with
+// only the last label written.
+TEST_F(CueStoreTest, RapidRenamesCommitOnce) {
+  const CueStoreStats before = getCueStoreStats();
+  constexpr int kRenames = 150;
+  for (int round = 0; round < kRenames; ++round) {
+    ASSERT_TRUE(requestCueRename(0, label(round).c_str()));
+    test::runFor(10);
+  }
+  EXPECT_EQ(sim::nvsCommits(), commits_);
+
+  test::runFor(kCueStoreDebounceMillis + 100U);
+  EXPECT_EQ(sim::nvsCommits(), commits_ + 1U);
+  EXPECT_EQ(sim::nvsValue(kSpace, "cue0"), label(kRenames - 1));
+
+  const CueStoreStats after = getCueStoreStats();
+  EXPECT_EQ(after.staged - before.staged, static_cast<uint32_t>(kRenames));
+  EXPECT_EQ(after.coalesced - before.coalesced, static_cast<uint32_t>(kRenames - 1));
+  EXPECT_EQ(after.keysWritten - before.keysWritten, 1U);
+}
+
+// Edits that never pause are still written once the maximum delay runs out.
+TEST_F(CueStoreTest, ContinuousEditsFlushAtTheMaximumDelay) {
+  const uint32_t stepMs = kCueStoreDebounceMillis / 2U;
+  int round = 0;
+  for (uint32_t elapsed = 0; elapsed < kCueStoreMaxDelayMillis + stepMs; elapsed += stepMs) {
+    ASSERT_TRUE(requestCueRename(1, label(round++).c_str()));
+    test::runFor(stepMs);
+  }
+  EXPECT_EQ(sim::nvsCommits(), commits_ + 1U);
+  EXPECT_TRUE(sim::nvsHasKey(kSpace, "cue1"));
+}
+
+// A shutdown writes what the debounce was still holding back.
+TEST_F(CueStoreTest, ShutdownFlushesPendingLabels) {
+  for (int round = 0; round < 20; ++round) {
+    ASSERT_TRUE(requestCueRename(2 % kCueCount, label(round).c_str()));
+    test::runFor(5);
+  }
+  EXPECT_EQ(sim::nvsCommits(), commits_);
+
+  sim::runShutdownHandlers();
+  EXPECT_EQ(sim::nvsCommits(), commits_ + 1U);
+  EXPECT_EQ(sim::nvsValue(kSpace, ("cue" + std::to_string(2 % kCueCount)).c_str()), label(19));
+
+  test::runFor(kCueStoreDebounceMillis + 100U);
+  EXPECT_EQ(sim::nvsCommits(), commits_ + 1U);
+}
+
+// Neither a failed write nor a failed commit loses the label: the flush
+// is armed again and succeeds on the next attempt without another edit.
+TEST_F(CueStoreTest, FailedWritesAreRetried) {
+  sim::failNvsWrites(1);
+  ASSERT_TRUE(requestCueRename(0, "Write retry"));
+  test::runFor(kCueStoreDebounceMillis + 100U);
+  EXPECT_NE(sim::nvsValue(kSpace, "cue0"), "Write retry");
+  test::runFor(kCueStoreDebounceMillis + 100U);
+  EXPECT_EQ(sim::nvsValue(kSpace, "cue0"), "Write retry");
+
+  sim::failNvsCommits(1);
+  ASSERT_TRUE(requestCueRename(0, "Commit retry"));
+  test::runFor(kCueStoreDebounceMillis + 100U);
+  EXPECT_NE(sim::nvsValue(kSpace, "cue0"), "Commit retry");
+  test::runFor(kCueStoreDebounceMillis + 100U);
+  EXPECT_EQ(sim::nvsValue(kSpace, "cue0"), "Commit retry");
+}
+
+}  // namespace
+}  // namespace stagecue
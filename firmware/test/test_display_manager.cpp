@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include "display_manager.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+class DisplayManagerTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { ASSERT_TRUE(test::bootDevice()); }
+
+  // Renders on the calling thread, which is the loop (cue engine) task, and
+  // waits for the flush task to push the frame.
+  static DisplayFlushStats render(uint8_t index, const char *label) {
+    test::settleDisplays();
+    const uint32_t before = getDisplayFlushStats(index).updates;
+    updateDisplay(index, CueLabel(label));
+    EXPECT_TRUE(test::runUntil([&] { return getDisplayFlushStats(index).updates != before; }));
+    return getDisplayFlushStats(index);
+  }
+};
+
+TEST_F(DisplayManagerTest, RepeatedLabelPushesNothing) {
+  render(0, "Standby");
+  EXPECT_EQ(render(0, "Standby").lastUpdateBytes, 0U);
+}
+
+// "costarring" and "liquid" share an FNV-1a hash, so the cache key alone
+// cannot tell them apart.
+TEST_F(DisplayManagerTest, CollidingLabelsRenderTheirOwnFrames) {
+  ASSERT_TRUE(isDisplayCacheEnabled());
+  render(1, "costarring");
+  EXPECT_GT(render(1, "liquid").lastUpdateBytes, 0U);
+  EXPECT_GT(render(1, "costarring").lastUpdateBytes, 0U);
+}
+
+TEST_F(DisplayManagerTest, CacheSwitchFromWebServer) {
+  render(2, "Fly out");
+
+  auto response = sim::httpRequest(HTTP_POST, "/api/displays/cache", {{"enabled", "0"}});
+  EXPECT_EQ(response.code, 200);
+  EXPECT_FALSE(isDisplayCacheEnabled());
+  EXPECT_EQ(render(2, "Fly out").lastUpdateBytes, 0U);
+
+  response = sim::httpRequest(HTTP_POST, "/api/displays/cache", {{"enabled", "1"}});
+  EXPECT_EQ(response.code, 200);
+  EXPECT_TRUE(isDisplayCacheEnabled());
+  EXPECT_EQ(render(2, "Fly out").lastUpdateBytes, 0U);
+  EXPECT_GT(render(2, "Fly in").lastUpdateBytes, 0U);
+}
+
+// Every panel answers at the base address (behind the multiplexer when
+// there are more than two), so the bus counter there sees exactly what the
+// flush task reports.
+uint64_t panelBusBytes() {
+  uint64_t bytes = 0;
+  for (size_t i = 0; i < (kOledUseMux ? 1U : kCueCount); ++i) {
+    bytes += sim::i2cBytes(static_cast<uint8_t>(kOledBaseAddress + i));
+  }
+  return bytes;
+}
+
+// A whole frame: eight pages of window commands and 128 data bytes in
+// kDisplayI2cChunkBytes transactions.
+constexpr uint64_t kFullFrameBusBytes =
+    (kScreenHeight / 8U) * (8U + (kScreenWidth / kDisplayI2cChunkBytes) *
+                                     (kDisplayI2cChunkBytes + 2U));
+
+TEST_F(DisplayManagerTest, RenamePushesOnlyTheChangedSpan) {
+  render(0, "Cue 12 - Blackout");
+  const uint64_t before = panelBusBytes();
+  const DisplayFlushStats stats = render(0, "Cue 12 - Blackin");
+  const uint64_t pushed = panelBusBytes() - before;
+  EXPECT_EQ(pushed, stats.lastUpdateBytes);
+  EXPECT_GT(pushed, 0U);
+  EXPECT_LT(pushed, kFullFrameBusBytes / 4U);
+}
+
+// Trigger and release redraw the same label, which puts nothing on the bus.
+TEST_F(DisplayManagerTest, StateOnlyUpdatePushesNothing) {
+  render(0, "Standby");
+  ASSERT_TRUE(requestCueRename(0, "Standby"));
+  test::runFor(kRunLoopMaxSleepMillis);
+  test::settleDisplays();
+  const uint64_t before = panelBusBytes();
+  const uint32_t updates = getDisplayFlushStats(0).updates;
+
+  ASSERT_TRUE(requestCueTrigger(0));
+  test::runFor(kRunLoopMaxSleepMillis);
+  ASSERT_TRUE(getCueSnapshot(0).state.active);
+  ASSERT_TRUE(requestCueRelease(0));
+  test::runFor(kRunLoopMaxSleepMillis);
+  test::settleDisplays();
+
+  EXPECT_GT(getDisplayFlushStats(0).updates, updates);
+  EXPECT_EQ(getDisplayFlushStats(0).lastUpdateBytes, 0U);
+  EXPECT_EQ(panelBusBytes(), before);
+}
+
+}  // namespace
+}  // namespace stagecue
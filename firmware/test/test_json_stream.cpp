@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <ArduinoJson.h>
+
+#include <string>
+
+#include "json_stream.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+std::string text(const JsonRecordWriter &record) {
+  return std::string(record.data(), record.length());
+}
+
+TEST(JsonRecordWriterTest, EscapesStrings) {
+  JsonRecordWriter record;
+  record.reset();
+  record.beginObject();
+  record.key("label");
+  record.string("say \"go\"\\\n");
+  record.key("n");
+  record.number(static_cast<int32_t>(-7));
+  record.key("ok");
+  record.boolean(true);
+  record.endObject();
+  EXPECT_FALSE(record.overflowed());
+  EXPECT_EQ(text(record), R"({"label":"say \"go\"\\\u000a","n":-7,"ok":true})");
+}
+
+TEST(JsonRecordWriterTest, OverflowIsFlaggedNotTruncated) {
+  JsonRecordWriter record;
+  record.reset();
+  const std::string big(kJsonStreamRecordSize, 'x');
+  record.string(big.c_str());
+  EXPECT_TRUE(record.overflowed());
+
+  record.reset();
+  EXPECT_FALSE(record.overflowed());
+  EXPECT_EQ(record.length(), 0U);
+}
+
+bool writeElement(size_t index, JsonRecordWriter &record) {
+  if (index >= 5U) {
+    return false;
+  }
+  record.beginObject();
+  record.key("i");
+  record.number(static_cast<uint32_t>(index));
+  record.key("pad");
+  // Element 2 outgrows a record and must be skipped whole.
+  record.string(index == 2U ? std::string(kJsonStreamRecordSize, 'p').c_str() : "ab");
+  record.endObject();
+  return true;
+}
+
+int gDoneCalls = 0;
+void onDone() {
+  ++gDoneCalls;
+}
+
+std::string drain(JsonArrayStream stream, size_t chunk) {
+  std::string out;
+  std::vector<uint8_t> buffer(chunk);
+  for (;;) {
+    const size_t written = stream.fill(buffer.data(), buffer.size());
+    if (written == 0U) {
+      return out;
+    }
+    EXPECT_LE(written, chunk);
+    out.append(reinterpret_cast<const char *>(buffer.data()), written);
+  }
+}
+
+TEST(JsonArrayStreamTest, SameOutputForAnyChunkSize) {
+  gDoneCalls = 0;
+  const JsonArrayStream stream("{\"items\":", ",\"end\":1}", writeElement, onDone);
+  const std::string expected =
+      R"({"items":[{"i":0,"pad":"ab"},{"i":1,"pad":"ab"},{"i":3,"pad":"ab"},{"i":4,"pad":"ab"}],"end":1})";
+  for (size_t chunk : {1U, 2U, 7U, 64U, 1436U}) {
+    EXPECT_EQ(drain(stream, chunk), expected) << "chunk " << chunk;
+  }
+  EXPECT_EQ(gDoneCalls, 5);
+}
+
+TEST(JsonArrayStreamTest, EmptyArray) {
+  const JsonArrayStream stream("", "", [](size_t, JsonRecordWriter &) { return false; });
+  EXPECT_EQ(drain(stream, 3), "[]");
+}
+
+TEST(JsonArrayStreamTest, CueListOverHttp) {
+  ASSERT_TRUE(test::bootDevice());
+  requestCueRename(1, "Door \"slam\"");
+  test::runFor(kRunLoopMaxSleepMillis);
+
+  const sim::HttpResponse response = sim::httpRequest(HTTP_GET, "/api/cues");
+  ASSERT_EQ(response.code, 200);
+  DynamicJsonDocument doc(4096);
+  ASSERT_FALSE(deserializeJson(doc, response.body)) << response.body;
+  EXPECT_EQ(doc["count"].as<uint32_t>(), kCueCount);
+  ASSERT_EQ(doc["cues"].as<JsonArrayConst>().size(), kCueCount);
+  EXPECT_STREQ(doc["cues"][1]["text"] | "", "Door \"slam\"");
+}
+
+}  // namespace
+}  // namespace stagecue
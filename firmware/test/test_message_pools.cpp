@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <ArduinoJson.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "message_pools.h"
+#include "test_support.h"
+
+extern "C" void *__libc_malloc(size_t size);
+
+namespace {
+
+std::atomic<bool> gCountAllocations{false};
+std::atomic<uint32_t> gFirmwareAllocations{0};
+
+}  // namespace
+
+// Counts heap blocks taken by firmware code while a soak window is open;
+// library code (AsyncWebSocket's own message copies) is left out.
+extern "C" void *malloc(size_t size) {
+  if (gCountAllocations.load(std::memory_order_relaxed) && !sim::inLibraryCode()) {
+    gFirmwareAllocations.fetch_add(1U, std::memory_order_relaxed);
+  }
+  return __libc_malloc(size);
+}
+
+namespace stagecue {
+namespace {
+
+size_t countAcks(uint32_t client, const char *action) {
+  size_t acks = 0;
+  for (const sim::WebSocketMessage &message : sim::takeWebSocketMessages(client)) {
+    StaticJsonDocument<256> doc;
+    if (message.binary || deserializeJson(doc, message.data)) {
+      continue;
+    }
+    if (strcmp(doc["type"] | "", "ack") == 0 && strcmp(doc["action"] | "", action) == 0 &&
+        doc["ok"].as<bool>()) {
+      ++acks;
+    }
+  }
+  return acks;
+}
+
+class MessagePoolTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { ASSERT_TRUE(test::bootDevice()); }
+
+  void SetUp() override {
+    client_ = sim::connectWebSocket("/ws");
+    ASSERT_NE(client_, 0U);
+    test::runFor(100);
+    sim::takeWebSocketMessages(client_);
+  }
+
+  void TearDown() override {
+    gCountAllocations = false;
+    sim::disconnectWebSocket(client_);
+    for (uint8_t i = 0; i < kCueCount; ++i) {
+      requestCueRelease(i);
+    }
+    test::runFor(100);
+  }
+
+  uint32_t client_ = 0;
+};
+
+TEST_F(MessagePoolTest, SoakKeepsTheFirmwareOffTheHeap) {
+  constexpr int kRounds = 1000;
+
+  std::vector<std::string> messages;
+  for (uint8_t i = 0; i < kCueCount; ++i) {
+    messages.push_back(R"({"type":"trigger","cue":)" + std::to_string(i) + "}");
+    messages.push_back(R"({"type":"release","cue":)" + std::to_string(i) + "}");
+  }
+  messages.push_back(R"({"type":"ping"})");
+  messages.push_back(R"({"type":"batch","ops":[{"op":"trigger","cue":"all"}]})");
+  messages.push_back(R"({"type":"batch","ops":[{"op":"release","cue":"all"}]})");
+
+  // Warm-up: lazily built state (sessions, rings) is not a leak.
+  for (const std::string &message : messages) {
+    sim::sendWebSocketText(client_, message);
+    test::runFor(kRunLoopMaxSleepMillis);
+  }
+  sim::takeWebSocketMessages(client_);
+  const size_t libraryBuffers = sim::webSocketBuffers();
+  const SlabPoolStats outboundBefore = getMessagePoolStats(MessagePool::kOutbound);
+
+  size_t sent = 0;
+  for (int round = 0; round < kRounds; ++round) {
+    const std::string &message = messages[round % messages.size()];
+    gCountAllocations = true;
+    sim::sendWebSocketText(client_, message);
+    test::runFor(5);
+    gCountAllocations = false;
+    ++sent;
+    if (round % 16 == 15) {
+      sim::takeWebSocketMessages(client_);
+    }
+  }
+  test::runFor(100);
+  sim::takeWebSocketMessages(client_);
+
+  EXPECT_EQ(sent, static_cast<size_t>(kRounds));
+  EXPECT_EQ(gFirmwareAllocations.load(), 0U);
+  EXPECT_EQ(sim::webSocketBuffers(), libraryBuffers);
+  EXPECT_TRUE(sim::webSocketConnected(client_));
+
+  const SlabPoolStats outbound = getMessagePoolStats(MessagePool::kOutbound);
+  EXPECT_GT(outbound.acquires, outboundBefore.acquires);
+  EXPECT_EQ(outbound.exhausted, outboundBefore.exhausted);
+  for (size_t i = 0; i < kMessagePoolCount; ++i) {
+    const SlabPoolStats stats = getMessagePoolStats(static_cast<MessagePool>(i));
+    EXPECT_LE(stats.highWater, stats.slots) << messagePoolName(static_cast<MessagePool>(i));
+  }
+}
+
+TEST_F(MessagePoolTest, RepliesStillGoOutWithTheOutboundPoolExhausted) {
+  const SlabPoolStats before = getMessagePoolStats(MessagePool::kOutbound);
+  {
+    std::vector<std::unique_ptr<MessageBuffer>> held;
+    for (size_t i = 0; i < kOutboundFrameSlots; ++i) {
+      held.push_back(std::make_unique<MessageBuffer>(MessagePool::kOutbound, 64U));
+      ASSERT_TRUE(*held.back());
+    }
+
+    sim::sendWebSocketText(client_, R"({"type":"ping"})");
+    ASSERT_TRUE(test::runUntil([&] { return countAcks(client_, "ping") == 1U; }));
+  }
+  EXPECT_GT(getMessagePoolStats(MessagePool::kOutbound).exhausted, before.exhausted);
+
+  // With the slots back, replies come from the pool again.
+  const SlabPoolStats released = getMessagePoolStats(MessagePool::kOutbound);
+  sim::sendWebSocketText(client_, R"({"type":"ping"})");
+  ASSERT_TRUE(test::runUntil([&] { return countAcks(client_, "ping") == 1U; }));
+  EXPECT_EQ(getMessagePoolStats(MessagePool::kOutbound).exhausted, released.exhausted);
+}
+
+}  // namespace
+}  // namespace stagecue
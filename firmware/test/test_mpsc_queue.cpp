@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mpsc_queue.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+struct Item {
+  uint32_t producer = 0;
+  uint32_t sequence = 0;
+};
+
+TEST(MpscQueueTest, FifoUntilFull) {
+  MpscQueue<uint32_t, 4> queue;
+  for (uint32_t i = 0; i < 4U; ++i) {
+    EXPECT_TRUE(queue.push(i));
+  }
+  EXPECT_FALSE(queue.push(99));
+  EXPECT_EQ(queue.sizeApprox(), 4U);
+
+  uint32_t value = 0;
+  for (uint32_t i = 0; i < 4U; ++i) {
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(MpscQueueTest, WrapsAroundManyTimes) {
+  MpscQueue<uint32_t, 8> queue;
+  uint32_t next = 0;
+  uint32_t expected = 0;
+  for (int round = 0; round < 1000; ++round) {
+    for (int i = 0; i < 5; ++i) {
+      ASSERT_TRUE(queue.push(next++));
+    }
+    uint32_t value = 0;
+    while (queue.pop(value)) {
+      ASSERT_EQ(value, expected++);
+    }
+  }
+  EXPECT_EQ(expected, next);
+}
+
+// Producers race each other and the consumer; every accepted item arrives
+// exactly once and in per-producer order. The size producers see after a
+// push, as submitCueCommand() reads it for the high-water mark, stays
+// within the capacity.
+TEST(MpscQueueTest, ConcurrentProducersKeepTheirOrder) {
+  constexpr uint32_t kProducers = 4;
+  constexpr uint32_t kItemsEach = 50000;
+  MpscQueue<Item, 16> queue;
+  std::atomic<size_t> largestSize{0};
+
+  std::vector<std::thread> producers;
+  for (uint32_t p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, &largestSize, p] {
+      for (uint32_t i = 0; i < kItemsEach;) {
+        if (queue.push(Item{p, i})) {
+          ++i;
+          const size_t size = queue.sizeApprox();
+          size_t largest = largestSize.load();
+          while (size > largest && !largestSize.compare_exchange_weak(largest, size)) {
+          }
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::array<uint32_t, kProducers> next{};
+  uint32_t received = 0;
+  Item item;
+  while (received < kProducers * kItemsEach) {
+    if (!queue.pop(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_LT(item.producer, kProducers);
+    ASSERT_EQ(item.sequence, next[item.producer]) << "producer " << item.producer;
+    ++next[item.producer];
+    ++received;
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  EXPECT_FALSE(queue.pop(item));
+  EXPECT_LE(largestSize.load(), 16U);
+}
+
+// The cue engine's command queue: commands from other tasks are counted
+// and rejected once it is full, never lost silently.
+TEST(MpscQueueTest, CueCommandsBeyondCapacityAreRejected) {
+  ASSERT_TRUE(test::bootDevice());
+  const CueCommandStats before = getCueCommandStats();
+
+  uint32_t accepted = 0;
+  std::thread web([&accepted] {
+    for (size_t i = 0; i < kCueCommandQueueSize * 2U; ++i) {
+      accepted += requestCueRename(0, i % 2U == 0U ? "A" : "B") ? 1U : 0U;
+    }
+  });
+  web.join();
+  EXPECT_EQ(accepted, kCueCommandQueueSize);
+
+  test::runFor(kRunLoopMaxSleepMillis);
+  const CueCommandStats after = getCueCommandStats();
+  EXPECT_EQ(after.submitted - before.submitted, kCueCommandQueueSize);
+  EXPECT_EQ(after.rejected - before.rejected, kCueCommandQueueSize);
+  EXPECT_EQ(after.applied - before.applied, kCueCommandQueueSize);
+  EXPECT_EQ(after.highWater, kCueCommandQueueSize);
+}
+
+// A full-length label of one repeated letter: lowercase for the label a
+// trigger carries, uppercase for a rename while the cue is idle.
+std::string roundLabel(uint32_t round, bool live) {
+  return std::string(CueLabel::kCapacity, static_cast<char>((live ? 'a' : 'A') + round % 26U));
+}
+
+// Web tasks rename, trigger and release every cue while others read
+// snapshots and the loop task applies the commands. A snapshot is one copy
+// under the cue lock: its label is never a mix of two, and an active cue
+// always shows the label of the trigger that armed it.
+TEST(MpscQueueTest, CueSnapshotsAreNeverTorn) {
+  ASSERT_TRUE(test::bootDevice());
+  constexpr uint32_t kRounds = 1000;
+  std::atomic<uint32_t> producersLeft{kCueCount};
+  std::atomic<bool> reading{true};
+  std::atomic<uint32_t> snapshots{0};
+  std::atomic<uint32_t> torn{0};
+
+  auto submit = [](auto &&request) {
+    while (!request()) {
+      std::this_thread::yield();
+    }
+  };
+  std::vector<std::thread> producers;
+  for (uint8_t cue = 0; cue < kCueCount; ++cue) {
+    producers.emplace_back([&, cue] {
+      for (uint32_t round = 0; round < kRounds; ++round) {
+        const std::string idle = roundLabel(round, false);
+        const std::string live = roundLabel(round, true);
+        submit([&] { return requestCueRename(cue, idle.c_str()); });
+        submit([&] { return requestCueTrigger(cue, live.c_str()); });
+        submit([&] { return requestCueRelease(cue); });
+      }
+      producersLeft.fetch_sub(1U);
+    });
+  }
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 2; ++r) {
+    readers.emplace_back([&] {
+      while (reading.load()) {
+        for (uint8_t cue = 0; cue < kCueCount; ++cue) {
+          const CueSnapshot snapshot = getCueSnapshot(cue);
+          const char *text = snapshot.text.c_str();
+          const size_t length = snapshot.text.length();
+          bool consistent = std::string(text).size() == length;
+          if (length == CueLabel::kCapacity) {
+            consistent = consistent && std::string(length, text[0]) == text &&
+                         (!snapshot.state.active || (text[0] >= 'a' && text[0] <= 'z'));
+          }
+          torn.fetch_add(consistent ? 0U : 1U);
+          snapshots.fetch_add(1U);
+        }
+      }
+    });
+  }
+
+  const CueCommandStats before = getCueCommandStats();
+  while (producersLeft.load() != 0U) {
+    updateCues();
+    std::this_thread::yield();
+  }
+  updateCues();
+  reading = false;
+  for (auto &thread : producers) {
+    thread.join();
+  }
+  for (auto &thread : readers) {
+    thread.join();
+  }
+
+  const CueCommandStats after = getCueCommandStats();
+  EXPECT_EQ(after.applied - before.applied, after.submitted - before.submitted);
+  EXPECT_GT(snapshots.load(), 0U);
+  EXPECT_EQ(torn.load(), 0U) << "of " << snapshots.load() << " snapshots";
+  for (uint8_t cue = 0; cue < kCueCount; ++cue) {
+    const CueSnapshot snapshot = getCueSnapshot(cue);
+    EXPECT_FALSE(snapshot.state.active);
+    EXPECT_STREQ(snapshot.text.c_str(), roundLabel(kRounds - 1U, true).c_str());
+  }
+}
+
+}  // namespace
+}  // namespace stagecue
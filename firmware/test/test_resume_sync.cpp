@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <ArduinoJson.h>
+
+#include <string>
+
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+struct Message {
+  std::string type;
+  int index = -1;
+  uint16_t seq = 0;
+  uint32_t epoch = 0;
+  std::vector<int> cues;
+};
+
+std::vector<Message> receive(uint32_t client) {
+  std::vector<Message> parsed;
+  for (const auto &raw : sim::takeWebSocketMessages(client)) {
+    if (raw.binary) {
+      continue;
+    }
+    DynamicJsonDocument doc(2048);
+    EXPECT_FALSE(deserializeJson(doc, raw.data)) << raw.data;
+    Message message;
+    message.type = doc["type"] | "";
+    message.index = doc["index"] | -1;
+    message.seq = doc["seq"] | 0U;
+    message.epoch = doc["epoch"] | 0U;
+    for (JsonVariantConst cue : doc["cues"].as<JsonArrayConst>()) {
+      message.cues.push_back(cue["index"] | -1);
+    }
+    parsed.push_back(message);
+  }
+  return parsed;
+}
+
+class ResumeSyncTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { ASSERT_TRUE(test::bootDevice()); }
+
+  // Connects and returns the init message.
+  static Message join(uint32_t &client, const std::string &query = std::string()) {
+    client = sim::connectWebSocket("/ws" + query);
+    EXPECT_NE(client, 0U);
+    test::runFor(kRunLoopMaxSleepMillis);
+    const auto messages = receive(client);
+    EXPECT_FALSE(messages.empty());
+    return messages.empty() ? Message{} : messages.front();
+  }
+
+  static void toggle(uint8_t index) {
+    if (getCueSnapshot(index).state.active) {
+      requestCueRelease(index);
+    } else {
+      requestCueTrigger(index);
+    }
+    test::runFor(2);
+  }
+};
+
+TEST_F(ResumeSyncTest, ReconnectGetsOnlyMissedCues) {
+  uint32_t client = 0;
+  const Message init = join(client);
+  ASSERT_EQ(init.type, "init");
+  sim::disconnectWebSocket(client);
+
+  toggle(1);
+  toggle(1);
+  toggle(2);
+
+  const Message resumed = join(client, "?since=" + std::to_string(init.seq) +
+                                           "&epoch=" + std::to_string(init.epoch));
+  EXPECT_EQ(resumed.type, "delta");
+  EXPECT_EQ(resumed.cues, (std::vector<int>{1, 2}));
+  EXPECT_EQ(static_cast<uint16_t>(resumed.seq - init.seq), 3U);
+  sim::disconnectWebSocket(client);
+}
+
+TEST_F(ResumeSyncTest, ForeignEpochOrLongGapGetsSnapshot) {
+  uint32_t client = 0;
+  const Message init = join(client);
+  sim::disconnectWebSocket(client);
+
+  toggle(0);
+  Message resumed = join(client, "?since=" + std::to_string(init.seq) +
+                                     "&epoch=" + std::to_string(init.epoch + 1U));
+  EXPECT_EQ(resumed.type, "init");
+  sim::disconnectWebSocket(client);
+
+  for (size_t i = 0; i <= kStateDeltaRingSize; ++i) {
+    toggle(0);
+  }
+  resumed = join(client, "?since=" + std::to_string(init.seq) +
+                             "&epoch=" + std::to_string(init.epoch));
+  EXPECT_EQ(resumed.type, "init");
+  sim::disconnectWebSocket(client);
+}
+
+// A client that fell behind gets its backlog in sequence order, ahead of
+// anything newer.
+TEST_F(ResumeSyncTest, BacklogGoesOutInSequenceOrder) {
+  uint32_t client = 0;
+  join(client);
+
+  sim::stallWebSocket(client, true);
+  for (size_t i = 0; i < WS_MAX_QUEUED_MESSAGES; ++i) {
+    toggle(0);
+  }
+  // Queue full: these wait in the session backlog, cue 2 before cue 0.
+  toggle(2);
+  toggle(0);
+  sim::stallWebSocket(client, false);
+  EXPECT_EQ(sim::webSocketDropped(client), 0U);
+
+  toggle(1);
+  const auto messages = receive(client);
+  ASSERT_GE(messages.size(), WS_MAX_QUEUED_MESSAGES + 3U);
+
+  std::vector<int> tail;
+  for (size_t i = 1; i < messages.size(); ++i) {
+    EXPECT_GT(static_cast<int16_t>(messages[i].seq - messages[i - 1].seq), 0)
+        << "message " << i << " (" << messages[i].type << ")";
+  }
+  for (size_t i = messages.size() - 3U; i < messages.size(); ++i) {
+    tail.push_back(messages[i].index);
+  }
+  EXPECT_EQ(tail, (std::vector<int>{2, 0, 1}));
+  sim::disconnectWebSocket(client);
+}
+
+}  // namespace
+}  // namespace stagecue
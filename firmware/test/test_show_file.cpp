@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+
+#include "show.h"
+#include "test_support.h"
+#include "web_server.h"
+
+namespace stagecue {
+namespace {
+
+constexpr char kShow[] =
+    "# channel\tauto-release\ttext\n"
+    "1\t0\tHouse to half\n"
+    "\n"
+    "2\t\tThunder\n"
+    "not a cue\n"
+    "1\t0\tHouse out\n";
+
+uint32_t broadcastNotifications() {
+  DynamicJsonDocument doc(4096);
+  deserializeJson(doc, sim::httpRequest(HTTP_GET, "/api/ws").body);
+  return doc["broadcast"]["notifications"].as<uint32_t>();
+}
+
+// Labels the client was sent for `index`, in order.
+std::vector<std::string> labelsSent(uint32_t client, uint8_t index) {
+  std::vector<std::string> labels;
+  for (const sim::WebSocketMessage &message : sim::takeWebSocketMessages(client)) {
+    DynamicJsonDocument doc(2048);
+    if (message.binary || deserializeJson(doc, message.data)) {
+      continue;
+    }
+    if (doc["type"] == "cue" && doc["index"].as<uint8_t>() == index) {
+      labels.emplace_back(doc["text"].as<const char *>());
+    }
+  }
+  return labels;
+}
+
+class ShowFileTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    ASSERT_TRUE(test::bootDevice());
+    sim::writeFile(kShowFilePath, kShow);
+    const sim::HttpResponse response = sim::httpRequest(HTTP_POST, "/api/show/reload");
+    ASSERT_EQ(response.code, 202);
+    ASSERT_TRUE(test::runUntil([] { return getShowStatus().loaded; }));
+  }
+
+  void SetUp() override {
+    ASSERT_TRUE(requestShowJump(0));
+    for (uint8_t i = 0; i < kCueCount; ++i) {
+      requestCueRelease(i);
+    }
+    test::runFor(kRunLoopMaxSleepMillis);
+  }
+};
+
+TEST_F(ShowFileTest, CompilesRecordsAndSkipsBadLines) {
+  const std::unique_ptr<CompiledShow> show = compileShowFile(LittleFS, kShowFilePath);
+  ASSERT_NE(show, nullptr);
+  ASSERT_EQ(show->count, 3U);
+  EXPECT_EQ(show->skippedLines, 1U);
+  EXPECT_EQ(show->records[0].channel, 0U);
+  EXPECT_EQ(show->records[0].autoReleaseMs, 0U);
+  EXPECT_STREQ(show->text(show->records[0]), "House to half");
+  EXPECT_EQ(show->records[1].channel, 1U);
+  EXPECT_EQ(show->records[1].autoReleaseMs, kCueAutoReleaseMillis);
+  EXPECT_STREQ(show->text(show->records[2]), "House out");
+
+  EXPECT_EQ(compileShowFile(LittleFS, "/missing.txt"), nullptr);
+}
+
+TEST_F(ShowFileTest, ReloadAnswersBeforeCompiling) {
+  sim::removeFile(kShowFilePath);
+  EXPECT_EQ(sim::httpRequest(HTTP_POST, "/api/show/reload").code, 202);
+  test::runFor(100);
+  // A failed reload keeps the show that was loaded.
+  EXPECT_TRUE(getShowStatus().loaded);
+  EXPECT_EQ(getShowStatus().count, 3U);
+  sim::writeFile(kShowFilePath, kShow);
+}
+
+TEST_F(ShowFileTest, GoSendsLabelWithStateInOneNotification) {
+  const uint32_t client = sim::connectWebSocket("/ws");
+  ASSERT_NE(client, 0U);
+  test::runFor(100);
+  sim::takeWebSocketMessages(client);
+
+  const uint32_t before = broadcastNotifications();
+  ASSERT_TRUE(requestShowGo());
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_EQ(broadcastNotifications() - before, 1U);
+  EXPECT_TRUE(getCueSnapshot(0).state.active);
+  EXPECT_EQ(labelsSent(client, 0), std::vector<std::string>{"House to half"});
+  EXPECT_EQ(getShowStatus().position, 1U);
+
+  // Channel 1 is still held, so only its label changes.
+  ASSERT_TRUE(requestShowJump(2));
+  ASSERT_TRUE(requestShowGo());
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_TRUE(getCueSnapshot(0).state.active);
+  EXPECT_EQ(labelsSent(client, 0), std::vector<std::string>{"House out"});
+
+  sim::disconnectWebSocket(client);
+  test::runFor(100);
+}
+
+}  // namespace
+}  // namespace stagecue
@@ -0,0 +1,181 @@
+// Web assets, built twice: test_static_assets_packed links the core that
+// tools/pack_assets.py fed, which serves gzip'd blobs from flash with strong
+// ETags; test_static_assets has no packed assets and LittleFS serves the
+// files. Each build skips the cases that belong to the other.
+
+#include <gtest/gtest.h>
+
+#include <ArduinoJson.h>
+
+#include <map>
+#include <string>
+
+#include "static_assets.h"
+#include "test_support.h"
+
+namespace stagecue {
+namespace {
+
+const std::map<std::string, std::string> kGzip{{"Accept-Encoding", "gzip, deflate"}};
+constexpr const char *kAppJs = "/app.js";
+const std::string kAppJsOnLittleFs = "console.log('stagecue');\n";
+
+bool isPacked() {
+  return getStaticAssetCount() > 0U;
+}
+
+size_t slotFor(const char *path) {
+  for (size_t slot = 0; slot < getStaticAssetCount(); ++slot) {
+    if (std::string(getStaticAssetStats(slot).path) == path) {
+      return slot;
+    }
+  }
+  ADD_FAILURE() << path << " is not packed";
+  return 0;
+}
+
+bool isGzip(const std::string &body) {
+  return body.size() > 2U && static_cast<uint8_t>(body[0]) == 0x1fU &&
+         static_cast<uint8_t>(body[1]) == 0x8bU;
+}
+
+class StaticAssetsTest : public ::testing::Test {
+ protected:
+  // The LittleFS copy only serves clients without gzip, or every client
+  // when nothing was packed.
+  static void SetUpTestSuite() {
+    sim::writeFile(kAppJs, kAppJsOnLittleFs);
+    ASSERT_TRUE(test::bootDevice());
+  }
+};
+
+// Every packed asset comes from its in-flash blob: gzip'd, with a strong
+// ETag and no filesystem read. Hashed scripts and styles never revalidate.
+TEST_F(StaticAssetsTest, PackedAssetsServeGzipFromFlash) {
+  if (!isPacked()) {
+    GTEST_SKIP() << "built without the pack step";
+  }
+  for (size_t slot = 0; slot < getStaticAssetCount(); ++slot) {
+    const StaticAssetStats before = getStaticAssetStats(slot);
+    const std::string path = before.path;
+    const uint32_t opens = sim::fileOpens();
+
+    const sim::HttpResponse response = sim::httpRequest(HTTP_GET, path, {}, kGzip);
+    ASSERT_EQ(response.code, 200) << path;
+    EXPECT_EQ(response.header("Content-Encoding"), "gzip") << path;
+    EXPECT_TRUE(isGzip(response.body)) << path;
+    const std::string etag = response.header("ETag");
+    ASSERT_GT(etag.size(), 2U) << path;
+    EXPECT_EQ(etag.front(), '"');
+    EXPECT_EQ(etag.back(), '"');
+    const bool page = path.size() > 5U && path.compare(path.size() - 5U, 5U, ".html") == 0;
+    EXPECT_EQ(response.header("Cache-Control"),
+              page ? "no-cache" : "public, max-age=31536000, immutable")
+        << path;
+
+    const StaticAssetStats after = getStaticAssetStats(slot);
+    EXPECT_EQ(after.requests - before.requests, 1U);
+    EXPECT_EQ(after.bytesSent - before.bytesSent, response.body.size());
+    EXPECT_EQ(sim::fileOpens(), opens) << path;
+  }
+}
+
+// A revalidation with the current ETag is answered with an empty 304; a
+// stale one gets the asset again.
+TEST_F(StaticAssetsTest, MatchingIfNoneMatchIsNotModified) {
+  if (!isPacked()) {
+    GTEST_SKIP() << "built without the pack step";
+  }
+  const size_t slot = slotFor("/index.html");
+  const std::string etag = sim::httpRequest(HTTP_GET, "/index.html", {}, kGzip).header("ETag");
+  const StaticAssetStats before = getStaticAssetStats(slot);
+
+  std::map<std::string, std::string> headers = kGzip;
+  headers["If-None-Match"] = etag;
+  const sim::HttpResponse revalidated = sim::httpRequest(HTTP_GET, "/index.html", {}, headers);
+  EXPECT_EQ(revalidated.code, 304);
+  EXPECT_TRUE(revalidated.body.empty());
+  EXPECT_EQ(revalidated.header("ETag"), etag);
+  EXPECT_EQ(revalidated.header("Content-Encoding"), "");
+
+  headers["If-None-Match"] = "\"0000000000000000\"";
+  const sim::HttpResponse stale = sim::httpRequest(HTTP_GET, "/index.html", {}, headers);
+  EXPECT_EQ(stale.code, 200);
+  EXPECT_TRUE(isGzip(stale.body));
+
+  const StaticAssetStats after = getStaticAssetStats(slot);
+  EXPECT_EQ(after.requests - before.requests, 2U);
+  EXPECT_EQ(after.notModified - before.notModified, 1U);
+  EXPECT_EQ(after.bytesSent - before.bytesSent, stale.body.size());
+
+  // "/" is the same page under the same ETag.
+  const sim::HttpResponse root = sim::httpRequest(HTTP_GET, "/", {}, headers);
+  EXPECT_EQ(root.code, 200);
+  EXPECT_EQ(root.header("ETag"), etag);
+}
+
+// The flash blob is the cache: a gzip client never touches the filesystem,
+// a client without gzip misses it and reads the plain file from LittleFS.
+TEST_F(StaticAssetsTest, ClientWithoutGzipMissesTheFlashCopy) {
+  if (!isPacked()) {
+    GTEST_SKIP() << "built without the pack step";
+  }
+  const size_t slot = slotFor(kAppJs);
+  const StaticAssetStats before = getStaticAssetStats(slot);
+  const uint32_t opens = sim::fileOpens();
+
+  const sim::HttpResponse hit = sim::httpRequest(HTTP_GET, kAppJs, {}, kGzip);
+  EXPECT_TRUE(isGzip(hit.body));
+  EXPECT_EQ(sim::fileOpens(), opens);
+
+  const sim::HttpResponse miss = sim::httpRequest(HTTP_GET, kAppJs);
+  EXPECT_EQ(miss.code, 200);
+  EXPECT_EQ(miss.header("Content-Encoding"), "");
+  EXPECT_EQ(miss.body, kAppJsOnLittleFs);
+  EXPECT_EQ(miss.header("ETag"), hit.header("ETag"));
+  EXPECT_EQ(sim::fileOpens(), opens + 1U);
+
+  const StaticAssetStats after = getStaticAssetStats(slot);
+  EXPECT_EQ(after.requests - before.requests, 2U);
+  EXPECT_EQ(after.bytesSent - before.bytesSent, hit.body.size());
+}
+
+// /api/assets reports the counters getStaticAssetStats() holds, one entry
+// per packed asset and none without the pack step.
+TEST_F(StaticAssetsTest, ApiReportsPerAssetCounters) {
+  sim::httpRequest(HTTP_GET, kAppJs, {}, kGzip);
+  const sim::HttpResponse response = sim::httpRequest(HTTP_GET, "/api/assets");
+  ASSERT_EQ(response.code, 200);
+  EXPECT_EQ(response.header("Cache-Control"), "no-store");
+
+  DynamicJsonDocument doc(4096);
+  ASSERT_FALSE(deserializeJson(doc, response.body)) << response.body;
+  JsonArrayConst assets = doc["assets"];
+  ASSERT_EQ(assets.size(), getStaticAssetCount());
+  for (size_t slot = 0; slot < assets.size(); ++slot) {
+    const StaticAssetStats stats = getStaticAssetStats(slot);
+    JsonObjectConst entry = assets[slot];
+    EXPECT_STREQ(entry["path"] | "", stats.path);
+    EXPECT_EQ(entry["requests"].as<uint32_t>(), stats.requests);
+    EXPECT_EQ(entry["notModified"].as<uint32_t>(), stats.notModified);
+    EXPECT_EQ(entry["bytesSent"].as<uint32_t>(), stats.bytesSent);
+    EXPECT_LE(entry["lastServeUs"].as<uint32_t>(), entry["maxServeUs"].as<uint32_t>());
+  }
+}
+
+// Without the pack step every client gets the plain file from LittleFS.
+TEST_F(StaticAssetsTest, UnpackedBuildServesLittleFs) {
+  if (isPacked()) {
+    GTEST_SKIP() << "built with packed assets";
+  }
+  const uint32_t opens = sim::fileOpens();
+  const sim::HttpResponse response = sim::httpRequest(HTTP_GET, kAppJs, {}, kGzip);
+  EXPECT_EQ(response.code, 200);
+  EXPECT_EQ(response.body, kAppJsOnLittleFs);
+  EXPECT_EQ(response.header("Content-Encoding"), "");
+  EXPECT_EQ(response.header("Cache-Control"), "max-age=3600, public");
+  EXPECT_EQ(sim::fileOpens(), opens + 1U);
+}
+
+}  // namespace
+}  // namespace stagecue
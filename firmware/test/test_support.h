@@ -0,0 +1,119 @@
+#pragma once
+
+// Shared set-up for the host suites: boots the firmware the way setup()
+// does and drives the loop task from the test thread.
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "boot_sequence.h"
+#include "config.h"
+#include "cues.h"
+#include "display_manager.h"
+#include "run_loop.h"
+#include "sim.h"
+
+namespace stagecue {
+namespace test {
+
+// Runs loop() passes until `ms` of simulated time went by. Idle waits
+// fast-forward the clock up to that point, so this costs real time only for
+// work done.
+inline void runFor(uint32_t ms) {
+  const uint32_t deadline = millis() + ms;
+  sim::setIdleHorizon(sim::nowMicros() + static_cast<uint64_t>(ms) * 1000U);
+  while (static_cast<int32_t>(millis() - deadline) < 0) {
+    runLoop();
+  }
+  sim::setIdleHorizon(UINT64_MAX);
+}
+
+// Runs loop() passes until `done` holds; false after `limitMs`.
+inline bool runUntil(const std::function<bool()> &done, uint32_t limitMs = 5000U) {
+  const uint32_t deadline = millis() + limitMs;
+  while (!done()) {
+    if (static_cast<int32_t>(millis() - deadline) >= 0) {
+      return false;
+    }
+    runLoop();
+  }
+  return true;
+}
+
+inline void attachDisplays() {
+  if (kOledUseMux) {
+    sim::attachI2cDevice(kOledMuxAddress);
+    sim::attachI2cDevice(kOledBaseAddress);
+    return;
+  }
+  for (size_t i = 0; i < kCueCount; ++i) {
+    sim::attachI2cDevice(static_cast<uint8_t>(kOledBaseAddress + i));
+  }
+}
+
+// The 10k resistors GPIO34-39 need as button inputs.
+inline void fitExternalPullUps() {
+  for (uint8_t pin : kCueButtons) {
+    if (!hasInternalPullUp(pin)) {
+      sim::setPinInput(pin, true);
+    }
+  }
+}
+
+// Waits (in real time) until the display flush task has pushed every frame
+// handed to it so far.
+inline void settleDisplays() {
+  uint32_t previous = UINT32_MAX;
+  for (;;) {
+    uint32_t updates = 0;
+    for (size_t i = 0; i < kCueCount; ++i) {
+      updates += getDisplayFlushStats(static_cast<uint8_t>(i)).updates;
+    }
+    if (updates == previous) {
+      return;
+    }
+    previous = updates;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+// What setup() does, with every panel attached: cue I/O is live on return,
+// displays and network still come up on their boot tasks.
+inline void powerOn() {
+  attachDisplays();
+  fitExternalPullUps();
+  Serial.begin(115200);
+  initRunLoop();
+  initCues();
+  startBackgroundBringUp();
+}
+
+// powerOn(), then waits until the web server answers and the displays show
+// their boot labels.
+inline bool bootDevice() {
+  powerOn();
+  const bool up = runUntil([] {
+    for (size_t i = 0; i < kCueCount; ++i) {
+      if (!isDisplayReady(static_cast<uint8_t>(i))) {
+        return false;
+      }
+    }
+    return sim::httpRequest(HTTP_GET, "/api/health").code != 0;
+  });
+  runFor(kRunLoopMaxSleepMillis);  // the display refresh queued by bring-up
+  settleDisplays();
+  return up;
+}
+
+// A button press held for `holdMs`, then released; pins idle high.
+inline void pressButton(uint8_t index, uint32_t holdMs = kButtonDebounceMillis * 2U) {
+  sim::setPinInput(kCueButtons[index], false);
+  runFor(holdMs);
+  sim::setPinInput(kCueButtons[index], true);
+}
+
+}  // namespace test
+}  // namespace stagecue
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "test_support.h"
+#include "timer_wheel.h"
+
+namespace stagecue {
+namespace {
+
+// Firing times by timer argument; UINT32_MAX until it fires.
+std::vector<uint32_t> gFiredAt;
+uint32_t gNowMs = 0;
+
+void recordFire(uint32_t arg) {
+  EXPECT_EQ(gFiredAt[arg], UINT32_MAX) << "timer " << arg << " fired twice";
+  gFiredAt[arg] = gNowMs;
+}
+
+size_t advanceTo(TimerWheel &wheel, uint32_t nowMs) {
+  gNowMs = nowMs;
+  return wheel.advance(nowMs);
+}
+
+class TimerWheelTest : public ::testing::Test {
+ protected:
+  void SetUp() override { gFiredAt.assign(kTimerPoolSize, UINT32_MAX); }
+};
+
+TEST_F(TimerWheelTest, FiresOnItsDeadlineNotBefore) {
+  TimerWheel wheel(1000);
+  ASSERT_NE(wheel.schedule(1010, recordFire, 0), kInvalidTimer);
+  ASSERT_NE(wheel.schedule(1000 + 300, recordFire, 1), kInvalidTimer);  // past the root level
+  ASSERT_NE(wheel.schedule(500, recordFire, 2), kInvalidTimer);         // already due
+
+  EXPECT_EQ(advanceTo(wheel, 1000), 1U);
+  EXPECT_EQ(gFiredAt[2], 1000U);
+  EXPECT_EQ(advanceTo(wheel, 1009), 0U);
+  EXPECT_EQ(advanceTo(wheel, 1010), 1U);
+  EXPECT_EQ(advanceTo(wheel, 1299), 0U);
+  EXPECT_EQ(advanceTo(wheel, 1400), 1U);
+  EXPECT_EQ(wheel.pending(), 0U);
+  EXPECT_EQ(wheel.stats().fired, 3U);
+}
+
+TEST_F(TimerWheelTest, CancelledAndReusedIdsAreStale) {
+  TimerWheel wheel;
+  const TimerId first = wheel.schedule(50, recordFire, 0);
+  EXPECT_TRUE(wheel.cancel(first));
+  EXPECT_FALSE(wheel.cancel(first));
+
+  // The slot comes back with a new generation.
+  const TimerId second = wheel.schedule(50, recordFire, 1);
+  EXPECT_NE(second, first);
+  EXPECT_FALSE(wheel.cancel(first));
+  advanceTo(wheel, 50);
+  EXPECT_EQ(gFiredAt[0], UINT32_MAX);
+  EXPECT_EQ(gFiredAt[1], 50U);
+  EXPECT_FALSE(wheel.cancel(second));
+  EXPECT_FALSE(wheel.cancel(kInvalidTimer));
+}
+
+TEST_F(TimerWheelTest, RefusesWhenThePoolIsFull) {
+  TimerWheel wheel;
+  for (uint32_t i = 0; i < kTimerPoolSize; ++i) {
+    ASSERT_NE(wheel.schedule(100 + i, recordFire, i), kInvalidTimer);
+  }
+  EXPECT_EQ(wheel.schedule(100, recordFire, 0), kInvalidTimer);
+  EXPECT_EQ(wheel.stats().exhausted, 1U);
+  EXPECT_EQ(wheel.stats().highWater, kTimerPoolSize);
+}
+
+TEST_F(TimerWheelTest, HandlesClockWrap) {
+  const uint32_t start = UINT32_MAX - 100U;
+  TimerWheel wheel(start);
+  ASSERT_NE(wheel.schedule(start + 50U, recordFire, 0), kInvalidTimer);
+  ASSERT_NE(wheel.schedule(start + 5000U, recordFire, 1), kInvalidTimer);  // wraps past 0
+
+  EXPECT_EQ(advanceTo(wheel, start + 50U), 1U);
+  EXPECT_EQ(advanceTo(wheel, start + 4999U), 0U);
+  EXPECT_EQ(advanceTo(wheel, start + 5000U), 1U);
+  EXPECT_EQ(gFiredAt[1], start + 5000U);
+}
+
+// Random deadlines from 0 ms to past the ~18 h horizon, random cancels and
+// uneven advance steps: every live timer fires on the first advance() at or
+// after its deadline, and millisUntilNext() never overshoots it.
+TEST_F(TimerWheelTest, MatchesReferenceOverRandomSchedules) {
+  std::mt19937 rng(1234);
+  constexpr uint32_t kStart = 0xFFF00000U;  // crosses the 32-bit wrap too
+  constexpr uint32_t kDay = 24U * 3600U * 1000U;
+  const uint32_t ranges[] = {255U, 20000U, 3U * 3600U * 1000U, kDay};
+
+  TimerWheel wheel(kStart);
+  std::vector<uint32_t> deadline(kTimerPoolSize);
+  std::vector<TimerId> ids(kTimerPoolSize, kInvalidTimer);
+  for (uint32_t i = 0; i < kTimerPoolSize; ++i) {
+    deadline[i] = kStart + rng() % (ranges[i % 4U] + 1U);
+    ids[i] = wheel.schedule(deadline[i], recordFire, i);
+    ASSERT_NE(ids[i], kInvalidTimer);
+  }
+  std::vector<bool> cancelled(kTimerPoolSize, false);
+  for (uint32_t i = 0; i < kTimerPoolSize; i += 7U) {
+    ASSERT_TRUE(wheel.cancel(ids[i]));
+    cancelled[i] = true;
+  }
+
+  uint32_t previous = kStart - 1U;
+  uint32_t now = kStart;
+  while (wheel.pending() > 0U) {
+    uint32_t earliest = UINT32_MAX;
+    for (uint32_t i = 0; i < kTimerPoolSize; ++i) {
+      if (!cancelled[i] && gFiredAt[i] == UINT32_MAX) {
+        earliest = std::min(earliest, deadline[i] - now);
+      }
+    }
+    EXPECT_LE(wheel.millisUntilNext(now, UINT32_MAX), earliest);
+
+    advanceTo(wheel, now);
+    for (uint32_t i = 0; i < kTimerPoolSize; ++i) {
+      const bool due = static_cast<int32_t>(now - deadline[i]) >= 0;
+      if (cancelled[i]) {
+        EXPECT_EQ(gFiredAt[i], UINT32_MAX);
+      } else if (due && static_cast<int32_t>(previous - deadline[i]) < 0) {
+        EXPECT_EQ(gFiredAt[i], now) << "timer " << i;
+      } else if (!due) {
+        EXPECT_EQ(gFiredAt[i], UINT32_MAX) << "timer " << i << " fired early";
+      }
+    }
+    previous = now;
+    now += 1U + rng() % (rng() % 2U != 0U ? 300U : 3600U * 1000U);
+  }
+  for (uint32_t i = 0; i < kTimerPoolSize; ++i) {
+    EXPECT_NE(gFiredAt[i] == UINT32_MAX, !cancelled[i]) << "timer " << i;
+  }
+}
+
+TEST(TimerWheelDeviceTest, AutoReleaseRunsOffTheWheel) {
+  ASSERT_TRUE(test::bootDevice());
+  ASSERT_TRUE(requestCueTrigger(0));
+  test::runFor(kCueAutoReleaseMillis - 20U);
+  EXPECT_TRUE(getCueSnapshot(0).state.active);
+
+  // Re-triggering restarts the countdown.
+  ASSERT_TRUE(requestCueTrigger(0));
+  test::runFor(kCueAutoReleaseMillis - 20U);
+  EXPECT_TRUE(getCueSnapshot(0).state.active);
+  test::runFor(40);
+  EXPECT_FALSE(getCueSnapshot(0).state.active);
+
+  // Releasing by hand cancels the timer, so the next trigger gets its full time.
+  ASSERT_TRUE(requestCueTrigger(1));
+  test::runFor(50);
+  ASSERT_TRUE(requestCueRelease(1));
+  test::runFor(10);
+  ASSERT_TRUE(requestCueTrigger(1));
+  test::runFor(kCueAutoReleaseMillis - 20U);
+  EXPECT_TRUE(getCueSnapshot(1).state.active);
+}
+
+}  // namespace
+}  // namespace stagecue
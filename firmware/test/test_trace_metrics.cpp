@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+#include <regex>
+#include <set>
+#include <sstream>
+
+#include "test_support.h"
+#include "trace.h"
+
+namespace stagecue {
+namespace {
+
+class TraceMetricsTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    ASSERT_TRUE(test::bootDevice());
+    const uint32_t client = sim::connectWebSocket("/ws");
+    for (int round = 0; round < 20; ++round) {
+      ASSERT_TRUE(requestCueTrigger(round % 2));
+      test::runFor(5);
+      ASSERT_TRUE(requestCueRelease(round % 2));
+      test::runFor(5);
+    }
+    sim::disconnectWebSocket(client);
+    test::runFor(kRunLoopStatsPeriodMillis);  // task stats are published once a period
+  }
+
+  // Sample values by their full `name{labels}` key.
+  static std::map<std::string, double> scrape() {
+    const sim::HttpResponse response = sim::httpRequest(HTTP_GET, "/api/metrics");
+    EXPECT_EQ(response.code, 200);
+    EXPECT_EQ(response.contentType.rfind("text/plain", 0), 0U) << response.contentType;
+
+    static const std::regex kHelp(R"(# HELP (\w+) .+)");
+    static const std::regex kType(R"(# TYPE (\w+) (counter|gauge|histogram))");
+    static const std::regex kSample(R"((\w+)(\{[^}]*\})? (\d+))");
+    std::map<std::string, double> samples;
+    std::set<std::string> typed;
+    std::string help;
+    std::istringstream lines(response.body);
+    std::string line;
+    std::smatch match;
+    while (std::getline(lines, line)) {
+      if (std::regex_match(line, match, kHelp)) {
+        help = match[1];
+      } else if (std::regex_match(line, match, kType)) {
+        EXPECT_EQ(match[1], help) << "TYPE without HELP: " << line;
+        EXPECT_TRUE(typed.insert(match[1]).second) << "family repeated: " << line;
+      } else if (std::regex_match(line, match, kSample)) {
+        const std::string name = match[1];
+        EXPECT_EQ(name.rfind(help, 0), 0U) << "sample outside its family: " << line;
+        EXPECT_TRUE(samples.emplace(name + match[2].str(), std::stod(match[3])).second)
+            << "duplicate sample: " << line;
+      } else {
+        ADD_FAILURE() << "malformed line: " << line;
+      }
+    }
+    EXPECT_FALSE(response.body.empty());
+    EXPECT_EQ(response.body.back(), '\n');
+    return samples;
+  }
+};
+
+TEST_F(TraceMetricsTest, MetricsAreWellFormedPrometheusText) {
+  const std::map<std::string, double> samples = scrape();
+  EXPECT_GT(samples.at(R"(stagecue_span_total{event="apply_cue_state",core="1"})") +
+                samples.at(R"(stagecue_span_total{event="apply_cue_state",core="0"})"),
+            0.0);
+  EXPECT_GE(samples.at(R"(stagecue_cue_commands_total{result="applied"})"), 40.0);
+  EXPECT_EQ(samples.at("stagecue_trace_enabled"), 1.0);
+
+  // Buckets are cumulative and end at _count.
+  for (size_t i = 0; i < kTraceEventCount; ++i) {
+    const std::string event = traceEventName(static_cast<TraceEvent>(i));
+    double previous = 0;
+    for (size_t bucket = 0; bucket < kTraceHistogramBuckets; ++bucket) {
+      const uint32_t bound = traceHistogramBound(bucket);
+      const std::string le = bound == 0U ? "+Inf" : std::to_string(bound);
+      const double value = samples.at("stagecue_span_duration_microseconds_bucket{event=\"" +
+                                      event + "\",le=\"" + le + "\"}");
+      EXPECT_GE(value, previous) << event << " le=" << le;
+      previous = value;
+    }
+    EXPECT_EQ(samples.at("stagecue_span_duration_microseconds_count{event=\"" + event + "\"}"),
+              previous);
+  }
+}
+
+TEST_F(TraceMetricsTest, TraceDumpHasHeaderAndRecords) {
+  const sim::HttpResponse response = sim::httpRequest(HTTP_GET, "/api/trace");
+  ASSERT_EQ(response.code, 200);
+  ASSERT_GE(response.body.size(), sizeof(TraceDumpHeader));
+
+  TraceDumpHeader header;
+  memcpy(&header, response.body.data(), sizeof(header));
+  EXPECT_EQ(std::string(header.magic, 4), "SCTR");
+  EXPECT_EQ(header.recordSize, sizeof(TraceRecord));
+  ASSERT_GT(header.recordCount, 0U);
+  EXPECT_EQ(response.body.size(), sizeof(header) + header.recordCount * sizeof(TraceRecord));
+  EXPECT_GE(header.totalSpans, header.recordCount);
+
+  bool sawApply = false;
+  for (uint32_t i = 0; i < header.recordCount; ++i) {
+    TraceRecord record;
+    memcpy(&record, response.body.data() + sizeof(header) + i * sizeof(TraceRecord),
+           sizeof(record));
+    ASSERT_LT(record.event, kTraceEventCount);
+    EXPECT_LT(record.core, portNUM_PROCESSORS);
+    if (record.event == static_cast<uint8_t>(TraceEvent::kApplyCueState)) {
+      sawApply = true;
+      EXPECT_LT(record.arg, kCueCount);
+    }
+  }
+  EXPECT_TRUE(sawApply);
+}
+
+TEST_F(TraceMetricsTest, RuntimeSwitchStopsRecording) {
+  ASSERT_EQ(sim::httpRequest(HTTP_POST, "/api/trace", {{"enabled", "0"}}).code, 200);
+  EXPECT_FALSE(isTraceEnabled());
+  const uint32_t before = getTraceSpanTotal();
+  ASSERT_TRUE(requestCueTrigger(0));
+  test::runFor(5);
+  ASSERT_TRUE(requestCueRelease(0));
+  test::runFor(5);
+  EXPECT_EQ(getTraceSpanTotal(), before);
+  EXPECT_EQ(scrape().at("stagecue_trace_enabled"), 0.0);
+
+  ASSERT_EQ(sim::httpRequest(HTTP_POST, "/api/trace", {{"enabled", "1"}}).code, 200);
+  ASSERT_TRUE(requestCueTrigger(0));
+  test::runFor(5);
+  EXPECT_GT(getTraceSpanTotal(), before);
+
+  EXPECT_EQ(sim::httpRequest(HTTP_POST, "/api/trace").code, 400);
+}
+
+}  // namespace
+}  // namespace stagecue
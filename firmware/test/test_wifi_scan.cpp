@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <ArduinoJson.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "test_support.h"
+#include "wifi_portal.h"
+
+namespace stagecue {
+namespace {
+
+// The sim's radio takes two simulated seconds per scan.
+constexpr uint32_t kScanSettleMillis = 2500U;
+
+struct ScanReply {
+  int code = 0;
+  bool pending = false;
+  std::vector<std::string> ssids;
+  std::chrono::microseconds took{0};
+};
+
+ScanReply getScan() {
+  ScanReply reply;
+  const auto start = std::chrono::steady_clock::now();
+  const sim::HttpResponse response = sim::httpRequest(HTTP_GET, "/scan");
+  reply.took =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  reply.code = response.code;
+  reply.pending = response.header("X-Scan-Pending") == "1";
+  DynamicJsonDocument doc(4096);
+  EXPECT_FALSE(deserializeJson(doc, response.body)) << response.body;
+  for (JsonVariantConst network : doc.as<JsonArrayConst>()) {
+    reply.ssids.push_back(network["ssid"] | "");
+  }
+  return reply;
+}
+
+bool scanSettled() {
+  const WifiScanStatus status = getWifiScanStatus();
+  return status.valid && !status.scanning;
+}
+
+const std::vector<std::string> kVenue{"Stage", "FOH", "Dressing rooms"};
+
+class WifiScanTest : public ::testing::Test {
+ protected:
+  // The access point started at boot scans an empty band; the venue's
+  // networks show up only afterwards, and the boot scan is left to age out.
+  static void SetUpTestSuite() {
+    ASSERT_TRUE(test::bootDevice());
+    test::runFor(kScanSettleMillis);
+    ASSERT_TRUE(scanSettled());
+    for (const std::string &ssid : kVenue) {
+      sim::AccessPoint ap;
+      ap.ssid = ssid;
+      sim::addAccessPoint(ap);
+    }
+    test::runFor(kWifiScanMaxAgeMillis);
+  }
+};
+
+// A stale cache is served at once while the radio rescans, instead of the
+// request waiting two seconds for it; the cue engine keeps running meanwhile.
+TEST_F(WifiScanTest, StaleRequestAnswersWhileTheRadioScans) {
+  const uint64_t simStartUs = sim::nowMicros();
+  const ScanReply stale = getScan();
+  EXPECT_EQ(stale.code, 200);
+  EXPECT_TRUE(stale.pending);
+  EXPECT_TRUE(stale.ssids.empty());
+  EXPECT_LT(sim::nowMicros() - simStartUs, 1000U);
+  EXPECT_LT(stale.took, std::chrono::milliseconds(100));
+
+  ASSERT_TRUE(requestCueTrigger(0));
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_TRUE(getWifiScanStatus().scanning);
+  EXPECT_TRUE(getCueSnapshot(0).state.active);
+  requestCueRelease(0);
+
+  test::runFor(kScanSettleMillis);
+  ASSERT_TRUE(scanSettled());
+  const ScanReply fresh = getScan();
+  EXPECT_FALSE(fresh.pending);
+  EXPECT_EQ(fresh.ssids, kVenue);
+}
+
+// Within the maximum age the cached list is served and no scan starts.
+TEST_F(WifiScanTest, FreshCacheStartsNoScan) {
+  const uint32_t generation = getWifiScanStatus().generation;
+  for (int i = 0; i < 5; ++i) {
+    const ScanReply cached = getScan();
+    EXPECT_FALSE(cached.pending);
+    EXPECT_EQ(cached.ssids, kVenue);
+    test::runFor(kRunLoopMaxSleepMillis);
+    EXPECT_FALSE(getWifiScanStatus().scanning);
+  }
+  test::runFor(kScanSettleMillis);
+  EXPECT_EQ(getWifiScanStatus().generation, generation);
+}
+
+}  // namespace
+}  // namespace stagecue
@@ -0,0 +1,118 @@
+// One device walked through a network's life: the first join, losing an
+// access point, roaming, and every access point going away. The tests run
+// in order and share the device.
+
+#include <gtest/gtest.h>
+
+#include "test_support.h"
+#include "wifi_portal.h"
+#include "wifi_supervisor.h"
+
+namespace stagecue {
+namespace {
+
+constexpr uint32_t kLongWaitMs = 120000U;
+
+size_t gWeakAp = 0;    // channel 1
+size_t gStrongAp = 0;  // channel 6
+
+sim::AccessPoint makeAccessPoint(uint8_t lastOctet, int32_t channel, int32_t rssi) {
+  sim::AccessPoint ap;
+  ap.ssid = "Stage";
+  ap.bssid[0] = 0x02;
+  ap.bssid[5] = lastOctet;
+  ap.channel = channel;
+  ap.rssi = rssi;
+  return ap;
+}
+
+WifiLinkState linkState() {
+  return getWifiSupervisorStats().state;
+}
+
+class WifiSupervisorTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    gWeakAp = sim::addAccessPoint(makeAccessPoint(1, 1, -80));
+    gStrongAp = sim::addAccessPoint(makeAccessPoint(2, 6, -50));
+    ASSERT_TRUE(test::bootDevice());
+  }
+};
+
+TEST_F(WifiSupervisorTest, WithoutSavedNetworksThePortalComesUp) {
+  test::runFor(100);
+  EXPECT_EQ(linkState(), WifiLinkState::kIdle);
+  EXPECT_TRUE(sim::softApActive());
+  EXPECT_FALSE(isWifiStationUp());
+}
+
+TEST_F(WifiSupervisorTest, JoinsWithoutBlockingTheCueEngine) {
+  ASSERT_TRUE(saveWifiCredentials("Stage", "lighting"));
+  ASSERT_TRUE(test::runUntil([] { return linkState() == WifiLinkState::kConnecting; }));
+
+  // The join takes seconds; cues keep working meanwhile.
+  ASSERT_TRUE(requestCueTrigger(0));
+  test::runFor(kRunLoopMaxSleepMillis);
+  EXPECT_TRUE(getCueSnapshot(0).state.active);
+  EXPECT_EQ(linkState(), WifiLinkState::kConnecting);
+  ASSERT_TRUE(requestCueRelease(0));
+
+  ASSERT_TRUE(test::runUntil([] { return isWifiStationUp(); }, kLongWaitMs));
+  EXPECT_EQ(sim::connectedAccessPoint(), static_cast<int>(gStrongAp));
+  const WifiSupervisorStats stats = getWifiSupervisorStats();
+  EXPECT_EQ(stats.connects, 1U);
+  EXPECT_STREQ(stats.ssid, "Stage");
+
+  // The access point is cached for the next, faster join.
+  test::runFor(100);
+  const SavedNetworks saved = getSavedNetworks();
+  ASSERT_EQ(saved.count, 1U);
+  EXPECT_EQ(saved.entries[0].channel, 6U);
+  EXPECT_EQ(saved.entries[0].bssid[5], 2U);
+}
+
+TEST_F(WifiSupervisorTest, FallsBackToAnotherAccessPointAfterADrop) {
+  sim::setAccessPointUp(gStrongAp, false);
+  ASSERT_TRUE(test::runUntil([] { return !isWifiStationUp(); }, kLongWaitMs));
+  ASSERT_TRUE(test::runUntil([] { return isWifiStationUp(); }, kLongWaitMs));
+  EXPECT_EQ(sim::connectedAccessPoint(), static_cast<int>(gWeakAp));
+
+  const WifiSupervisorStats stats = getWifiSupervisorStats();
+  EXPECT_EQ(stats.drops, 1U);
+  EXPECT_GE(stats.failures, 1U);  // the cached access point was gone
+  EXPECT_GT(stats.lastReconnectMs, 0U);
+  EXPECT_LT(stats.lastReconnectMs, kWifiFastConnectTimeoutMillis + kWifiConnectTimeoutMillis);
+}
+
+TEST_F(WifiSupervisorTest, RoamsToAStrongerAccessPoint) {
+  sim::setAccessPointUp(gStrongAp, true);
+  ASSERT_TRUE(test::runUntil(
+      [] { return sim::connectedAccessPoint() == static_cast<int>(gStrongAp); }, kLongWaitMs));
+  ASSERT_TRUE(test::runUntil([] { return isWifiStationUp(); }, kLongWaitMs));
+  EXPECT_EQ(getWifiSupervisorStats().roams, 1U);
+  EXPECT_EQ(linkState(), WifiLinkState::kConnected);
+}
+
+TEST_F(WifiSupervisorTest, BacksOffAndOpensThePortalWhileDown) {
+  sim::setAccessPointUp(gStrongAp, false);
+  sim::setAccessPointUp(gWeakAp, false);
+  ASSERT_TRUE(test::runUntil([] { return linkState() == WifiLinkState::kBackoff; }, kLongWaitMs));
+  EXPECT_GE(getWifiSupervisorStats().backoffMs, kWifiBackoffBaseMillis);
+
+  test::runFor(kWifiApFallbackMillis);
+  EXPECT_TRUE(sim::softApActive());
+  EXPECT_FALSE(isWifiStationUp());
+  const uint32_t failures = getWifiSupervisorStats().failures;
+  test::runFor(kWifiBackoffMaxMillis);
+  EXPECT_GT(getWifiSupervisorStats().failures, failures);  // still retrying
+
+  sim::setAccessPointUp(gWeakAp, true);
+  ASSERT_TRUE(test::runUntil([] { return isWifiStationUp(); }, kLongWaitMs));
+  EXPECT_GE(getWifiSupervisorStats().downMs, kWifiApFallbackMillis);
+
+  test::runFor(kWifiApLingerMillis + kRunLoopMaxSleepMillis);
+  EXPECT_FALSE(sim::softApActive());
+}
+
+}  // namespace
+}  // namespace stagecue
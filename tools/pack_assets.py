@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Pack firmware/data into gzip'd, content-hashed blobs compiled into flash.
+
+    tools/pack_assets.py                  # writes firmware/src/static_assets_data.h
+    tools/pack_assets.py --output build/static_assets_data.h
+                                          # the host build's copy, outside the tree
+    tools/pack_assets.py --measure http://192.168.4.1
+                                          # fetches every asset, prints bytes and TTFB
+
+Pages get `?v=<hash>` appended to the scripts and stylesheets they reference,
+so those can be cached as immutable while pages revalidate with their ETag.
+"""
+
+import argparse
+import gzip
+import hashlib
+import http.client
+import re
+import sys
+import time
+import urllib.parse
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+DATA_DIR = ROOT / "firmware" / "data"
+OUTPUT = ROOT / "firmware" / "src" / "static_assets_data.h"
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+}
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def symbol_for(name):
+    parts = re.split(r"[^0-9A-Za-z]+", name)
+    return "k" + "".join(p[:1].upper() + p[1:] for p in parts if p) + "Gz"
+
+
+def pin_references(text, hashes):
+    def repl(match):
+        name = match.group(2)
+        if name in hashes:
+            return f'{match.group(1)}="{name}?v={hashes[name]}"'
+        return match.group(0)
+
+    return re.sub(r'(src|href)="([^"?#]+)"', repl, text)
+
+
+def load_assets():
+    files = sorted(p for p in DATA_DIR.iterdir() if p.suffix in CONTENT_TYPES)
+    raw = {p.name: p.read_bytes() for p in files}
+    hashes = {name: content_hash(data) for name, data in raw.items() if not name.endswith(".html")}
+
+    assets = []
+    for name, data in raw.items():
+        if name.endswith(".html"):
+            data = pin_references(data.decode("utf-8"), hashes).encode("utf-8")
+        packed = gzip.compress(data, compresslevel=9, mtime=0)
+        assets.append(
+            {
+                "name": name,
+                "type": CONTENT_TYPES[Path(name).suffix],
+                "etag": content_hash(data),
+                "raw": len(data),
+                "gz": packed,
+                "immutable": not name.endswith(".html"),
+            }
+        )
+    return assets
+
+
+def c_bytes(data, indent="    "):
+    lines = []
+    for i in range(0, len(data), 16):
+        chunk = ", ".join(f"0x{b:02x}" for b in data[i : i + 16])
+        lines.append(f"{indent}{chunk},")
+    return "\n".join(lines)
+
+
+def write_header(assets, output):
+    out = [
+        "#pragma once",
+        "",
+        "// Generated by tools/pack_assets.py from firmware/data; do not edit.",
+        "",
+        "#include <Arduino.h>",
+        "",
+        '#include "static_assets.h"',
+        "",
+        "namespace stagecue {",
+        "namespace packed {",
+        "",
+    ]
+    for asset in assets:
+        out.append(f"// {asset['name']}: {asset['raw']} -> {len(asset['gz'])} bytes")
+        out.append(f"const uint8_t {symbol_for(asset['name'])}[] PROGMEM = {{")
+        out.append(c_bytes(asset["gz"]))
+        out.append("};")
+        out.append("")
+    out.append("const StaticAsset kAssets[] = {")
+    for asset in assets:
+        sym = symbol_for(asset["name"])
+        immutable = "true" if asset["immutable"] else "false"
+        out.append(
+            f'    {{"/{asset["name"]}", "{asset["type"]}", "\\"{asset["etag"]}\\"", '
+            f"{sym}, sizeof({sym}), {immutable}}},"
+        )
+    out.append("};")
+    out.append("")
+    out.append("}  // namespace packed")
+    out.append("}  // namespace stagecue")
+    out.append("")
+    output.write_text("\n".join(out))
+
+
+def measure(base_url, assets):
+    parsed = urllib.parse.urlparse(base_url)
+    print(f"{'asset':<14}{'status':>7}{'bytes':>8}{'ttfb ms':>10}{'total ms':>10}  revalidate")
+    for asset in assets:
+        path = "/" + asset["name"]
+        results = []
+        for etag in (None, f'"{asset["etag"]}"'):
+            conn = http.client.HTTPConnection(parsed.hostname, parsed.port or 80, timeout=5)
+            headers = {"Accept-Encoding": "gzip"}
+            if etag:
+                headers["If-None-Match"] = etag
+            start = time.perf_counter()
+            conn.request("GET", path, headers=headers)
+            response = conn.getresponse()
+            ttfb = (time.perf_counter() - start) * 1000.0
+            body = response.read()
+            total = (time.perf_counter() - start) * 1000.0
+            conn.close()
+            results.append((response.status, len(body), ttfb, total))
+        (status, size, ttfb, total), (revalidated, _, rttfb, _) = results
+        print(
+            f"{asset['name']:<14}{status:>7}{size:>8}{ttfb:>10.1f}{total:>10.1f}"
+            f"  {revalidated} in {rttfb:.1f} ms"
+        )
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--measure", metavar="URL", help="time asset fetches from a running device")
+    parser.add_argument("--output", type=Path, default=OUTPUT, help="header to write")
+    args = parser.parse_args()
+
+    assets = load_assets()
+    if args.measure:
+        measure(args.measure, assets)
+        return 0
+
+    output = args.output.resolve()
+    output.parent.mkdir(parents=True, exist_ok=True)
+    write_header(assets, output)
+    for asset in assets:
+        print(f"{asset['name']:<14}{asset['raw']:>7} -> {len(asset['gz']):>6} bytes  etag {asset['etag']}")
+    print(f"wrote {output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())